@@ -0,0 +1,300 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "allocator.h"
+#include "benchmark.h"
+#include "net.h"
+#include "platform.h"
+
+namespace ncnn {
+
+// always return empty weights
+class ModelBinFromEmpty : public ModelBin
+{
+public:
+    virtual Mat load(int w, int /*type*/) const { return Mat(w); }
+};
+
+class BenchNet : public Net
+{
+public:
+    int load_model()
+    {
+        ModelBinFromEmpty mb;
+        for (size_t i=0; i<layers.size(); i++)
+        {
+            Layer* layer = layers[i];
+
+            int lret = layer->load_model(mb);
+            if (lret != 0)
+            {
+                fprintf(stderr, "layer load_model %d failed\n", (int)i);
+                return -1;
+            }
+
+            int cret = layer->create_pipeline(opt);
+            if (cret != 0)
+            {
+                fprintf(stderr, "layer create_pipeline %d failed\n", (int)i);
+                return -1;
+            }
+        }
+
+        return fuse_network();
+    }
+};
+
+} // namespace ncnn
+
+// one allocator event, size > 0 for malloc and the index of the matching malloc for free
+struct TraceEvent
+{
+    size_t size;
+    int index;
+};
+
+// log the blob and workspace allocations of one inference
+class TraceAllocator : public ncnn::Allocator
+{
+public:
+    virtual void* fastMalloc(size_t size)
+    {
+        void* ptr = ncnn::fastMalloc(size);
+
+        TraceEvent e;
+        e.size = size;
+        e.index = malloc_count++;
+        events.push_back(e);
+
+        payouts[ptr] = e.index;
+
+        return ptr;
+    }
+
+    virtual void fastFree(void* ptr)
+    {
+        std::map<void*, int>::iterator it = payouts.find(ptr);
+        if (it != payouts.end())
+        {
+            TraceEvent e;
+            e.size = 0;
+            e.index = it->second;
+            events.push_back(e);
+
+            payouts.erase(it);
+        }
+
+        ncnn::fastFree(ptr);
+    }
+
+public:
+    TraceAllocator() : malloc_count(0) {}
+
+    int malloc_count;
+    std::vector<TraceEvent> events;
+    std::map<void*, int> payouts;
+};
+
+// one extractor replaying the trace against an allocator
+class ReplayClient
+{
+public:
+    ncnn::Allocator* allocator;
+    const TraceAllocator* trace;
+    int loop_count;
+};
+
+static void* client_main(void* args)
+{
+    ReplayClient* client = (ReplayClient*)args;
+
+    const std::vector<TraceEvent>& events = client->trace->events;
+    std::vector<void*> ptrs(client->trace->malloc_count, (void*)0);
+
+    for (int i=0; i<client->loop_count; i++)
+    {
+        for (size_t j=0; j<events.size(); j++)
+        {
+            const TraceEvent& e = events[j];
+            if (e.size)
+            {
+                void* ptr = client->allocator->fastMalloc(e.size);
+                // touch like a layer writing its output
+                memset(ptr, 0, std::min(e.size, (size_t)64));
+                ptrs[e.index] = ptr;
+            }
+            else
+            {
+                client->allocator->fastFree(ptrs[e.index]);
+                ptrs[e.index] = 0;
+            }
+        }
+    }
+
+    // allocations outliving the inference, such as the extracted output
+    for (size_t j=0; j<ptrs.size(); j++)
+    {
+        if (ptrs[j])
+            client->allocator->fastFree(ptrs[j]);
+    }
+
+    return 0;
+}
+
+// allocator shared by all clients, or one allocator per client if the array holds client_count
+static double benchmark(const char* comment, ncnn::Allocator** allocators, bool shared, const TraceAllocator& trace, int client_count, int loop_count)
+{
+    std::vector<ReplayClient> clients(client_count);
+    std::vector<ncnn::Thread*> threads(client_count);
+
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<client_count; i++)
+    {
+        clients[i].allocator = shared ? allocators[0] : allocators[i];
+        clients[i].trace = &trace;
+        clients[i].loop_count = loop_count;
+
+        threads[i] = new ncnn::Thread(client_main, &clients[i]);
+    }
+
+    for (int i=0; i<client_count; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    double end = ncnn::get_current_time();
+
+    const double op_count = (double)trace.events.size() * loop_count * client_count;
+    double ns_per_op = (end - start) * 1000000.0 / op_count;
+
+    fprintf(stderr, "%24s  clients = %3d  time = %8.2f ms  ns/op = %8.2f\n", comment, client_count, end - start, ns_per_op);
+
+    return ns_per_op;
+}
+
+int main(int argc, char** argv)
+{
+    const char* model = "squeezenet";
+    int input_size = 227;
+    int loop_count = 100;
+    int max_client_count = 32;
+
+    if (argc >= 2)
+    {
+        model = argv[1];
+        input_size = 224;
+    }
+    if (argc >= 3)
+    {
+        input_size = atoi(argv[2]);
+    }
+    if (argc >= 4)
+    {
+        loop_count = atoi(argv[3]);
+    }
+    if (argc >= 5)
+    {
+        max_client_count = atoi(argv[4]);
+    }
+
+    fprintf(stderr, "model = %s\n", model);
+    fprintf(stderr, "input_size = %d\n", input_size);
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+
+    // record the allocations of one single threaded inference
+    TraceAllocator trace;
+    {
+        ncnn::BenchNet net;
+        net.opt.lightmode = true;
+        net.opt.num_threads = 1;
+        net.opt.use_winograd_convolution = true;
+        net.opt.use_sgemm_convolution = true;
+        net.opt.use_int8_inference = true;
+
+        char parampath[256];
+        sprintf(parampath, "%s.param", model);
+        if (net.load_param(parampath) != 0)
+            return -1;
+
+        if (net.load_model() != 0)
+            return -1;
+
+        ncnn::Mat in(input_size, input_size, 3);
+        in.fill(0.01f);
+
+        ncnn::Mat out;
+        {
+            ncnn::Extractor ex = net.create_extractor();
+            ex.set_blob_allocator(&trace);
+            ex.set_workspace_allocator(&trace);
+
+            ex.input("data", in);
+            ex.extract("output", out);
+        }
+        out.release();
+    }
+
+    fprintf(stderr, "trace = %d allocations\n", trace.malloc_count);
+
+    const int client_counts[3] = { 1, 8, 32 };
+    for (int k=0; k<3; k++)
+    {
+        const int client_count = client_counts[k];
+        if (client_count > max_client_count)
+            break;
+
+        {
+            ncnn::PoolAllocator pool;
+            ncnn::Allocator* allocator = &pool;
+            benchmark("PoolAllocator", &allocator, true, trace, client_count, loop_count);
+        }
+
+        {
+            std::vector<ncnn::UnlockedPoolAllocator*> pools(client_count);
+            std::vector<ncnn::Allocator*> allocators(client_count);
+            for (int i=0; i<client_count; i++)
+            {
+                pools[i] = new ncnn::UnlockedPoolAllocator;
+                allocators[i] = pools[i];
+            }
+
+            benchmark("UnlockedPoolAllocator", &allocators[0], false, trace, client_count, loop_count);
+
+            for (int i=0; i<client_count; i++)
+            {
+                delete pools[i];
+            }
+        }
+
+        {
+            ncnn::ThreadCachePoolAllocator pool;
+            ncnn::Allocator* allocator = &pool;
+            benchmark("ThreadCachePoolAllocator", &allocator, true, trace, client_count, loop_count);
+
+            fprintf(stderr, "%24s  hit = %lu  miss = %lu  evict = %lu  peak = %.2f MB\n", "",
+                (unsigned long)pool.hit_count(), (unsigned long)pool.miss_count(), (unsigned long)pool.eviction_count(), pool.peak_size() / 1024.0 / 1024.0);
+        }
+    }
+
+    return 0;
+}
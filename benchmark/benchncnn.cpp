@@ -88,6 +88,9 @@ public:
         }
 #endif // NCNN_VULKAN
 
+        if (ret == 0)
+            fuse_network();
+
         return ret;
     }
 };
@@ -96,11 +99,14 @@ public:
 
 static int g_warmup_loop_count = 3;
 static int g_loop_count = 4;
+static bool g_memory_plan = false;
 
 static ncnn::Option g_default_option;
 
 static ncnn::UnlockedPoolAllocator g_blob_pool_allocator;
 static ncnn::PoolAllocator g_workspace_pool_allocator;
+static ncnn::PlannedAllocator g_blob_planned_allocator;
+static ncnn::PoolAllocator g_blob_locked_pool_allocator;
 
 #if NCNN_VULKAN
 static ncnn::VulkanDevice* g_vkdev = 0;
@@ -125,10 +131,15 @@ void benchmark(const char* comment, const ncnn::Mat& in)
     sprintf(parampath, "%s.param", comment);
     net.load_param(parampath);
 
+    // let the layers specialize for the input size
+    net.reshape(std::vector<ncnn::Mat>(1, in));
+
     net.load_model();
 
     g_blob_pool_allocator.clear();
     g_workspace_pool_allocator.clear();
+    g_blob_planned_allocator.clear();
+    g_blob_locked_pool_allocator.clear();
 
 #if NCNN_VULKAN
     if (net.opt.use_vulkan_compute)
@@ -147,9 +158,24 @@ void benchmark(const char* comment, const ncnn::Mat& in)
 
     ncnn::Mat out;
 
+    if (g_memory_plan)
+    {
+        // record one inference and plan the blob arena
+        g_blob_planned_allocator.begin_record();
+        {
+            ncnn::Extractor ex = net.create_extractor();
+            ex.input("data", in);
+            ex.extract("output", out);
+        }
+        g_blob_planned_allocator.end_record();
+    }
+
     // warm up
     for (int i=0; i<g_warmup_loop_count; i++)
     {
+        if (g_memory_plan)
+            g_blob_planned_allocator.rewind();
+
         ncnn::Extractor ex = net.create_extractor();
         ex.input("data", in);
         ex.extract("output", out);
@@ -161,6 +187,9 @@ void benchmark(const char* comment, const ncnn::Mat& in)
 
     for (int i=0; i<g_loop_count; i++)
     {
+        if (g_memory_plan)
+            g_blob_planned_allocator.rewind();
+
         double start = ncnn::get_current_time();
 
         {
@@ -180,7 +209,20 @@ void benchmark(const char* comment, const ncnn::Mat& in)
 
     time_avg /= g_loop_count;
 
-    fprintf(stderr, "%20s  min = %7.2f  max = %7.2f  avg = %7.2f\n", comment, time_min, time_max, time_avg);
+    if (net.opt.num_inter_op_threads > 1)
+    {
+        char name[256];
+        sprintf(name, "%s-inter%d", comment, net.opt.num_inter_op_threads);
+        fprintf(stderr, "%20s  min = %7.2f  max = %7.2f  avg = %7.2f\n", name, time_min, time_max, time_avg);
+    }
+    else if (g_memory_plan)
+    {
+        fprintf(stderr, "%20s  min = %7.2f  max = %7.2f  avg = %7.2f  peak = %7.2fMB  arena = %7.2fMB  heap = %d\n", comment, time_min, time_max, time_avg, g_blob_planned_allocator.recorded_peak_size() / 1048576.f, g_blob_planned_allocator.arena_size() / 1048576.f, g_blob_planned_allocator.heap_fallback_count());
+    }
+    else
+    {
+        fprintf(stderr, "%20s  min = %7.2f  max = %7.2f  avg = %7.2f\n", comment, time_min, time_max, time_avg);
+    }
 }
 
 int main(int argc, char** argv)
@@ -189,6 +231,8 @@ int main(int argc, char** argv)
     int num_threads = ncnn::get_cpu_count();
     int powersave = 0;
     int gpu_device = -1;
+    int num_inter_op_threads = 1;
+    int weight_storage = 0;
 
     if (argc >= 2)
     {
@@ -206,6 +250,18 @@ int main(int argc, char** argv)
     {
         gpu_device = atoi(argv[4]);
     }
+    if (argc >= 6)
+    {
+        g_memory_plan = atoi(argv[5]) != 0;
+    }
+    if (argc >= 7)
+    {
+        num_inter_op_threads = atoi(argv[6]);
+    }
+    if (argc >= 8)
+    {
+        weight_storage = atoi(argv[7]);
+    }
 
     bool use_vulkan_compute = gpu_device != -1;
 
@@ -229,7 +285,7 @@ int main(int argc, char** argv)
     // default option
     g_default_option.lightmode = true;
     g_default_option.num_threads = num_threads;
-    g_default_option.blob_allocator = &g_blob_pool_allocator;
+    g_default_option.blob_allocator = g_memory_plan ? (ncnn::Allocator*)&g_blob_planned_allocator : &g_blob_pool_allocator;
     g_default_option.workspace_allocator = &g_workspace_pool_allocator;
 #if NCNN_VULKAN
     g_default_option.blob_vkallocator = g_blob_vkallocator;
@@ -239,6 +295,9 @@ int main(int argc, char** argv)
     g_default_option.use_winograd_convolution = true;
     g_default_option.use_sgemm_convolution = true;
     g_default_option.use_int8_inference = true;
+    g_default_option.use_layer_fusion = true;
+    g_default_option.use_weight_fp16_storage = weight_storage == 1;
+    g_default_option.use_weight_int8_storage = weight_storage == 2;
     g_default_option.use_vulkan_compute = use_vulkan_compute;
     g_default_option.use_fp16_packed = true;
     g_default_option.use_fp16_storage = true;
@@ -255,6 +314,35 @@ int main(int argc, char** argv)
     fprintf(stderr, "num_threads = %d\n", num_threads);
     fprintf(stderr, "powersave = %d\n", ncnn::get_cpu_powersave());
     fprintf(stderr, "gpu_device = %d\n", gpu_device);
+    fprintf(stderr, "memory_plan = %d\n", g_memory_plan);
+    fprintf(stderr, "num_inter_op_threads = %d\n", num_inter_op_threads);
+    fprintf(stderr, "weight_storage = %d\n", weight_storage);
+
+    if (num_inter_op_threads > 1)
+    {
+        // compare intra-layer threading against branch parallel scheduling
+        // concurrent layers need a thread safe blob allocator
+        g_default_option.blob_allocator = &g_blob_locked_pool_allocator;
+
+        // the planned arena replays one layer order, concurrent layers have none
+        if (g_memory_plan)
+        {
+            fprintf(stderr, "memory_plan ignored with num_inter_op_threads > 1\n");
+            g_memory_plan = false;
+        }
+
+        g_default_option.num_inter_op_threads = 1;
+        benchmark("googlenet", ncnn::Mat(224, 224, 3));
+        g_default_option.num_inter_op_threads = num_inter_op_threads;
+        benchmark("googlenet", ncnn::Mat(224, 224, 3));
+
+        g_default_option.num_inter_op_threads = 1;
+        benchmark("mobilenet_ssd", ncnn::Mat(300, 300, 3));
+        g_default_option.num_inter_op_threads = num_inter_op_threads;
+        benchmark("mobilenet_ssd", ncnn::Mat(300, 300, 3));
+
+        return 0;
+    }
 
     // run
     benchmark("squeezenet", ncnn::Mat(227, 227, 3));
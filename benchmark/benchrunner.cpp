@@ -0,0 +1,247 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "net.h"
+#include "platform.h"
+#include "runner.h"
+
+namespace ncnn {
+
+// always return empty weights
+class ModelBinFromEmpty : public ModelBin
+{
+public:
+    virtual Mat load(int w, int /*type*/) const { return Mat(w); }
+};
+
+class BenchNet : public Net
+{
+public:
+    int load_model()
+    {
+        ModelBinFromEmpty mb;
+        for (size_t i=0; i<layers.size(); i++)
+        {
+            Layer* layer = layers[i];
+
+            int lret = layer->load_model(mb);
+            if (lret != 0)
+            {
+                fprintf(stderr, "layer load_model %d failed\n", (int)i);
+                return -1;
+            }
+
+            int cret = layer->create_pipeline(opt);
+            if (cret != 0)
+            {
+                fprintf(stderr, "layer create_pipeline %d failed\n", (int)i);
+                return -1;
+            }
+        }
+
+        return fuse_network();
+    }
+};
+
+} // namespace ncnn
+
+// one closed loop client, submit and wait one request at a time
+class BenchClient
+{
+public:
+    ncnn::Runner* runner;
+    const ncnn::Mat* in;
+    int request_count;
+
+    std::vector<double> latencies;
+    int failed_count;
+};
+
+static void* client_main(void* args)
+{
+    BenchClient* client = (BenchClient*)args;
+
+    client->latencies.clear();
+    client->failed_count = 0;
+
+    for (int i=0; i<client->request_count; i++)
+    {
+        double start = ncnn::get_current_time();
+
+        ncnn::RunnerFuture future = client->runner->submit(*client->in);
+
+        ncnn::Mat out;
+        int ret = future.get(out);
+
+        double end = ncnn::get_current_time();
+
+        if (ret != 0)
+            client->failed_count++;
+
+        client->latencies.push_back(end - start);
+    }
+
+    return 0;
+}
+
+static void benchmark(ncnn::Runner& runner, const ncnn::Mat& in, int client_count, int request_count)
+{
+    std::vector<BenchClient> clients(client_count);
+    std::vector<ncnn::Thread*> threads(client_count);
+
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<client_count; i++)
+    {
+        clients[i].runner = &runner;
+        clients[i].in = &in;
+        clients[i].request_count = request_count;
+
+        threads[i] = new ncnn::Thread(client_main, &clients[i]);
+    }
+
+    for (int i=0; i<client_count; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    double end = ncnn::get_current_time();
+
+    std::vector<double> latencies;
+    int failed_count = 0;
+    for (int i=0; i<client_count; i++)
+    {
+        latencies.insert(latencies.end(), clients[i].latencies.begin(), clients[i].latencies.end());
+        failed_count += clients[i].failed_count;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    const int n = latencies.size();
+    double p50 = latencies[n * 50 / 100];
+    double p99 = latencies[std::min(n * 99 / 100, n - 1)];
+    double throughput = n * 1000.0 / (end - start);
+
+    fprintf(stderr, "clients = %3d  req/s = %8.2f  p50 = %8.2f  p99 = %8.2f", client_count, throughput, p50, p99);
+    if (failed_count)
+        fprintf(stderr, "  failed = %d", failed_count);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* model = "squeezenet";
+    int input_size = 227;
+    int num_workers = 1;
+    int num_threads = ncnn::get_cpu_count();
+    int max_batch_size = 8;
+    double max_latency_ms = 2.0;
+    int max_client_count = 16;
+    int request_count = 8;
+
+    if (argc >= 2)
+    {
+        model = argv[1];
+        input_size = 224;
+    }
+    if (argc >= 3)
+    {
+        input_size = atoi(argv[2]);
+    }
+    if (argc >= 4)
+    {
+        num_workers = atoi(argv[3]);
+    }
+    if (argc >= 5)
+    {
+        num_threads = atoi(argv[4]);
+    }
+    if (argc >= 6)
+    {
+        max_batch_size = atoi(argv[5]);
+    }
+    if (argc >= 7)
+    {
+        max_latency_ms = atof(argv[6]);
+    }
+    if (argc >= 8)
+    {
+        max_client_count = atoi(argv[7]);
+    }
+    if (argc >= 9)
+    {
+        request_count = atoi(argv[8]);
+    }
+
+    ncnn::set_omp_dynamic(0);
+
+    fprintf(stderr, "model = %s\n", model);
+    fprintf(stderr, "input_size = %d\n", input_size);
+    fprintf(stderr, "num_workers = %d\n", num_workers);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+    fprintf(stderr, "max_batch_size = %d\n", max_batch_size);
+    fprintf(stderr, "max_latency_ms = %.2f\n", max_latency_ms);
+    fprintf(stderr, "request_count = %d\n", request_count);
+
+    ncnn::BenchNet net;
+    net.opt.lightmode = true;
+    net.opt.num_threads = num_threads;
+    net.opt.use_winograd_convolution = true;
+    net.opt.use_sgemm_convolution = true;
+    net.opt.use_int8_inference = true;
+
+    char parampath[256];
+    sprintf(parampath, "%s.param", model);
+    if (net.load_param(parampath) != 0)
+        return -1;
+
+    if (net.load_model() != 0)
+        return -1;
+
+    ncnn::Mat in(input_size, input_size, 3);
+    in.fill(0.01f);
+
+    ncnn::Runner runner;
+    runner.num_workers = num_workers;
+    runner.num_threads = num_threads;
+    runner.max_batch_size = max_batch_size;
+    runner.max_latency_ms = max_latency_ms;
+
+    if (runner.start(&net, "data", "output") != 0)
+        return -1;
+
+    // warm up
+    {
+        ncnn::Mat out;
+        runner.submit(in).get(out);
+    }
+
+    // latency under growing load, in milliseconds
+    for (int client_count=1; client_count<=max_client_count; client_count*=2)
+    {
+        benchmark(runner, in, client_count, request_count);
+    }
+
+    runner.stop();
+
+    return 0;
+}
@@ -18,6 +18,10 @@
 #include <algorithm>
 #include "gpu.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif // _OPENMP
+
 namespace ncnn {
 
 Allocator::~Allocator() 
@@ -241,6 +245,915 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
     ncnn::fastFree(ptr);
 }
 
+// atomic helpers for the thread cache pool allocator
+#if defined _MSC_VER
+static inline bool atomic_cas_ptr(void* volatile* addr, void* expected, void* desired)
+{
+    return InterlockedCompareExchangePointer((PVOID volatile*)addr, desired, expected) == expected;
+}
+
+static inline size_t atomic_add_size(volatile size_t* addr, size_t delta)
+{
+#if defined _WIN64
+    return (size_t)InterlockedExchangeAdd64((LONGLONG volatile*)addr, (LONGLONG)delta) + delta;
+#else
+    return (size_t)InterlockedExchangeAdd((LONG volatile*)addr, (LONG)delta) + delta;
+#endif
+}
+
+static inline bool atomic_cas_size(volatile size_t* addr, size_t expected, size_t desired)
+{
+    return InterlockedCompareExchangePointer((PVOID volatile*)addr, (PVOID)desired, (PVOID)expected) == (PVOID)expected;
+}
+#else
+static inline bool atomic_cas_ptr(void* volatile* addr, void* expected, void* desired)
+{
+    return __sync_bool_compare_and_swap(addr, expected, desired);
+}
+
+static inline size_t atomic_add_size(volatile size_t* addr, size_t delta)
+{
+    return __sync_add_and_fetch(addr, delta);
+}
+
+static inline bool atomic_cas_size(volatile size_t* addr, size_t expected, size_t desired)
+{
+    return __sync_bool_compare_and_swap(addr, expected, desired);
+}
+#endif
+
+// class c holds (64 << (c / 4)) * (4 + c % 4) / 4 bytes
+// -1 for the sizes too large to be cached
+static inline int size_class_index(size_t size)
+{
+    if (size <= 64)
+        return 0;
+
+    size_t s = size - 1;
+
+    // most significant bit
+#if defined __GNUC__
+    int k = (int)(sizeof(unsigned long long) * 8 - 1) - __builtin_clzll((unsigned long long)s);
+#else
+    int k = 6;
+    while (k < 63 && (s >> (k + 1)))
+        k++;
+#endif
+
+    if (k > 31)
+        return -1;
+
+    int sub = (int)(s >> (k - 2)) - 4;
+    return (k - 6) * 4 + sub + 1;
+}
+
+static inline size_t size_class_bytes(int c)
+{
+    return ((size_t)64 << (c / 4)) * (4 + c % 4) / 4;
+}
+
+// every buffer carries its size class and heap bytes ahead of the aligned payload
+struct ThreadCacheBufferHeader
+{
+    size_t size;
+    int size_class;
+};
+
+class ThreadCachePoolAllocator::ThreadCache
+{
+public:
+    ThreadCachePoolAllocator* allocator;
+
+    int counts[size_class_count];
+    void* buffers[size_class_count][thread_cache_slots];
+
+    size_t hits;
+    size_t misses;
+};
+
+ThreadCachePoolAllocator::ThreadCachePoolAllocator()
+{
+    cache_capacity = (size_t)256 * 1024 * 1024;
+
+#ifdef _WIN32
+    tls_index = FlsAlloc(thread_cache_destructor);
+#else
+    pthread_key_create(&tls_key, thread_cache_destructor);
+#endif
+
+    for (int i=0; i<size_class_count; i++)
+    {
+        for (int j=0; j<depot_slots; j++)
+        {
+            depot[i][j] = 0;
+        }
+    }
+
+    cached_bytes = 0;
+    heap_bytes = 0;
+    peak_heap_bytes = 0;
+    evictions = 0;
+
+    retired_hits = 0;
+    retired_misses = 0;
+}
+
+ThreadCachePoolAllocator::~ThreadCachePoolAllocator()
+{
+#ifdef _WIN32
+    // the callback runs for every thread holding a cache
+    FlsFree(tls_index);
+#else
+    pthread_key_delete(tls_key);
+
+    // the destructors of the live threads will not run anymore
+    caches_lock.lock();
+    std::vector<ThreadCache*> live_caches = caches;
+    caches_lock.unlock();
+
+    for (size_t i=0; i<live_caches.size(); i++)
+    {
+        release_thread_cache(live_caches[i]);
+    }
+#endif
+
+    release_depot();
+
+    if (heap_bytes != 0)
+    {
+        fprintf(stderr, "FATAL ERROR! thread cache pool allocator destroyed too early\n");
+        fprintf(stderr, "%lu bytes still in use\n", (unsigned long)heap_bytes);
+    }
+}
+
+void ThreadCachePoolAllocator::set_cache_capacity(size_t capacity)
+{
+    cache_capacity = capacity;
+
+    ThreadCache* tc = get_thread_cache();
+    while (cached_bytes > cache_capacity)
+    {
+        if (!evict(tc))
+            break;
+    }
+}
+
+void ThreadCachePoolAllocator::clear()
+{
+    release_depot();
+
+    ThreadCache* tc = get_thread_cache();
+    if (!tc)
+        return;
+
+    for (int i=0; i<size_class_count; i++)
+    {
+        for (int j=0; j<tc->counts[i]; j++)
+        {
+            atomic_add_size(&cached_bytes, -size_class_bytes(i));
+            heap_free(tc->buffers[i][j]);
+        }
+        tc->counts[i] = 0;
+    }
+}
+
+size_t ThreadCachePoolAllocator::hit_count() const
+{
+    caches_lock.lock();
+
+    size_t count = retired_hits;
+    for (size_t i=0; i<caches.size(); i++)
+    {
+        count += caches[i]->hits;
+    }
+
+    caches_lock.unlock();
+
+    return count;
+}
+
+size_t ThreadCachePoolAllocator::miss_count() const
+{
+    caches_lock.lock();
+
+    size_t count = retired_misses;
+    for (size_t i=0; i<caches.size(); i++)
+    {
+        count += caches[i]->misses;
+    }
+
+    caches_lock.unlock();
+
+    return count;
+}
+
+size_t ThreadCachePoolAllocator::eviction_count() const
+{
+    return evictions;
+}
+
+size_t ThreadCachePoolAllocator::peak_size() const
+{
+    return peak_heap_bytes;
+}
+
+size_t ThreadCachePoolAllocator::cached_size() const
+{
+    return cached_bytes;
+}
+
+void* ThreadCachePoolAllocator::fastMalloc(size_t size)
+{
+    int c = size_class_index(size);
+
+    ThreadCache* tc = get_thread_cache();
+
+    if (c == -1)
+    {
+        if (tc)
+            tc->misses++;
+
+        return heap_malloc(size, -1);
+    }
+
+    void* ptr = 0;
+    if (tc && tc->counts[c] > 0)
+    {
+        ptr = tc->buffers[c][--tc->counts[c]];
+    }
+    else
+    {
+        ptr = depot_pop(c);
+
+        // take a few more along for the next requests
+        if (ptr && tc)
+        {
+            const int refill = thread_cache_slots / 2;
+            while (tc->counts[c] < refill)
+            {
+                void* p = depot_pop(c);
+                if (!p)
+                    break;
+
+                tc->buffers[c][tc->counts[c]++] = p;
+            }
+        }
+    }
+
+    if (ptr)
+    {
+        atomic_add_size(&cached_bytes, -size_class_bytes(c));
+
+        if (tc)
+            tc->hits++;
+
+        return ptr;
+    }
+
+    if (tc)
+        tc->misses++;
+
+    return heap_malloc(size_class_bytes(c), c);
+}
+
+void ThreadCachePoolAllocator::fastFree(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    const ThreadCacheBufferHeader* header = (const ThreadCacheBufferHeader*)((unsigned char*)ptr - MALLOC_ALIGN);
+
+    int c = header->size_class;
+    if (c == -1)
+    {
+        heap_free(ptr);
+        return;
+    }
+
+    const size_t bytes = size_class_bytes(c);
+
+    if (bytes > cache_capacity)
+    {
+        atomic_add_size(&evictions, 1);
+        heap_free(ptr);
+        return;
+    }
+
+    ThreadCache* tc = get_thread_cache();
+
+    // keep under capacity, prefer dropping larger idle buffers over this one
+    if (atomic_add_size(&cached_bytes, bytes) > cache_capacity)
+    {
+        while (cached_bytes > cache_capacity)
+        {
+            if (!evict(tc))
+                break;
+        }
+
+        if (cached_bytes > cache_capacity)
+        {
+            atomic_add_size(&cached_bytes, -bytes);
+            atomic_add_size(&evictions, 1);
+            heap_free(ptr);
+            return;
+        }
+    }
+
+    if (!tc)
+    {
+        if (!depot_push(c, ptr))
+        {
+            atomic_add_size(&cached_bytes, -bytes);
+            heap_free(ptr);
+        }
+        return;
+    }
+
+    if (tc->counts[c] == thread_cache_slots)
+    {
+        // move the older half to the depot
+        const int half = thread_cache_slots / 2;
+        for (int i=0; i<half; i++)
+        {
+            void* p = tc->buffers[c][i];
+            if (!depot_push(c, p))
+            {
+                atomic_add_size(&cached_bytes, -bytes);
+                heap_free(p);
+            }
+        }
+        for (int i=half; i<thread_cache_slots; i++)
+        {
+            tc->buffers[c][i - half] = tc->buffers[c][i];
+        }
+        tc->counts[c] -= half;
+    }
+
+    tc->buffers[c][tc->counts[c]++] = ptr;
+}
+
+ThreadCachePoolAllocator::ThreadCache* ThreadCachePoolAllocator::get_thread_cache()
+{
+#ifdef _WIN32
+    ThreadCache* tc = (ThreadCache*)FlsGetValue(tls_index);
+#else
+    ThreadCache* tc = (ThreadCache*)pthread_getspecific(tls_key);
+#endif
+    if (tc)
+        return tc;
+
+    tc = new ThreadCache;
+    tc->allocator = this;
+    for (int i=0; i<size_class_count; i++)
+    {
+        tc->counts[i] = 0;
+    }
+    tc->hits = 0;
+    tc->misses = 0;
+
+    caches_lock.lock();
+    caches.push_back(tc);
+    caches_lock.unlock();
+
+#ifdef _WIN32
+    FlsSetValue(tls_index, tc);
+#else
+    pthread_setspecific(tls_key, tc);
+#endif
+
+    return tc;
+}
+
+void ThreadCachePoolAllocator::release_thread_cache(ThreadCache* tc)
+{
+    // hand the idle buffers over to the other threads
+    for (int i=0; i<size_class_count; i++)
+    {
+        for (int j=0; j<tc->counts[i]; j++)
+        {
+            void* ptr = tc->buffers[i][j];
+            if (!depot_push(i, ptr))
+            {
+                atomic_add_size(&cached_bytes, -size_class_bytes(i));
+                heap_free(ptr);
+            }
+        }
+        tc->counts[i] = 0;
+    }
+
+    caches_lock.lock();
+
+    retired_hits += tc->hits;
+    retired_misses += tc->misses;
+    caches.erase(std::find(caches.begin(), caches.end(), tc));
+
+    caches_lock.unlock();
+
+    delete tc;
+}
+
+#ifdef _WIN32
+void WINAPI ThreadCachePoolAllocator::thread_cache_destructor(void* tc)
+#else
+void ThreadCachePoolAllocator::thread_cache_destructor(void* tc)
+#endif
+{
+    if (!tc)
+        return;
+
+    ThreadCache* cache = (ThreadCache*)tc;
+    cache->allocator->release_thread_cache(cache);
+}
+
+void* ThreadCachePoolAllocator::heap_malloc(size_t size, int size_class)
+{
+    unsigned char* data = (unsigned char*)ncnn::fastMalloc(size + MALLOC_ALIGN);
+    if (!data)
+        return 0;
+
+    ThreadCacheBufferHeader* header = (ThreadCacheBufferHeader*)data;
+    header->size = size;
+    header->size_class = size_class;
+
+    size_t held = atomic_add_size(&heap_bytes, size);
+
+    size_t peak = peak_heap_bytes;
+    while (held > peak)
+    {
+        if (atomic_cas_size(&peak_heap_bytes, peak, held))
+            break;
+
+        peak = peak_heap_bytes;
+    }
+
+    return data + MALLOC_ALIGN;
+}
+
+void ThreadCachePoolAllocator::heap_free(void* ptr)
+{
+    unsigned char* data = (unsigned char*)ptr - MALLOC_ALIGN;
+
+    const ThreadCacheBufferHeader* header = (const ThreadCacheBufferHeader*)data;
+    atomic_add_size(&heap_bytes, -header->size);
+
+    ncnn::fastFree(data);
+}
+
+bool ThreadCachePoolAllocator::depot_push(int size_class, void* ptr)
+{
+    void* volatile* slots = depot[size_class];
+    for (int i=0; i<depot_slots; i++)
+    {
+        if (slots[i] == 0 && atomic_cas_ptr(&slots[i], 0, ptr))
+            return true;
+    }
+
+    return false;
+}
+
+void* ThreadCachePoolAllocator::depot_pop(int size_class)
+{
+    // a slot only ever goes from null to a buffer and back,
+    // whoever swaps a buffer out owns it exclusively
+    void* volatile* slots = depot[size_class];
+    for (int i=depot_slots-1; i>=0; i--)
+    {
+        void* ptr = slots[i];
+        if (ptr && atomic_cas_ptr(&slots[i], ptr, 0))
+            return ptr;
+    }
+
+    return 0;
+}
+
+void ThreadCachePoolAllocator::release_depot()
+{
+    for (int i=0; i<size_class_count; i++)
+    {
+        for (;;)
+        {
+            void* ptr = depot_pop(i);
+            if (!ptr)
+                break;
+
+            atomic_add_size(&cached_bytes, -size_class_bytes(i));
+            heap_free(ptr);
+        }
+    }
+}
+
+bool ThreadCachePoolAllocator::evict(ThreadCache* tc)
+{
+    // the depot first, largest buffers first
+    for (int i=size_class_count-1; i>=0; i--)
+    {
+        void* ptr = depot_pop(i);
+        if (ptr)
+        {
+            atomic_add_size(&cached_bytes, -size_class_bytes(i));
+            atomic_add_size(&evictions, 1);
+            heap_free(ptr);
+            return true;
+        }
+    }
+
+    if (!tc)
+        return false;
+
+    for (int i=size_class_count-1; i>=0; i--)
+    {
+        if (tc->counts[i] > 0)
+        {
+            void* ptr = tc->buffers[i][--tc->counts[i]];
+            atomic_add_size(&cached_bytes, -size_class_bytes(i));
+            atomic_add_size(&evictions, 1);
+            heap_free(ptr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+PlannedAllocator::PlannedAllocator()
+{
+    state = 0;
+    clock = 0;
+    live_size = 0;
+    peak_size = 0;
+    arena = 0;
+    arena_capacity = 0;
+    cursor = 0;
+    heap_fallbacks = 0;
+    record_refused = false;
+    replay_refused = false;
+}
+
+PlannedAllocator::~PlannedAllocator()
+{
+    if (!record_payouts.empty())
+    {
+        fprintf(stderr, "FATAL ERROR! planned allocator destroyed too early\n");
+    }
+
+    clear();
+}
+
+void PlannedAllocator::clear()
+{
+    for (size_t i=0; i<plan_alive.size(); i++)
+    {
+        if (plan_alive[i])
+        {
+            fprintf(stderr, "FATAL ERROR! planned allocator cleared with arena %p in use\n", arena + plan_offsets[i]);
+            return;
+        }
+    }
+
+    ncnn::fastFree(arena);
+    arena = 0;
+    arena_capacity = 0;
+    cursor = 0;
+
+    plan_sizes.clear();
+    plan_offsets.clear();
+    conflict_offsets.clear();
+    conflicts.clear();
+    slot_offsets.clear();
+    plan_slots.clear();
+    slot_payouts.clear();
+    plan_alive.clear();
+    heap_fallbacks = 0;
+    replay_refused = false;
+
+    state = 0;
+}
+
+void PlannedAllocator::rewind()
+{
+    cursor = 0;
+}
+
+int PlannedAllocator::begin_record()
+{
+    if (state == 1)
+        return 0;
+
+    clear();
+    if (arena)
+        return -1;
+
+    clock = 0;
+    live_size = 0;
+    peak_size = 0;
+    record_sizes.clear();
+    record_births.clear();
+    record_deaths.clear();
+    record_payouts.clear();
+    record_refused = false;
+
+    state = 1;
+
+    return 0;
+}
+
+int PlannedAllocator::end_record()
+{
+    if (state != 1)
+    {
+        fprintf(stderr, "planned allocator is not recording\n");
+        return -1;
+    }
+
+    if (record_refused)
+    {
+        fprintf(stderr, "planned allocator recorded concurrent layers, set num_inter_op_threads to 1\n");
+        record_payouts.clear();
+        state = 0;
+        return -1;
+    }
+
+    const int count = record_sizes.size();
+
+    plan_sizes = record_sizes;
+    plan_offsets.resize(count, -1);
+
+    // greedy by size, larger allocations take the lower offsets
+    std::vector<int> order(count);
+    for (int i=0; i<count; i++)
+    {
+        order[i] = i;
+    }
+    for (int i=1; i<count; i++)
+    {
+        // insertion sort keeps equal sizes in record order
+        int k = order[i];
+        int j = i - 1;
+        for (; j>=0 && record_sizes[order[j]] < record_sizes[k]; j--)
+        {
+            order[j + 1] = order[j];
+        }
+        order[j + 1] = k;
+    }
+
+    size_t total_size = 0;
+    std::vector< std::pair<long, long> > busy;
+    std::vector<int> placed;
+    for (int i=0; i<count; i++)
+    {
+        int k = order[i];
+
+        // still in use by the caller, leave it to the heap
+        if (record_deaths[k] == -1)
+            continue;
+
+        // arena ranges occupied by placed allocations alive at the same time
+        busy.clear();
+        for (size_t j=0; j<placed.size(); j++)
+        {
+            int q = placed[j];
+            if (record_births[q] < record_deaths[k] && record_births[k] < record_deaths[q])
+            {
+                busy.push_back(std::make_pair(plan_offsets[q], plan_offsets[q] + (long)alignSize(record_sizes[q], MALLOC_ALIGN)));
+            }
+        }
+        std::sort(busy.begin(), busy.end());
+
+        // lowest gap that fits
+        long offset = 0;
+        const long size = alignSize(record_sizes[k], MALLOC_ALIGN);
+        for (size_t j=0; j<busy.size(); j++)
+        {
+            if (busy[j].first >= offset + size)
+                break;
+
+            offset = std::max(offset, busy[j].second);
+        }
+
+        plan_offsets[k] = offset;
+        placed.push_back(k);
+
+        total_size = std::max(total_size, (size_t)(offset + size));
+    }
+
+    // planned allocations that share arena bytes must never be alive together
+    conflict_offsets.resize(count + 1);
+    conflicts.clear();
+    for (int i=0; i<count; i++)
+    {
+        conflict_offsets[i] = conflicts.size();
+
+        if (plan_offsets[i] == -1)
+            continue;
+
+        for (int j=0; j<count; j++)
+        {
+            if (j == i || plan_offsets[j] == -1)
+                continue;
+
+            if (plan_offsets[j] < plan_offsets[i] + (long)plan_sizes[i] && plan_offsets[i] < plan_offsets[j] + (long)plan_sizes[j])
+            {
+                conflicts.push_back(j);
+            }
+        }
+    }
+    conflict_offsets[count] = conflicts.size();
+
+    slot_offsets.clear();
+    for (int i=0; i<count; i++)
+    {
+        if (plan_offsets[i] != -1)
+            slot_offsets.push_back(plan_offsets[i]);
+    }
+    std::sort(slot_offsets.begin(), slot_offsets.end());
+    slot_offsets.erase(std::unique(slot_offsets.begin(), slot_offsets.end()), slot_offsets.end());
+
+    plan_slots.resize(count, -1);
+    for (int i=0; i<count; i++)
+    {
+        if (plan_offsets[i] != -1)
+            plan_slots[i] = std::lower_bound(slot_offsets.begin(), slot_offsets.end(), plan_offsets[i]) - slot_offsets.begin();
+    }
+    slot_payouts.resize(slot_offsets.size(), -1);
+    plan_alive.resize(count, 0);
+
+    if (total_size > 0)
+    {
+        arena = (unsigned char*)ncnn::fastMalloc(total_size);
+        if (!arena)
+        {
+            fprintf(stderr, "planned allocator arena %lu bytes malloc failed\n", (unsigned long)total_size);
+            record_payouts.clear();
+            clear();
+            return -1;
+        }
+    }
+    arena_capacity = total_size;
+    cursor = 0;
+    heap_fallbacks = 0;
+
+    // recorded blocks still in use stay on the heap and are released by fastFree
+    record_payouts.clear();
+
+    state = 2;
+
+    return 0;
+}
+
+size_t PlannedAllocator::recorded_peak_size() const
+{
+    return peak_size;
+}
+
+size_t PlannedAllocator::arena_size() const
+{
+    return arena_capacity;
+}
+
+int PlannedAllocator::heap_fallback_count() const
+{
+    return heap_fallbacks;
+}
+
+// called from a team of more than one thread, the branch parallel scheduler runs layers this way
+static bool in_thread_team()
+{
+#ifdef _OPENMP
+    return omp_get_num_threads() > 1;
+#else
+    return false;
+#endif // _OPENMP
+}
+
+void* PlannedAllocator::fastMalloc(size_t size)
+{
+    if (state == 1 && in_thread_team())
+    {
+        // the log is not thread safe and the order would not repeat
+        record_refused = true;
+        return ncnn::fastMalloc(size);
+    }
+
+    if (state == 1)
+    {
+        void* ptr = ncnn::fastMalloc(size);
+
+        record_payouts.push_back(std::make_pair(ptr, (int)record_sizes.size()));
+        record_sizes.push_back(size);
+        record_births.push_back(clock++);
+        record_deaths.push_back(-1);
+
+        live_size += size;
+        peak_size = std::max(peak_size, live_size);
+
+        return ptr;
+    }
+
+    if (state == 2 && !plan_sizes.empty())
+    {
+        if (!replay_refused && in_thread_team())
+        {
+            // layers running side by side allocate in no fixed order and race on the plan
+            fprintf(stderr, "planned allocator called by concurrent layers, replay refused\n");
+            replay_refused = true;
+        }
+
+        void* ptr = 0;
+        bool planned_heap = false;
+        if (!replay_refused)
+        {
+            ptr = replay_malloc(size, planned_heap);
+        }
+
+        if (ptr)
+            return ptr;
+
+        if (!planned_heap)
+            heap_fallbacks++;
+    }
+
+    return ncnn::fastMalloc(size);
+}
+
+void* PlannedAllocator::replay_malloc(size_t size, bool& planned_heap)
+{
+    // the allocation expected next, or the first free one of the same size after it
+    // a skipped or extra allocation resyncs the cursor instead of shifting every later match
+    const int count = plan_sizes.size();
+    for (int k=0; k<count; k++)
+    {
+        int i = (cursor + k) % count;
+        if (plan_sizes[i] != size)
+            continue;
+
+        if (plan_offsets[i] == -1)
+        {
+            // escaped the recorded inference, planned to the heap
+            cursor = (i + 1) % count;
+            planned_heap = true;
+            return 0;
+        }
+
+        bool overlapped = plan_alive[i] != 0;
+        for (int j=conflict_offsets[i]; j<conflict_offsets[i + 1] && !overlapped; j++)
+        {
+            overlapped = plan_alive[conflicts[j]] != 0;
+        }
+
+        if (overlapped)
+            continue;
+
+        cursor = (i + 1) % count;
+        plan_alive[i] = 1;
+        slot_payouts[plan_slots[i]] = i;
+        return arena + plan_offsets[i];
+    }
+
+    return 0;
+}
+
+void PlannedAllocator::fastFree(void* ptr)
+{
+    if (arena && (unsigned char*)ptr >= arena && (unsigned char*)ptr < arena + arena_capacity)
+    {
+        long offset = (unsigned char*)ptr - arena;
+        std::vector<long>::const_iterator it = std::lower_bound(slot_offsets.begin(), slot_offsets.end(), offset);
+        if (it != slot_offsets.end() && *it == offset)
+        {
+            int slot = it - slot_offsets.begin();
+            int i = slot_payouts[slot];
+            if (i != -1)
+            {
+                plan_alive[i] = 0;
+                slot_payouts[slot] = -1;
+                return;
+            }
+        }
+
+        fprintf(stderr, "FATAL ERROR! planned allocator get wild %p\n", ptr);
+        return;
+    }
+
+    if (state == 1 && !in_thread_team())
+    {
+        for (size_t j=0; j<record_payouts.size(); j++)
+        {
+            if (record_payouts[j].first == ptr)
+            {
+                int i = record_payouts[j].second;
+
+                record_deaths[i] = clock++;
+                live_size -= record_sizes[i];
+
+                record_payouts.erase(record_payouts.begin() + j);
+                break;
+            }
+        }
+    }
+
+    ncnn::fastFree(ptr);
+}
+
 #if NCNN_VULKAN
 VkAllocator::VkAllocator(const VulkanDevice* _vkdev) : vkdev(_vkdev)
 {
@@ -173,6 +173,171 @@ private:
     std::list< std::pair<size_t, void*> > payouts;
 };
 
+// pool allocator with geometric size classes, four per power of two from 64 bytes
+// freed buffers go to a small cache of the calling thread first,
+// overflow is exchanged with a lock-free depot shared by all threads
+// idle buffers are kept under a byte capacity, the largest ones are evicted first
+// thread safe, share one instance between extractors
+class ThreadCachePoolAllocator : public Allocator
+{
+public:
+    ThreadCachePoolAllocator();
+    ~ThreadCachePoolAllocator();
+
+    // most idle bytes kept for reuse in all threads
+    // default 256M
+    void set_cache_capacity(size_t capacity);
+
+    // release the depot and the cache of the calling thread immediately
+    void clear();
+
+    // requests served from a cache or the depot
+    size_t hit_count() const;
+
+    // requests that went to the heap
+    size_t miss_count() const;
+
+    // idle buffers released to honor the capacity
+    size_t eviction_count() const;
+
+    // most heap bytes held at once, in use and idle
+    size_t peak_size() const;
+
+    // idle bytes kept for reuse now
+    size_t cached_size() const;
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+public:
+    enum { size_class_count = 105 };
+    enum { thread_cache_slots = 8 };
+    enum { depot_slots = 16 };
+
+    class ThreadCache;
+
+private:
+    // not copyable
+    ThreadCachePoolAllocator(const ThreadCachePoolAllocator&);
+    ThreadCachePoolAllocator& operator=(const ThreadCachePoolAllocator&);
+
+    ThreadCache* get_thread_cache();
+    void release_thread_cache(ThreadCache* tc);
+#ifdef _WIN32
+    static void WINAPI thread_cache_destructor(void* tc);
+#else
+    static void thread_cache_destructor(void* tc);
+#endif
+
+    void* heap_malloc(size_t size, int size_class);
+    void heap_free(void* ptr);
+    bool depot_push(int size_class, void* ptr);
+    void* depot_pop(int size_class);
+    void release_depot();
+    // take idle buffers back to the heap until under capacity
+    // return false if nothing left to evict
+    bool evict(ThreadCache* tc);
+
+    size_t cache_capacity;
+
+#ifdef _WIN32
+    DWORD tls_index;
+#else
+    pthread_key_t tls_key;
+#endif
+
+    void* volatile depot[size_class_count][depot_slots];
+
+    volatile size_t cached_bytes;
+    volatile size_t heap_bytes;
+    volatile size_t peak_heap_bytes;
+    volatile size_t evictions;
+
+    // live thread caches and the counters of the exited ones
+    mutable Mutex caches_lock;
+    std::vector<ThreadCache*> caches;
+    size_t retired_hits;
+    size_t retired_misses;
+};
+
+// static memory planner for blob memory
+// record the allocations of one inference for a given input shape,
+// then pack them into one arena with offset reuse by liveness
+// later inferences get their blobs sliced from the arena without any malloc
+// not thread safe, use one instance per extractor
+// record and replay are refused under concurrent layers, use num_inter_op_threads 1
+class PlannedAllocator : public Allocator
+{
+public:
+    PlannedAllocator();
+    ~PlannedAllocator();
+
+    // discard the current plan and log the following allocations
+    // return 0 if success
+    int begin_record();
+
+    // assign arena offsets to the allocations released since begin_record
+    // allocations still in use are left to the heap
+    // return 0 if success
+    int end_record();
+
+    // match the next allocation against the first planned one
+    // call before each inference to replay the plan from its start
+    void rewind();
+
+    // release arena and plan
+    void clear();
+
+    // peak bytes in use while recording
+    size_t recorded_peak_size() const;
+
+    // bytes of the planned arena
+    size_t arena_size() const;
+
+    // allocations that missed the plan and went to the heap since end_record
+    int heap_fallback_count() const;
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    // arena block for size, 0 to use the heap
+    void* replay_malloc(size_t size, bool& planned_heap);
+
+private:
+    // 0=passthrough 1=record 2=replay
+    int state;
+
+    // record log
+    int clock;
+    size_t live_size;
+    size_t peak_size;
+    std::vector<size_t> record_sizes;
+    std::vector<int> record_births;
+    std::vector<int> record_deaths;
+    std::vector< std::pair<void*, int> > record_payouts;
+
+    // plan, offset -1 means heap
+    unsigned char* arena;
+    size_t arena_capacity;
+    int cursor;
+    std::vector<size_t> plan_sizes;
+    std::vector<long> plan_offsets;
+    // planned allocations sharing arena bytes with each one, packed
+    std::vector<int> conflict_offsets;
+    std::vector<int> conflicts;
+    // distinct start offsets and the allocation living there, -1 if none
+    std::vector<long> slot_offsets;
+    std::vector<int> plan_slots;
+    std::vector<int> slot_payouts;
+    std::vector<unsigned char> plan_alive;
+    int heap_fallbacks;
+
+    // called from concurrent layers, the plan is not recorded or replayed
+    bool record_refused;
+    bool replay_refused;
+};
+
 #if NCNN_VULKAN
 
 class VkBufferMemory
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 #include "platform.h"
+#include "mat.h"
 
 namespace ncnn {
 
@@ -36,6 +37,10 @@ public:
     int producer;
     // layer index which need this blob as input
     std::vector<int> consumers;
+    // int8 quantize scale if the blob flows as int8, 0 for float32
+    float int8_scale;
+    // shape inferred by Net::reshape or from the Input params, dims 0 if unknown
+    Mat shape;
 };
 
 } // namespace ncnn
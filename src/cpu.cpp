@@ -28,6 +28,15 @@
 #include <stdint.h>
 #endif
 
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define __X86__ 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 #if __APPLE__
 #include "TargetConditionals.h"
 #if TARGET_OS_IPHONE
@@ -191,6 +200,126 @@ int cpu_support_arm_asimdhp()
 #endif
 }
 
+#if __X86__
+static void x86_cpuid(int level, int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int*)regs, level, subleaf);
+#else
+    __cpuid_count(level, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// register state enabled by the os
+static unsigned int x86_xgetbv()
+{
+#ifdef _MSC_VER
+    return (unsigned int)_xgetbv(0);
+#else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#endif
+}
+
+static int get_x86_avx2()
+{
+    unsigned int regs[4];
+
+    x86_cpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return 0;
+
+    // osxsave avx fma
+    x86_cpuid(1, 0, regs);
+    if (!(regs[2] & (1u << 27)) || !(regs[2] & (1u << 28)) || !(regs[2] & (1u << 12)))
+        return 0;
+
+    // xmm ymm state
+    if ((x86_xgetbv() & 6) != 6)
+        return 0;
+
+    x86_cpuid(7, 0, regs);
+    return (regs[1] & (1u << 5)) ? 1 : 0;
+}
+
+static int get_x86_f16c()
+{
+    if (!get_x86_avx2())
+        return 0;
+
+    unsigned int regs[4];
+    x86_cpuid(1, 0, regs);
+    return (regs[2] & (1u << 29)) ? 1 : 0;
+}
+
+static int get_x86_avx512()
+{
+    if (!get_x86_avx2())
+        return 0;
+
+    // opmask zmm state
+    if ((x86_xgetbv() & 0xe6) != 0xe6)
+        return 0;
+
+    unsigned int regs[4];
+    x86_cpuid(7, 0, regs);
+    return (regs[1] & (1u << 16)) ? 1 : 0;
+}
+
+static int get_x86_avx512_vnni()
+{
+    if (!get_x86_avx512())
+        return 0;
+
+    unsigned int regs[4];
+    x86_cpuid(7, 0, regs);
+    return (regs[2] & (1u << 11)) ? 1 : 0;
+}
+
+static int g_x86_avx2 = get_x86_avx2();
+static int g_x86_f16c = get_x86_f16c();
+static int g_x86_avx512 = get_x86_avx512();
+static int g_x86_avx512_vnni = get_x86_avx512_vnni();
+#endif // __X86__
+
+int cpu_support_x86_avx2()
+{
+#if __X86__
+    return g_x86_avx2;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_f16c()
+{
+#if __X86__
+    return g_x86_f16c;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx512()
+{
+#if __X86__
+    return g_x86_avx512;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx512_vnni()
+{
+#if __X86__
+    return g_x86_avx512_vnni;
+#else
+    return 0;
+#endif
+}
+
 static int get_cpucount()
 {
 #ifdef __ANDROID__
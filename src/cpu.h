@@ -24,6 +24,14 @@ int cpu_support_arm_neon();
 int cpu_support_arm_vfpv4();
 // asimdhp = aarch64 asimd half precision
 int cpu_support_arm_asimdhp();
+// avx2 = x86 avx2 + fma, enabled by the os
+int cpu_support_x86_avx2();
+// f16c = x86 avx2 + fma + f16c half precision conversion, enabled by the os
+int cpu_support_x86_f16c();
+// avx512 = x86 avx512f, enabled by the os
+int cpu_support_x86_avx512();
+// avx512 vnni = x86 avx512f + vpdpbusd, enabled by the os
+int cpu_support_x86_avx512_vnni();
 
 // cpu info
 int get_cpu_count();
@@ -27,11 +27,58 @@
 
 namespace ncnn {
 
+int KernelChoiceCache::find(int w, int h, int c) const
+{
+    MutexLockGuard guard(lock);
+
+    for (size_t i=0; i<entries.size(); i++)
+    {
+        const KernelChoice& e = entries[i];
+        if (e.w == w && e.h == h && e.c == c)
+            return e.kernel;
+    }
+
+    return -1;
+}
+
+void KernelChoiceCache::insert(int w, int h, int c, int kernel)
+{
+    MutexLockGuard guard(lock);
+
+    for (size_t i=0; i<entries.size(); i++)
+    {
+        KernelChoice& e = entries[i];
+        if (e.w == w && e.h == h && e.c == c)
+        {
+            e.kernel = kernel;
+            return;
+        }
+    }
+
+    KernelChoice e = { w, h, c, kernel };
+    entries.push_back(e);
+}
+
+std::vector<KernelChoice> KernelChoiceCache::choices() const
+{
+    MutexLockGuard guard(lock);
+
+    return entries;
+}
+
+void KernelChoiceCache::assign(const std::vector<KernelChoice>& choices)
+{
+    MutexLockGuard guard(lock);
+
+    entries = choices;
+}
+
 Layer::Layer()
 {
     one_blob_only = false;
     support_inplace = false;
     support_vulkan = false;
+    support_packing = false;
 
 #if NCNN_VULKAN
     vkdev = 0;
@@ -62,6 +109,18 @@ int Layer::destroy_pipeline(const Option& /*opt*/)
     return 0;
 }
 
+int Layer::load_kernel_choices(const std::vector<KernelChoice>& /*choices*/)
+{
+    return 0;
+}
+
+int Layer::save_kernel_choices(std::vector<KernelChoice>& choices) const
+{
+    choices.clear();
+
+    return 0;
+}
+
 int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     if (!support_inplace)
@@ -100,6 +159,42 @@ int Layer::forward_inplace(Mat& /*bottom_top_blob*/, const Option& /*opt*/) cons
     return -1;
 }
 
+int Layer::forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    top_blobs.resize(bottom_blobs.size());
+    for (int i = 0; i < (int)bottom_blobs.size(); i++)
+    {
+        int ret = forward(bottom_blobs[i], top_blobs[i], opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int Layer::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    for (int i = 0; i < (int)bottom_top_blobs.size(); i++)
+    {
+        int ret = forward_inplace(bottom_top_blobs[i], opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int Layer::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    if (!one_blob_only || !support_inplace)
+        return -1;
+
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shapes[0].shape();
+
+    return 0;
+}
+
 #if NCNN_VULKAN
 int Layer::upload_model(VkTransfer& /*cmd*/, const Option& /*opt*/)
 {
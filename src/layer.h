@@ -33,6 +33,36 @@
 
 namespace ncnn {
 
+// kernel chosen for one feature map size
+struct KernelChoice
+{
+    // the feature map size the layer keys on
+    int w;
+    int h;
+    int c;
+    // layer specific kernel id
+    int kernel;
+};
+
+// kernel choices of one layer, shared by the threads running it
+class KernelChoiceCache
+{
+public:
+    // kernel chosen for the size, -1 if none yet
+    int find(int w, int h, int c) const;
+    // record the kernel for the size, replacing any earlier choice
+    void insert(int w, int h, int c, int kernel);
+
+    // copy of all choices
+    std::vector<KernelChoice> choices() const;
+    // replace all choices
+    void assign(const std::vector<KernelChoice>& choices);
+
+private:
+    mutable Mutex lock;
+    std::vector<KernelChoice> entries;
+};
+
 class Layer
 {
 public:
@@ -55,6 +85,12 @@ public:
     //
     virtual int destroy_pipeline(const Option& opt = Option());
 
+    // kernels chosen per feature map size, see Option::use_kernel_autotune
+    // load before create_pipeline so that only the chosen kernels are prepared
+    // return 0 if success
+    virtual int load_kernel_choices(const std::vector<KernelChoice>& choices);
+    virtual int save_kernel_choices(std::vector<KernelChoice>& choices) const;
+
 public:
     // one input and one output blob
     bool one_blob_only;
@@ -65,6 +101,9 @@ public:
     // support vulkan compute
     bool support_vulkan;
 
+    // accept packed blobs on cpu, unpacked ones must still work
+    bool support_packing;
+
 public:
     // implement inference
     // return 0 if success
@@ -76,6 +115,21 @@ public:
     virtual int forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt = Option()) const;
     virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt = Option()) const;
 
+    // implement batched inference of one_blob_only layer, one mat per sample
+    // default implementation forwards the samples one by one
+    // return 0 if success
+    virtual int forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt = Option()) const;
+
+    // implement batched inplace inference of one_blob_only layer
+    // return 0 if success
+    virtual int forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt = Option()) const;
+
+    // compute top shapes without running the layer
+    // a shape is a mat header without data, top_shapes comes sized to the top count
+    // default implementation keeps the shape for one_blob_only inplace layers
+    // return 0 if success, -1 if the shape depends on blob data
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
 #if NCNN_VULKAN
 public:
     // upload weight blob from host to device
@@ -110,6 +164,11 @@ public:
     std::vector<int> bottoms;
     // blob index which this layer produces as output
     std::vector<int> tops;
+
+    // shapes assigned by Net::reshape, empty mat headers if unknown
+    // create_pipeline may specialize for them
+    std::vector<Mat> bottom_shapes;
+    std::vector<Mat> top_shapes;
 };
 
 // layer factory function
@@ -79,4 +79,12 @@ int ArgMax::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) co
     return 0;
 }
 
+int ArgMax::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(topk, out_max_val ? 2 : 1, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -113,4 +113,10 @@ int BatchNorm_arm::forward_inplace(Mat& bottom_top_blob, const Option& opt) cons
     return 0;
 }
 
+int BatchNorm_arm::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    // neon kernel per sample
+    return Layer::forward_batch_inplace(bottom_top_blobs, opt);
+}
+
 } // namespace ncnn
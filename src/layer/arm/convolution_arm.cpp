@@ -15,6 +15,8 @@
 #include "convolution_arm.h"
 #include "benchmark.h"
 
+#include <algorithm>
+
 #include "layer_type.h"
 
 #if __ARM_NEON
@@ -26,6 +28,7 @@ namespace ncnn {
 #include "convolution_1x1.h"
 #include "convolution_2x2.h"
 #include "convolution_3x3.h"
+#include "convolution_winograd.h"
 #include "convolution_4x4.h"
 #include "convolution_5x5.h"
 #include "convolution_7x7.h"
@@ -137,11 +140,45 @@ int Convolution_arm::create_pipeline(const Option& opt)
         return 0;
     }
 
+    weight_3x3_winograd63_data.release();
+    weight_3x3_winograd43_data.release();
+
     if (use_winograd3x3)
     {
         int num_input = weight_data_size / 9 / num_output;
-//         conv3x3s1_winograd64_transform_kernel_neon(weight_data, weight_3x3_winograd64_data, num_input, num_output);
-        conv3x3s1_winograd64_transform_kernel_neon5(weight_data, weight_3x3_winograd64_data, num_input, num_output);
+
+        // F(6,3) for large feature maps, F(4,3) for small ones
+        int mask = WINOGRAD_F63 | WINOGRAD_F43;
+
+        // the input shape is known from Net::reshape, keep only the kernel it runs
+        if (!bottom_shapes.empty() && bottom_shapes[0].dims == 3)
+        {
+            int w = bottom_shapes[0].w;
+            int h = bottom_shapes[0].h;
+            if (pad_w > 0 || pad_h > 0)
+            {
+                w += pad_w * 2;
+                h += pad_h * 2;
+            }
+            else if (pad_w == -233 && pad_h == -233)
+            {
+                w += 2;
+                h += 2;
+            }
+
+            // a tuned choice, or the cost model unless autotune wants every candidate
+            int winograd_m = kernel_choices.find(w - 2, h - 2, num_input);
+            if (winograd_m == -1 && !opt.use_kernel_autotune)
+                winograd_m = conv3x3s1_winograd_select(w - 2, h - 2, num_input, num_output, mask);
+
+            if (winograd_m != -1)
+                mask = winograd_m == 6 ? WINOGRAD_F63 : winograd_m == 4 ? WINOGRAD_F43 : 0;
+        }
+
+        if (mask & WINOGRAD_F63)
+            conv3x3s1_winograd_transform_kernel(weight_data, weight_3x3_winograd63_data, num_input, num_output, 6);
+        if (mask & WINOGRAD_F43)
+            conv3x3s1_winograd_transform_kernel(weight_data, weight_3x3_winograd43_data, num_input, num_output, 4);
     }
 
     if (use_sgemm1x1)
@@ -180,110 +217,6 @@ int Convolution_arm::destroy_pipeline(const Option& opt)
     return 0;
 }
 
-int Convolution_arm::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv_func conv, const Option& opt) const
-{
-    int w = bottom_blob.w;
-    int h = bottom_blob.h;
-    size_t elemsize = bottom_blob.elemsize;
-
-    const int kernel_size = kernel_w;
-    const int stride = stride_w;
-    const int dilation = dilation_w;
-    const int kernel_extent = dilation * (kernel_size - 1) + 1;
-
-    Mat bottom_blob_bordered = bottom_blob;
-    if (pad_w > 0 || pad_h > 0)
-    {
-        copy_make_border(bottom_blob, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-        if (bottom_blob_bordered.empty())
-            return -100;
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-    else if (pad_w == -233 && pad_h == -233)
-    {
-        int wpad = kernel_extent + (w - 1) / stride * stride - w;
-        int hpad = kernel_extent + (h - 1) / stride * stride - h;
-        if (wpad > 0 || hpad > 0)
-        {
-            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-            if (bottom_blob_bordered.empty())
-                return -100;
-        }
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-
-    int outw = (w - kernel_extent) / stride + 1;
-    int outh = (h - kernel_extent) / stride + 1;
-
-    top_blob.create(outw, outh, num_output, elemsize, opt.blob_allocator);
-    if (top_blob.empty())
-        return -100;
-
-    // Make (dilation * dilation) batches
-    Mat inner_bottom_blob;
-    Mat inner_top_blob;
-    for (int x = 0; x < dilation; x ++)
-    {
-        for (int y = 0; y < dilation; y ++)
-        {
-            int inner_w = (w - y + dilation - 1) / dilation;
-            int inner_h = (h - x + dilation - 1) / dilation;
-
-            int inner_outw = (inner_w - kernel_size) / stride + 1;
-            int inner_outh = (inner_h - kernel_size) / stride + 1;
-
-            inner_bottom_blob.create(inner_w, inner_h, bottom_blob.c, elemsize, opt.workspace_allocator);
-            if (inner_bottom_blob.empty())
-                return -100;
-
-            inner_top_blob.create(inner_outw, inner_outh, num_output, elemsize, opt.workspace_allocator);
-            if (inner_top_blob.empty())
-                return -100;
-
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int c = 0; c < bottom_blob.c; c ++)
-            {
-                float *outptr = inner_bottom_blob.channel(c);
-
-                for (int i = 0; i < inner_h; i ++)
-                {
-                    const float *ptr = (const float *) bottom_blob_bordered.channel(c) + dilation * i * w + x * w + y;
-                    for (int j = 0; j < inner_w; j ++)
-                    {
-                        outptr[j] = ptr[j*dilation];
-                    }
-                    outptr += inner_w;
-                }
-            }
-
-            ncnn::Option opt_g = opt;
-            opt_g.blob_allocator = inner_top_blob.allocator;
-            conv(inner_bottom_blob, inner_top_blob, weight_data, bias_data, opt_g);
-
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int c = 0; c < num_output; c ++)
-            {
-                float *outptr = (float *) top_blob.channel(c) + x * outw + y;
-                for (int i = 0; i < inner_outh; i ++)
-                {
-                    const float *ptr = (const float *) inner_top_blob.channel(c) + i * inner_outw;
-                    for (int j = 0; j < inner_outw; j ++)
-                    {
-                        outptr[j*dilation] = ptr[j];
-                    }
-                    outptr += dilation * outw;
-                }
-            }
-        }
-    }
-
-    return 0;
-}
-
 int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // convolv with NxN kernel
@@ -294,144 +227,122 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         return Convolution::forward(bottom_blob, top_blob, opt);
     }
 
-    if (kernel_w != kernel_h || stride_w != stride_h)
-    {
-        return Convolution::forward(bottom_blob, top_blob, opt);
-    }
-
-    const int kernel_size = kernel_w;
-    //const int stride = stride_w;
-    int stride = stride_w;
-
-    if (kernel_size > 7 || stride > 4 || dilation_w != dilation_h)
-    {
-        return Convolution::forward(bottom_blob, top_blob, opt);
-    }
-
     typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, const Option&);
-
-    // kernel_size x stride
-    conv_func conv_func_table[7][4] =
-    {
-        {
-            conv1x1s1_neon,
-            conv1x1s2_neon,
-            0,
-            0
-        }, // kernel_size = 1
-        {
-            conv2x2s1_neon,
-            0,
-            0,
-            0
-        }, // kernel_size = 2
-        {
-            conv3x3s1_neon,
-            conv3x3s2_neon,
-            0,
-            0
-        }, // kernel_size = 3
-        {
-            0,
-            0,
-            0,
-            conv4x4s4_neon
-        }, // kernel_size = 4
-        {
-            conv5x5s1_neon,
-            conv5x5s2_neon,
-            0,
-            0
-        }, // kernel_size = 5
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 6
-        {
-            conv7x7s1_neon,
-            conv7x7s2_neon,
-            0,
-            0
-        }  // kernel_size = 7
-    };
-
     typedef void (*conv_int8_func)(const Mat&, Mat&, const Mat&, const Option&);
 
-    // kernel_size x stride
-    conv_int8_func conv_int8_func_table[7][4] =
-    {
-        {
-            conv1x1s1_int8_neon,
-            conv1x1s2_int8_neon,
-            0,
-            0
-        }, // kernel_size = 1
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 2
-        {
-            conv3x3s1_int8_neon,
-            conv3x3s2_int8_neon,
-            0,
-            0
-        }, // kernel_size = 3
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 4
-        {
-            conv5x5s1_int8_neon,
-            conv5x5s2_int8_neon,
-            0,
-            0
-        }, // kernel_size = 5
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 6
-        {            
-            conv7x7s1_int8_neon,           
-            conv7x7s2_int8_neon,
-            0,
-            0
-        }  // kernel_size = 7                
-    };
-
     conv_func conv = 0;
     conv_int8_func conv_int8 = 0;
 
-    if (use_int8_inference)
+    // the direct kernels are square and do not dilate
+    // float32 runs im2col sgemm for any other kernel, stride and dilation
+    if (kernel_w == kernel_h && stride_w == stride_h && dilation_w == 1 && dilation_h == 1 && kernel_w <= 7 && stride_w <= 4)
     {
-        conv_int8 = conv_int8_func_table[kernel_size-1][stride-1];
-        if (!conv_int8)
+        const int kernel_size = kernel_w;
+        const int stride = stride_w;
+
+        // kernel_size x stride
+        conv_func conv_func_table[7][4] =
         {
-            return Convolution::forward(bottom_blob, top_blob, opt);
-        }
-    }
-    else
-    {
-        conv = conv_func_table[kernel_size-1][stride-1];
-        if (!conv)
+            {
+                conv1x1s1_neon,
+                conv1x1s2_neon,
+                0,
+                0
+            }, // kernel_size = 1
+            {
+                conv2x2s1_neon,
+                0,
+                0,
+                0
+            }, // kernel_size = 2
+            {
+                conv3x3s1_neon,
+                conv3x3s2_neon,
+                0,
+                0
+            }, // kernel_size = 3
+            {
+                0,
+                0,
+                0,
+                conv4x4s4_neon
+            }, // kernel_size = 4
+            {
+                conv5x5s1_neon,
+                conv5x5s2_neon,
+                0,
+                0
+            }, // kernel_size = 5
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 6
+            {
+                conv7x7s1_neon,
+                conv7x7s2_neon,
+                0,
+                0
+            }  // kernel_size = 7
+        };
+
+        // kernel_size x stride
+        conv_int8_func conv_int8_func_table[7][4] =
         {
-            return Convolution::forward(bottom_blob, top_blob, opt);
-        }
+            {
+                conv1x1s1_int8_neon,
+                conv1x1s2_int8_neon,
+                0,
+                0
+            }, // kernel_size = 1
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 2
+            {
+                conv3x3s1_int8_neon,
+                conv3x3s2_int8_neon,
+                0,
+                0
+            }, // kernel_size = 3
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 4
+            {
+                conv5x5s1_int8_neon,
+                conv5x5s2_int8_neon,
+                0,
+                0
+            }, // kernel_size = 5
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 6
+            {            
+                conv7x7s1_int8_neon,           
+                conv7x7s2_int8_neon,
+                0,
+                0
+            }  // kernel_size = 7                
+        };
 
-        if (dilation_w != 1)
-        {
-            if (stride != 1)
-                return Convolution::forward(bottom_blob, top_blob, opt);
+        if (use_int8_inference)
+            conv_int8 = conv_int8_func_table[kernel_size-1][stride-1];
+        else
+            conv = conv_func_table[kernel_size-1][stride-1];
+    }
 
-            return forwardDilation(bottom_blob, top_blob, conv, opt);
-        }
+    if (use_int8_inference && !conv_int8)
+    {
+        return Convolution::forward(bottom_blob, top_blob, opt);
     }
 
     int w = bottom_blob.w;
@@ -458,6 +369,9 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         bottom_blob_unbordered = bottom_blob_int8;             
     }
 
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
     Mat bottom_blob_bordered = bottom_blob_unbordered;
     if (pad_w > 0 || pad_h > 0)
     {
@@ -470,8 +384,8 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     }
     else if (pad_w == -233 && pad_h == -233)
     {
-        int wpad = kernel_size + (w - 1) / stride * stride - w;
-        int hpad = kernel_size + (h - 1) / stride * stride - h;
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
         if (wpad > 0 || hpad > 0)
         {
             copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
@@ -483,19 +397,14 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         h = bottom_blob_bordered.h;
     }
 
-    int outw = (w - kernel_size) / stride + 1;
-    int outh = (h - kernel_size) / stride + 1;
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
 
     // int8
     if (use_int8_inference)
     {
         if (use_int8_requantize == true)
         {
-            Mat top_blob_tm;
-            top_blob_tm.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
-            if (top_blob_tm.empty())
-                return -100;
-            
             top_blob.create(outw, outh, num_output, (size_t)1u, opt.blob_allocator);
             if (top_blob.empty())
                 return -100; 
@@ -503,35 +412,41 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             if (use_sgemm1x1)
             {              
                 conv1x1s1_sgemm_int8_requant_neon(bottom_blob_bordered, top_blob, weight_1x1s1_sgemm_int8_data, bias_data, requantize_scales, opt);
-                
-                return 0;
-            }
-            else if (use_winograd3x3)
-            {
-                // conv3x3s1_winograd23_int8_neon(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_int8_data, opt);
-                conv3x3s1_winograd43_int8_neon(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_int8_data, opt);
-            }
-            else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
-            {
-                conv3x3s2_packed_int8_neon(bottom_blob_bordered, top_blob_tm, weight_3x3s2_int8_data, opt);
             }
             else
             {
-                conv_int8(bottom_blob_bordered, top_blob_tm, weight_sgemm_int8_data, opt);     
-            }
+                Mat top_blob_tm;
+                top_blob_tm.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
+                if (top_blob_tm.empty())
+                    return -100;
 
-            // requantize, reverse scale inplace
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int p=0; p<num_output; p++)
-            {
-                ncnn::Option opt_g = opt;
-                opt_g.num_threads = 1;
-                opt_g.blob_allocator = top_blob.allocator;
-
-                Mat top_blob_tm_g = top_blob_tm.channel_range(p, 1);
-                Mat top_blob_g = top_blob.channel_range(p, 1);
-                requantize_ops[p]->forward(top_blob_tm_g, top_blob_g, opt_g);
-            }                     
+                if (use_winograd3x3)
+                {
+                    // conv3x3s1_winograd23_int8_neon(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_int8_data, opt);
+                    conv3x3s1_winograd43_int8_neon(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_int8_data, opt);
+                }
+                else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+                {
+                    conv3x3s2_packed_int8_neon(bottom_blob_bordered, top_blob_tm, weight_3x3s2_int8_data, opt);
+                }
+                else
+                {
+                    conv_int8(bottom_blob_bordered, top_blob_tm, weight_sgemm_int8_data, opt);     
+                }
+
+                // requantize, reverse scale inplace
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int p=0; p<num_output; p++)
+                {
+                    ncnn::Option opt_g = opt;
+                    opt_g.num_threads = 1;
+                    opt_g.blob_allocator = top_blob.allocator;
+
+                    Mat top_blob_tm_g = top_blob_tm.channel_range(p, 1);
+                    Mat top_blob_g = top_blob.channel_range(p, 1);
+                    requantize_ops[p]->forward(top_blob_tm_g, top_blob_g, opt_g);
+                }
+            }
         }
         else
         {
@@ -539,39 +454,46 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             if (top_blob.empty())
                 return -100; 
 
-            if (use_sgemm1x1)
-            {
-                conv1x1s1_sgemm_int8_neon(bottom_blob_bordered, top_blob, weight_1x1s1_sgemm_int8_data, opt);
-            }
-            else if (use_winograd3x3)
+            if (use_winograd3x3)
             {
                 // conv3x3s1_winograd23_int8_neon(bottom_blob_bordered, top_blob, weight_3x3_winograd23_int8_data, opt);
                 // conv3x3s1_winograd43_int8_neon(bottom_blob_bordered, top_blob, weight_3x3_winograd23_int8_data, opt);
                 conv3x3s1_winograd43_dequant_int8_neon(bottom_blob_bordered, top_blob, weight_3x3_winograd23_int8_data, bias_data, dequantize_scales, opt);
-                return 0;
-            }
-            else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
-            {
-                conv3x3s2_packed_int8_neon(bottom_blob_bordered, top_blob, weight_3x3s2_int8_data, opt);
             }
             else
             {
-                conv_int8(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, opt);
-            }        
+                if (use_sgemm1x1)
+                {
+                    conv1x1s1_sgemm_int8_neon(bottom_blob_bordered, top_blob, weight_1x1s1_sgemm_int8_data, opt);
+                }
+                else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+                {
+                    conv3x3s2_packed_int8_neon(bottom_blob_bordered, top_blob, weight_3x3s2_int8_data, opt);
+                }
+                else
+                {
+                    conv_int8(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, opt);
+                }
 
-            // dequantize, reverse scale inplace
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int p=0; p<num_output; p++)
-            {
-                ncnn::Option opt_g = opt;
-                opt_g.num_threads = 1;
-                opt_g.blob_allocator = top_blob.allocator;
+                // dequantize, reverse scale inplace
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int p=0; p<num_output; p++)
+                {
+                    ncnn::Option opt_g = opt;
+                    opt_g.num_threads = 1;
+                    opt_g.blob_allocator = top_blob.allocator;
 
-                Mat top_blob_g = top_blob.channel_range(p, 1);
-                dequantize_ops[p]->forward_inplace(top_blob_g, opt_g);
-            }          
+                    Mat top_blob_g = top_blob.channel_range(p, 1);
+                    dequantize_ops[p]->forward_inplace(top_blob_g, opt_g);
+                }
+            }
         } 
 
+        if (activation)
+        {
+            activation->forward_inplace(top_blob, opt);
+        }
+
         return 0;
     }
 
@@ -580,10 +502,16 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     if (top_blob.empty())
         return -100;
 
-    if (use_winograd3x3 && w <= 120 && h <= 120)
+    int winograd_m = winograd_tile_size(outw, outh, channels);
+    if (opt.use_kernel_autotune && use_winograd3x3 && kernel_choices.find(outw, outh, channels) == -1)
+    {
+        winograd_m = tune_winograd_tile_size(bottom_blob_bordered, top_blob, opt);
+    }
+
+    if (winograd_m)
     {
-//         conv3x3s1_winograd64_neon4(bottom_blob_bordered, top_blob, weight_3x3_winograd64_data, bias_data, opt);
-        conv3x3s1_winograd64_neon5(bottom_blob_bordered, top_blob, weight_3x3_winograd64_data, bias_data, opt);
+        const Mat& weight_3x3_winograd_data = winograd_m == 6 ? weight_3x3_winograd63_data : weight_3x3_winograd43_data;
+        conv3x3s1_winograd(bottom_blob_bordered, top_blob, weight_3x3_winograd_data, bias_data, winograd_m, 0, opt);
     }
     else if (use_sgemm1x1)
     {
@@ -591,17 +519,19 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     }
     else if (kernel_w == 1 && kernel_h == 1 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
     {
-        conv_im2col_sgemm_neon(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, opt);
+        conv_im2col_sgemm_neon(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
     }
     else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
     {
         if (outw >=8 && outh >=8)
             conv3x3s2_packed_neon(bottom_blob_bordered, top_blob, weight_3x3s2_data, bias_data, opt);
         else
-            conv_im2col_sgemm_neon(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, opt);
-    }     
-    else
+            conv_im2col_sgemm_neon(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+    }
+    else if (conv)
         conv(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
+    else
+        conv_im2col_sgemm_neon(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
 
     if (activation)
     {
@@ -611,4 +541,76 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     return 0;
 }
 
+int Convolution_arm::winograd_tile_size(int outw, int outh, int num_input) const
+{
+    if (!use_winograd3x3)
+        return 0;
+
+    // only the tile sizes whose kernels were transformed
+    int mask = 0;
+    if (!weight_3x3_winograd63_data.empty())
+        mask |= WINOGRAD_F63;
+    if (!weight_3x3_winograd43_data.empty())
+        mask |= WINOGRAD_F43;
+
+    // a tuned choice wins over the cost model
+    int winograd_m = kernel_choices.find(outw, outh, num_input);
+    if (winograd_m == 0 || (winograd_m == 6 && (mask & WINOGRAD_F63)) || (winograd_m == 4 && (mask & WINOGRAD_F43)))
+        return winograd_m;
+
+    return conv3x3s1_winograd_select(outw, outh, num_input, num_output, mask);
+}
+
+int Convolution_arm::tune_winograd_tile_size(const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const
+{
+    const int candidates[3] = { 0, 4, 6 };
+
+    int best_m = 0;
+    double best_time = -1;
+    for (int i=0; i<3; i++)
+    {
+        const int m = candidates[i];
+        if ((m == 6 && weight_3x3_winograd63_data.empty()) || (m == 4 && weight_3x3_winograd43_data.empty()))
+            continue;
+
+        // the first run warms up caches and allocators, the second one is timed
+        double time = 0;
+        for (int j=0; j<2; j++)
+        {
+            double start = get_current_time();
+
+            if (m)
+                conv3x3s1_winograd(bottom_blob_bordered, top_blob, m == 6 ? weight_3x3_winograd63_data : weight_3x3_winograd43_data, bias_data, m, 0, opt);
+            else
+                conv3x3s1_neon(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
+
+            time = get_current_time() - start;
+        }
+
+        if (best_time < 0 || time < best_time)
+        {
+            best_time = time;
+            best_m = m;
+        }
+    }
+
+    kernel_choices.insert(top_blob.w, top_blob.h, bottom_blob_bordered.c, best_m);
+
+    return best_m;
+}
+
+int Convolution_arm::load_kernel_choices(const std::vector<KernelChoice>& choices)
+{
+    kernel_choices.assign(choices);
+
+    return 0;
+}
+
+int Convolution_arm::save_kernel_choices(std::vector<KernelChoice>& choices) const
+{
+    choices = kernel_choices.choices();
+
+    return 0;
+}
+
 } // namespace ncnn
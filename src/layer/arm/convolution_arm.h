@@ -19,8 +19,6 @@
 
 namespace ncnn {
 
-typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, const Option&);
-
 class Convolution_arm : virtual public Convolution
 {
 public:
@@ -30,13 +28,27 @@ public:
     virtual int destroy_pipeline(const Option& opt);
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
-    virtual int forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv_func conv, const Option& opt) const;
+
+    virtual int load_kernel_choices(const std::vector<KernelChoice>& choices);
+    virtual int save_kernel_choices(std::vector<KernelChoice>& choices) const;
+
+protected:
+    // winograd output tile size for this feature map, 0 for the direct kernel
+    int winograd_tile_size(int outw, int outh, int num_input) const;
+
+    // time the direct kernel and the transformed winograd kernels on this input, record and return the fastest
+    int tune_winograd_tile_size(const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const;
 
 public:
     Layer* activation;
     bool use_winograd3x3;
     bool use_sgemm1x1;
-    Mat weight_3x3_winograd64_data;
+    Mat weight_3x3_winograd63_data;
+    Mat weight_3x3_winograd43_data;
+
+    // winograd tile size per output size w h and input channels, 0 for the direct kernel
+    mutable KernelChoiceCache kernel_choices;
+
     Mat weight_1x1_sgemm_data;
     Mat weight_3x3s2_data;
     Mat weight_3x3s2_int8_data;
@@ -125,7 +125,7 @@ static void conv_im2col_sgemm_transform_kernel_neon(const Mat& _kernel, Mat& ker
 }
 
 static void conv_im2col_sgemm_neon(const Mat &bottom_blob, Mat &top_blob, const Mat & kernel_tm, const Mat& _bias, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+            const int kernel_w, const int kernel_h, const int dilation_w, const int dilation_h, const int stride_w, const int stride_h, const Option& opt)
 {
     int w = bottom_blob.w;
     int inch = bottom_blob.c;
@@ -154,12 +154,18 @@ static void conv_im2col_sgemm_neon(const Mat &bottom_blob, Mat &top_blob, const
                 {
                     for (int i=0; i<outh; i++)
                     {
+                        const float* sptr = input + (u * dilation_h + i * stride_h) * w + v * dilation_w;
+
+                        if (stride_w == 1)
+                        {
+                            memcpy(ret + retID, sptr, outw * sizeof(float));
+                            retID += outw;
+                            continue;
+                        }
+
                         for (int j=0; j<outw; j++)
                         {
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
+                            ret[retID] = sptr[j * stride_w];
                             retID++;
                         }
                     }
@@ -144,7 +144,7 @@ int ConvolutionDepthWise_arm::create_pipeline(const Option& opt)
 
             if (int8_scale_term)
             {
-                weights[2] = weight_data_int8_scales.range(g, 1);
+                weights[2] = weight_data_int8_scales.range(num_output_g * g, num_output_g);
                 weights[3] = bottom_blob_int8_scales.range(g, 1);
             }
 
@@ -157,7 +157,7 @@ int ConvolutionDepthWise_arm::create_pipeline(const Option& opt)
 
             if (int8_scale_term)
             {
-                weights[1] = weight_data_int8_scales.range(g, 1);
+                weights[1] = weight_data_int8_scales.range(num_output_g * g, num_output_g);
                 weights[2] = bottom_blob_int8_scales.range(g, 1);
             }
 
@@ -210,6 +210,12 @@ int ConvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, con
         return -100;
     }
 
+    if (use_int8_requantize && !(channels == group && group == num_output && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))))
+    {
+        // the group convolutions only dequantize
+        return ConvolutionDepthWise::forward(bottom_blob, top_blob, opt);
+    }
+
     const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
     const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
 
@@ -272,110 +278,51 @@ int ConvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, con
     {
         if (use_int8_requantize)
         {
-            Mat top_blob_tm;
-            top_blob_tm.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
-            if (top_blob_tm.empty())
-                return -100;
-  
             top_blob.create(outw, outh, num_output, (size_t)1u, opt.blob_allocator);
             if (top_blob.empty())
                 return -100;
 
+            if (stride_w == 1 && stride_h == 1)
+            {
+                convdw3x3s1_int8_requant_neon(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
+            }
+            else if (stride_w == 2 && stride_h == 2)
+            {
+                convdw3x3s2_int8_requant_neon(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
+            }
+        }
+        else
+        {
+            top_blob.create(outw, outh, num_output, (size_t)4u, opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;               
+
             // depth-wise
-            if (channels == group && group == num_output)
-            {                
-                if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
+            if (channels == group && group == num_output && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2)))
+            {
+                if (stride_w == 1 && stride_h == 1)
+                {
+                    convdw3x3s1_int8_neon(bottom_blob_bordered, top_blob, weight_data, opt);
+                }
+                else if (stride_w == 2 && stride_h == 2)
                 {
-                    if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
-                    {                  
-                        if (stride_w == 1 && stride_h == 1)
-                        {
-                            convdw3x3s1_int8_requant_neon(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
-                        }
-                        else if (stride_w == 2 && stride_h == 2)
-                        {
-                            convdw3x3s2_int8_requant_neon(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
-                        }                   
-
-                        return 0;
-                    }
+                    convdw3x3s2_int8_neon(bottom_blob_bordered, top_blob, weight_data, opt);
                 }
 
+                // dequantize, reverse scale inplace
                 #pragma omp parallel for num_threads(opt.num_threads)
                 for (int g=0; g<group; g++)
                 {
-                    const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(g, 1);
-                    Mat top_blob_tm_g = top_blob_tm.channel_range(g, 1);
-
-                    const ncnn::Layer* op = group_ops[g];
-
                     ncnn::Option opt_g = opt;
                     opt_g.num_threads = 1;
                     opt_g.blob_allocator = top_blob.allocator;
 
-                    // forward
-                    op->forward(bottom_blob_bordered_g, top_blob_tm_g, opt_g);
+                    Mat top_blob_g = top_blob.channel(g);
+                    dequantize_ops[g]->forward_inplace(top_blob_g, opt_g);
                 }
-
-                return 0;
             }
-
-            const int channels_g = channels / group;
-            const int num_output_g = num_output / group;
-
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int g=0; g<group; g++)
+            else if (channels == group && group == num_output)
             {
-                const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
-                Mat top_blob_tm_g = top_blob_tm.channel_range(num_output_g * g, num_output_g);
-
-                const ncnn::Layer* op = group_ops[g];
-
-                ncnn::Option opt_g = opt;
-                opt_g.blob_allocator = top_blob.allocator;
-
-                // forward
-                op->forward(bottom_blob_bordered_g, top_blob_tm_g, opt_g);
-            }     
-        }
-        else
-        {
-            top_blob.create(outw, outh, num_output, (size_t)4u, opt.blob_allocator);
-            if (top_blob.empty())
-                return -100;               
-
-            // depth-wise
-            if (channels == group && group == num_output)
-            {                
-                if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
-                {
-                    if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
-                    {
-                        if (stride_w == 1 && stride_h == 1)
-                        {
-                            convdw3x3s1_int8_neon(bottom_blob_bordered, top_blob, weight_data, opt);
-                        }
-                        else if (stride_w == 2 && stride_h == 2)
-                        {
-                            convdw3x3s2_int8_neon(bottom_blob_bordered, top_blob, weight_data, opt);
-                        }
-
-                        // dequantize, reverse scale inplace
-                        #pragma omp parallel for num_threads(opt.num_threads)
-                        for (int g=0; g<group; g++)
-                        {
-                            ncnn::Option opt_g = opt;
-                            opt_g.num_threads = 1;
-                            opt_g.blob_allocator = top_blob.allocator;
-
-                            Mat top_blob_g = top_blob.channel(g);
-                            dequantize_ops[g]->forward_inplace(top_blob_g, opt_g);
-                        }
-
-                        return 0;
-                    }
-                }
-
                 #pragma omp parallel for num_threads(opt.num_threads)
                 for (int g=0; g<group; g++)
                 {
@@ -391,27 +338,32 @@ int ConvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, con
                     // forward
                     op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
                 }
-
-                return 0;
             }
+            else
+            {
+                const int channels_g = channels / group;
+                const int num_output_g = num_output / group;
 
-            const int channels_g = channels / group;
-            const int num_output_g = num_output / group;
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int g=0; g<group; g++)
+                {
+                    const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
+                    Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
 
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int g=0; g<group; g++)
-            {
-                const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
-                Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
+                    const ncnn::Layer* op = group_ops[g];
 
-                const ncnn::Layer* op = group_ops[g];
+                    ncnn::Option opt_g = opt;
+                    opt_g.blob_allocator = top_blob.allocator;
 
-                ncnn::Option opt_g = opt;
-                opt_g.blob_allocator = top_blob.allocator;
+                    // forward
+                    op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
+                }
+            }
+        }
 
-                // forward
-                op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
-            }                    
+        if (activation)
+        {
+            activation->forward_inplace(top_blob, opt);
         }
 
         return 0;
@@ -15,6 +15,8 @@
 #include "deconvolution_arm.h"
 #include "layer_type.h"
 
+#include <algorithm>
+
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
@@ -23,12 +25,15 @@ namespace ncnn {
 
 #include "deconvolution_4x4.h"
 #include "deconvolution_3x3.h"
+#include "convolution_1x1.h"
+#include "deconvolution_sgemm.h"
 
 DEFINE_LAYER_CREATOR(Deconvolution_arm)
 
 Deconvolution_arm::Deconvolution_arm()
 {
     activation = 0;
+    use_sgemm = false;
 }
 
 int Deconvolution_arm::create_pipeline(const Option& opt)
@@ -72,6 +77,22 @@ int Deconvolution_arm::create_pipeline(const Option& opt)
         activation->create_pipeline(opt_cpu);
     }
 
+    // the direct kernels cover 3x3 and 4x4 with stride 1 or 2, sgemm takes the rest
+    use_sgemm = true;
+    if (kernel_w == kernel_h && stride_w == stride_h && dilation_w == 1 && dilation_h == 1)
+    {
+        if ((kernel_w == 3 || kernel_w == 4) && (stride_w == 1 || stride_w == 2))
+            use_sgemm = false;
+    }
+
+    if (use_sgemm)
+    {
+        const int maxk = kernel_w * kernel_h;
+        int num_input = weight_data_size / maxk / num_output;
+
+        deconv_sgemm_transform_kernel_neon(weight_data, weight_sgemm_data, num_input, num_output, maxk);
+    }
+
     return 0;
 }
 
@@ -94,15 +115,7 @@ int Deconvolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Opti
     // deconvolv with NxN kernel
     // value = value + bias
 
-    if (kernel_w != kernel_h || stride_w != stride_h)
-    {
-        return Deconvolution::forward(bottom_blob, top_blob, opt);
-    }
-
-    const int kernel_size = kernel_w;
-    const int stride = stride_w;
-
-    if ((kernel_size != 3 && kernel_size != 4) || stride > 2 || dilation_w != 1 || dilation_h != 1)
+    if (bottom_blob.dims != 3 || bottom_blob.elemsize != 4u)
     {
         return Deconvolution::forward(bottom_blob, top_blob, opt);
     }
@@ -122,18 +135,21 @@ int Deconvolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Opti
         }   // kernel_size = 4
     };
 
-    deconv_func deconv = deconv_func_table[kernel_size-3][stride-1];
-    if (!deconv)
+    deconv_func deconv = 0;
+    if (!use_sgemm)
     {
-        return Deconvolution::forward(bottom_blob, top_blob, opt);
+        deconv = deconv_func_table[kernel_w-3][stride_w-1];
     }
 
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     size_t elemsize = bottom_blob.elemsize;
 
-    int outw = (w - 1) * stride + kernel_size;
-    int outh = (h - 1) * stride + kernel_size;
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    int outw = (w - 1) * stride_w + kernel_extent_w;
+    int outh = (h - 1) * stride_h + kernel_extent_h;
 
     Mat top_blob_bordered;
     if (pad_w > 0 || pad_h > 0)
@@ -150,7 +166,10 @@ int Deconvolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Opti
             return -100;
     }
 
-    deconv(bottom_blob, top_blob_bordered, weight_data, bias_data, opt);
+    if (deconv)
+        deconv(bottom_blob, top_blob_bordered, weight_data, bias_data, opt);
+    else
+        deconv_sgemm_neon(bottom_blob, top_blob_bordered, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
 
     if (pad_w > 0 || pad_h > 0)
     {
@@ -31,6 +31,10 @@ public:
 
 public:
     Layer* activation;
+
+    // packed (outch * maxk)-inch sgemm weights for shapes without a direct kernel
+    bool use_sgemm;
+    Mat weight_sgemm_data;
 };
 
 } // namespace ncnn
@@ -0,0 +1,182 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// deconvolution as a 1x1 convolution to outch * maxk columns followed by col2im
+// needs convolution_1x1.h included before
+
+// column buffer bound in floats, taller inputs run in row bands
+static const int deconv_sgemm_col_budget = 2 * 1024 * 1024;
+
+static void deconv_sgemm_transform_kernel_neon(const Mat& _kernel, Mat& kernel_tm, int inch, int outch, int maxk)
+{
+    // outch-inch-maxk to (outch * maxk)-inch
+    Mat kernel_t(inch * outch * maxk);
+
+    const float* kernel = _kernel;
+    float* ptr = kernel_t;
+
+    for (int p=0; p<outch; p++)
+    {
+        for (int k=0; k<maxk; k++)
+        {
+            for (int q=0; q<inch; q++)
+            {
+                *ptr++ = kernel[(p * inch + q) * maxk + k];
+            }
+        }
+    }
+
+    conv1x1s1_sgemm_transform_kernel_neon(kernel_t, kernel_tm, inch, outch * maxk);
+}
+
+// outptr[j * stride_w] += ptr[j] * scale
+static void deconv_scatter_row_neon(float* outptr, const float* ptr, float scale, int w, int stride_w)
+{
+    int j = 0;
+
+#if __ARM_NEON
+    if (stride_w == 1)
+    {
+        for (; j+3<w; j+=4)
+        {
+            float32x4_t _out = vld1q_f32(outptr + j);
+            _out = vmlaq_n_f32(_out, vld1q_f32(ptr + j), scale);
+            vst1q_f32(outptr + j, _out);
+        }
+    }
+    else if (stride_w == 2)
+    {
+        // even lanes of the deinterleaved output pairs
+        for (; j+3<w; j+=4)
+        {
+            float32x4x2_t _out = vld2q_f32(outptr + j*2);
+            _out.val[0] = vmlaq_n_f32(_out.val[0], vld1q_f32(ptr + j), scale);
+            vst2q_f32(outptr + j*2, _out);
+        }
+    }
+#endif // __ARM_NEON
+
+    for (; j<w; j++)
+    {
+        outptr[j * stride_w] += ptr[j] * scale;
+    }
+}
+
+static void deconv_sgemm_neon(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, \
+            const int kernel_w, const int kernel_h, const int dilation_w, const int dilation_h, const int stride_w, const int stride_h, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int inch = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    int outch = top_blob.c;
+
+    const float* bias = _bias;
+
+    const int maxk = kernel_w * kernel_h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        Mat out = top_blob.channel(p);
+        out.fill(bias ? bias[p] : 0.f);
+    }
+
+    // bands of 4 rows keep every band start 16 byte aligned for the sgemm loads
+    int band_h = std::max(4, deconv_sgemm_col_budget / (outch * maxk * w)) / 4 * 4;
+    band_h = std::min(h, band_h);
+
+    Mat top_col(w, band_h, outch * maxk, elemsize, opt.workspace_allocator);
+
+    for (int i0=0; i0<h; i0+=band_h)
+    {
+        const int rows = std::min(band_h, h - i0);
+
+        // rows i0 .. i0 + rows of every channel, sgemm walks the channels by cstep
+        Mat bottom_band = bottom_blob;
+        Mat top_band = top_col;
+        if (rows != h)
+        {
+            bottom_band = Mat(w, rows, inch, (float*)bottom_blob.data + i0 * w, elemsize);
+            bottom_band.cstep = bottom_blob.cstep;
+
+            top_band = Mat(w, rows, outch * maxk, top_col.data, elemsize);
+            top_band.cstep = top_col.cstep;
+        }
+
+        conv1x1s1_sgemm_neon(bottom_band, top_band, kernel_tm, Mat(), opt);
+
+        // col2im
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p=0; p<outch; p++)
+        {
+            Mat out = top_blob.channel(p);
+
+            for (int u=0; u<kernel_h; u++)
+            {
+                for (int v=0; v<kernel_w; v++)
+                {
+                    const float* ptr = top_band.channel(p * maxk + u * kernel_w + v);
+
+                    for (int i=0; i<rows; i++)
+                    {
+                        float* outptr = out.row((i0 + i) * stride_h + u * dilation_h) + v * dilation_w;
+
+                        deconv_scatter_row_neon(outptr, ptr, 1.f, w, stride_w);
+
+                        ptr += w;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void deconvdw_neon(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& _bias, \
+            const int kernel_w, const int kernel_h, const int dilation_w, const int dilation_h, const int stride_w, const int stride_h, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int group = bottom_blob.c;
+
+    const float* bias = _bias;
+
+    const int maxk = kernel_w * kernel_h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<group; g++)
+    {
+        Mat out = top_blob.channel(g);
+        out.fill(bias ? bias[g] : 0.f);
+
+        const float* kptr = (const float*)kernel + maxk * g;
+        const Mat m = bottom_blob.channel(g);
+
+        for (int u=0; u<kernel_h; u++)
+        {
+            for (int v=0; v<kernel_w; v++)
+            {
+                const float k = kptr[u * kernel_w + v];
+
+                for (int i=0; i<h; i++)
+                {
+                    float* outptr = out.row(i * stride_h + u * dilation_h) + v * dilation_w;
+
+                    deconv_scatter_row_neon(outptr, m.row(i), k, w, stride_w);
+                }
+            }
+        }
+    }
+}
@@ -15,12 +15,17 @@
 #include "deconvolutiondepthwise_arm.h"
 #include "layer_type.h"
 
+#include <algorithm>
+
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
 
 namespace ncnn {
 
+#include "convolution_1x1.h"
+#include "deconvolution_sgemm.h"
+
 DEFINE_LAYER_CREATOR(DeconvolutionDepthWise_arm)
 
 DeconvolutionDepthWise_arm::DeconvolutionDepthWise_arm()
@@ -69,20 +74,88 @@ int DeconvolutionDepthWise_arm::create_pipeline(const Option& opt)
         activation->create_pipeline(opt_cpu);
     }
 
+    // create Deconvolution op for each group
+    const int maxk = kernel_w * kernel_h;
+    int channels = (weight_data_size / group) / maxk / (num_output / group) * group;
+
+    for (int i=0; i<(int)group_ops.size(); i++)
+        delete group_ops[i];
+
+    group_ops.clear();
+
+    if (channels == group && group == num_output)
+    {
+        // depth-wise specific
+        return 0;
+    }
+
+    const int channels_g = channels / group;
+    const int num_output_g = num_output / group;
+
+    Option opt_cpu = opt;
+    opt_cpu.use_vulkan_compute = false;
+
+    group_ops.resize(group);
+
+    for (int g=0; g<group; g++)
+    {
+        Mat weight_data_g = weight_data.range(maxk * channels_g * num_output_g * g, maxk * channels_g * num_output_g);
+        Mat bias_data_g;
+        if (bias_term)
+            bias_data_g = bias_data.range(num_output_g * g, num_output_g);
+
+        ncnn::Layer* op = ncnn::create_layer(ncnn::LayerType::Deconvolution);
+
+        // set param
+        ncnn::ParamDict pd;
+        pd.set(0, num_output_g);// num_output
+        pd.set(1, kernel_w);
+        pd.set(11, kernel_h);
+        pd.set(2, dilation_w);
+        pd.set(12, dilation_h);
+        pd.set(3, stride_w);
+        pd.set(13, stride_h);
+        pd.set(4, 0);// pad_w
+        pd.set(14, 0);// pad_h
+        pd.set(5, bias_term);
+        pd.set(6, maxk * channels_g * num_output_g);// weight_data_size
+
+        op->load_param(pd);
+
+        // set weights
+        ncnn::Mat weights[2];
+        weights[0] = weight_data_g;
+        weights[1] = bias_data_g;
+
+        op->load_model(ModelBinFromMatArray(weights));
+
+        op->create_pipeline(opt_cpu);
+
+        group_ops[g] = op;
+    }
+
     return 0;
 }
 
 int DeconvolutionDepthWise_arm::destroy_pipeline(const Option& opt)
 {
+    Option opt_cpu = opt;
+    opt_cpu.use_vulkan_compute = false;
+
     if (activation)
     {
-        Option opt_cpu = opt;
-        opt_cpu.use_vulkan_compute = false;
         activation->destroy_pipeline(opt_cpu);
         delete activation;
         activation = 0;
     }
 
+    for (int i=0; i<(int)group_ops.size(); i++)
+    {
+        group_ops[i]->destroy_pipeline(opt_cpu);
+        delete group_ops[i];
+    }
+    group_ops.clear();
+
     return 0;
 }
 
@@ -91,6 +164,11 @@ int DeconvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, c
     // convolv with NxN kernel
     // value = value + bias
 
+    if (bottom_blob.dims != 3 || bottom_blob.elemsize != 4u)
+    {
+        return DeconvolutionDepthWise::forward(bottom_blob, top_blob, opt);
+    }
+
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int channels = bottom_blob.c;
@@ -123,57 +201,10 @@ int DeconvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, c
             return -100;
     }
 
-    const int maxk = kernel_w * kernel_h;
-
     // depth-wise
     if (channels == group && group == num_output)
     {
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int g=0; g<group; g++)
-        {
-            Mat bottom_blob_g = bottom_blob.channel_range(g, 1);
-            Mat top_blob_bordered_g = top_blob_bordered.channel_range(g, 1);
-            Mat weight_data_g = weight_data.range(maxk * g, maxk);
-
-            Mat bias_data_g;
-            if (bias_term)
-                bias_data_g = bias_data.range(g, 1);
-
-            // call Deconvolution
-            ncnn::Layer* op = ncnn::create_layer(ncnn::LayerType::Deconvolution);
-
-            // set param
-            ncnn::ParamDict pd;
-            pd.set(0, 1);// num_output
-            pd.set(1, kernel_w);
-            pd.set(11, kernel_h);
-            pd.set(2, dilation_w);
-            pd.set(12, dilation_h);
-            pd.set(3, stride_w);
-            pd.set(13, stride_h);
-            pd.set(4, 0);// pad_w
-            pd.set(14, 0);// pad_h
-            pd.set(5, bias_term);
-            pd.set(6, maxk);// weight_data_size
-
-            op->load_param(pd);
-
-            // set weights
-            ncnn::Mat weights[2];
-            weights[0] = weight_data_g;
-            weights[1] = bias_data_g;
-
-            op->load_model(ModelBinFromMatArray(weights));
-
-            ncnn::Option opt_g = opt;
-            opt_g.num_threads = 1;
-            opt_g.blob_allocator = top_blob_bordered.allocator;
-
-            // forward
-            op->forward(bottom_blob_g, top_blob_bordered_g, opt_g);
-
-            delete op;
-        }
+        deconvdw_neon(bottom_blob, top_blob_bordered, weight_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
     }
     else
     {
@@ -182,46 +213,16 @@ int DeconvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, c
 
         for (int g=0; g<group; g++)
         {
-            Mat bottom_blob_g = bottom_blob.channel_range(channels_g * g, channels_g);
+            const Mat bottom_blob_g = bottom_blob.channel_range(channels_g * g, channels_g);
             Mat top_blob_bordered_g = top_blob_bordered.channel_range(num_output_g * g, num_output_g);
-            Mat weight_data_g = weight_data.range(maxk * channels_g * num_output_g * g, maxk * channels_g * num_output_g);
-            Mat bias_data_g;
-            if (bias_term)
-                bias_data_g = bias_data.range(num_output_g * g, num_output_g);
-
-            // call Deconvolution
-            ncnn::Layer* op = ncnn::create_layer(ncnn::LayerType::Deconvolution);
-
-            // set param
-            ncnn::ParamDict pd;
-            pd.set(0, num_output_g);// num_output
-            pd.set(1, kernel_w);
-            pd.set(11, kernel_h);
-            pd.set(2, dilation_w);
-            pd.set(12, dilation_h);
-            pd.set(3, stride_w);
-            pd.set(13, stride_h);
-            pd.set(4, 0);// pad_w
-            pd.set(14, 0);// pad_h
-            pd.set(5, bias_term);
-            pd.set(6, maxk * channels_g * num_output_g);// weight_data_size
-
-            op->load_param(pd);
-
-            // set weights
-            ncnn::Mat weights[2];
-            weights[0] = weight_data_g;
-            weights[1] = bias_data_g;
-
-            op->load_model(ModelBinFromMatArray(weights));
+
+            const ncnn::Layer* op = group_ops[g];
 
             ncnn::Option opt_g = opt;
             opt_g.blob_allocator = top_blob_bordered.allocator;
 
             // forward
             op->forward(bottom_blob_g, top_blob_bordered_g, opt_g);
-
-            delete op;
         }
     }
 
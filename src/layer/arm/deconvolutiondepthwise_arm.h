@@ -31,6 +31,9 @@ public:
 
 public:
     Layer* activation;
+
+    // Deconvolution op for each group, depth-wise runs its own kernel
+    std::vector<ncnn::Layer*> group_ops;
 };
 
 } // namespace ncnn
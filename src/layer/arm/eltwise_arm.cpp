@@ -24,6 +24,9 @@ DEFINE_LAYER_CREATOR(Eltwise_arm)
 
 int Eltwise_arm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (use_int8_inference)
+        return Eltwise::forward_int8(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     int w = bottom_blob.w;
     int h = bottom_blob.h;
@@ -0,0 +1,69 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "expression_arm.h"
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#include "neon_mathfun.h"
+#endif // __ARM_NEON
+
+#include <math.h>
+
+#include "unaryop.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Expression_arm)
+
+void Expression_arm::run_instruction(const Instruction& ins, float* dst, const float* a, const float* b, int n) const
+{
+    const bool is_sigmoid = ins.op == Instruction_SIGMOID;
+    const bool is_exp = ins.op == Instruction_UNARY && ins.type == UnaryOp::Operation_EXP;
+
+    if (!is_sigmoid && !is_exp)
+    {
+        Expression::run_instruction(ins, dst, a, b, n);
+        return;
+    }
+
+    int i = 0;
+#if __ARM_NEON
+    float32x4_t _one = vdupq_n_f32(1.f);
+    for (; i+3<n; i+=4)
+    {
+        float32x4_t _p = vld1q_f32(a + i);
+        if (is_sigmoid)
+        {
+            _p = vnegq_f32(_p);
+            _p = exp_ps(_p);
+            _p = vaddq_f32(_p, _one);
+            float32x4_t _outp = vrecpeq_f32(_p);
+            _p = vmulq_f32(vrecpsq_f32(_p, _outp), _outp);
+        }
+        else
+        {
+            _p = exp_ps(_p);
+        }
+        vst1q_f32(dst + i, _p);
+    }
+#endif // __ARM_NEON
+    for (; i<n; i++)
+    {
+        dst[i] = is_sigmoid ? 1.f / (1.f + exp(-a[i])) : exp(a[i]);
+    }
+}
+
+} // namespace ncnn
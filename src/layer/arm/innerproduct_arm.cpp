@@ -14,6 +14,9 @@
 
 #include "innerproduct_arm.h"
 
+#include <math.h>
+#include <algorithm>
+
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
@@ -30,6 +33,12 @@ int InnerProduct_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
         return InnerProduct::forward(bottom_blob, top_blob, opt);
     }
 
+    if (weight_data.elemsize != 4u)
+    {
+        // fp16 or int8 weight storage
+        return InnerProduct::forward(bottom_blob, top_blob, opt);
+    }
+
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int channels = bottom_blob.c;
@@ -310,4 +319,287 @@ int InnerProduct_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
     return 0;
 }
 
+// 4 weight rows against 2 inputs over n elements, sum[s * 4 + r] for input s and row r
+static void dot_4x2(const float* x0, const float* x1, const float* w0, const float* w1, const float* w2, const float* w3, int n, float* sum)
+{
+#if __ARM_NEON
+    int nn = n >> 2;
+    int remain = n & 3;
+#else
+    int remain = n;
+#endif // __ARM_NEON
+
+    for (int i=0; i<8; i++)
+    {
+        sum[i] = 0.f;
+    }
+
+#if __ARM_NEON
+    float32x4_t _sum00 = vdupq_n_f32(0.f);
+    float32x4_t _sum01 = vdupq_n_f32(0.f);
+    float32x4_t _sum02 = vdupq_n_f32(0.f);
+    float32x4_t _sum03 = vdupq_n_f32(0.f);
+    float32x4_t _sum10 = vdupq_n_f32(0.f);
+    float32x4_t _sum11 = vdupq_n_f32(0.f);
+    float32x4_t _sum12 = vdupq_n_f32(0.f);
+    float32x4_t _sum13 = vdupq_n_f32(0.f);
+
+    for (; nn>0; nn--)
+    {
+        float32x4_t _w0 = vld1q_f32(w0);
+        float32x4_t _w1 = vld1q_f32(w1);
+        float32x4_t _w2 = vld1q_f32(w2);
+        float32x4_t _w3 = vld1q_f32(w3);
+
+        float32x4_t _x0 = vld1q_f32(x0);
+        _sum00 = vmlaq_f32(_sum00, _x0, _w0);
+        _sum01 = vmlaq_f32(_sum01, _x0, _w1);
+        _sum02 = vmlaq_f32(_sum02, _x0, _w2);
+        _sum03 = vmlaq_f32(_sum03, _x0, _w3);
+
+        float32x4_t _x1 = vld1q_f32(x1);
+        _sum10 = vmlaq_f32(_sum10, _x1, _w0);
+        _sum11 = vmlaq_f32(_sum11, _x1, _w1);
+        _sum12 = vmlaq_f32(_sum12, _x1, _w2);
+        _sum13 = vmlaq_f32(_sum13, _x1, _w3);
+
+        x0 += 4;
+        x1 += 4;
+        w0 += 4;
+        w1 += 4;
+        w2 += 4;
+        w3 += 4;
+    }
+
+    float32x2_t _sum01ss = vpadd_f32(vadd_f32(vget_low_f32(_sum00), vget_high_f32(_sum00)), vadd_f32(vget_low_f32(_sum01), vget_high_f32(_sum01)));
+    float32x2_t _sum23ss = vpadd_f32(vadd_f32(vget_low_f32(_sum02), vget_high_f32(_sum02)), vadd_f32(vget_low_f32(_sum03), vget_high_f32(_sum03)));
+    float32x2_t _sum45ss = vpadd_f32(vadd_f32(vget_low_f32(_sum10), vget_high_f32(_sum10)), vadd_f32(vget_low_f32(_sum11), vget_high_f32(_sum11)));
+    float32x2_t _sum67ss = vpadd_f32(vadd_f32(vget_low_f32(_sum12), vget_high_f32(_sum12)), vadd_f32(vget_low_f32(_sum13), vget_high_f32(_sum13)));
+
+    vst1_f32(sum, _sum01ss);
+    vst1_f32(sum + 2, _sum23ss);
+    vst1_f32(sum + 4, _sum45ss);
+    vst1_f32(sum + 6, _sum67ss);
+#endif // __ARM_NEON
+
+    for (; remain>0; remain--)
+    {
+        sum[0] += *x0 * *w0;
+        sum[1] += *x0 * *w1;
+        sum[2] += *x0 * *w2;
+        sum[3] += *x0 * *w3;
+        sum[4] += *x1 * *w0;
+        sum[5] += *x1 * *w1;
+        sum[6] += *x1 * *w2;
+        sum[7] += *x1 * *w3;
+
+        x0++;
+        x1++;
+        w0++;
+        w1++;
+        w2++;
+        w3++;
+    }
+}
+
+static float dot_1x1(const float* x, const float* w, int n)
+{
+#if __ARM_NEON
+    int nn = n >> 2;
+    int remain = n & 3;
+#else
+    int remain = n;
+#endif // __ARM_NEON
+
+    float sum = 0.f;
+
+#if __ARM_NEON
+    float32x4_t _sum = vdupq_n_f32(0.f);
+    for (; nn>0; nn--)
+    {
+        _sum = vmlaq_f32(_sum, vld1q_f32(x), vld1q_f32(w));
+
+        x += 4;
+        w += 4;
+    }
+
+    float32x2_t _sumss = vadd_f32(vget_low_f32(_sum), vget_high_f32(_sum));
+    _sumss = vpadd_f32(_sumss, _sumss);
+    sum = vget_lane_f32(_sumss, 0);
+#endif // __ARM_NEON
+
+    for (; remain>0; remain--)
+    {
+        sum += *x * *w;
+
+        x++;
+        w++;
+    }
+
+    return sum;
+}
+
+int InnerProduct_arm::forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const int batch = bottom_blobs.size();
+
+    int w = bottom_blobs[0].w;
+    int h = bottom_blobs[0].h;
+    int channels = bottom_blobs[0].c;
+    size_t elemsize = bottom_blobs[0].elemsize;
+    int size = w * h;
+
+    bool same_shape = true;
+    for (int n=1; n<batch; n++)
+    {
+        const Mat& m = bottom_blobs[n];
+        if (m.w != w || m.h != h || m.c != channels || m.elemsize != elemsize)
+            same_shape = false;
+    }
+
+    // neon kernel per sample
+    if (use_int8_inference || elemsize != 4u || weight_data.elemsize != 4u || !same_shape || batch < 2)
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+    const int K = size * channels;
+
+    std::vector<const float*> x(batch);
+    std::vector<Mat> bottom_blobs_flattened(batch);
+    for (int n=0; n<batch; n++)
+    {
+        bottom_blobs_flattened[n] = bottom_blobs[n].reshape(K, opt.workspace_allocator);
+        if (bottom_blobs_flattened[n].empty())
+            return -100;
+
+        x[n] = bottom_blobs_flattened[n];
+    }
+
+    top_blobs.resize(batch);
+    for (int n=0; n<batch; n++)
+    {
+        top_blobs[n].create(num_output, elemsize, opt.blob_allocator);
+        if (top_blobs[n].empty())
+            return -100;
+
+        float* outptr = top_blobs[n];
+        for (int p=0; p<num_output; p++)
+        {
+            outptr[p] = bias_term ? bias_data[p] : 0.f;
+        }
+    }
+
+    const float* weight_data_ptr = weight_data;
+
+    // the 4 row weight block stays in cache while all samples pass over it
+    // so the weights are read from memory once for the whole batch
+    const int kc = 1024;
+
+    const int nn_batch = batch >> 1;
+    const int remain_batch_start = nn_batch << 1;
+
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        const float* w0 = weight_data_ptr + K * p;
+        const float* w1 = w0 + K;
+        const float* w2 = w1 + K;
+        const float* w3 = w2 + K;
+
+        for (int k0=0; k0<K; k0+=kc)
+        {
+            const int n = std::min(kc, K - k0);
+
+            for (int bb=0; bb<nn_batch; bb++)
+            {
+                int b = bb * 2;
+
+                float sum[8];
+                dot_4x2(x[b] + k0, x[b+1] + k0, w0 + k0, w1 + k0, w2 + k0, w3 + k0, n, sum);
+
+                float* outptr0 = top_blobs[b];
+                float* outptr1 = top_blobs[b+1];
+                outptr0[p] += sum[0];
+                outptr0[p+1] += sum[1];
+                outptr0[p+2] += sum[2];
+                outptr0[p+3] += sum[3];
+                outptr1[p] += sum[4];
+                outptr1[p+1] += sum[5];
+                outptr1[p+2] += sum[6];
+                outptr1[p+3] += sum[7];
+            }
+
+            for (int b=remain_batch_start; b<batch; b++)
+            {
+                float* outptr = top_blobs[b];
+                outptr[p] += dot_1x1(x[b] + k0, w0 + k0, n);
+                outptr[p+1] += dot_1x1(x[b] + k0, w1 + k0, n);
+                outptr[p+2] += dot_1x1(x[b] + k0, w2 + k0, n);
+                outptr[p+3] += dot_1x1(x[b] + k0, w3 + k0, n);
+            }
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        const float* w = weight_data_ptr + K * p;
+
+        for (int k0=0; k0<K; k0+=kc)
+        {
+            const int n = std::min(kc, K - k0);
+
+            for (int b=0; b<batch; b++)
+            {
+                float* outptr = top_blobs[b];
+                outptr[p] += dot_1x1(x[b] + k0, w + k0, n);
+            }
+        }
+    }
+
+    if (activation_type != 0)
+    {
+        for (int n=0; n<batch; n++)
+        {
+            float* outptr = top_blobs[n];
+
+            for (int p=0; p<num_output; p++)
+            {
+                float sum = outptr[p];
+
+                if (activation_type == 1)
+                {
+                    sum = std::max(sum, 0.f);
+                }
+                else if (activation_type == 2)
+                {
+                    float slope = activation_params[0];
+                    sum = sum > 0.f ? sum : sum * slope;
+                }
+                else if (activation_type == 3)
+                {
+                    float min = activation_params[0];
+                    float max = activation_params[1];
+                    if (sum < min)
+                        sum = min;
+                    if (sum > max)
+                        sum = max;
+                }
+                else if (activation_type == 4)
+                {
+                    sum = 1.f / (1.f + exp(-sum));
+                }
+
+                outptr[p] = sum;
+            }
+        }
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
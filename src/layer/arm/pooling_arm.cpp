@@ -31,6 +31,9 @@ int Pooling_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
     // max value in NxN window
     // avg value in NxN window
 
+    if (bottom_blob.elemsize == 1u)
+        return Pooling::forward_int8(bottom_blob, top_blob, opt);
+
     if (kernel_w != kernel_h || stride_w != stride_h)
     {
         return Pooling::forward(bottom_blob, top_blob, opt);
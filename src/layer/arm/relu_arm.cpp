@@ -233,4 +233,10 @@ int ReLU_arm::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
     return 0;
 }
 
+int ReLU_arm::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    // neon kernel per sample
+    return Layer::forward_batch_inplace(bottom_top_blobs, opt);
+}
+
 } // namespace ncnn
@@ -24,6 +24,8 @@ class ReLU_arm : virtual public ReLU
 public:
     virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
     virtual int forward_inplace_int8(Mat& bottom_top_blob, const Option& opt) const;
+
+    virtual int forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const;
 };
 
 } // namespace ncnn
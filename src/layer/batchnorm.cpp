@@ -131,4 +131,42 @@ int BatchNorm::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
     return 0;
 }
 
+int BatchNorm::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    const int batch = bottom_top_blobs.size();
+
+    int w = bottom_top_blobs[0].w;
+    int h = bottom_top_blobs[0].h;
+    int size = w * h;
+
+    bool same_shape = bottom_top_blobs[0].dims == 3;
+    for (int n=1; n<batch; n++)
+    {
+        const Mat& m = bottom_top_blobs[n];
+        if (m.dims != 3 || m.w != w || m.h != h)
+            same_shape = false;
+    }
+
+    if (!same_shape)
+        return Layer::forward_batch_inplace(bottom_top_blobs, opt);
+
+    // one parallel region over all channels of all samples
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int nq=0; nq<batch * channels; nq++)
+    {
+        int q = nq % channels;
+
+        float* ptr = bottom_top_blobs[nq / channels].channel(q);
+        float a = a_data[q];
+        float b = b_data[q];
+
+        for (int i=0; i<size; i++)
+        {
+            ptr[i] = b * ptr[i] + a;
+        }
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
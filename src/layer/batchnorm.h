@@ -30,6 +30,8 @@ public:
 
     virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
 
+    virtual int forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const;
+
 public:
     // param
     int channels;
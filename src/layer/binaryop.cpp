@@ -488,4 +488,22 @@ int BinaryOp::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
     return 0;
 }
 
+int BinaryOp::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    if (with_scalar)
+        return Layer::infer_shape(bottom_shapes, top_shapes);
+
+    const Mat& a = bottom_shapes[0];
+    const Mat& b = bottom_shapes[1];
+
+    // b broadcasts to a unless it has more dims or a is a scalar
+    top_shapes.resize(1);
+    if (b.dims > a.dims || (a.dims == 1 && a.w == 1 && b.dims == 1))
+        top_shapes[0] = b.shape();
+    else
+        top_shapes[0] = a.shape();
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -30,6 +30,8 @@ public:
 
     virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
 
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
     enum {
         Operation_ADD   = 0,
         Operation_SUB   = 1,
@@ -32,122 +32,6 @@ int Cast::load_param(const ParamDict& pd)
     return 0;
 }
 
-// convert float to half precision floating point
-static unsigned short float32_to_float16(float value)
-{
-    // 1 : 8 : 23
-    union
-    {
-        unsigned int u;
-        float f;
-    } tmp;
-
-    tmp.f = value;
-
-    // 1 : 8 : 23
-    unsigned short sign = (tmp.u & 0x80000000) >> 31;
-    unsigned short exponent = (tmp.u & 0x7F800000) >> 23;
-    unsigned int significand = tmp.u & 0x7FFFFF;
-
-//     fprintf(stderr, "%d %d %d\n", sign, exponent, significand);
-
-    // 1 : 5 : 10
-    unsigned short fp16;
-    if (exponent == 0)
-    {
-        // zero or denormal, always underflow
-        fp16 = (sign << 15) | (0x00 << 10) | 0x00;
-    }
-    else if (exponent == 0xFF)
-    {
-        // infinity or NaN
-        fp16 = (sign << 15) | (0x1F << 10) | (significand ? 0x200 : 0x00);
-    }
-    else
-    {
-        // normalized
-        short newexp = exponent + (- 127 + 15);
-        if (newexp >= 31)
-        {
-            // overflow, return infinity
-            fp16 = (sign << 15) | (0x1F << 10) | 0x00;
-        }
-        else if (newexp <= 0)
-        {
-            // underflow
-            if (newexp >= -10)
-            {
-                // denormal half-precision
-                unsigned short sig = (significand | 0x800000) >> (14 - newexp);
-                fp16 = (sign << 15) | (0x00 << 10) | sig;
-            }
-            else
-            {
-                // underflow
-                fp16 = (sign << 15) | (0x00 << 10) | 0x00;
-            }
-        }
-        else
-        {
-            fp16 = (sign << 15) | (newexp << 10) | (significand >> 13);
-        }
-    }
-
-    return fp16;
-}
-
-// convert half precision floating point to float
-static float float16_to_float32(unsigned short value)
-{
-    // 1 : 5 : 10
-    unsigned short sign = (value & 0x8000) >> 15;
-    unsigned short exponent = (value & 0x7c00) >> 10;
-    unsigned short significand = value & 0x03FF;
-
-//     fprintf(stderr, "%d %d %d\n", sign, exponent, significand);
-
-    // 1 : 8 : 23
-    union
-    {
-        unsigned int u;
-        float f;
-    } tmp;
-    if (exponent == 0)
-    {
-        if (significand == 0)
-        {
-            // zero
-            tmp.u = (sign << 31);
-        }
-        else
-        {
-            // denormal
-            exponent = 0;
-            // find non-zero bit
-            while ((significand & 0x200) == 0)
-            {
-                significand <<= 1;
-                exponent++;
-            }
-            significand <<= 1;
-            significand &= 0x3FF;
-            tmp.u = (sign << 31) | ((-exponent + (-15 + 127)) << 23) | (significand << 13);
-        }
-    }
-    else if (exponent == 0x1F)
-    {
-        // infinity or NaN
-        tmp.u = (sign << 31) | (0xFF << 23) | (significand << 13);
-    }
-    else
-    {
-        // normalized
-        tmp.u = (sign << 31) | ((exponent + (-15 + 127)) << 23) | (significand << 13);
-    }
-
-    return tmp.f;
-}
-
 // round to nearest
 static signed char float32_to_int8(float value)
 {
@@ -247,4 +131,26 @@ int Cast::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
     return 0;
 }
 
+int Cast::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shape.shape();
+
+    if (type_from == type_to)
+        return 0;
+
+    int packing = bottom_shape.packing;
+
+    if (type_to == 1)
+        top_shapes[0].elemsize = 4 * packing;
+    else if (type_to == 2)
+        top_shapes[0].elemsize = 2 * packing;
+    else if (type_to == 3)
+        top_shapes[0].elemsize = packing;
+
+    return 0;
+}
+
 } // namespace ncnn
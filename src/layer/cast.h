@@ -28,6 +28,8 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
 public:
     // element type
     // 0 = auto
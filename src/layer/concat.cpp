@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "concat.h"
+#include <math.h>
 #include <algorithm>
 
 namespace ncnn {
@@ -23,19 +24,142 @@ Concat::Concat()
 {
     one_blob_only = false;
     support_inplace = false;
+    use_int8_inference = false;
+    top_blob_int8_scale = 0.f;
 }
 
 int Concat::load_param(const ParamDict& pd)
 {
     axis = pd.get(0, 0);
 
+    // packed channel blocks are concatenated as whole
+    support_packing = axis == 0;
+
+    return 0;
+}
+
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -128) return -128;
+    return (signed char)int32;
+}
+
+// bring one bottom to the top blob type, int8 at top_scale or float32 if top_scale is 0
+static int convert_int8_blob(const Mat& bottom_blob, Mat& bottom_blob_converted, float bottom_scale, float top_scale, const Option& opt)
+{
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (bottom_blob.packing != 1)
+    {
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    bool bottom_int8 = bottom_blob_unpacked.elemsize == 1u;
+    bool top_int8 = top_scale != 0.f;
+
+    if (bottom_int8 == top_int8 && (!top_int8 || bottom_scale == top_scale))
+    {
+        bottom_blob_converted = bottom_blob_unpacked;
+        return 0;
+    }
+
+    int w = bottom_blob_unpacked.w;
+    int h = bottom_blob_unpacked.h;
+    int channels = bottom_blob_unpacked.c;
+    int dims = bottom_blob_unpacked.dims;
+    int size = w * h;
+
+    size_t elemsize = top_int8 ? 1u : 4u;
+    if (dims == 1)
+        bottom_blob_converted.create(w, elemsize, opt.workspace_allocator);
+    else if (dims == 2)
+        bottom_blob_converted.create(w, h, elemsize, opt.workspace_allocator);
+    else
+        bottom_blob_converted.create(w, h, channels, elemsize, opt.workspace_allocator);
+    if (bottom_blob_converted.empty())
+        return -100;
+
+    // float value = int8 value / bottom_scale
+    float scale = (bottom_int8 ? 1.f / bottom_scale : 1.f) * (top_int8 ? top_scale : 1.f);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        if (bottom_int8 && top_int8)
+        {
+            const signed char* ptr = bottom_blob_unpacked.channel(q);
+            signed char* outptr = bottom_blob_converted.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                outptr[i] = float2int8(ptr[i] * scale);
+            }
+        }
+        else if (bottom_int8)
+        {
+            const signed char* ptr = bottom_blob_unpacked.channel(q);
+            float* outptr = bottom_blob_converted.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                outptr[i] = ptr[i] * scale;
+            }
+        }
+        else
+        {
+            const float* ptr = bottom_blob_unpacked.channel(q);
+            signed char* outptr = bottom_blob_converted.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                outptr[i] = float2int8(ptr[i] * scale);
+            }
+        }
+    }
+
     return 0;
 }
 
-int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+int Concat::forward(const std::vector<Mat>& _bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    std::vector<Mat> bottom_blobs_converted;
+    if (use_int8_inference)
+    {
+        // mixed int8 and float32 bottoms, or int8 bottoms at another scale
+        bottom_blobs_converted.resize(_bottom_blobs.size());
+        for (size_t b=0; b<_bottom_blobs.size(); b++)
+        {
+            int ret = convert_int8_blob(_bottom_blobs[b], bottom_blobs_converted[b], bottom_blob_int8_scales[b], top_blob_int8_scale, opt);
+            if (ret != 0)
+                return ret;
+        }
+    }
+
+    const std::vector<Mat>& bottom_blobs = use_int8_inference ? bottom_blobs_converted : _bottom_blobs;
+
     int dims = bottom_blobs[0].dims;
     size_t elemsize = bottom_blobs[0].elemsize;
+    int packing = bottom_blobs[0].packing;
+
+    for (size_t b=1; b<bottom_blobs.size(); b++)
+    {
+        if (bottom_blobs[b].packing == packing)
+            continue;
+
+        // mixed layout, concat the plain blobs
+        std::vector<Mat> bottom_blobs_unpacked(bottom_blobs.size());
+        for (size_t i=0; i<bottom_blobs.size(); i++)
+        {
+            convert_packing(bottom_blobs[i], bottom_blobs_unpacked[i], 1, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blobs_unpacked[i].empty())
+                return -100;
+        }
+
+        return forward(bottom_blobs_unpacked, top_blobs, opt);
+    }
 
     if (dims == 1) // axis == 0
     {
@@ -53,17 +177,17 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         if (top_blob.empty())
             return -100;
 
-        float* outptr = top_blob;
+        unsigned char* outptr = top_blob;
         for (size_t b=0; b<bottom_blobs.size(); b++)
         {
             const Mat& bottom_blob = bottom_blobs[b];
 
             int w = bottom_blob.w;
 
-            const float* ptr = bottom_blob;
+            const unsigned char* ptr = bottom_blob;
             memcpy(outptr, ptr, w * elemsize);
 
-            outptr += w;
+            outptr += w * elemsize;
         }
 
         return 0;
@@ -87,17 +211,17 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         if (top_blob.empty())
             return -100;
 
-        float* outptr = top_blob;
+        unsigned char* outptr = top_blob;
         for (size_t b=0; b<bottom_blobs.size(); b++)
         {
             const Mat& bottom_blob = bottom_blobs[b];
 
             int size = w * bottom_blob.h;
 
-            const float* ptr = bottom_blob;
+            const unsigned char* ptr = bottom_blob;
             memcpy(outptr, ptr, size * elemsize);
 
-            outptr += size;
+            outptr += size * elemsize;
         }
 
         return 0;
@@ -124,15 +248,15 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int i=0; i<h; i++)
         {
-            float* outptr = top_blob.row(i);
+            unsigned char* outptr = top_blob.row<unsigned char>(i);
             for (size_t b=0; b<bottom_blobs.size(); b++)
             {
                 const Mat& bottom_blob = bottom_blobs[b];
 
-                const float* ptr = bottom_blob.row(i);
+                const unsigned char* ptr = bottom_blob.row<unsigned char>(i);
                 memcpy(outptr, ptr, bottom_blob.w * elemsize);
 
-                outptr += bottom_blob.w;
+                outptr += bottom_blob.w * elemsize;
             }
         }
 
@@ -154,7 +278,7 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         }
 
         Mat& top_blob = top_blobs[0];
-        top_blob.create(w, h, top_channels, elemsize, opt.blob_allocator);
+        top_blob.create(w, h, top_channels, elemsize, packing, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -198,7 +322,7 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int q=0; q<channels; q++)
         {
-            float* outptr = top_blob.channel(q);
+            unsigned char* outptr = top_blob.channel(q);
 
             for (size_t b=0; b<bottom_blobs.size(); b++)
             {
@@ -206,10 +330,10 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
 
                 int size = bottom_blob.w * bottom_blob.h;
 
-                const float* ptr = bottom_blob.channel(q);
+                const unsigned char* ptr = bottom_blob.channel(q);
                 memcpy(outptr, ptr, size * elemsize);
 
-                outptr += size;
+                outptr += size * elemsize;
             }
         }
 
@@ -238,7 +362,7 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int q=0; q<channels; q++)
         {
-            float* outptr = top_blob.channel(q);
+            unsigned char* outptr = top_blob.channel(q);
 
             for (int i=0; i<h; i++)
             {
@@ -246,10 +370,10 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
                 {
                     const Mat& bottom_blob = bottom_blobs[b];
 
-                    const float* ptr = bottom_blob.channel(q).row(i);
+                    const unsigned char* ptr = bottom_blob.channel(q).row<unsigned char>(i);
                     memcpy(outptr, ptr, bottom_blob.w * elemsize);
 
-                    outptr += bottom_blob.w;
+                    outptr += bottom_blob.w * elemsize;
                 }
             }
         }
@@ -260,4 +384,46 @@ int Concat::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
     return 0;
 }
 
+int Concat::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+    int dims = bottom_shape.dims;
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int c = bottom_shape.c;
+
+    // sum the concat axis
+    int top_size = 0;
+    for (size_t b=0; b<bottom_shapes.size(); b++)
+    {
+        const Mat& m = bottom_shapes[b];
+
+        if ((dims == 1) || (dims == 2 && axis == 1) || (dims == 3 && axis == 2))
+            top_size += m.w;
+        else if ((dims == 2 && axis == 0) || (dims == 3 && axis == 1))
+            top_size += m.h;
+        else if (dims == 3 && axis == 0)
+            top_size += m.c;
+        else
+            return -1;
+    }
+
+    top_shapes.resize(1);
+    if (dims == 1)
+        top_shapes[0] = Mat(top_size, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+    else if (dims == 2 && axis == 0)
+        top_shapes[0] = Mat(w, top_size, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+    else if (dims == 2 && axis == 1)
+        top_shapes[0] = Mat(top_size, h, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+    else if (axis == 0)
+        top_shapes[0] = Mat(w, h, top_size, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+    else if (axis == 1)
+        top_shapes[0] = Mat(w, top_size, c, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+    else
+        top_shapes[0] = Mat(top_size, h, c, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+
+    return 0;
+}
+
 } // namespace ncnn
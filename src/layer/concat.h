@@ -28,8 +28,17 @@ public:
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
 public:
     int axis;
+
+    // int8 blobs in or out, set up by Net::fuse_network
+    bool use_int8_inference;
+    // one per bottom, 0 for float32 bottom
+    Mat bottom_blob_int8_scales;
+    // 0 for float32 top
+    float top_blob_int8_scale;
 };
 
 } // namespace ncnn
@@ -27,6 +27,9 @@ Convolution::Convolution()
     use_int8_requantize = false;
 
     quantize = 0;
+
+    use_fused_eltwise = false;
+    fused_activation_type = 0;
 }
 
 int Convolution::load_param(const ParamDict& pd)
@@ -249,6 +252,72 @@ int Convolution::create_requantize_op(void)
     return 0;
 }
 
+static void activation_inplace(Mat& top_blob, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    if (activation_type == 0)
+        return;
+
+    int channels = top_blob.c;
+    int size = top_blob.w * top_blob.h;
+
+    if (top_blob.elemsize == 1u)
+    {
+        // requantized output, relu is the only activation kept in int8
+        if (activation_type != 1)
+            return;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            signed char* ptr = top_blob.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                if (ptr[i] < 0)
+                    ptr[i] = 0;
+            }
+        }
+
+        return;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = top_blob.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            float v = ptr[i];
+
+            if (activation_type == 1)
+            {
+                v = std::max(v, 0.f);
+            }
+            else if (activation_type == 2)
+            {
+                float slope = activation_params[0];
+                v = v > 0.f ? v : v * slope;
+            }
+            else if (activation_type == 3)
+            {
+                float min = activation_params[0];
+                float max = activation_params[1];
+                if (v < min)
+                    v = min;
+                if (v > max)
+                    v = max;
+            }
+            else if (activation_type == 4)
+            {
+                v = 1.f / (1.f + exp(-v));
+            }
+
+            ptr[i] = v;
+        }
+    }
+}
+
 int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // convolv with NxN kernel
@@ -492,6 +561,8 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
             }   
         }        
 
+        activation_inplace(top_blob, activation_type, activation_params, opt);
+
         return 0;
     }
 
@@ -566,4 +637,112 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
     return 0;
 }
 
+static int eltwise_sum_inplace(Mat& top_blob, const ConvolutionEpilogue& epilogue, const Option& opt)
+{
+    ConvolutionEpilogue epilogue_packed = epilogue;
+    if (epilogue.residual.packing != top_blob.packing)
+    {
+        convert_packing(epilogue.residual, epilogue_packed.residual, top_blob.packing, opt.workspace_allocator, opt.num_threads);
+        if (epilogue_packed.residual.empty())
+            return -100;
+    }
+
+    const Mat& residual = epilogue_packed.residual;
+    if (residual.w != top_blob.w || residual.h != top_blob.h || residual.c != top_blob.c || residual.elemsize != top_blob.elemsize)
+    {
+        fprintf(stderr, "fused eltwise residual shape mismatch\n");
+        return -1;
+    }
+
+    int channels = top_blob.c;
+    int size = top_blob.w * top_blob.h * top_blob.packing;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        epilogue_packed.apply(top_blob, q, 0, size);
+    }
+
+    return 0;
+}
+
+ConvolutionEpilogue Convolution::fused_epilogue(const Mat& residual) const
+{
+    ConvolutionEpilogue epilogue;
+    epilogue.residual = residual;
+    epilogue.coeff0 = fused_eltwise_coeffs[0];
+    epilogue.coeff1 = fused_eltwise_coeffs[1];
+    epilogue.activation_type = fused_activation_type;
+    epilogue.slope = fused_relu_slope;
+
+    return epilogue;
+}
+
+int Convolution::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Mat top_blob;
+    int ret = forward(bottom_blobs[0], top_blob, opt);
+    if (ret != 0)
+        return ret;
+
+    if (use_fused_eltwise)
+    {
+        // sum and relu in a single pass
+        ret = eltwise_sum_inplace(top_blob, fused_epilogue(bottom_blobs[1]), opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    top_blobs[0] = top_blob;
+
+    return 0;
+}
+
+int Convolution::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    top_shapes.resize(1);
+
+    // flattened blob, implement as InnerProduct
+    if (bottom_shape.dims == 1 && kernel_w == 1 && kernel_h == 1)
+    {
+        int num_input = weight_data_size / num_output;
+        if (bottom_shape.w == num_input)
+        {
+            top_shapes[0] = Mat(num_output, (void*)0);
+            return 0;
+        }
+    }
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    if (pad_w > 0 || pad_h > 0)
+    {
+        w += pad_w * 2;
+        h += pad_h * 2;
+    }
+    else if (pad_w == -233 && pad_h == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    top_shapes[0] = Mat(outw, outh, num_output, (void*)0, use_int8_requantize ? (size_t)1u : (size_t)4u);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -19,6 +19,49 @@
 
 namespace ncnn {
 
+// residual sum and relu fused into a convolution by Net::fuse_network
+// top = top * coeff0 + residual * coeff1, then relu when activation_type is 1
+struct ConvolutionEpilogue
+{
+    Mat residual;
+    float coeff0;
+    float coeff1;
+    int activation_type;
+    float slope;
+
+    // n values of channel p from offset i
+    // the float32 kernels call it on each output tile right after storing it
+    void apply(Mat& top_blob, int p, int i, int n) const
+    {
+        float* ptr = (float*)((unsigned char*)top_blob.data + top_blob.cstep * top_blob.elemsize * p) + i;
+        const float* rptr = (const float*)((const unsigned char*)residual.data + residual.cstep * residual.elemsize * p) + i;
+
+        if (activation_type == 1 && slope == 0.f)
+        {
+            for (int k=0; k<n; k++)
+            {
+                float v = ptr[k] * coeff0 + rptr[k] * coeff1;
+                ptr[k] = v > 0.f ? v : 0.f;
+            }
+        }
+        else if (activation_type == 1)
+        {
+            for (int k=0; k<n; k++)
+            {
+                float v = ptr[k] * coeff0 + rptr[k] * coeff1;
+                ptr[k] = v > 0.f ? v : v * slope;
+            }
+        }
+        else
+        {
+            for (int k=0; k<n; k++)
+            {
+                ptr[k] = ptr[k] * coeff0 + rptr[k] * coeff1;
+            }
+        }
+    }
+};
+
 class Convolution : public Layer
 {
 public:
@@ -35,6 +78,13 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    // convolution followed by the epilogue fused by Net::fuse_network
+    // the residual comes in as the second bottom blob
+    // this one sums it in a pass over the top blob, the x86 float32 kernels sum it as they store each tile
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
 public:
     // param
     int num_output;
@@ -74,6 +124,18 @@ public:
     // merge de/requantize op into convolution op
     std::vector<float> dequantize_scales;
     std::vector<float> requantize_scales;    
+
+    // epilogue fused by Net::fuse_network
+    // top = top * fused_eltwise_coeffs[0] + residual * fused_eltwise_coeffs[1]
+    bool use_fused_eltwise;
+    float fused_eltwise_coeffs[2];
+    // relu after the residual sum, 0=none 1=relu
+    int fused_activation_type;
+    float fused_relu_slope;
+
+protected:
+    // the fused epilogue with this residual
+    ConvolutionEpilogue fused_epilogue(const Mat& residual) const;
 };
 
 } // namespace ncnn
@@ -0,0 +1,763 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// winograd F(m,3) for 3x3 stride 1 convolution, m = 2, 4 or 6
+// shared by the x86 and arm Convolution, included inside namespace ncnn
+//
+// output tiles are grouped in blocks of conv3x3s1_winograd_nr tiles
+// each block is transformed, multiplied with one gemm per tile position
+// and transformed back, and the blocks are spread over threads
+
+#if __AVX512F__
+static const int conv3x3s1_winograd_nr = 32;
+#elif __AVX__
+static const int conv3x3s1_winograd_nr = 16;
+#else
+static const int conv3x3s1_winograd_nr = 8;
+#endif
+
+// kernel_tm mask bits for conv3x3s1_winograd_select
+#define WINOGRAD_F23 1
+#define WINOGRAD_F43 2
+#define WINOGRAD_F63 4
+
+static void conv3x3s1_winograd_transform_kernel(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int m)
+{
+    // G
+    const float ktm23[4][3] = {
+        {   1.0f,     0.0f,     0.0f},
+        {   0.5f,     0.5f,     0.5f},
+        {   0.5f,    -0.5f,     0.5f},
+        {   0.0f,     0.0f,     1.0f}
+    };
+
+    const float ktm43[6][3] = {
+        {  1.0f/4,     0.0f,    0.0f},
+        { -1.0f/6,  -1.0f/6, -1.0f/6},
+        { -1.0f/6,   1.0f/6, -1.0f/6},
+        { 1.0f/24,  1.0f/12,  1.0f/6},
+        { 1.0f/24, -1.0f/12,  1.0f/6},
+        {    0.0f,     0.0f,    1.0f}
+    };
+
+    const float ktm63[8][3] = {
+        {   1.0f,     0.0f,     0.0f},
+        {-2.0f/9,  -2.0f/9,  -2.0f/9},
+        {-2.0f/9,   2.0f/9,  -2.0f/9},
+        {1.0f/90,  1.0f/45,  2.0f/45},
+        {1.0f/90, -1.0f/45,  2.0f/45},
+        {1.0f/45,  1.0f/90, 1.0f/180},
+        {1.0f/45, -1.0f/90, 1.0f/180},
+        {   0.0f,     0.0f,     1.0f}
+    };
+
+    const int n = m + 2;
+    const float (*ktm)[3] = m == 6 ? ktm63 : m == 4 ? ktm43 : ktm23;
+
+    // one channel per tile position, one row per 4 output channels
+    // holding inch x 4 interleaved weights, padded with zero
+    const int outch4 = (outch + 3) / 4;
+
+    kernel_tm.create(inch * 4, outch4, n * n);
+    if (kernel_tm.empty())
+        return;
+
+    kernel_tm.fill(0.f);
+
+    #pragma omp parallel for
+    for (int p=0; p<outch; p++)
+    {
+        for (int q=0; q<inch; q++)
+        {
+            const float* k0 = (const float*)kernel + p * inch * 9 + q * 9;
+            const float* k1 = k0 + 3;
+            const float* k2 = k0 + 6;
+
+            // h
+            float tmp[8][3];
+            for (int i=0; i<n; i++)
+            {
+                tmp[i][0] = k0[0] * ktm[i][0] + k0[1] * ktm[i][1] + k0[2] * ktm[i][2];
+                tmp[i][1] = k1[0] * ktm[i][0] + k1[1] * ktm[i][1] + k1[2] * ktm[i][2];
+                tmp[i][2] = k2[0] * ktm[i][0] + k2[1] * ktm[i][1] + k2[2] * ktm[i][2];
+            }
+
+            // U
+            for (int j=0; j<n; j++)
+            {
+                const float* tmpp = &tmp[j][0];
+
+                for (int i=0; i<n; i++)
+                {
+                    float* kptr = kernel_tm.channel(i * n + j).row(p / 4);
+                    kptr[q * 4 + p % 4] = tmpp[0] * ktm[i][0] + tmpp[1] * ktm[i][1] + tmpp[2] * ktm[i][2];
+                }
+            }
+        }
+    }
+}
+
+// pick the output tile size for a feature map, 0 when im2col sgemm is expected to win
+// cost counts gemm multiply-adds over tile blocks padded to full width, the
+// input and output transforms, and for sgemm the im2col copy
+static int conv3x3s1_winograd_select(int outw, int outh, int inch, int outch, int mask)
+{
+    const int nr = conv3x3s1_winograd_nr;
+
+    double best_cost = (double)outw * outh * 9 * (inch * outch + inch);
+    int best_m = 0;
+
+    for (int m=2; m<=6; m+=2)
+    {
+        if (!(mask & (1 << (m / 2 - 1))))
+            continue;
+
+        const int n = m + 2;
+        const int tiles = ((outw + m - 1) / m) * ((outh + m - 1) / m);
+        const int tiles_padded = (tiles + nr - 1) / nr * nr;
+
+        double cost = (double)tiles_padded * n * n * inch * ((outch + 3) / 4 * 4)
+                    + (double)tiles_padded * n * n * 4 * (inch + outch);
+
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best_m = m;
+        }
+    }
+
+    return best_m;
+}
+
+// BT, one column of n points for nr tiles, in and out stepped by rows of nr
+static inline void conv3x3s1_winograd_bt(const float* d, int ds, float* r, int rs, int m)
+{
+    const int nr = conv3x3s1_winograd_nr;
+
+    const float* d0 = d;
+    const float* d1 = d + ds;
+    const float* d2 = d + ds * 2;
+    const float* d3 = d + ds * 3;
+
+    float* r0 = r;
+    float* r1 = r + rs;
+    float* r2 = r + rs * 2;
+    float* r3 = r + rs * 3;
+
+    if (m == 2)
+    {
+        for (int t=0; t<nr; t++)
+        {
+            r0[t] = d0[t] - d2[t];
+            r1[t] = d1[t] + d2[t];
+            r2[t] = d2[t] - d1[t];
+            r3[t] = d1[t] - d3[t];
+        }
+        return;
+    }
+
+    const float* d4 = d + ds * 4;
+    const float* d5 = d + ds * 5;
+
+    float* r4 = r + rs * 4;
+    float* r5 = r + rs * 5;
+
+    if (m == 4)
+    {
+        // 0 =  4 * r00 - 5 * r02 + r04
+        // 1 = -4 * (r01 + r02) + r03 + r04
+        // 2 =  4 * (r01 - r02) - r03 + r04
+        // 3 = -2 * (r01 - r03) - r02 + r04
+        // 4 =  2 * (r01 - r03) - r02 + r04
+        // 5 =  4 * r01 - 5 * r03 + r05
+        for (int t=0; t<nr; t++)
+        {
+            float tmp12a = d3[t] + d4[t] - d2[t] * 4.f;
+            float tmp12b = d1[t] * 4.f;
+            float tmp34a = d4[t] - d2[t];
+            float tmp34b = (d1[t] - d3[t]) * 2.f;
+
+            r0[t] = d0[t] * 4.f - d2[t] * 5.f + d4[t];
+            r1[t] = tmp12a - tmp12b;
+            r2[t] = tmp12a + tmp12b - d3[t] * 2.f;
+            r3[t] = tmp34a - tmp34b;
+            r4[t] = tmp34a + tmp34b;
+            r5[t] = d1[t] * 4.f - d3[t] * 5.f + d5[t];
+        }
+        return;
+    }
+
+    const float* d6 = d + ds * 6;
+    const float* d7 = d + ds * 7;
+
+    float* r6 = r + rs * 6;
+    float* r7 = r + rs * 7;
+
+    // 0 = r00 - r06 + (r04 - r02) * 5.25
+    // 7 = r07 - r01 + (r03 - r05) * 5.25
+    // 1 = (r02 + r06 - r04 * 4.25) + (r01 - r03 * 4.25 + r05)
+    // 2 = (r02 + r06 - r04 * 4.25) - (r01 - r03 * 4.25 + r05)
+    // 3 = (r06 + r02 * 0.25 - r04 * 1.25) + (r01 * 0.5 - r03 * 2.5 + r05 * 2)
+    // 4 = (r06 + r02 * 0.25 - r04 * 1.25) - (r01 * 0.5 - r03 * 2.5 + r05 * 2)
+    // 5 = (r06 + (r02 - r04 * 1.25) * 4) + (r01 * 2 - r03 * 2.5 + r05 * 0.5)
+    // 6 = (r06 + (r02 - r04 * 1.25) * 4) - (r01 * 2 - r03 * 2.5 + r05 * 0.5)
+    for (int t=0; t<nr; t++)
+    {
+        r0[t] = d0[t] - d6[t] + (d4[t] - d2[t]) * 5.25f;
+        r7[t] = d7[t] - d1[t] + (d3[t] - d5[t]) * 5.25f;
+
+        float tmp12a = d2[t] + d6[t] - d4[t] * 4.25f;
+        float tmp12b = d1[t] + d5[t] - d3[t] * 4.25f;
+
+        r1[t] = tmp12a + tmp12b;
+        r2[t] = tmp12a - tmp12b;
+
+        float tmp34a = d6[t] + d2[t] * 0.25f - d4[t] * 1.25f;
+        float tmp34b = d1[t] * 0.5f - d3[t] * 2.5f + d5[t] * 2.f;
+
+        r3[t] = tmp34a + tmp34b;
+        r4[t] = tmp34a - tmp34b;
+
+        float tmp56a = d6[t] + (d2[t] - d4[t] * 1.25f) * 4.f;
+        float tmp56b = d1[t] * 2.f - d3[t] * 2.5f + d5[t] * 0.5f;
+
+        r5[t] = tmp56a + tmp56b;
+        r6[t] = tmp56a - tmp56b;
+    }
+}
+
+// AT, one column of n points into m points for nr tiles
+static inline void conv3x3s1_winograd_at(const float* s, int ss, float* o, int os, int m)
+{
+    const int nr = conv3x3s1_winograd_nr;
+
+    const float* s0 = s;
+    const float* s1 = s + ss;
+    const float* s2 = s + ss * 2;
+    const float* s3 = s + ss * 3;
+
+    float* o0 = o;
+    float* o1 = o + os;
+
+    if (m == 2)
+    {
+        for (int t=0; t<nr; t++)
+        {
+            o0[t] = s0[t] + s1[t] + s2[t];
+            o1[t] = s1[t] - s2[t] - s3[t];
+        }
+        return;
+    }
+
+    const float* s4 = s + ss * 4;
+    const float* s5 = s + ss * 5;
+
+    float* o2 = o + os * 2;
+    float* o3 = o + os * 3;
+
+    if (m == 4)
+    {
+        // 0 = r00 + (r01 + r02) + (r03 + r04)
+        // 1 =       (r01 - r02) + (r03 - r04) * 2
+        // 2 =       (r01 + r02) + (r03 + r04) * 4
+        // 3 = r05 + (r01 - r02) + (r03 - r04) * 8
+        for (int t=0; t<nr; t++)
+        {
+            float tmp02a = s1[t] + s2[t];
+            float tmp02b = s3[t] + s4[t];
+            float tmp13a = s1[t] - s2[t];
+            float tmp13b = s3[t] - s4[t];
+
+            o0[t] = s0[t] + tmp02a + tmp02b;
+            o1[t] = tmp13a + tmp13b * 2.f;
+            o2[t] = tmp02a + tmp02b * 4.f;
+            o3[t] = s5[t] + tmp13a + tmp13b * 8.f;
+        }
+        return;
+    }
+
+    const float* s6 = s + ss * 6;
+    const float* s7 = s + ss * 7;
+
+    float* o4 = o + os * 4;
+    float* o5 = o + os * 5;
+
+    // 0 = r00 + (r01 + r02) + (r03 + r04)      + (r05 + r06) * 32
+    // 1 =       (r01 - r02) + (r03 - r04) * 2  + (r05 - r06) * 16
+    // 2 =       (r01 + r02) + (r03 + r04) * 4  + (r05 + r06) * 8
+    // 3 =       (r01 - r02) + (r03 - r04) * 8  + (r05 - r06) * 4
+    // 4 =       (r01 + r02) + (r03 + r04) * 16 + (r05 + r06) * 2
+    // 5 = r07 + (r01 - r02) + (r03 - r04) * 32 + (r05 - r06)
+    for (int t=0; t<nr; t++)
+    {
+        float tmp024a = s1[t] + s2[t];
+        float tmp135a = s1[t] - s2[t];
+        float tmp024b = s3[t] + s4[t];
+        float tmp135b = s3[t] - s4[t];
+        float tmp024c = s5[t] + s6[t];
+        float tmp135c = s5[t] - s6[t];
+
+        o0[t] = s0[t] + tmp024a + tmp024b + tmp024c * 32.f;
+        o2[t] = tmp024a + tmp024b * 4.f + tmp024c * 8.f;
+        o4[t] = tmp024a + tmp024b * 16.f + tmp024c * 2.f;
+
+        o1[t] = tmp135a + tmp135b * 2.f + tmp135c * 16.f;
+        o3[t] = tmp135a + tmp135b * 8.f + tmp135c * 4.f;
+        o5[t] = s7[t] + tmp135a + tmp135b * 32.f + tmp135c;
+    }
+}
+
+// transform input channel q of one tile block into V
+// V holds n*n tile positions of inch rows of nr tiles
+static void conv3x3s1_winograd_transform_input(const Mat& bottom_blob, float* V, int q, int tile0, int ntile, int tiles_w, int m)
+{
+    const int nr = conv3x3s1_winograd_nr;
+    const int n = m + 2;
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const int inch = bottom_blob.c;
+
+    const float* img = bottom_blob.channel(q);
+
+    // gather n x n input points of every tile, lanes beyond the map are zero
+    float d[64 * conv3x3s1_winograd_nr];
+    for (int t=0; t<nr; t++)
+    {
+        if (t >= ntile)
+        {
+            for (int k=0; k<n*n; k++)
+                d[k * nr + t] = 0.f;
+            continue;
+        }
+
+        const int y0 = (tile0 + t) / tiles_w * m;
+        const int x0 = (tile0 + t) % tiles_w * m;
+
+        for (int i=0; i<n; i++)
+        {
+            const float* r = img + (y0 + i) * w + x0;
+            float* dp = d + i * n * nr + t;
+
+            if (y0 + i >= h)
+            {
+                for (int j=0; j<n; j++)
+                    dp[j * nr] = 0.f;
+                continue;
+            }
+
+            int j = 0;
+            for (; j<n && x0 + j < w; j++)
+                dp[j * nr] = r[j];
+            for (; j<n; j++)
+                dp[j * nr] = 0.f;
+        }
+    }
+
+    // columns, then rows straight into V
+    float tmp[64 * conv3x3s1_winograd_nr];
+    for (int j=0; j<n; j++)
+    {
+        conv3x3s1_winograd_bt(d + j * nr, n * nr, tmp + j * nr, n * nr, m);
+    }
+
+    float* Vq = V + q * nr;
+    for (int i=0; i<n; i++)
+    {
+        conv3x3s1_winograd_bt(tmp + i * n * nr, nr, Vq + i * n * inch * nr, inch * nr, m);
+    }
+}
+
+// M = U * V for tile position p of one tile block
+// M holds n*n tile positions of outch padded to 4 rows of nr tiles
+static void conv3x3s1_winograd_dot(const float* V, float* M, const Mat& kernel_tm, int p, int inch, int outch4)
+{
+    const int nr = conv3x3s1_winograd_nr;
+
+    const float* Vp = V + p * inch * nr;
+    float* Mp = M + p * outch4 * 4 * nr;
+
+    for (int pp=0; pp<outch4; pp++)
+    {
+        const float* kptr = kernel_tm.channel(p).row(pp);
+        const float* vptr = Vp;
+        float* outptr = Mp + pp * 4 * nr;
+
+#if __AVX512F__
+        __m512 _sum00 = _mm512_setzero_ps();
+        __m512 _sum01 = _mm512_setzero_ps();
+        __m512 _sum10 = _mm512_setzero_ps();
+        __m512 _sum11 = _mm512_setzero_ps();
+        __m512 _sum20 = _mm512_setzero_ps();
+        __m512 _sum21 = _mm512_setzero_ps();
+        __m512 _sum30 = _mm512_setzero_ps();
+        __m512 _sum31 = _mm512_setzero_ps();
+
+        for (int q=0; q<inch; q++)
+        {
+            __m512 _v0 = _mm512_loadu_ps(vptr);
+            __m512 _v1 = _mm512_loadu_ps(vptr + 16);
+
+            __m512 _k0 = _mm512_set1_ps(kptr[0]);
+            __m512 _k1 = _mm512_set1_ps(kptr[1]);
+            _sum00 = _mm512_fmadd_ps(_k0, _v0, _sum00);
+            _sum01 = _mm512_fmadd_ps(_k0, _v1, _sum01);
+            _sum10 = _mm512_fmadd_ps(_k1, _v0, _sum10);
+            _sum11 = _mm512_fmadd_ps(_k1, _v1, _sum11);
+
+            __m512 _k2 = _mm512_set1_ps(kptr[2]);
+            __m512 _k3 = _mm512_set1_ps(kptr[3]);
+            _sum20 = _mm512_fmadd_ps(_k2, _v0, _sum20);
+            _sum21 = _mm512_fmadd_ps(_k2, _v1, _sum21);
+            _sum30 = _mm512_fmadd_ps(_k3, _v0, _sum30);
+            _sum31 = _mm512_fmadd_ps(_k3, _v1, _sum31);
+
+            vptr += nr;
+            kptr += 4;
+        }
+
+        _mm512_storeu_ps(outptr, _sum00);
+        _mm512_storeu_ps(outptr + 16, _sum01);
+        _mm512_storeu_ps(outptr + nr, _sum10);
+        _mm512_storeu_ps(outptr + nr + 16, _sum11);
+        _mm512_storeu_ps(outptr + nr * 2, _sum20);
+        _mm512_storeu_ps(outptr + nr * 2 + 16, _sum21);
+        _mm512_storeu_ps(outptr + nr * 3, _sum30);
+        _mm512_storeu_ps(outptr + nr * 3 + 16, _sum31);
+#elif __AVX__
+        __m256 _sum00 = _mm256_setzero_ps();
+        __m256 _sum01 = _mm256_setzero_ps();
+        __m256 _sum10 = _mm256_setzero_ps();
+        __m256 _sum11 = _mm256_setzero_ps();
+        __m256 _sum20 = _mm256_setzero_ps();
+        __m256 _sum21 = _mm256_setzero_ps();
+        __m256 _sum30 = _mm256_setzero_ps();
+        __m256 _sum31 = _mm256_setzero_ps();
+
+        for (int q=0; q<inch; q++)
+        {
+            __m256 _v0 = _mm256_loadu_ps(vptr);
+            __m256 _v1 = _mm256_loadu_ps(vptr + 8);
+
+            __m256 _k0 = _mm256_broadcast_ss(kptr);
+            __m256 _k1 = _mm256_broadcast_ss(kptr + 1);
+            __m256 _k2 = _mm256_broadcast_ss(kptr + 2);
+            __m256 _k3 = _mm256_broadcast_ss(kptr + 3);
+#if __FMA__
+            _sum00 = _mm256_fmadd_ps(_k0, _v0, _sum00);
+            _sum01 = _mm256_fmadd_ps(_k0, _v1, _sum01);
+            _sum10 = _mm256_fmadd_ps(_k1, _v0, _sum10);
+            _sum11 = _mm256_fmadd_ps(_k1, _v1, _sum11);
+            _sum20 = _mm256_fmadd_ps(_k2, _v0, _sum20);
+            _sum21 = _mm256_fmadd_ps(_k2, _v1, _sum21);
+            _sum30 = _mm256_fmadd_ps(_k3, _v0, _sum30);
+            _sum31 = _mm256_fmadd_ps(_k3, _v1, _sum31);
+#else
+            _sum00 = _mm256_add_ps(_mm256_mul_ps(_k0, _v0), _sum00);
+            _sum01 = _mm256_add_ps(_mm256_mul_ps(_k0, _v1), _sum01);
+            _sum10 = _mm256_add_ps(_mm256_mul_ps(_k1, _v0), _sum10);
+            _sum11 = _mm256_add_ps(_mm256_mul_ps(_k1, _v1), _sum11);
+            _sum20 = _mm256_add_ps(_mm256_mul_ps(_k2, _v0), _sum20);
+            _sum21 = _mm256_add_ps(_mm256_mul_ps(_k2, _v1), _sum21);
+            _sum30 = _mm256_add_ps(_mm256_mul_ps(_k3, _v0), _sum30);
+            _sum31 = _mm256_add_ps(_mm256_mul_ps(_k3, _v1), _sum31);
+#endif // __FMA__
+
+            vptr += nr;
+            kptr += 4;
+        }
+
+        _mm256_storeu_ps(outptr, _sum00);
+        _mm256_storeu_ps(outptr + 8, _sum01);
+        _mm256_storeu_ps(outptr + nr, _sum10);
+        _mm256_storeu_ps(outptr + nr + 8, _sum11);
+        _mm256_storeu_ps(outptr + nr * 2, _sum20);
+        _mm256_storeu_ps(outptr + nr * 2 + 8, _sum21);
+        _mm256_storeu_ps(outptr + nr * 3, _sum30);
+        _mm256_storeu_ps(outptr + nr * 3 + 8, _sum31);
+#elif __SSE2__
+        __m128 _sum00 = _mm_setzero_ps();
+        __m128 _sum01 = _mm_setzero_ps();
+        __m128 _sum10 = _mm_setzero_ps();
+        __m128 _sum11 = _mm_setzero_ps();
+        __m128 _sum20 = _mm_setzero_ps();
+        __m128 _sum21 = _mm_setzero_ps();
+        __m128 _sum30 = _mm_setzero_ps();
+        __m128 _sum31 = _mm_setzero_ps();
+
+        for (int q=0; q<inch; q++)
+        {
+            __m128 _v0 = _mm_loadu_ps(vptr);
+            __m128 _v1 = _mm_loadu_ps(vptr + 4);
+
+            __m128 _k0 = _mm_load1_ps(kptr);
+            __m128 _k1 = _mm_load1_ps(kptr + 1);
+            __m128 _k2 = _mm_load1_ps(kptr + 2);
+            __m128 _k3 = _mm_load1_ps(kptr + 3);
+
+            _sum00 = _mm_add_ps(_mm_mul_ps(_k0, _v0), _sum00);
+            _sum01 = _mm_add_ps(_mm_mul_ps(_k0, _v1), _sum01);
+            _sum10 = _mm_add_ps(_mm_mul_ps(_k1, _v0), _sum10);
+            _sum11 = _mm_add_ps(_mm_mul_ps(_k1, _v1), _sum11);
+            _sum20 = _mm_add_ps(_mm_mul_ps(_k2, _v0), _sum20);
+            _sum21 = _mm_add_ps(_mm_mul_ps(_k2, _v1), _sum21);
+            _sum30 = _mm_add_ps(_mm_mul_ps(_k3, _v0), _sum30);
+            _sum31 = _mm_add_ps(_mm_mul_ps(_k3, _v1), _sum31);
+
+            vptr += nr;
+            kptr += 4;
+        }
+
+        _mm_storeu_ps(outptr, _sum00);
+        _mm_storeu_ps(outptr + 4, _sum01);
+        _mm_storeu_ps(outptr + nr, _sum10);
+        _mm_storeu_ps(outptr + nr + 4, _sum11);
+        _mm_storeu_ps(outptr + nr * 2, _sum20);
+        _mm_storeu_ps(outptr + nr * 2 + 4, _sum21);
+        _mm_storeu_ps(outptr + nr * 3, _sum30);
+        _mm_storeu_ps(outptr + nr * 3 + 4, _sum31);
+#elif __ARM_NEON
+        float32x4_t _sum00 = vdupq_n_f32(0.f);
+        float32x4_t _sum01 = vdupq_n_f32(0.f);
+        float32x4_t _sum10 = vdupq_n_f32(0.f);
+        float32x4_t _sum11 = vdupq_n_f32(0.f);
+        float32x4_t _sum20 = vdupq_n_f32(0.f);
+        float32x4_t _sum21 = vdupq_n_f32(0.f);
+        float32x4_t _sum30 = vdupq_n_f32(0.f);
+        float32x4_t _sum31 = vdupq_n_f32(0.f);
+
+        for (int q=0; q<inch; q++)
+        {
+            float32x4_t _v0 = vld1q_f32(vptr);
+            float32x4_t _v1 = vld1q_f32(vptr + 4);
+            float32x4_t _k = vld1q_f32(kptr);
+#if __aarch64__
+            _sum00 = vfmaq_laneq_f32(_sum00, _v0, _k, 0);
+            _sum01 = vfmaq_laneq_f32(_sum01, _v1, _k, 0);
+            _sum10 = vfmaq_laneq_f32(_sum10, _v0, _k, 1);
+            _sum11 = vfmaq_laneq_f32(_sum11, _v1, _k, 1);
+            _sum20 = vfmaq_laneq_f32(_sum20, _v0, _k, 2);
+            _sum21 = vfmaq_laneq_f32(_sum21, _v1, _k, 2);
+            _sum30 = vfmaq_laneq_f32(_sum30, _v0, _k, 3);
+            _sum31 = vfmaq_laneq_f32(_sum31, _v1, _k, 3);
+#else
+            float32x2_t _k01 = vget_low_f32(_k);
+            float32x2_t _k23 = vget_high_f32(_k);
+            _sum00 = vmlaq_lane_f32(_sum00, _v0, _k01, 0);
+            _sum01 = vmlaq_lane_f32(_sum01, _v1, _k01, 0);
+            _sum10 = vmlaq_lane_f32(_sum10, _v0, _k01, 1);
+            _sum11 = vmlaq_lane_f32(_sum11, _v1, _k01, 1);
+            _sum20 = vmlaq_lane_f32(_sum20, _v0, _k23, 0);
+            _sum21 = vmlaq_lane_f32(_sum21, _v1, _k23, 0);
+            _sum30 = vmlaq_lane_f32(_sum30, _v0, _k23, 1);
+            _sum31 = vmlaq_lane_f32(_sum31, _v1, _k23, 1);
+#endif // __aarch64__
+
+            vptr += nr;
+            kptr += 4;
+        }
+
+        vst1q_f32(outptr, _sum00);
+        vst1q_f32(outptr + 4, _sum01);
+        vst1q_f32(outptr + nr, _sum10);
+        vst1q_f32(outptr + nr + 4, _sum11);
+        vst1q_f32(outptr + nr * 2, _sum20);
+        vst1q_f32(outptr + nr * 2 + 4, _sum21);
+        vst1q_f32(outptr + nr * 3, _sum30);
+        vst1q_f32(outptr + nr * 3 + 4, _sum31);
+#else
+        float sum[4][conv3x3s1_winograd_nr] = {{0.f}};
+
+        for (int q=0; q<inch; q++)
+        {
+            for (int k=0; k<4; k++)
+            {
+                for (int t=0; t<nr; t++)
+                {
+                    sum[k][t] += kptr[k] * vptr[t];
+                }
+            }
+
+            vptr += nr;
+            kptr += 4;
+        }
+
+        for (int k=0; k<4; k++)
+        {
+            for (int t=0; t<nr; t++)
+            {
+                outptr[k * nr + t] = sum[k][t];
+            }
+        }
+#endif // __AVX512F__
+    }
+}
+
+// transform output channel p of one tile block out of M, add bias and store
+// the epilogue, if any, runs on each output row segment right after it is stored
+static void conv3x3s1_winograd_transform_output(const float* M, Mat& top_blob, float bias0, const ConvolutionEpilogue* epilogue, int p, int tile0, int ntile, int tiles_w, int m)
+{
+    const int nr = conv3x3s1_winograd_nr;
+    const int n = m + 2;
+
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int outch4 = (top_blob.c + 3) / 4;
+
+    const float* Mp = M + p * nr;
+
+    // columns, then rows
+    float tmp[48 * conv3x3s1_winograd_nr];
+    for (int j=0; j<n; j++)
+    {
+        conv3x3s1_winograd_at(Mp + j * outch4 * 4 * nr, n * outch4 * 4 * nr, tmp + j * nr, n * nr, m);
+    }
+
+    float o[36 * conv3x3s1_winograd_nr];
+    for (int i=0; i<m; i++)
+    {
+        conv3x3s1_winograd_at(tmp + i * n * nr, nr, o + i * m * nr, nr, m);
+    }
+
+    float* outptr = top_blob.channel(p);
+
+    for (int t=0; t<ntile; t++)
+    {
+        const int y0 = (tile0 + t) / tiles_w * m;
+        const int x0 = (tile0 + t) % tiles_w * m;
+
+        for (int i=0; i<m && y0 + i < outh; i++)
+        {
+            float* r = outptr + (y0 + i) * outw + x0;
+            const float* op = o + i * m * nr + t;
+
+            for (int j=0; j<m && x0 + j < outw; j++)
+            {
+                r[j] = op[j * nr] + bias0;
+            }
+
+            if (epilogue)
+            {
+                epilogue->apply(top_blob, p, (y0 + i) * outw + x0, std::min(m, outw - x0));
+            }
+        }
+    }
+}
+
+// bottom_blob is the bordered input, top_blob is created by the caller
+static void conv3x3s1_winograd(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int m, const ConvolutionEpilogue* epilogue, const Option& opt)
+{
+    const int nr = conv3x3s1_winograd_nr;
+    const int n = m + 2;
+
+    int inch = bottom_blob.c;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+    const int outch4 = (outch + 3) / 4;
+
+    const float* bias = _bias;
+
+    const int tiles_w = (outw + m - 1) / m;
+    const int tiles_h = (outh + m - 1) / m;
+    const int tiles = tiles_w * tiles_h;
+    const int nblocks = (tiles + nr - 1) / nr;
+
+    // per tile block buffers
+    const int vsize = n * n * inch * nr;
+    const int msize = n * n * outch4 * 4 * nr;
+
+    if (nblocks >= opt.num_threads * 4)
+    {
+        // enough tile blocks for every thread
+        // each thread runs whole blocks, the buffers stay in cache
+        const int nslots = opt.num_threads;
+
+        Mat buffer(vsize + msize, 1, nslots, 4u, opt.workspace_allocator);
+        if (buffer.empty())
+            return;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int s=0; s<nslots; s++)
+        {
+            float* V = buffer.channel(s);
+            float* M = V + vsize;
+
+            for (int b=s; b<nblocks; b+=nslots)
+            {
+                const int tile0 = b * nr;
+                const int ntile = std::min(nr, tiles - tile0);
+
+                for (int q=0; q<inch; q++)
+                {
+                    conv3x3s1_winograd_transform_input(bottom_blob, V, q, tile0, ntile, tiles_w, m);
+                }
+
+                for (int r=0; r<n*n; r++)
+                {
+                    conv3x3s1_winograd_dot(V, M, kernel_tm, r, inch, outch4);
+                }
+
+                for (int p=0; p<outch; p++)
+                {
+                    conv3x3s1_winograd_transform_output(M, top_blob, bias ? bias[p] : 0.f, epilogue, p, tile0, ntile, tiles_w, m);
+                }
+            }
+        }
+
+        return;
+    }
+
+    // few tile blocks on a small feature map
+    // keep all blocks and split each stage over blocks and channels or positions
+    Mat buffer(vsize + msize, 1, nblocks, 4u, opt.workspace_allocator);
+    if (buffer.empty())
+        return;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int bq=0; bq<nblocks*inch; bq++)
+    {
+        const int b = bq / inch;
+        const int q = bq % inch;
+
+        float* V = buffer.channel(b);
+
+        conv3x3s1_winograd_transform_input(bottom_blob, V, q, b * nr, std::min(nr, tiles - b * nr), tiles_w, m);
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int br=0; br<nblocks*n*n; br++)
+    {
+        const int b = br / (n * n);
+        const int r = br % (n * n);
+
+        float* V = buffer.channel(b);
+        float* M = V + vsize;
+
+        conv3x3s1_winograd_dot(V, M, kernel_tm, r, inch, outch4);
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int bp=0; bp<nblocks*outch; bp++)
+    {
+        const int b = bp / outch;
+        const int p = bp % outch;
+
+        const float* V = buffer.channel(b);
+        const float* M = V + vsize;
+
+        conv3x3s1_winograd_transform_output(M, top_blob, bias ? bias[p] : 0.f, epilogue, p, b * nr, std::min(nr, tiles - b * nr), tiles_w, m);
+    }
+}
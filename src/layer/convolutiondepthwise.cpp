@@ -73,6 +73,18 @@ int ConvolutionDepthWise::load_model(const ModelBin& mb)
         weight_data_int8_scales = mb.load(group, 1);
         bottom_blob_int8_scales = mb.load(1, 1);
 
+        // extend per group scales to per output channel
+        const int num_output_g = num_output / group;
+        Mat weight_data_int8_scales_g = weight_data_int8_scales;
+        weight_data_int8_scales = Mat(num_output);
+        for (int g=0; g<group; g++)
+        {
+            for (int p=0; p<num_output_g; p++)
+            {
+                weight_data_int8_scales[g * num_output_g + p] = weight_data_int8_scales_g[g];
+            }
+        }
+
         float bottom_blob_int8_scale = bottom_blob_int8_scales[0];
         bottom_blob_int8_scales = Mat(group);
         bottom_blob_int8_scales.fill(bottom_blob_int8_scale);
@@ -84,13 +96,23 @@ int ConvolutionDepthWise::load_model(const ModelBin& mb)
 
         // extend group if only one provided
         float weight_data_int8_scale = weight_data_int8_scales[0];
-        weight_data_int8_scales = Mat(group);
+        weight_data_int8_scales = Mat(num_output);
         weight_data_int8_scales.fill(weight_data_int8_scale);
 
         float bottom_blob_int8_scale = bottom_blob_int8_scales[0];
         bottom_blob_int8_scales = Mat(group);
         bottom_blob_int8_scales.fill(bottom_blob_int8_scale);
     }
+    else if (int8_scale_term == 3)
+    {
+        // per output channel
+        weight_data_int8_scales = mb.load(num_output, 1);
+        bottom_blob_int8_scales = mb.load(1, 1);
+
+        float bottom_blob_int8_scale = bottom_blob_int8_scales[0];
+        bottom_blob_int8_scales = Mat(group);
+        bottom_blob_int8_scales.fill(bottom_blob_int8_scale);
+    }
 
     return 0;
 }
@@ -121,14 +143,14 @@ int ConvolutionDepthWise::create_pipeline(const Option& opt)
         if (int8_weight_data.empty())
             return -100;
 
-        const int weight_data_size_g = weight_data_size / group;
+        const int weight_data_size_output = weight_data_size / num_output;
 
-        for (int g=0; g<group; g++)
+        for (int n=0; n<num_output; n++)
         {
             Layer* op = ncnn::create_layer(ncnn::LayerType::Quantize);
 
             ncnn::ParamDict pd;
-            pd.set(0, weight_data_int8_scales[g]);// scale
+            pd.set(0, weight_data_int8_scales[n]);// scale
 
             op->load_param(pd);
 
@@ -137,9 +159,9 @@ int ConvolutionDepthWise::create_pipeline(const Option& opt)
             ncnn::Option opt;
             opt.blob_allocator = int8_weight_data.allocator;
 
-            const Mat weight_data_g = weight_data.range(weight_data_size_g * g, weight_data_size_g);
-            Mat int8_weight_data_g = int8_weight_data.range(weight_data_size_g * g, weight_data_size_g);
-            op->forward(weight_data_g, int8_weight_data_g, opt);
+            const Mat weight_data_n = weight_data.range(weight_data_size_output * n, weight_data_size_output);
+            Mat int8_weight_data_n = int8_weight_data.range(weight_data_size_output * n, weight_data_size_output);
+            op->forward(weight_data_n, int8_weight_data_n, opt);
 
             delete op;
         }
@@ -150,7 +172,7 @@ int ConvolutionDepthWise::create_pipeline(const Option& opt)
     if (use_int8_inference)
     {
         quantize_ops.resize(group);
-        dequantize_ops.resize(group);
+        dequantize_ops.resize(num_output);
 
         for (int g=0; g<group; g++)
         {
@@ -164,29 +186,33 @@ int ConvolutionDepthWise::create_pipeline(const Option& opt)
             quantize_ops[g]->create_pipeline(opt_cpu);
         }
 
-        for (int g=0; g<group; g++)
+        const int num_output_g = num_output / group;
+
+        for (int n=0; n<num_output; n++)
         {
-            dequantize_ops[g] = ncnn::create_layer(ncnn::LayerType::Dequantize);
+            dequantize_ops[n] = ncnn::create_layer(ncnn::LayerType::Dequantize);
+
+            const int g = n / num_output_g;
 
             float top_rescale = 1.f;
-            if (weight_data_int8_scales[g] == 0)
+            if (weight_data_int8_scales[n] == 0)
                 top_rescale = 0;
             else
-                top_rescale = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[g]);
+                top_rescale = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[n]);
 
             ncnn::ParamDict pd;
             pd.set(0, top_rescale);// scale
             pd.set(1, bias_term);// bias_term
             pd.set(2, 1);// bias_data_size
 
-            dequantize_ops[g]->load_param(pd);
+            dequantize_ops[n]->load_param(pd);
 
             ncnn::Mat weights[1];
-            weights[0] = bias_data.range(g, 1);
+            weights[0] = bias_data.range(n, 1);
 
-            dequantize_ops[g]->load_model(ModelBinFromMatArray(weights));
+            dequantize_ops[n]->load_model(ModelBinFromMatArray(weights));
 
-            dequantize_ops[g]->create_pipeline(opt_cpu);
+            dequantize_ops[n]->create_pipeline(opt_cpu);
 
             dequantize_scales.push_back(top_rescale);
         }
@@ -235,21 +261,25 @@ int ConvolutionDepthWise::create_requantize_op(void)
         return -1;
     }
 
-    requantize_ops.resize(group);
-    for (int g=0; g<group; g++)
+    const int num_output_g = num_output / group;
+
+    requantize_ops.resize(num_output);
+    for (int n=0; n<num_output; n++)
     {
-        requantize_ops[g] = ncnn::create_layer(ncnn::LayerType::Requantize);
+        requantize_ops[n] = ncnn::create_layer(ncnn::LayerType::Requantize);
+
+        const int g = n / num_output_g;
 
         float scale_in = 1.f;
         float scale_out = 1.f;
 
-        if (weight_data_int8_scales[g] == 0)
+        if (weight_data_int8_scales[n] == 0)
         {
             scale_in = 0;
         }
         else
         {
-            scale_in = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[g]);
+            scale_in = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[n]);
         }
 
         scale_out = top_blob_int8_scale;
@@ -260,12 +290,12 @@ int ConvolutionDepthWise::create_requantize_op(void)
         pd.set(2, bias_term);  // bias_term
         pd.set(3, 1);          // bias_data_size
 
-        requantize_ops[g]->load_param(pd);
+        requantize_ops[n]->load_param(pd);
 
         ncnn::Mat weights[1];
-        weights[0] = bias_data.range(g, 1);
+        weights[0] = bias_data.range(n, 1);
 
-        requantize_ops[g]->load_model(ModelBinFromMatArray(weights));
+        requantize_ops[n]->load_model(ModelBinFromMatArray(weights));
 
         requantize_scales.push_back(scale_in);
         requantize_scales.push_back(scale_out);
@@ -274,6 +304,72 @@ int ConvolutionDepthWise::create_requantize_op(void)
     return 0;
 }
 
+static void activation_inplace(Mat& top_blob, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    if (activation_type == 0)
+        return;
+
+    int channels = top_blob.c;
+    int size = top_blob.w * top_blob.h;
+
+    if (top_blob.elemsize == 1u)
+    {
+        // requantized output, relu is the only activation kept in int8
+        if (activation_type != 1)
+            return;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            signed char* ptr = top_blob.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                if (ptr[i] < 0)
+                    ptr[i] = 0;
+            }
+        }
+
+        return;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = top_blob.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            float v = ptr[i];
+
+            if (activation_type == 1)
+            {
+                v = std::max(v, 0.f);
+            }
+            else if (activation_type == 2)
+            {
+                float slope = activation_params[0];
+                v = v > 0.f ? v : v * slope;
+            }
+            else if (activation_type == 3)
+            {
+                float min = activation_params[0];
+                float max = activation_params[1];
+                if (v < min)
+                    v = min;
+                if (v > max)
+                    v = max;
+            }
+            else if (activation_type == 4)
+            {
+                v = 1.f / (1.f + exp(-v));
+            }
+
+            ptr[i] = v;
+        }
+    }
+}
+
 int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // convolv with NxN kernel
@@ -390,7 +486,7 @@ int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const O
                 #pragma omp parallel for num_threads(opt.num_threads)
                 for (int g=0; g<group; g++)
                 {
-                    int* outptr = top_blob.channel(g);
+                    int* outptr = top_blob_tm.channel(g);
                     const signed char* kptr = (const signed char*)weight_data + maxk * g;
                     const Mat m = bottom_blob_bordered.channel(g);
 
@@ -441,7 +537,7 @@ int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const O
                 {
                     for (int p=0; p<num_output_g; p++)
                     {
-                        int* outptr = top_blob.channel(g * num_output_g + p);
+                        int* outptr = top_blob_tm.channel(g * num_output_g + p);
                         const signed char* weight_data_ptr = (const signed char*)weight_data + maxk * channels_g * num_output_g * g;
 
                         for (int i = 0; i < outh; i++)
@@ -478,15 +574,15 @@ int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const O
 
                 // requantize, reverse scale inplace
                 #pragma omp parallel for num_threads(opt.num_threads)
-                for (int g=0; g<group; g++)
+                for (int p=0; p<num_output; p++)
                 {
-                    ncnn::Option opt_g = opt;
-                    opt_g.num_threads = 1;
-                    opt_g.blob_allocator = top_blob.allocator;
+                    ncnn::Option opt_p = opt;
+                    opt_p.num_threads = 1;
+                    opt_p.blob_allocator = top_blob.allocator;
 
-                    Mat top_blob_tm_g = top_blob_tm.channel_range(num_output_g * g, num_output_g);
-                    Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
-                    requantize_ops[g]->forward(top_blob_tm_g, top_blob_g, opt_g);                    
+                    Mat top_blob_tm_p = top_blob_tm.channel_range(p, 1);
+                    Mat top_blob_p = top_blob.channel_range(p, 1);
+                    requantize_ops[p]->forward(top_blob_tm_p, top_blob_p, opt_p);
                 }
             }            
         }
@@ -589,18 +685,20 @@ int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const O
 
                 // dequantize, reverse scale inplace
                 #pragma omp parallel for num_threads(opt.num_threads)
-                for (int g=0; g<group; g++)
+                for (int p=0; p<num_output; p++)
                 {
-                    ncnn::Option opt_g = opt;
-                    opt_g.num_threads = 1;
-                    opt_g.blob_allocator = top_blob.allocator;
+                    ncnn::Option opt_p = opt;
+                    opt_p.num_threads = 1;
+                    opt_p.blob_allocator = top_blob.allocator;
 
-                    Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
-                    dequantize_ops[g]->forward_inplace(top_blob_g, opt_g);
+                    Mat top_blob_p = top_blob.channel_range(p, 1);
+                    dequantize_ops[p]->forward_inplace(top_blob_p, opt_p);
                 }
             }
         }
 
+        activation_inplace(top_blob, activation_type, activation_params, opt);
+
         return 0;
     }
 
@@ -746,4 +844,51 @@ int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const O
     return 0;
 }
 
+int ConvolutionDepthWise::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    top_shapes.resize(1);
+
+    // flattened blob, implement as InnerProduct
+    if (bottom_shape.dims == 1 && kernel_w == 1 && kernel_h == 1)
+    {
+        int num_input = weight_data_size / num_output;
+        if (bottom_shape.w == num_input)
+        {
+            top_shapes[0] = Mat(num_output, (void*)0);
+            return 0;
+        }
+    }
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    if (pad_w > 0 || pad_h > 0)
+    {
+        w += pad_w * 2;
+        h += pad_h * 2;
+    }
+    else if (pad_w == -233 && pad_h == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    top_shapes[0] = Mat(outw, outh, num_output, (void*)0, use_int8_requantize ? (size_t)1u : (size_t)4u);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -35,6 +35,8 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
 public:
     // param
     int num_output;
@@ -51,6 +53,7 @@ public:
     int weight_data_size;
     int group;
 
+    // 0=none 1=per group 2=shared 3=per output channel weight scales
     int int8_scale_term;
 
     // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid
@@ -61,7 +64,9 @@ public:
     Mat weight_data;
     Mat bias_data;
 
+    // per output channel
     Mat weight_data_int8_scales;
+    // per group
     Mat bottom_blob_int8_scales;
     float top_blob_int8_scale;
 
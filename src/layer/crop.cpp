@@ -115,6 +115,8 @@ int Crop::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
         top_blob = bottom_blob_sliced.clone();
         if (top_blob.empty())
             return -100;
+
+        return 0;
     }
 
     int top = hoffset;
@@ -122,7 +124,7 @@ int Crop::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
 
     if (dims == 2)
     {
-        top_blob.create(_outh, _outh, elemsize, opt.blob_allocator);
+        top_blob.create(_outw, _outh, elemsize, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -134,12 +136,12 @@ int Crop::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
 
     if (dims == 3)
     {
-        top_blob.create(_outw, _outh, channels, elemsize, opt.blob_allocator);
+        top_blob.create(_outw, _outh, _outc, elemsize, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
         #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q=0; q<channels; q++)
+        for (int q=0; q<_outc; q++)
         {
             const Mat m = bottom_blob_sliced.channel(q);
             Mat borderm = top_blob.channel(q);
@@ -213,7 +215,7 @@ int Crop::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
 
     if (dims == 2)
     {
-        top_blob.create(_outh, _outh, elemsize, opt.blob_allocator);
+        top_blob.create(_outw, _outh, elemsize, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -225,12 +227,12 @@ int Crop::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
 
     if (dims == 3)
     {
-        top_blob.create(_outw, _outh, channels, elemsize, opt.blob_allocator);
+        top_blob.create(_outw, _outh, _outc, elemsize, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
         #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q=0; q<channels; q++)
+        for (int q=0; q<_outc; q++)
         {
             const Mat m = bottom_blob_sliced.channel(q);
             Mat borderm = top_blob.channel(q);
@@ -245,4 +247,64 @@ int Crop::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     return 0;
 }
 
+int Crop::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int channels = bottom_shape.c;
+    int dims = bottom_shape.dims;
+
+    int _outw;
+    int _outh;
+    int _outc;
+
+    if (bottom_shapes.size() == 2)
+    {
+        // offsets and sizes read from the reference blob data
+        if (woffset == -233 && hoffset == -233 && coffset == -233)
+            return -1;
+
+        const Mat& reference_shape = bottom_shapes[1];
+
+        _outw = reference_shape.w;
+        _outh = reference_shape.h;
+        _outc = reference_shape.dims == 3 ? reference_shape.c : channels;
+    }
+    else
+    {
+        if (outw == -233)
+            _outw = w - woffset;
+        else if (outw == -234)
+            _outw = w - 1 - woffset;
+        else
+            _outw = std::min(outw, w - woffset);
+
+        if (outh == -233)
+            _outh = h - hoffset;
+        else if (outh == -234)
+            _outh = h - 1 - hoffset;
+        else
+            _outh = std::min(outh, h - hoffset);
+
+        if (outc == -233)
+            _outc = channels - coffset;
+        else if (outc == -234)
+            _outc = channels - 1 - coffset;
+        else
+            _outc = std::min(outc, channels - coffset);
+    }
+
+    top_shapes.resize(1);
+    if (dims == 1)
+        top_shapes[0] = Mat(_outw, (void*)0, bottom_shape.elemsize);
+    else if (dims == 2)
+        top_shapes[0] = Mat(_outw, _outh, (void*)0, bottom_shape.elemsize);
+    else
+        top_shapes[0] = Mat(_outw, _outh, _outc, (void*)0, bottom_shape.elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -215,4 +215,26 @@ int Deconvolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option&
     return 0;
 }
 
+int Deconvolution::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    int outw = (bottom_shape.w - 1) * stride_w + kernel_extent_w;
+    int outh = (bottom_shape.h - 1) * stride_h + kernel_extent_h;
+
+    if (pad_w > 0 || pad_h > 0)
+    {
+        outw -= pad_w * 2;
+        outh -= pad_h * 2;
+    }
+
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(outw, outh, num_output, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "eltwise.h"
+#include <math.h>
 #include <algorithm>
 
 namespace ncnn {
@@ -23,6 +24,8 @@ Eltwise::Eltwise()
 {
     one_blob_only = false;
     support_inplace = false;// TODO inplace reduction
+    use_int8_inference = false;
+    top_blob_int8_scale = 0.f;
 }
 
 int Eltwise::load_param(const ParamDict& pd)
@@ -33,8 +36,131 @@ int Eltwise::load_param(const ParamDict& pd)
     return 0;
 }
 
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -128) return -128;
+    return (signed char)int32;
+}
+
+template<typename T>
+static void eltwise_accumulate(const T* ptr, float* outptr, int size, float scale, int op_type, bool first)
+{
+    if (first)
+    {
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = ptr[i] * scale;
+        }
+    }
+    else if (op_type == Eltwise::Operation_PROD)
+    {
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] *= ptr[i] * scale;
+        }
+    }
+    else if (op_type == Eltwise::Operation_SUM)
+    {
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] += ptr[i] * scale;
+        }
+    }
+    else if (op_type == Eltwise::Operation_MAX)
+    {
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = std::max(outptr[i], ptr[i] * scale);
+        }
+    }
+}
+
+int Eltwise::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    // dequantize on the fly, accumulate in float32 and requantize the top
+
+    for (size_t b=0; b<bottom_blobs.size(); b++)
+    {
+        if (bottom_blobs[b].packing == 1)
+            continue;
+
+        // float32 bottom from a packed layer
+        std::vector<Mat> bottom_blobs_unpacked(bottom_blobs.size());
+        for (size_t i=0; i<bottom_blobs.size(); i++)
+        {
+            convert_packing(bottom_blobs[i], bottom_blobs_unpacked[i], 1, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blobs_unpacked[i].empty())
+                return -100;
+        }
+
+        return forward_int8(bottom_blobs_unpacked, top_blobs, opt);
+    }
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    int size = w * h;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(w, h, channels, top_blob_int8_scale == 0.f ? (size_t)4u : (size_t)1u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    Mat sum_blob = top_blob;
+    if (top_blob_int8_scale != 0.f)
+    {
+        sum_blob.create(w, h, channels, (size_t)4u, opt.workspace_allocator);
+        if (sum_blob.empty())
+            return -100;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* sumptr = sum_blob.channel(q);
+
+        for (size_t b=0; b<bottom_blobs.size(); b++)
+        {
+            const Mat& m = bottom_blobs[b];
+
+            float scale = 1.f;
+            if (op_type == Operation_SUM && coeffs.w != 0)
+                scale = coeffs[b];
+
+            if (m.elemsize == 1u)
+            {
+                scale /= bottom_blob_int8_scales[b];
+
+                eltwise_accumulate<signed char>(m.channel(q), sumptr, size, scale, op_type, b == 0);
+            }
+            else
+            {
+                eltwise_accumulate<float>(m.channel(q), sumptr, size, scale, op_type, b == 0);
+            }
+        }
+
+        if (top_blob_int8_scale != 0.f)
+        {
+            signed char* outptr = top_blob.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                outptr[i] = float2int8(sumptr[i] * top_blob_int8_scale);
+            }
+        }
+    }
+
+    return 0;
+}
+
 int Eltwise::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (use_int8_inference)
+        return forward_int8(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     int w = bottom_blob.w;
     int h = bottom_blob.h;
@@ -189,4 +315,12 @@ int Eltwise::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
     return 0;
 }
 
+int Eltwise::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shapes[0].shape();
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -88,4 +88,12 @@ int Embed::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) con
     return 0;
 }
 
+int Embed::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(num_output, (int)bottom_shapes[0].total(), (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -76,4 +76,48 @@ int ExpandDims::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt
     return 0;
 }
 
+int ExpandDims::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int dims = bottom_shape.dims;
+    size_t elemsize = bottom_shape.elemsize;
+
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shape.shape();
+
+    if (dims == 1)
+    {
+        if (expand_w)
+        {
+            if (expand_h)
+                top_shapes[0] = Mat(1, 1, w, (void*)0, elemsize);
+            else if (expand_c)
+                top_shapes[0] = Mat(1, w, 1, (void*)0, elemsize);
+            else
+                top_shapes[0] = Mat(1, w, (void*)0, elemsize);
+        }
+        else if (expand_h)
+        {
+            if (expand_c)
+                top_shapes[0] = Mat(w, 1, 1, (void*)0, elemsize);
+            else
+                top_shapes[0] = Mat(w, 1, (void*)0, elemsize);
+        }
+    }
+    else if (dims == 2)
+    {
+        if (expand_w)
+            top_shapes[0] = Mat(1, w, h, (void*)0, elemsize);
+        else if (expand_h)
+            top_shapes[0] = Mat(w, 1, h, (void*)0, elemsize);
+        else if (expand_c)
+            top_shapes[0] = Mat(w, h, 1, (void*)0, elemsize);
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
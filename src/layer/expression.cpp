@@ -0,0 +1,608 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "expression.h"
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include "binaryop.h"
+#include "unaryop.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Expression)
+
+Expression::Expression()
+{
+    one_blob_only = false;
+    support_inplace = false;
+
+    register_count = 0;
+}
+
+template<typename Op>
+static void unary(float* dst, const float* a, int n)
+{
+    Op op;
+    for (int i=0; i<n; i++)
+    {
+        dst[i] = op(a[i]);
+    }
+}
+
+template<typename Op>
+static void binary(float* dst, const float* a, const float* b, int n)
+{
+    Op op;
+    for (int i=0; i<n; i++)
+    {
+        dst[i] = op(a[i], b[i]);
+    }
+}
+
+template<typename Op>
+static void binary_scalar(float* dst, const float* a, float b, int n)
+{
+    Op op;
+    for (int i=0; i<n; i++)
+    {
+        dst[i] = op(a[i], b);
+    }
+}
+
+template<typename T>
+struct unary_op_abs {
+    T operator() (const T& x) const { return fabs(x); }
+};
+
+template<typename T>
+struct unary_op_neg {
+    T operator() (const T& x) const { return -x; }
+};
+
+template<typename T>
+struct unary_op_floor {
+    T operator() (const T& x) const { return floor(x); }
+};
+
+template<typename T>
+struct unary_op_ceil {
+    T operator() (const T& x) const { return ceil(x); }
+};
+
+template<typename T>
+struct unary_op_square {
+    T operator() (const T& x) const { return x * x; }
+};
+
+template<typename T>
+struct unary_op_sqrt {
+    T operator() (const T& x) const { return sqrt(x); }
+};
+
+template<typename T>
+struct unary_op_rsqrt {
+    T operator() (const T& x) const { return 1.f / sqrt(x); }
+};
+
+template<typename T>
+struct unary_op_exp {
+    T operator() (const T& x) const { return exp(x); }
+};
+
+template<typename T>
+struct unary_op_log {
+    T operator() (const T& x) const { return log(x); }
+};
+
+template<typename T>
+struct unary_op_sin {
+    T operator() (const T& x) const { return sin(x); }
+};
+
+template<typename T>
+struct unary_op_cos {
+    T operator() (const T& x) const { return cos(x); }
+};
+
+template<typename T>
+struct unary_op_tan {
+    T operator() (const T& x) const { return tan(x); }
+};
+
+template<typename T>
+struct unary_op_asin {
+    T operator() (const T& x) const { return asin(x); }
+};
+
+template<typename T>
+struct unary_op_acos {
+    T operator() (const T& x) const { return acos(x); }
+};
+
+template<typename T>
+struct unary_op_atan {
+    T operator() (const T& x) const { return atan(x); }
+};
+
+template<typename T>
+struct unary_op_reciprocal {
+    T operator() (const T& x) const { return 1.f / x; }
+};
+
+template<typename T>
+struct unary_op_sigmoid {
+    T operator() (const T& x) const { return 1.f / (1.f + exp(-x)); }
+};
+
+template<typename T>
+struct unary_op_tanh {
+    T operator() (const T& x) const { return tanh(x); }
+};
+
+template<typename T>
+struct binary_op_max {
+    T operator() (const T& x, const T& y) const { return std::max(x, y); }
+};
+
+template<typename T>
+struct binary_op_min {
+    T operator() (const T& x, const T& y) const { return std::min(x, y); }
+};
+
+template<typename T>
+struct binary_op_pow {
+    T operator() (const T& x, const T& y) const { return pow(x, y); }
+};
+
+template<typename T>
+struct binary_op_rsub {
+    T operator() (const T& x, const T& y) const { return y - x; }
+};
+
+template<typename T>
+struct binary_op_rdiv {
+    T operator() (const T& x, const T& y) const { return y / x; }
+};
+
+static void unary_op(int op_type, float* dst, const float* a, int n)
+{
+    if (op_type == UnaryOp::Operation_ABS)
+        unary< unary_op_abs<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_NEG)
+        unary< unary_op_neg<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_FLOOR)
+        unary< unary_op_floor<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_CEIL)
+        unary< unary_op_ceil<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_SQUARE)
+        unary< unary_op_square<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_SQRT)
+        unary< unary_op_sqrt<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_RSQRT)
+        unary< unary_op_rsqrt<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_EXP)
+        unary< unary_op_exp<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_LOG)
+        unary< unary_op_log<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_SIN)
+        unary< unary_op_sin<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_COS)
+        unary< unary_op_cos<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_TAN)
+        unary< unary_op_tan<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_ASIN)
+        unary< unary_op_asin<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_ACOS)
+        unary< unary_op_acos<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_ATAN)
+        unary< unary_op_atan<float> >(dst, a, n);
+
+    if (op_type == UnaryOp::Operation_RECIPROCAL)
+        unary< unary_op_reciprocal<float> >(dst, a, n);
+}
+
+static void binary_op(int op_type, float* dst, const float* a, const float* b, int n)
+{
+    if (op_type == BinaryOp::Operation_ADD)
+        binary< std::plus<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_SUB)
+        binary< std::minus<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_MUL)
+        binary< std::multiplies<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_DIV)
+        binary< std::divides<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_MAX)
+        binary< binary_op_max<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_MIN)
+        binary< binary_op_min<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_POW)
+        binary< binary_op_pow<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_RSUB)
+        binary< binary_op_rsub<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_RDIV)
+        binary< binary_op_rdiv<float> >(dst, a, b, n);
+}
+
+static void binary_op_scalar(int op_type, float* dst, const float* a, float b, int n)
+{
+    if (op_type == BinaryOp::Operation_ADD)
+        binary_scalar< std::plus<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_SUB)
+        binary_scalar< std::minus<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_MUL)
+        binary_scalar< std::multiplies<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_DIV)
+        binary_scalar< std::divides<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_MAX)
+        binary_scalar< binary_op_max<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_MIN)
+        binary_scalar< binary_op_min<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_POW)
+        binary_scalar< binary_op_pow<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_RSUB)
+        binary_scalar< binary_op_rsub<float> >(dst, a, b, n);
+
+    if (op_type == BinaryOp::Operation_RDIV)
+        binary_scalar< binary_op_rdiv<float> >(dst, a, b, n);
+}
+
+void Expression::run_instruction(const Instruction& ins, float* dst, const float* a, const float* b, int n) const
+{
+    if (ins.op == Instruction_UNARY)
+    {
+        unary_op(ins.type, dst, a, n);
+    }
+    else if (ins.op == Instruction_BINARY)
+    {
+        binary_op(ins.type, dst, a, b, n);
+    }
+    else if (ins.op == Instruction_SCALAR)
+    {
+        binary_op_scalar(ins.type, dst, a, ins.p0, n);
+    }
+    else if (ins.op == Instruction_RELU)
+    {
+        const float slope = ins.p0;
+        if (slope == 0.f)
+        {
+            for (int i=0; i<n; i++)
+            {
+                dst[i] = std::max(a[i], 0.f);
+            }
+        }
+        else
+        {
+            for (int i=0; i<n; i++)
+            {
+                dst[i] = a[i] < 0.f ? a[i] * slope : a[i];
+            }
+        }
+    }
+    else if (ins.op == Instruction_CLIP)
+    {
+        const float min = ins.p0;
+        const float max = ins.p1;
+        for (int i=0; i<n; i++)
+        {
+            dst[i] = std::min(std::max(a[i], min), max);
+        }
+    }
+    else if (ins.op == Instruction_SIGMOID)
+    {
+        unary< unary_op_sigmoid<float> >(dst, a, n);
+    }
+    else if (ins.op == Instruction_TANH)
+    {
+        unary< unary_op_tanh<float> >(dst, a, n);
+    }
+}
+
+int Expression::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    // the largest bottom is the shape of the result
+    const int bottom_count = bottom_blobs.size();
+
+    int ref = 0;
+    for (int j=1; j<bottom_count; j++)
+    {
+        const Mat& m = bottom_blobs[j];
+        if ((size_t)m.w * m.h * m.c > (size_t)bottom_blobs[ref].w * bottom_blobs[ref].h * bottom_blobs[ref].c)
+            ref = j;
+    }
+
+    const int dims = bottom_blobs[ref].dims;
+    const int w = bottom_blobs[ref].w;
+    const int h = bottom_blobs[ref].h;
+    const int channels = bottom_blobs[ref].c;
+
+    // scale data is per row and per element in lower dims
+    for (size_t k=0; k<constants.size(); k++)
+    {
+        if (dims != 3 || constants[k].w != channels)
+            return forward_layers(bottom_blobs, top_blobs, opt);
+    }
+
+    // 0 = same shape, 1 = one value per channel, 2 = one value
+    std::vector<int> broadcast(bottom_count);
+    bool broadcast_cube = false;
+    for (int j=0; j<bottom_count; j++)
+    {
+        const Mat& m = bottom_blobs[j];
+        if (m.elemsize != 4u || m.packing != 1)
+            return forward_layers(bottom_blobs, top_blobs, opt);
+
+        if (m.dims == dims && m.w == w && m.h == h && m.c == channels)
+        {
+            broadcast[j] = 0;
+        }
+        else if (m.dims == 1 && m.w == 1)
+        {
+            broadcast[j] = 2;
+        }
+        else if (dims == 3 && m.dims == 1 && m.w == channels)
+        {
+            broadcast[j] = 1;
+        }
+        else if (dims == 3 && m.dims == 3 && m.w == 1 && m.h == 1 && m.c == channels)
+        {
+            broadcast[j] = 1;
+            broadcast_cube = true;
+        }
+        else
+        {
+            // row broadcast and friends
+            return forward_layers(bottom_blobs, top_blobs, opt);
+        }
+    }
+
+    // which instructions compute one value per channel
+    const int instruction_count = program.size();
+    std::vector<int> uniform(instruction_count);
+    std::vector<int> uniform_a(instruction_count, 0);
+    std::vector<int> uniform_b(instruction_count, 0);
+    {
+        int register_uniform[max_register_count] = { 0 };
+        for (int k=0; k<instruction_count; k++)
+        {
+            const Instruction& ins = program[k];
+
+            if (ins.op == Instruction_LOAD)
+            {
+                uniform[k] = broadcast[ins.a] != 0;
+            }
+            else if (ins.op == Instruction_CONSTANT)
+            {
+                uniform[k] = 1;
+            }
+            else if (ins.op == Instruction_BINARY)
+            {
+                uniform_a[k] = register_uniform[ins.a];
+                uniform_b[k] = register_uniform[ins.b];
+
+                // binaryop keeps the shape of a 1x1xc left operand
+                if (uniform_a[k] && !uniform_b[k] && broadcast_cube)
+                    return forward_layers(bottom_blobs, top_blobs, opt);
+
+                uniform[k] = uniform_a[k] && uniform_b[k];
+            }
+            else
+            {
+                uniform_a[k] = register_uniform[ins.a];
+                uniform[k] = uniform_a[k];
+            }
+
+            register_uniform[ins.dst] = uniform[k];
+        }
+    }
+
+    Mat& top_blob = top_blobs[0];
+    if (dims == 1)
+        top_blob.create(w, 4u, opt.blob_allocator);
+    if (dims == 2)
+        top_blob.create(w, h, 4u, opt.blob_allocator);
+    if (dims == 3)
+        top_blob.create(w, h, channels, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int size = dims == 3 ? w * h : (int)top_blob.total();
+    const int outer = dims == 3 ? channels : 1;
+    const int last = instruction_count - 1;
+    const int result = program[last].dst;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<outer; q++)
+    {
+        float registers[max_register_count][tile_size];
+        float broadcast_a[tile_size];
+        float broadcast_b[tile_size];
+
+        // loads point at the bottoms, everything else at the registers
+        const float* values[max_register_count];
+
+        float* outptr = dims == 3 ? top_blob.channel(q) : (float*)top_blob;
+
+        for (int i=0; i<size; i+=tile_size)
+        {
+            const int n = std::min((int)tile_size, size - i);
+
+            for (int k=0; k<instruction_count; k++)
+            {
+                const Instruction& ins = program[k];
+
+                if (ins.op == Instruction_LOAD)
+                {
+                    const Mat& m = bottom_blobs[ins.a];
+                    if (broadcast[ins.a] == 0)
+                        values[ins.dst] = (dims == 3 ? (const float*)m.channel(q) : (const float*)m) + i;
+                    else if (broadcast[ins.a] == 2)
+                        values[ins.dst] = m;
+                    else
+                        values[ins.dst] = m.dims == 3 ? (const float*)m.channel(q) : (const float*)m + q;
+                    continue;
+                }
+
+                if (ins.op == Instruction_CONSTANT)
+                {
+                    values[ins.dst] = (const float*)constants[ins.a] + q;
+                    continue;
+                }
+
+                const float* a = values[ins.a];
+                const float* b = ins.op == Instruction_BINARY ? values[ins.b] : 0;
+
+                if (uniform[k])
+                {
+                    run_instruction(ins, registers[ins.dst], a, b, 1);
+                    values[ins.dst] = registers[ins.dst];
+                    continue;
+                }
+
+                // spread a per channel operand over the tile
+                if (uniform_a[k])
+                {
+                    std::fill(broadcast_a, broadcast_a + n, a[0]);
+                    a = broadcast_a;
+                }
+                if (uniform_b[k])
+                {
+                    std::fill(broadcast_b, broadcast_b + n, b[0]);
+                    b = broadcast_b;
+                }
+
+                // the last instruction writes the top directly
+                float* dst = k == last ? outptr + i : registers[ins.dst];
+                run_instruction(ins, dst, a, b, n);
+                values[ins.dst] = dst;
+            }
+
+            if (values[result] != outptr + i)
+            {
+                if (uniform[last])
+                    std::fill(outptr + i, outptr + i + n, values[result][0]);
+                else
+                    std::copy(values[result], values[result] + n, outptr + i);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int Expression::forward_layers(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const int bottom_count = bottom_blobs.size();
+
+    std::vector<Mat> blobs(bottom_count + fused_layers.size());
+    for (int j=0; j<bottom_count; j++)
+    {
+        blobs[j] = bottom_blobs[j];
+    }
+
+    for (size_t k=0; k<fused_layers.size(); k++)
+    {
+        const Layer* layer = fused_layers[k];
+        const std::vector<int>& layer_bottoms = fused_layer_bottoms[k];
+        Mat& top_blob = blobs[bottom_count + k];
+
+        int ret = 0;
+        if (layer->one_blob_only && layer->support_inplace)
+        {
+            // the blob between two fused layers is ours to modify
+            if (layer_bottoms[0] >= bottom_count)
+                top_blob = blobs[layer_bottoms[0]];
+            else
+                top_blob = blobs[layer_bottoms[0]].clone(opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;
+
+            ret = layer->forward_inplace(top_blob, opt);
+        }
+        else if (layer->one_blob_only)
+        {
+            ret = layer->forward(blobs[layer_bottoms[0]], top_blob, opt);
+        }
+        else
+        {
+            std::vector<Mat> bottoms(layer_bottoms.size());
+            for (size_t j=0; j<layer_bottoms.size(); j++)
+            {
+                bottoms[j] = blobs[layer_bottoms[j]];
+            }
+
+            std::vector<Mat> tops(1);
+            ret = layer->forward(bottoms, tops, opt);
+            top_blob = tops[0];
+        }
+
+        if (ret != 0)
+            return ret;
+    }
+
+    top_blobs[0] = blobs.back();
+
+    return 0;
+}
+
+int Expression::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    // the full size bottom, the others broadcast to it
+    size_t max_total = 0;
+    int k = 0;
+    for (size_t i=0; i<bottom_shapes.size(); i++)
+    {
+        if (bottom_shapes[i].total() > max_total)
+        {
+            max_total = bottom_shapes[i].total();
+            k = i;
+        }
+    }
+
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shapes[k].shape();
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,83 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_EXPRESSION_H
+#define LAYER_EXPRESSION_H
+
+#include "layer.h"
+
+namespace ncnn {
+
+// a chain of elementwise layers evaluated in one pass over the blob
+// the program is compiled by Net::fuse_network, there is no param or model to load
+class Expression : public Layer
+{
+public:
+    Expression();
+
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
+    enum {
+        Instruction_LOAD        = 0,// dst = bottom a
+        Instruction_CONSTANT    = 1,// dst = constants[a] of the channel
+        Instruction_UNARY       = 2,// dst = unary(a)
+        Instruction_BINARY      = 3,// dst = binary(a, b)
+        Instruction_SCALAR      = 4,// dst = binary(a, p0)
+        Instruction_RELU        = 5,// dst = relu(a), p0 slope
+        Instruction_CLIP        = 6,// dst = clip(a, p0, p1)
+        Instruction_SIGMOID     = 7,// dst = sigmoid(a)
+        Instruction_TANH        = 8 // dst = tanh(a)
+    };
+
+    struct Instruction
+    {
+        int op;
+        // UnaryOp or BinaryOp operation type
+        int type;
+        int dst;
+        int a;
+        int b;
+        float p0;
+        float p1;
+    };
+
+    // registers are tiles of this many floats
+    enum { tile_size = 256 };
+    enum { max_register_count = 4 };
+
+protected:
+    // dst = ins(regs), n elements
+    virtual void run_instruction(const Instruction& ins, float* dst, const float* a, const float* b, int n) const;
+
+    int forward_layers(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+public:
+    std::vector<Instruction> program;
+    int register_count;
+
+    // per channel constants, indexed by Instruction_CONSTANT
+    std::vector<Mat> constants;
+
+    // the layers the program was compiled from, owned by the net
+    // they run one by one when the bottoms do not broadcast the way the program can
+    std::vector<const Layer*> fused_layers;
+    // bottoms of every fused layer, 0 .. bottoms - 1 are ours and fused layer k produces bottoms + k
+    std::vector< std::vector<int> > fused_layer_bottoms;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_EXPRESSION_H
@@ -32,6 +32,16 @@ int Flatten::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     size_t elemsize = bottom_blob.elemsize;
     int size = w * h;
 
+    if (bottom_blob.dims < 3 || bottom_blob.cstep == (size_t)size)
+    {
+        // channels back to back already
+        top_blob = bottom_blob.reshape(size * channels, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        return 0;
+    }
+
     top_blob.create(size * channels, elemsize, opt.blob_allocator);
     if (top_blob.empty())
         return -100;
@@ -51,4 +61,14 @@ int Flatten::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     return 0;
 }
 
+int Flatten::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(bottom_shape.w * bottom_shape.h * bottom_shape.c, (void*)0, bottom_shape.elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "innerproduct.h"
+#include <math.h>
 #include <algorithm>
 #include "layer_type.h"
 
@@ -125,37 +126,86 @@ int InnerProduct::create_pipeline(const Option& opt)
     // runtime quantize the weight data
     if (weight_data_is_float32 && use_int8_inference)
     {
-        // quantize weight to int8
-        Mat int8_weight_data(weight_data_size, (size_t)1u);
-        if (int8_weight_data.empty())
-            return -100;
-
-        const int weight_data_size_output = weight_data_size / num_output;
+        int ret = quantize_weight_data(opt_cpu);
+        if (ret != 0)
+            return ret;
+    }
 
-        for (int n=0; n<num_output; n++)
+    // weight only low precision storage, converted back to fp32 in forward
+    if (weight_data_is_float32 && !use_int8_inference && !opt.use_vulkan_compute)
+    {
+        if (opt.use_weight_int8_storage)
         {
-            Layer* op = ncnn::create_layer(ncnn::LayerType::Quantize);
+            const int weight_data_size_output = weight_data_size / num_output;
 
-            ncnn::ParamDict pd;
-            pd.set(0, weight_data_int8_scales[n]);// scale
+            // symmetric scale from the absmax of each output channel
+            weight_data_int8_scales.create(num_output);
+            if (weight_data_int8_scales.empty())
+                return -100;
 
-            op->load_param(pd);
+            for (int n=0; n<num_output; n++)
+            {
+                const float* ptr = (const float*)weight_data + weight_data_size_output * n;
 
-            op->create_pipeline(opt_cpu);
+                float absmax = 0.f;
+                for (int i=0; i<weight_data_size_output; i++)
+                {
+                    absmax = std::max(absmax, (float)fabs(ptr[i]));
+                }
 
-            ncnn::Option opt;
-            opt.blob_allocator = int8_weight_data.allocator;
+                weight_data_int8_scales[n] = absmax == 0.f ? 0.f : 127 / absmax;
+            }
 
-            const Mat weight_data_n = weight_data.range(weight_data_size_output * n, weight_data_size_output);
-            Mat int8_weight_data_n = int8_weight_data.range(weight_data_size_output * n, weight_data_size_output);
-            op->forward(weight_data_n, int8_weight_data_n, opt);
+            int ret = quantize_weight_data(opt_cpu);
+            if (ret != 0)
+                return ret;
+        }
+        else if (opt.use_weight_fp16_storage)
+        {
+            Mat weight_data_fp16;
+            cast_float32_to_float16(weight_data, weight_data_fp16, 0, opt.num_threads);
+            if (weight_data_fp16.empty())
+                return -100;
 
-            delete op;
+            weight_data = weight_data_fp16;
         }
+    }
+
+    return 0;
+}
+
+int InnerProduct::quantize_weight_data(const Option& opt)
+{
+    // quantize weight to int8
+    Mat int8_weight_data(weight_data_size, (size_t)1u);
+    if (int8_weight_data.empty())
+        return -100;
+
+    const int weight_data_size_output = weight_data_size / num_output;
 
-        weight_data = int8_weight_data;
+    for (int n=0; n<num_output; n++)
+    {
+        Layer* op = ncnn::create_layer(ncnn::LayerType::Quantize);
+
+        ncnn::ParamDict pd;
+        pd.set(0, weight_data_int8_scales[n]);// scale
+
+        op->load_param(pd);
+
+        op->create_pipeline(opt);
+
+        ncnn::Option opt_q = opt;
+        opt_q.blob_allocator = int8_weight_data.allocator;
+
+        const Mat weight_data_n = weight_data.range(weight_data_size_output * n, weight_data_size_output);
+        Mat int8_weight_data_n = int8_weight_data.range(weight_data_size_output * n, weight_data_size_output);
+        op->forward(weight_data_n, int8_weight_data_n, opt_q);
+
+        delete op;
     }
 
+    weight_data = int8_weight_data;
+
     return 0;
 }
 
@@ -181,6 +231,34 @@ int InnerProduct::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+static inline float activation_ss(float v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        v = std::max(v, 0.f);
+    }
+    else if (activation_type == 2)
+    {
+        float slope = activation_params[0];
+        v = v > 0.f ? v : v * slope;
+    }
+    else if (activation_type == 3)
+    {
+        float min = activation_params[0];
+        float max = activation_params[1];
+        if (v < min)
+            v = min;
+        if (v > max)
+            v = max;
+    }
+    else if (activation_type == 4)
+    {
+        v = 1.f / (1.f + exp(-v));
+    }
+
+    return v;
+}
+
 int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int w = bottom_blob.w;
@@ -189,23 +267,26 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
     size_t elemsize = bottom_blob.elemsize;
     int size = w * h;
 
-    top_blob.create(num_output, elemsize, opt.blob_allocator);
-    if (top_blob.empty())
-        return -100;
-
     if (use_int8_inference)
     {
-        Mat bottom_blob_int8;
-        bottom_blob_int8.create(w, h, channels, (size_t)1u, opt.workspace_allocator);
-        if (bottom_blob_int8.empty())
+        top_blob.create(num_output, (size_t)4u, opt.blob_allocator);
+        if (top_blob.empty())
             return -100;
 
-        // quantize, scale and round to nearest
+        Mat bottom_blob_int8 = bottom_blob;
+        if (elemsize != 1)
         {
-            ncnn::Option opt_g = opt;
-            opt_g.blob_allocator = bottom_blob_int8.allocator;
+            bottom_blob_int8.create(w, h, channels, (size_t)1u, opt.workspace_allocator);
+            if (bottom_blob_int8.empty())
+                return -100;
 
-            quantize->forward(bottom_blob, bottom_blob_int8, opt_g);
+            // quantize, scale and round to nearest
+            {
+                ncnn::Option opt_g = opt;
+                opt_g.blob_allocator = bottom_blob_int8.allocator;
+
+                quantize->forward(bottom_blob, bottom_blob_int8, opt_g);
+            }
         }
 
         // num_output
@@ -242,9 +323,75 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
                 top_rescale = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[p]);
 
             if (bias_term)
-                out_f32[p] = out_s32[p] * top_rescale + bias_data[p];
+                out_f32[p] = activation_ss(out_s32[p] * top_rescale + bias_data[p], activation_type, activation_params);
             else
-                out_f32[p] = out_s32[p] * top_rescale;
+                out_f32[p] = activation_ss(out_s32[p] * top_rescale, activation_type, activation_params);
+        }
+
+        return 0;
+    }
+
+    top_blob.create(num_output, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    if (weight_data.elemsize == (size_t)2u)
+    {
+        // fp16 weight storage
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p=0; p<num_output; p++)
+        {
+            float sum = 0.f;
+
+            if (bias_term)
+                sum = bias_data[p];
+
+            // channels
+            for (int q=0; q<channels; q++)
+            {
+                const unsigned short* w = (const unsigned short*)weight_data + size * channels * p + size * q;
+                const float* m = bottom_blob.channel(q);
+
+                for (int i = 0; i < size; i++)
+                {
+                    sum += m[i] * float16_to_float32(w[i]);
+                }
+            }
+
+            top_blob[p] = activation_ss(sum, activation_type, activation_params);
+        }
+
+        return 0;
+    }
+
+    if (weight_data.elemsize == (size_t)1u)
+    {
+        // int8 weight storage, the scale is applied once per output
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p=0; p<num_output; p++)
+        {
+            float sum = 0.f;
+
+            // channels
+            for (int q=0; q<channels; q++)
+            {
+                const signed char* w = (const signed char*)weight_data + size * channels * p + size * q;
+                const float* m = bottom_blob.channel(q);
+
+                for (int i = 0; i < size; i++)
+                {
+                    sum += m[i] * w[i];
+                }
+            }
+
+            float scale_out = weight_data_int8_scales[p] == 0.f ? 0.f : 1.f / weight_data_int8_scales[p];
+
+            sum *= scale_out;
+
+            if (bias_term)
+                sum += bias_data[p];
+
+            top_blob[p] = activation_ss(sum, activation_type, activation_params);
         }
 
         return 0;
@@ -271,33 +418,113 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
             }
         }
 
-        if (activation_type == 1)
-        {
-            sum = std::max(sum, 0.f);
-        }
-        else if (activation_type == 2)
-        {
-            float slope = activation_params[0];
-            sum = sum > 0.f ? sum : sum * slope;
-        }
-        else if (activation_type == 3)
+        top_blob[p] = activation_ss(sum, activation_type, activation_params);
+    }
+
+    return 0;
+}
+
+int InnerProduct::forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const int batch = bottom_blobs.size();
+
+    int w = bottom_blobs[0].w;
+    int h = bottom_blobs[0].h;
+    int channels = bottom_blobs[0].c;
+    size_t elemsize = bottom_blobs[0].elemsize;
+    int size = w * h;
+
+    bool same_shape = true;
+    for (int n=1; n<batch; n++)
+    {
+        const Mat& m = bottom_blobs[n];
+        if (m.w != w || m.h != h || m.c != channels || m.elemsize != elemsize)
+            same_shape = false;
+    }
+
+    if (use_int8_inference || elemsize != 4u || weight_data.elemsize != 4u || !same_shape)
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+    top_blobs.resize(batch);
+    for (int n=0; n<batch; n++)
+    {
+        top_blobs[n].create(num_output, elemsize, opt.blob_allocator);
+        if (top_blobs[n].empty())
+            return -100;
+    }
+
+    // each weight row is loaded once for every 4 samples
+    const int nn_batch = batch >> 2;
+    const int remain_batch_start = nn_batch << 2;
+
+    // num_output
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        const float bias = bias_term ? bias_data[p] : 0.f;
+
+        for (int nn=0; nn<nn_batch; nn++)
         {
-            float min = activation_params[0];
-            float max = activation_params[1];
-            if (sum < min)
-                sum = min;
-            if (sum > max)
-                sum = max;
+            int n = nn * 4;
+
+            float sum0 = bias;
+            float sum1 = bias;
+            float sum2 = bias;
+            float sum3 = bias;
+
+            // channels
+            for (int q=0; q<channels; q++)
+            {
+                const float* w = (const float*)weight_data + size * channels * p + size * q;
+                const float* m0 = bottom_blobs[n].channel(q);
+                const float* m1 = bottom_blobs[n+1].channel(q);
+                const float* m2 = bottom_blobs[n+2].channel(q);
+                const float* m3 = bottom_blobs[n+3].channel(q);
+
+                for (int i = 0; i < size; i++)
+                {
+                    sum0 += m0[i] * w[i];
+                    sum1 += m1[i] * w[i];
+                    sum2 += m2[i] * w[i];
+                    sum3 += m3[i] * w[i];
+                }
+            }
+
+            top_blobs[n][p] = activation_ss(sum0, activation_type, activation_params);
+            top_blobs[n+1][p] = activation_ss(sum1, activation_type, activation_params);
+            top_blobs[n+2][p] = activation_ss(sum2, activation_type, activation_params);
+            top_blobs[n+3][p] = activation_ss(sum3, activation_type, activation_params);
         }
-        else if (activation_type == 4)
+
+        for (int n=remain_batch_start; n<batch; n++)
         {
-            sum = 1.f / (1.f + exp(-sum));
-        }
+            float sum = bias;
+
+            // channels
+            for (int q=0; q<channels; q++)
+            {
+                const float* w = (const float*)weight_data + size * channels * p + size * q;
+                const float* m = bottom_blobs[n].channel(q);
 
-        top_blob[p] = sum;
+                for (int i = 0; i < size; i++)
+                {
+                    sum += m[i] * w[i];
+                }
+            }
+
+            top_blobs[n][p] = activation_ss(sum, activation_type, activation_params);
+        }
     }
 
     return 0;
 }
 
+int InnerProduct::infer_shape(const std::vector<Mat>& /*bottom_shapes*/, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(num_output, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -33,6 +33,14 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    virtual int forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
+protected:
+    // quantize weight_data to int8 in place with weight_data_int8_scales
+    int quantize_weight_data(const Option& opt);
+
 public:
     // param
     int num_output;
@@ -47,9 +55,11 @@ public:
     Mat activation_params;
 
     // model
+    // fp32, or fp16 / int8 with use_weight_fp16_storage / use_weight_int8_storage
     Mat weight_data;
     Mat bias_data;
 
+    // per output channel
     Mat weight_data_int8_scales;
     float bottom_blob_int8_scale;
 
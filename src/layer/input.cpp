@@ -39,4 +39,20 @@ int Input::forward_inplace(Mat& /*bottom_top_blob*/, const Option& /*opt*/) cons
     return 0;
 }
 
+int Input::infer_shape(const std::vector<Mat>& /*bottom_shapes*/, std::vector<Mat>& top_shapes) const
+{
+    // shape from param, unknown if not given
+    top_shapes.resize(1);
+    if (w != 0 && h != 0 && c != 0)
+        top_shapes[0] = Mat(w, h, c, (void*)0);
+    else if (w != 0 && h != 0)
+        top_shapes[0] = Mat(w, h, (void*)0);
+    else if (w != 0)
+        top_shapes[0] = Mat(w, (void*)0);
+    else
+        return -1;
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -509,4 +509,35 @@ int Interp::forward(const Mat &bottom_blob, Mat &top_blob, const Option& opt) co
     }
 }
 
+int Interp::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int h = bottom_shape.h;
+    int w = bottom_shape.w;
+    int c = bottom_shape.c;
+
+    int oh = output_height;
+    int ow = output_width;
+    if (bottom_shape.dims == 1)
+    {
+        h = 1;
+        w = 1;
+        c = bottom_shape.w;
+    }
+    if (oh == 0 || ow == 0)
+    {
+        oh = h * height_scale;
+        ow = w * width_scale;
+    }
+
+    top_shapes.resize(1);
+    if (oh == h && ow == w)
+        top_shapes[0] = bottom_shape.shape();
+    else
+        top_shapes[0] = Mat(ow, oh, c, (void*)0, bottom_shape.elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
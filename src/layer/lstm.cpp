@@ -181,4 +181,13 @@ int LSTM::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     return 0;
 }
 
+int LSTM::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    // one output per timestep
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(num_output, bottom_shapes[0].h, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
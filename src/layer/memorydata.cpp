@@ -68,4 +68,19 @@ int MemoryData::forward(const std::vector<Mat>& /*bottom_blobs*/, std::vector<Ma
     return 0;
 }
 
+int MemoryData::infer_shape(const std::vector<Mat>& /*bottom_shapes*/, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    if (c != 0)
+        top_shapes[0] = Mat(w, h, c, (void*)0);
+    else if (h != 0)
+        top_shapes[0] = Mat(w, h, (void*)0);
+    else if (w != 0)
+        top_shapes[0] = Mat(w, (void*)0);
+    else // 0 0 0
+        top_shapes[0] = Mat(1, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -175,4 +175,12 @@ int MVN::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
     return 0;
 }
 
+int MVN::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shapes[0].shape();
+
+    return 0;
+}
+
 } // namespace ncnn
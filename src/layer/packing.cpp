@@ -102,7 +102,7 @@ int Packing::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
         if (top_blob.empty())
             return -100;
 
-        #pragma omp parallel for
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int i = 0; i < outh; i++)
         {
             unsigned char* outptr = (unsigned char*)top_blob + i * w * out_elemsize;
@@ -140,7 +140,59 @@ int Packing::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
         if (top_blob.empty())
             return -100;
 
-        #pragma omp parallel for
+        const int size = w * h;
+
+        // interleave four float channels, the common cpu case
+        if (lane_size == 4 && packing == 1 && out_packing == 4 && channels % 4 == 0)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q = 0; q < outc; q++)
+            {
+                const float* r0 = bottom_blob.channel(q * 4);
+                const float* r1 = bottom_blob.channel(q * 4 + 1);
+                const float* r2 = bottom_blob.channel(q * 4 + 2);
+                const float* r3 = bottom_blob.channel(q * 4 + 3);
+                float* outptr = top_blob.channel(q);
+
+                for (int i = 0; i < size; i++)
+                {
+                    outptr[0] = r0[i];
+                    outptr[1] = r1[i];
+                    outptr[2] = r2[i];
+                    outptr[3] = r3[i];
+                    outptr += 4;
+                }
+            }
+
+            return 0;
+        }
+
+        // split into four float channels
+        if (lane_size == 4 && packing == 4 && out_packing == 1)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q = 0; q < channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+                float* outptr0 = top_blob.channel(q * 4);
+                float* outptr1 = top_blob.channel(q * 4 + 1);
+                float* outptr2 = top_blob.channel(q * 4 + 2);
+                float* outptr3 = top_blob.channel(q * 4 + 3);
+
+                for (int i = 0; i < size; i++)
+                {
+                    outptr0[i] = ptr[0];
+                    outptr1[i] = ptr[1];
+                    outptr2[i] = ptr[2];
+                    outptr3[i] = ptr[3];
+                    ptr += 4;
+                }
+            }
+
+            return 0;
+        }
+
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int q = 0; q < outc; q++)
         {
             Mat out = top_blob.channel(q);
@@ -177,4 +229,24 @@ int Packing::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     return 0;
 }
 
+int Packing::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int packing = bottom_shape.packing;
+    size_t out_elemsize = bottom_shape.elemsize / packing * out_packing;
+
+    top_shapes.resize(1);
+    if (packing == out_packing)
+        top_shapes[0] = bottom_shape.shape();
+    else if (bottom_shape.dims == 1)
+        top_shapes[0] = Mat((bottom_shape.w * packing + out_packing - 1) / out_packing, (void*)0, out_elemsize, out_packing);
+    else if (bottom_shape.dims == 2)
+        top_shapes[0] = Mat(bottom_shape.w, (bottom_shape.h * packing + out_packing - 1) / out_packing, (void*)0, out_elemsize, out_packing);
+    else
+        top_shapes[0] = Mat(bottom_shape.w, bottom_shape.h, (bottom_shape.c * packing + out_packing - 1) / out_packing, (void*)0, out_elemsize, out_packing);
+
+    return 0;
+}
+
 } // namespace ncnn
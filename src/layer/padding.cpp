@@ -41,6 +41,12 @@ int Padding::load_param(const ParamDict& pd)
     return 0;
 }
 
+// one element of a pack4 float blob
+struct pack4_float
+{
+    float v[4];
+};
+
 template<typename T>
 static void copy_make_border_image(const Mat& src, Mat& dst, int top, int left, int type, T v)
 {
@@ -235,10 +241,14 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
 
     if (dims == 3)
     {
-        top_blob.create(outw, outh, channels, elemsize, opt.blob_allocator);
+        int packing = bottom_blob.packing;
+
+        top_blob.create(outw, outh, channels, elemsize, packing, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
+        pack4_float value4 = {{value, value, value, value}};
+
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int q=0; q<channels; q++)
         {
@@ -249,6 +259,8 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
                 copy_make_border_image<signed char>(m, borderm, top, left, type, value);
             else if (elemsize == 4)
                 copy_make_border_image<float>(m, borderm, top, left, type, value);
+            else if (packing == 4 && elemsize == 16)
+                copy_make_border_image<pack4_float>(m, borderm, top, left, type, value4);
         }
 
         return 0;
@@ -345,4 +357,26 @@ int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
     return 0;
 }
 
+int Padding::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    // paddings read from the second bottom data
+    if (bottom_shapes.size() == 2)
+        return -1;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int outw = bottom_shape.w + left + right;
+    int outh = bottom_shape.h + top + bottom;
+
+    top_shapes.resize(1);
+    if (bottom_shape.dims == 1)
+        top_shapes[0] = Mat(outw, (void*)0, bottom_shape.elemsize);
+    else if (bottom_shape.dims == 2)
+        top_shapes[0] = Mat(outw, outh, (void*)0, bottom_shape.elemsize);
+    else
+        top_shapes[0] = Mat(outw, outh, bottom_shape.c, (void*)0, bottom_shape.elemsize, bottom_shape.packing);
+
+    return 0;
+}
+
 } // namespace ncnn
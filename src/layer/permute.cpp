@@ -31,7 +31,49 @@ int Permute::load_param(const ParamDict& pd)
     return 0;
 }
 
+// channels back to back when dense, the flattened top is then a view
+static void create_top(Mat& top_blob, int w, int h, int c, size_t elemsize, bool dense, Allocator* allocator)
+{
+    if (!dense)
+    {
+        top_blob.create(w, h, c, elemsize, allocator);
+        return;
+    }
+
+    top_blob.create(w * h * c, elemsize, allocator);
+    if (top_blob.empty())
+        return;
+
+    top_blob.dims = 3;
+    top_blob.w = w;
+    top_blob.h = h;
+    top_blob.c = c;
+    top_blob.cstep = w * h;
+}
+
 int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (fused_reshapes.empty())
+        return forward_permute(bottom_blob, top_blob, false, opt);
+
+    int ret = forward_permute(bottom_blob, top_blob, true, opt);
+    if (ret != 0)
+        return ret;
+
+    for (size_t i=0; i<fused_reshapes.size(); i++)
+    {
+        Mat reshaped;
+        ret = fused_reshapes[i]->forward(top_blob, reshaped, opt);
+        if (ret != 0)
+            return ret;
+
+        top_blob = reshaped;
+    }
+
+    return 0;
+}
+
+int Permute::forward_permute(const Mat& bottom_blob, Mat& top_blob, bool dense, const Option& opt) const
 {
     int w = bottom_blob.w;
     int h = bottom_blob.h;
@@ -85,7 +127,7 @@ int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     }
     else if (order_type == 1)
     {
-        top_blob.create(h, w, channels, elemsize, opt.blob_allocator);
+        create_top(top_blob, h, w, channels, elemsize, dense, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -106,7 +148,7 @@ int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     }
     else if (order_type == 2)
     {
-        top_blob.create(w, channels, h, elemsize, opt.blob_allocator);
+        create_top(top_blob, w, channels, h, elemsize, dense, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -128,7 +170,7 @@ int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     }
     else if (order_type == 3)
     {
-        top_blob.create(channels, w, h, elemsize, opt.blob_allocator);
+        create_top(top_blob, channels, w, h, elemsize, dense, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -150,7 +192,7 @@ int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     }
     else if (order_type == 4)
     {
-        top_blob.create(h, channels, w, elemsize, opt.blob_allocator);
+        create_top(top_blob, h, channels, w, elemsize, dense, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -172,7 +214,7 @@ int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     }
     else if (order_type == 5)
     {
-        top_blob.create(channels, h, w, elemsize, opt.blob_allocator);
+        create_top(top_blob, channels, h, w, elemsize, dense, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
@@ -196,4 +238,43 @@ int Permute::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     return 0;
 }
 
+int Permute::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int channels = bottom_shape.c;
+    size_t elemsize = bottom_shape.elemsize;
+
+    top_shapes.resize(1);
+
+    if (bottom_shape.dims == 2)
+    {
+        top_shapes[0] = order_type == 1 ? Mat(h, w, (void*)0, elemsize) : bottom_shape.shape();
+    }
+    else if (order_type == 0)
+        top_shapes[0] = bottom_shape.shape();
+    else if (order_type == 1)
+        top_shapes[0] = Mat(h, w, channels, (void*)0, elemsize);
+    else if (order_type == 2)
+        top_shapes[0] = Mat(w, channels, h, (void*)0, elemsize);
+    else if (order_type == 3)
+        top_shapes[0] = Mat(channels, w, h, (void*)0, elemsize);
+    else if (order_type == 4)
+        top_shapes[0] = Mat(h, channels, w, (void*)0, elemsize);
+    else if (order_type == 5)
+        top_shapes[0] = Mat(channels, h, w, (void*)0, elemsize);
+
+    for (size_t i=0; i<fused_reshapes.size(); i++)
+    {
+        const std::vector<Mat> reshape_bottom_shapes = top_shapes;
+        int ret = fused_reshapes[i]->infer_shape(reshape_bottom_shapes, top_shapes);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
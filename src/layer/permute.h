@@ -28,8 +28,17 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
+protected:
+    int forward_permute(const Mat& bottom_blob, Mat& top_blob, bool dense, const Option& opt) const;
+
 public:
     int order_type;
+
+    // flatten and reshape layers fused by Net::fuse_network
+    // the permuted channels are written back to back so that they only view the top
+    std::vector<const Layer*> fused_reshapes;
 };
 
 } // namespace ncnn
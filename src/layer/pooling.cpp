@@ -14,6 +14,7 @@
 
 #include "pooling.h"
 #include <float.h>
+#include <math.h>
 #include <algorithm>
 #include "layer_type.h"
 
@@ -44,11 +45,236 @@ int Pooling::load_param(const ParamDict& pd)
     return 0;
 }
 
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -128) return -128;
+    return (signed char)int32;
+}
+
+int Pooling::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // max and avg of int8 values share the bottom blob scale
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+
+    if (global_pooling)
+    {
+        top_blob.create(channels, (size_t)1u, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        int size = w * h;
+
+        signed char* outptr = top_blob;
+
+        if (pooling_type == PoolMethod_MAX)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const signed char* ptr = bottom_blob.channel(q);
+
+                signed char max = ptr[0];
+                for (int i=0; i<size; i++)
+                {
+                    max = std::max(max, ptr[i]);
+                }
+
+                outptr[q] = max;
+            }
+        }
+        else if (pooling_type == PoolMethod_AVE)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const signed char* ptr = bottom_blob.channel(q);
+
+                int sum = 0;
+                for (int i=0; i<size; i++)
+                {
+                    sum += ptr[i];
+                }
+
+                outptr[q] = float2int8((float)sum / size);
+            }
+        }
+
+        return 0;
+    }
+
+    Mat bottom_blob_bordered = bottom_blob;
+
+    float pad_value = 0.f;
+    if (pooling_type == PoolMethod_MAX)
+    {
+        pad_value = -128.f;
+    }
+    else if (pooling_type == PoolMethod_AVE)
+    {
+        pad_value = 0.f;
+    }
+
+    int wtailpad = 0;
+    int htailpad = 0;
+
+    if (pad_mode == 0) // full padding
+    {
+        int wtail = (w + pad_left + pad_right - kernel_w) % stride_w;
+        int htail = (h + pad_top + pad_bottom - kernel_h) % stride_h;
+
+        if (wtail != 0)
+            wtailpad = stride_w - wtail;
+        if (htail != 0)
+            htailpad = stride_h - htail;
+
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom + htailpad, pad_left, pad_right + wtailpad, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_mode == 1) // valid padding
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_mode == 2) // tensorflow padding=SAME
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+
+    int outw = (w - kernel_w) / stride_w + 1;
+    int outh = (h - kernel_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, channels, (size_t)1u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // kernel offsets
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w - kernel_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2++;
+            }
+            p2 += gap;
+        }
+    }
+
+    if (pooling_type == PoolMethod_MAX)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = bottom_blob_bordered.channel(q);
+            signed char* outptr = top_blob.channel(q);
+
+            for (int i = 0; i < outh; i++)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    const signed char* sptr = m.row<signed char>(i*stride_h) + j*stride_w;
+
+                    signed char max = sptr[0];
+
+                    for (int k = 0; k < maxk; k++)
+                    {
+                        signed char val = sptr[ space_ofs[k] ];
+                        max = std::max(max, val);
+                    }
+
+                    outptr[j] = max;
+                }
+
+                outptr += outw;
+            }
+        }
+    }
+    else if (pooling_type == PoolMethod_AVE)
+    {
+        // fix pad, same edge scaling as float32
+        std::vector<float> _row_scales(outh, 1.f / maxk);
+        std::vector<float> _col_scales(outw, 1.f);
+        float* row_scales = &_row_scales[0];
+        float* col_scales = &_col_scales[0];
+
+        if (pad_top != 0)
+            row_scales[0] *= (float)kernel_h / (kernel_h - pad_top);
+        if (pad_bottom + htailpad != 0)
+            row_scales[outh - 1] *= (float)kernel_h / (kernel_h - pad_bottom - htailpad);
+        if (pad_left != 0)
+            col_scales[0] *= (float)kernel_w / (kernel_w - pad_left);
+        if (pad_right + wtailpad != 0)
+            col_scales[outw - 1] *= (float)kernel_w / (kernel_w - pad_right - wtailpad);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = bottom_blob_bordered.channel(q);
+            signed char* outptr = top_blob.channel(q);
+
+            for (int i = 0; i < outh; i++)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    const signed char* sptr = m.row<signed char>(i*stride_h) + j*stride_w;
+
+                    int sum = 0;
+
+                    for (int k = 0; k < maxk; k++)
+                    {
+                        sum += sptr[ space_ofs[k] ];
+                    }
+
+                    outptr[j] = float2int8(sum * row_scales[i] * col_scales[j]);
+                }
+
+                outptr += outw;
+            }
+        }
+    }
+
+    return 0;
+}
+
 int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // max value in NxN window
     // avg value in NxN window
 
+    if (bottom_blob.elemsize == 1u)
+        return forward_int8(bottom_blob, top_blob, opt);
+
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int channels = bottom_blob.c;
@@ -290,4 +516,53 @@ int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     return 0;
 }
 
+int Pooling::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int channels = bottom_shape.c;
+    size_t elemsize = bottom_shape.elemsize;
+
+    top_shapes.resize(1);
+
+    if (global_pooling)
+    {
+        top_shapes[0] = Mat(channels, (void*)0, elemsize);
+        return 0;
+    }
+
+    if (pad_mode == 0) // full padding
+    {
+        int wtail = (w + pad_left + pad_right - kernel_w) % stride_w;
+        int htail = (h + pad_top + pad_bottom - kernel_h) % stride_h;
+
+        w += pad_left + pad_right + (wtail != 0 ? stride_w - wtail : 0);
+        h += pad_top + pad_bottom + (htail != 0 ? stride_h - htail : 0);
+    }
+    else if (pad_mode == 1) // valid padding
+    {
+        w += pad_left + pad_right;
+        h += pad_top + pad_bottom;
+    }
+    else if (pad_mode == 2) // tensorflow padding=SAME
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    int outw = (w - kernel_w) / stride_w + 1;
+    int outh = (h - kernel_h) / stride_h + 1;
+
+    top_shapes[0] = Mat(outw, outh, channels, (void*)0, elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
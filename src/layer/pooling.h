@@ -27,6 +27,9 @@ public:
     virtual int load_param(const ParamDict& pd);
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    virtual int forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
 
     enum { PoolMethod_MAX = 0, PoolMethod_AVE = 1 };
 
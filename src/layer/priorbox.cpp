@@ -250,4 +250,33 @@ int PriorBox::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     return 0;
 }
 
+int PriorBox::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    int w = bottom_shapes[0].w;
+    int h = bottom_shapes[0].h;
+
+    top_shapes.resize(1);
+
+    if (bottom_shapes.size() == 1 && image_width == -233 && image_height == -233 && max_sizes.empty())
+    {
+        // mxnet style _contrib_MultiBoxPrior
+        int num_prior = min_sizes.w - 1 + aspect_ratios.w;
+
+        top_shapes[0] = Mat(4 * w * h * num_prior, (void*)0);
+        return 0;
+    }
+
+    int num_min_size = min_sizes.w;
+    int num_max_size = max_sizes.w;
+    int num_aspect_ratio = aspect_ratios.w;
+
+    int num_prior = num_min_size * num_aspect_ratio + num_min_size + num_max_size;
+    if (flip)
+        num_prior += num_min_size * num_aspect_ratio;
+
+    top_shapes[0] = Mat(4 * w * h * num_prior, 2, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
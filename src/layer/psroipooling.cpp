@@ -115,4 +115,12 @@ int PSROIPooling::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>
     return 0;
 }
 
+int PSROIPooling::infer_shape(const std::vector<Mat>& /*bottom_shapes*/, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(pooled_width, pooled_height, output_dim, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
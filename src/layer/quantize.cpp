@@ -110,4 +110,13 @@ int Quantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     return 0;
 }
 
+int Quantize::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shapes[0].shape();
+    top_shapes[0].elemsize = 1u;
+
+    return 0;
+}
+
 } // namespace ncnn
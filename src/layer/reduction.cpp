@@ -301,4 +301,25 @@ int Reduction::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     return 0;
 }
 
+int Reduction::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    top_shapes.resize(1);
+    if (dim == 0)
+        top_shapes[0] = Mat(1, (void*)0);
+    else if (dim == 1)
+        top_shapes[0] = Mat(bottom_shape.c, (void*)0);
+    else if (dim == 2)
+        top_shapes[0] = Mat(bottom_shape.h, bottom_shape.c, (void*)0);
+    else if (dim == -1)
+        top_shapes[0] = Mat(bottom_shape.w, (void*)0);
+    else if (dim == -2)
+        top_shapes[0] = Mat(bottom_shape.w, bottom_shape.h, (void*)0);
+    else
+        return -1;
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -114,4 +114,52 @@ int ReLU::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
     return 0;
 }
 
+int ReLU::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    const int batch = bottom_top_blobs.size();
+
+    int w = bottom_top_blobs[0].w;
+    int h = bottom_top_blobs[0].h;
+    int channels = bottom_top_blobs[0].c;
+    size_t elemsize = bottom_top_blobs[0].elemsize;
+    int size = w * h;
+
+    bool same_shape = true;
+    for (int n=1; n<batch; n++)
+    {
+        const Mat& m = bottom_top_blobs[n];
+        if (m.w != w || m.h != h || m.c != channels || m.elemsize != elemsize)
+            same_shape = false;
+    }
+
+    if (elemsize == 1u || !same_shape)
+        return Layer::forward_batch_inplace(bottom_top_blobs, opt);
+
+    // one parallel region over all channels of all samples
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int nq=0; nq<batch * channels; nq++)
+    {
+        float* ptr = bottom_top_blobs[nq / channels].channel(nq % channels);
+
+        if (slope == 0.f)
+        {
+            for (int i=0; i<size; i++)
+            {
+                if (ptr[i] < 0)
+                    ptr[i] = 0;
+            }
+        }
+        else
+        {
+            for (int i=0; i<size; i++)
+            {
+                if (ptr[i] < 0)
+                    ptr[i] *= slope;
+            }
+        }
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -29,6 +29,8 @@ public:
     virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
     virtual int forward_inplace_int8(Mat& bottom_top_blob, const Option& opt) const;
 
+    virtual int forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const;
+
 public:
     float slope;
 };
@@ -75,4 +75,14 @@ int Reorg::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) con
     return 0;
 }
 
+int Reorg::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(bottom_shape.w / stride, bottom_shape.h / stride, bottom_shape.c * stride * stride, (void*)0, bottom_shape.elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -30,6 +30,8 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    virtual int infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const;
+
 public:
     float scale_in;	// bottom_blob_scale * weight_scale
 	float scale_out;// top_blob_scale / (bottom_blob_scale * weight_scale)
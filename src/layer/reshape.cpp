@@ -128,4 +128,48 @@ int Reshape::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     return 0;
 }
 
+int Reshape::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    size_t elemsize = bottom_shape.elemsize;
+    int total = bottom_shape.w * bottom_shape.h * bottom_shape.c;
+
+    int _w = w == 0 ? bottom_shape.w : w;
+    int _h = h == 0 ? bottom_shape.h : h;
+    int _c = c == 0 ? bottom_shape.c : c;
+
+    top_shapes.resize(1);
+
+    if (ndim == 1)
+    {
+        if (_w == -1)
+            _w = total;
+
+        top_shapes[0] = Mat(_w, (void*)0, elemsize);
+    }
+    else if (ndim == 2)
+    {
+        if (_w == -1)
+            _w = total / _h;
+        if (_h == -1)
+            _h = total / _w;
+
+        top_shapes[0] = Mat(_w, _h, (void*)0, elemsize);
+    }
+    else if (ndim == 3)
+    {
+        if (_w == -1)
+            _w = total / _c / _h;
+        if (_h == -1)
+            _h = total / _c / _w;
+        if (_c == -1)
+            _c = total / _h / _w;
+
+        top_shapes[0] = Mat(_w, _h, _c, (void*)0, elemsize);
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -136,4 +136,13 @@ int RNN::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blo
     return 0;
 }
 
+int RNN::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    // one output per timestep
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(num_output, 1, bottom_shapes[0].c, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
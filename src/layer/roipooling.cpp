@@ -108,4 +108,12 @@ int ROIPooling::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>&
     return 0;
 }
 
+int ROIPooling::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(pooled_width, pooled_height, bottom_shapes[0].c, (void*)0);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -173,4 +173,12 @@ int Scale::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
     return forward_inplace(bottom_top_blobs, opt);
 }
 
+int Scale::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shapes[0].shape();
+
+    return 0;
+}
+
 } // namespace ncnn
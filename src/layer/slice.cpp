@@ -241,4 +241,52 @@ int Slice::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_b
     return 0;
 }
 
+int Slice::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+    int dims = bottom_shape.dims;
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int channels = bottom_shape.c;
+    size_t elemsize = bottom_shape.elemsize;
+
+    // size of the slice axis
+    int size = channels;
+    if ((dims == 1) || (dims == 2 && axis == 1) || (dims == 3 && axis == 2))
+        size = w;
+    else if ((dims == 2 && axis == 0) || (dims == 3 && axis == 1))
+        size = h;
+
+    const int* slices_ptr = slices;
+    const size_t top_count = top_shapes.size();
+
+    int q = 0;
+    for (size_t i=0; i<top_count; i++)
+    {
+        int slice = slices_ptr[i];
+        if (slice == -233)
+        {
+            slice = (size - q) / (top_count - i);
+        }
+
+        if (dims == 1)
+            top_shapes[i] = Mat(slice, (void*)0, elemsize);
+        else if (dims == 2 && axis == 0)
+            top_shapes[i] = Mat(w, slice, (void*)0, elemsize);
+        else if (dims == 2 && axis == 1)
+            top_shapes[i] = Mat(slice, h, (void*)0, elemsize);
+        else if (dims == 3 && axis == 0)
+            top_shapes[i] = Mat(w, h, slice, (void*)0, elemsize);
+        else if (dims == 3 && axis == 1)
+            top_shapes[i] = Mat(w, slice, channels, (void*)0, elemsize);
+        else
+            top_shapes[i] = Mat(slice, h, channels, (void*)0, elemsize);
+
+        q += slice;
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
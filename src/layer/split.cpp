@@ -23,6 +23,7 @@ Split::Split()
     one_blob_only = false;
     support_inplace = false;
     support_vulkan = true;
+    support_packing = true;
 }
 
 int Split::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& /*opt*/) const
@@ -51,4 +52,14 @@ int Split::forward(const std::vector<VkMat>& bottom_blobs, std::vector<VkMat>& t
 }
 #endif // NCNN_VULKAN
 
+int Split::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    for (size_t i=0; i<top_shapes.size(); i++)
+    {
+        top_shapes[i] = bottom_shapes[0].shape();
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
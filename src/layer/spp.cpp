@@ -168,4 +168,15 @@ int SPP::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
     return 0;
 }
 
+int SPP::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    // 1 + 4 + 16 + 64 + ... + (2*pyramid_height)^2
+    int pyramid_num_bins = ((1 << (pyramid_height * 2)) - 1) / 3;
+
+    top_shapes.resize(1);
+    top_shapes[0] = Mat(pyramid_num_bins, 1, 2, (void*)0, bottom_shapes[0].elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
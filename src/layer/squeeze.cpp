@@ -70,4 +70,42 @@ int Squeeze::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) c
     return 0;
 }
 
+int Squeeze::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int channels = bottom_shape.c;
+    int dims = bottom_shape.dims;
+    size_t elemsize = bottom_shape.elemsize;
+
+    top_shapes.resize(1);
+    top_shapes[0] = bottom_shape.shape();
+
+    if (squeeze_c && dims == 3 && channels == 1)
+    {
+        if (squeeze_h && h == 1)
+            top_shapes[0] = Mat(w, (void*)0, elemsize);
+        else
+            top_shapes[0] = Mat(w, h, (void*)0, elemsize);
+    }
+    else if (squeeze_h && dims >= 2 && h == 1)
+    {
+        if (squeeze_w && w == 1)
+            top_shapes[0] = Mat(channels, (void*)0, elemsize);
+        else
+            top_shapes[0] = Mat(w, channels, (void*)0, elemsize);
+    }
+    else if (squeeze_w && dims >= 1 && w == 1)
+    {
+        if (squeeze_h && h == 1)
+            top_shapes[0] = Mat(channels, (void*)0, elemsize);
+        else
+            top_shapes[0] = Mat(h, channels, (void*)0, elemsize);
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -116,4 +116,23 @@ int Tile::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
     return 0;
 }
 
+int Tile::infer_shape(const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes) const
+{
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    int channels = bottom_shape.c;
+
+    top_shapes.resize(1);
+    if (dim == 0)
+        top_shapes[0] = Mat(w, h, channels * tiles, (void*)0, bottom_shape.elemsize);
+    else if (dim == 1)
+        top_shapes[0] = Mat(w, h * tiles, channels, (void*)0, bottom_shape.elemsize);
+    else
+        top_shapes[0] = Mat(w * tiles, h, channels, (void*)0, bottom_shape.elemsize);
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -0,0 +1,118 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "batchnorm_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(BatchNorm_x86)
+
+BatchNorm_x86::BatchNorm_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int BatchNorm_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int dims = bottom_top_blob.dims;
+    if (dims != 3)
+        return BatchNorm::forward_inplace(bottom_top_blob, opt);
+
+    // a = bias - slope * mean / sqrt(var)
+    // b = slope / sqrt(var)
+    // value = b * value + a
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int size = w * h;
+
+    const float* a_data_ptr = a_data;
+    const float* b_data_ptr = b_data;
+
+#if __SSE2__
+    if (bottom_top_blob.packing == 4)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<bottom_top_blob.c; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            __m128 _a = _mm_loadu_ps(a_data_ptr + q * 4);
+            __m128 _b = _mm_loadu_ps(b_data_ptr + q * 4);
+            for (int i=0; i<size; i++)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                _p = _mm_add_ps(_mm_mul_ps(_b, _p), _a);
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+        }
+
+        return 0;
+    }
+#endif // __SSE2__
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+        float a = a_data_ptr[q];
+        float b = b_data_ptr[q];
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        __m128 _a = _mm_set1_ps(a);
+        __m128 _b = _mm_set1_ps(b);
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            _p = _mm_add_ps(_mm_mul_ps(_b, _p), _a);
+            _mm_storeu_ps(ptr, _p);
+
+            ptr += 4;
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            *ptr = b * *ptr + a;
+
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+int BatchNorm_x86::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    // sse kernel per sample
+    return Layer::forward_batch_inplace(bottom_top_blobs, opt);
+}
+
+} // namespace ncnn
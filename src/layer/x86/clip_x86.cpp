@@ -0,0 +1,80 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "clip_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Clip_x86)
+
+Clip_x86::Clip_x86()
+{
+    // elementwise, packed lanes are just more elements
+    support_packing = true;
+}
+
+int Clip_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h * bottom_top_blob.packing;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        __m128 _min = _mm_set1_ps(min);
+        __m128 _max = _mm_set1_ps(max);
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            // value as second operand keeps nan as is
+            _p = _mm_max_ps(_min, _p);
+            _p = _mm_min_ps(_max, _p);
+            _mm_storeu_ps(ptr, _p);
+
+            ptr += 4;
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            if (*ptr < min)
+                *ptr = min;
+            if (*ptr > max)
+                *ptr = max;
+
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -17,10 +17,13 @@ static void conv7x7s1_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_ker
     int kernel_w = 7;
     int kernel_h = 7;
 
+    int dilation_w = 1;
+    int dilation_h = 1;
+
     int stride_w = 1;
     int stride_h = 1;
 
-    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, opt);
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, 0, opt);
 }
 
 static void conv7x7s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, const Option& opt)
@@ -28,8 +31,11 @@ static void conv7x7s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_ker
     int kernel_w = 7;
     int kernel_h = 7;
 
+    int dilation_w = 1;
+    int dilation_h = 1;
+
     int stride_w = 2;
     int stride_h = 2;
 
-    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, opt);
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, 0, opt);
 }
\ No newline at end of file
@@ -12,6 +12,18 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+// residual sum and relu on the n outputs of channels p .. p+nch-1 at offset j, right after the tile is stored
+static inline void conv_sgemm_epilogue(const ConvolutionEpilogue* epilogue, Mat& top_blob, int p, int nch, int j, int n)
+{
+    if (!epilogue)
+        return;
+
+    for (int k=0; k<nch; k++)
+    {
+        epilogue->apply(top_blob, p + k, j, n);
+    }
+}
+
 #if __AVX__
 static void conv_im2col_sgemm_transform_kernel_sse(const Mat& _kernel, Mat& kernel_tm, int inch, int outch, int kernel_size)
 {
@@ -110,68 +122,73 @@ static void conv_im2col_sgemm_transform_kernel_sse(const Mat& _kernel, Mat& kern
     }
 }
 
-static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const Mat & kernel_tm, const Mat& _bias, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+#if __AVX512F__
+// bottom_tm holds 16 column tiles, then at most one 8 column tile, then single columns
+static inline int conv_sgemm_tile8_channel(int j) { return j/16 + (j%16)/8; }
+static inline int conv_sgemm_tile1_channel(int j) { return j/16 + (j%16)/8 + j%8; }
+#else
+static inline int conv_sgemm_tile8_channel(int j) { return j/8; }
+static inline int conv_sgemm_tile1_channel(int j) { return j/8 + j%8; }
+#endif // __AVX512F__
+
+static void conv_sgemm_sse(const Mat& bottom_im2col, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const int kernel_size, const ConvolutionEpilogue* epilogue, const Option& opt)
 {
-    int w = bottom_blob.w;
-    int inch = bottom_blob.c;
-    size_t elemsize = bottom_blob.elemsize;
+    size_t elemsize = bottom_im2col.elemsize;
 
-    int outw = top_blob.w;
-    int outh = top_blob.h;
     int outch = top_blob.c;
 
     const float* bias = _bias;
 
-    // im2col
-    Mat bottom_im2col(outw*outh, kernel_h*kernel_w*inch, elemsize, opt.workspace_allocator);
+    // one column per output pixel, samples side by side
+    // 1x1 stride 1 convolution passes the bottom blob itself, one row per channel
+    const bool direct = bottom_im2col.dims == 3;
+    int inch = direct ? bottom_im2col.c : bottom_im2col.h / kernel_size;
+    int out_size = direct ? bottom_im2col.w * bottom_im2col.h : bottom_im2col.w;
+    int row_stride = direct ? (int)bottom_im2col.cstep : bottom_im2col.w;
+
+#if __AVX512F__
+    // bottom_im2col memory packed 16 x 8
+    Mat bottom_tm(16*kernel_size, inch, out_size/16 + (out_size%16)/8 + out_size%8, elemsize, opt.workspace_allocator);
     {
-        const int stride = kernel_h*kernel_w*outw*outh;
-        float* ret = (float*)bottom_im2col;
-    
+        int nn_size = out_size >> 4;
+        int remain_size_start = nn_size << 4;
+
         #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=0; p<inch; p++)
+        for (int ii=0; ii<nn_size; ii++)
         {
-            const float* input = bottom_blob.channel(p);
-            int retID = stride * p;
-            for (int u=0; u<kernel_h; u++)
+            int i = ii * 16;
+
+            const float* img0 = bottom_im2col.channel(0);
+            img0 += i;
+
+            float* tmpptr = bottom_tm.channel(i/16);
+
+            for (int q=0; q<inch*kernel_size; q++)
             {
-                for (int v=0; v<kernel_w; v++)
-                {
-                    for (int i=0; i<outh; i++)
-                    {
-                        for (int j=0; j<outw; j++)
-                        {
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
-                        }
-                    }
-                }
+                _mm512_storeu_ps(tmpptr, _mm512_loadu_ps(img0));
+                tmpptr += 16;
+                img0 += row_stride;
             }
         }
-    }
-
-    int kernel_size = kernel_w * kernel_h;
-    int out_size = outw * outh;
 
+        nn_size = (out_size - remain_size_start) >> 3;
+#else
     // bottom_im2col memory packed 8 x 8
     Mat bottom_tm(8*kernel_size, inch, out_size/8 + out_size%8, elemsize, opt.workspace_allocator);
     {
         int nn_size = out_size >> 3;
-        int remain_size_start = nn_size << 3;
+        int remain_size_start = 0;
+#endif // __AVX512F__
 
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int ii=0; ii<nn_size; ii++)
         {
-            int i = ii * 8;
+            int i = remain_size_start + ii * 8;
 
             const float* img0 = bottom_im2col.channel(0);
             img0 += i;
 
-            float* tmpptr = bottom_tm.channel(i/8);
+            float* tmpptr = bottom_tm.channel(conv_sgemm_tile8_channel(i));
 
             for (int q=0; q<inch*kernel_size; q++)
             {
@@ -188,24 +205,26 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 tmpptr[7] = img0[7];
 #endif // __SSE__              
                 tmpptr += 8;
-                img0 += out_size;
+                img0 += row_stride;
             }
         }
 
+        remain_size_start += nn_size << 3;
+
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int i=remain_size_start; i<out_size; i++)
         {
             const float* img0 = bottom_im2col.channel(0);
             img0 += i;
 
-            float* tmpptr = bottom_tm.channel(i/8 + i%8);
+            float* tmpptr = bottom_tm.channel(conv_sgemm_tile1_channel(i));
 
             for (int q=0; q<inch*kernel_size; q++)
             {
                 tmpptr[0] = img0[0];
 
                 tmpptr += 1;
-                img0 += out_size;
+                img0 += row_stride;
             }
         }       
     }
@@ -213,8 +232,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
     // sgemm(int M, int N, int L, float* A, float* B, float* C)
     {
         //int M = outch;                    // outch
-        int N = outw * outh;                // outsize or out stride
-        int L = kernel_w * kernel_h * inch; // ksize * inch
+        int N = out_size;                   // outsize or out stride
+        int L = kernel_size * inch;         // ksize * inch
 
         int nn_outch = 0;
         int remain_outch_start = 0;
@@ -240,9 +259,61 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
             const float* biasptr = bias ? bias + i : zeros;
 
             int j=0;
+#if __AVX512F__
+            for (; j+15<N; j=j+16)
+            {
+                const float* vb = bottom_tm.channel(j/16);
+                const float* va = kernel_tm.channel(i/8);
+
+                __m512 _sum0 = _mm512_set1_ps(biasptr[0]);
+                __m512 _sum1 = _mm512_set1_ps(biasptr[1]);
+                __m512 _sum2 = _mm512_set1_ps(biasptr[2]);
+                __m512 _sum3 = _mm512_set1_ps(biasptr[3]);
+                __m512 _sum4 = _mm512_set1_ps(biasptr[4]);
+                __m512 _sum5 = _mm512_set1_ps(biasptr[5]);
+                __m512 _sum6 = _mm512_set1_ps(biasptr[6]);
+                __m512 _sum7 = _mm512_set1_ps(biasptr[7]);
+
+                for (int k=0; k<L; k++)
+                {
+                    __m512 _vb0 = _mm512_loadu_ps(vb);
+                    _sum0 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[0]), _sum0);    // sum0 += (a00-a0f) * k00
+                    _sum1 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[1]), _sum1);    // sum1 += (a00-a0f) * k10
+                    _sum2 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[2]), _sum2);    // sum2 += (a00-a0f) * k20
+                    _sum3 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[3]), _sum3);    // sum3 += (a00-a0f) * k30
+                    _sum4 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[4]), _sum4);    // sum4 += (a00-a0f) * k40
+                    _sum5 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[5]), _sum5);    // sum5 += (a00-a0f) * k50
+                    _sum6 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[6]), _sum6);    // sum6 += (a00-a0f) * k60
+                    _sum7 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[7]), _sum7);    // sum7 += (a00-a0f) * k70
+
+                    va += 8;
+                    vb += 16;
+                }
+
+                _mm512_storeu_ps(output0, _sum0);
+                _mm512_storeu_ps(output1, _sum1);
+                _mm512_storeu_ps(output2, _sum2);
+                _mm512_storeu_ps(output3, _sum3);
+                _mm512_storeu_ps(output4, _sum4);
+                _mm512_storeu_ps(output5, _sum5);
+                _mm512_storeu_ps(output6, _sum6);
+                _mm512_storeu_ps(output7, _sum7);
+
+                conv_sgemm_epilogue(epilogue, top_blob, i, 8, j, 16);
+
+                output0 += 16;
+                output1 += 16;
+                output2 += 16;
+                output3 += 16;
+                output4 += 16;
+                output5 += 16;
+                output6 += 16;
+                output7 += 16;
+            }
+#endif // __AVX512F__
             for (; j+7<N; j=j+8)
             {
-                const float* vb = bottom_tm.channel(j/8);
+                const float* vb = bottom_tm.channel(conv_sgemm_tile8_channel(j));
                 const float* va = kernel_tm.channel(i/8);
 #if __AVX__
                 __m256 _sum0 = _mm256_broadcast_ss(biasptr);
@@ -506,6 +577,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     output7[n] = sum7[n] + biasptr[7];
                 }
 #endif // __AVX__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 8, j, 8);
+
                 output0 += 8;
                 output1 += 8;
                 output2 += 8;
@@ -518,7 +591,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
             for (; j<N; j++)
             {
-                const float* vb = bottom_tm.channel(j/8 + j%8);
+                const float* vb = bottom_tm.channel(conv_sgemm_tile1_channel(j));
                 const float* va = kernel_tm.channel(i/8);
 
 #if __AVX__
@@ -607,6 +680,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 output6[0] = sum6;
                 output7[0] = sum7;
 #endif // __AVX__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 8, j, 1);
+
                 output0++;
                 output1++;
                 output2++;
@@ -634,9 +709,45 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
             const float* biasptr = bias ? bias + i : zeros;
 
             int j=0;
+#if __AVX512F__
+            for (; j+15<N; j=j+16)
+            {
+                const float* vb = bottom_tm.channel(j/16);
+                const float* va = kernel_tm.channel(i/8 + (i%8)/4);
+
+                __m512 _sum0 = _mm512_set1_ps(biasptr[0]);
+                __m512 _sum1 = _mm512_set1_ps(biasptr[1]);
+                __m512 _sum2 = _mm512_set1_ps(biasptr[2]);
+                __m512 _sum3 = _mm512_set1_ps(biasptr[3]);
+
+                for (int k=0; k<L; k++)
+                {
+                    __m512 _vb0 = _mm512_loadu_ps(vb);
+                    _sum0 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[0]), _sum0);    // sum0 += (a00-a0f) * k00
+                    _sum1 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[1]), _sum1);    // sum1 += (a00-a0f) * k10
+                    _sum2 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[2]), _sum2);    // sum2 += (a00-a0f) * k20
+                    _sum3 = _mm512_fmadd_ps(_vb0, _mm512_set1_ps(va[3]), _sum3);    // sum3 += (a00-a0f) * k30
+
+                    va += 4;
+                    vb += 16;
+                }
+
+                _mm512_storeu_ps(output0, _sum0);
+                _mm512_storeu_ps(output1, _sum1);
+                _mm512_storeu_ps(output2, _sum2);
+                _mm512_storeu_ps(output3, _sum3);
+
+                conv_sgemm_epilogue(epilogue, top_blob, i, 4, j, 16);
+
+                output0 += 16;
+                output1 += 16;
+                output2 += 16;
+                output3 += 16;
+            }
+#endif // __AVX512F__
             for (; j+7<N; j=j+8)
             {
-                const float* vb = bottom_tm.channel(j/8);
+                const float* vb = bottom_tm.channel(conv_sgemm_tile8_channel(j));
                 const float* va = kernel_tm.channel(i/8 + (i%8)/4);
 #if __AVX__
                 __m256 _sum0 = _mm256_broadcast_ss(biasptr);
@@ -715,7 +826,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     _sum3 = _mm256_fmadd_ps(_vb0, _va3, _sum3);    // sum3 = (a00-a07) * k30
 
                     va += 4;
-                    vb += 4;
+                    vb += 8;
                 }
 
                 _mm256_storeu_ps(output0, _sum0);
@@ -808,6 +919,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     output3[n] = sum3[n] + biasptr[3];
                 }
 #endif // __AVX__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 4, j, 8);
+
                 output0 += 8;
                 output1 += 8;
                 output2 += 8;
@@ -816,7 +929,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
             for (; j<N; j++)
             {                
-                const float* vb = bottom_tm.channel(j/8 + j%8);
+                const float* vb = bottom_tm.channel(conv_sgemm_tile1_channel(j));
                 const float* va = kernel_tm.channel(i/8 + (i%8)/4);
 #if __AVX__
                 __m128 _sum0_3 = _mm_loadu_ps(biasptr);
@@ -888,6 +1001,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 output2[0] = sum2;
                 output3[0] = sum3;
 #endif // __AVX__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 4, j, 1);
+
                 output0++;
                 output1++;
                 output2++;
@@ -905,9 +1020,32 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
             const float bias0 = bias ? bias[i] : 0.f;
 
             int j=0;
+#if __AVX512F__
+            for (; j+15<N; j=j+16)
+            {
+                const float* vb = bottom_tm.channel(j/16);
+                const float* va = kernel_tm.channel(i/8 + (i%8)/4 + i%4);
+
+                __m512 _sum0 = _mm512_set1_ps(bias0);
+
+                for (int k=0; k<L; k++)
+                {
+                    _sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(vb), _mm512_set1_ps(va[0]), _sum0);    // sum0 += (a00-a0f) * k00
+
+                    va += 1;
+                    vb += 16;
+                }
+
+                _mm512_storeu_ps(output, _sum0);
+
+                conv_sgemm_epilogue(epilogue, top_blob, i, 1, j, 16);
+
+                output += 16;
+            }
+#endif // __AVX512F__
             for (; j+7<N; j=j+8)
             {
-                const float* vb = bottom_tm.channel(j/8);
+                const float* vb = bottom_tm.channel(conv_sgemm_tile8_channel(j));
                 const float* va = kernel_tm.channel(i/8 + (i%8)/4 + i%4);
 #if __AVX__
                 __m256 _sum0 = _mm256_broadcast_ss(&bias0);
@@ -943,7 +1081,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     _sum0 = _mm256_fmadd_ps(_vb0, _va0, _sum0);    // sum0 = (a00-a07) * k00
 
                     va += 1;
-                    vb += 4;
+                    vb += 8;
                 }
 
                 _mm256_storeu_ps(output, _sum0); 
@@ -985,12 +1123,14 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     output[n] = sum[n] + bias0;
                 }
 #endif // __AVX__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 1, j, 8);
+
                 output += 8;
             }
 
             for (; j<N; j++)
             {
-                const float* vb = bottom_tm.channel(j/8 + j%8);
+                const float* vb = bottom_tm.channel(conv_sgemm_tile1_channel(j));
                 const float* va = kernel_tm.channel(i/8 + (i%8)/4 + i%4);
 
                 int k=0;
@@ -1020,6 +1160,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 }
                 output[0] = sum0;
 
+                conv_sgemm_epilogue(epilogue, top_blob, i, 1, j, 1);
+
                 output++;
             }
         }
@@ -1080,52 +1222,20 @@ static void conv_im2col_sgemm_transform_kernel_sse(const Mat& _kernel, Mat& kern
     }
 }
 
-static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const Mat & kernel_tm, const Mat& _bias, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+static void conv_sgemm_sse(const Mat& bottom_im2col, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const int kernel_size, const ConvolutionEpilogue* epilogue, const Option& opt)
 {
-    int w = bottom_blob.w;
-    int inch = bottom_blob.c;
-    size_t elemsize = bottom_blob.elemsize;
+    size_t elemsize = bottom_im2col.elemsize;
 
-    int outw = top_blob.w;
-    int outh = top_blob.h;
     int outch = top_blob.c;
 
     const float* bias = _bias;
 
-    // im2col
-    Mat bottom_im2col(outw*outh, kernel_h*kernel_w*inch, elemsize, opt.workspace_allocator);
-    {
-        const int stride = kernel_h*kernel_w*outw*outh;
-        float* ret = (float*)bottom_im2col;
-    
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=0; p<inch; p++)
-        {
-            const float* input = bottom_blob.channel(p);
-            int retID = stride * p;
-            for (int u=0; u<kernel_h; u++)
-            {
-                for (int v=0; v<kernel_w; v++)
-                {
-                    for (int i=0; i<outh; i++)
-                    {
-                        for (int j=0; j<outw; j++)
-                        {
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    int kernel_size = kernel_w * kernel_h;
-    int out_size = outw * outh;
+    // one column per output pixel, samples side by side
+    // 1x1 stride 1 convolution passes the bottom blob itself, one row per channel
+    const bool direct = bottom_im2col.dims == 3;
+    int inch = direct ? bottom_im2col.c : bottom_im2col.h / kernel_size;
+    int out_size = direct ? bottom_im2col.w * bottom_im2col.h : bottom_im2col.w;
+    int row_stride = direct ? (int)bottom_im2col.cstep : bottom_im2col.w;
 
     // bottom_im2col memory packed 4 x 4
     Mat bottom_tm(4*kernel_size, inch, out_size/4 + out_size%4, elemsize, opt.workspace_allocator);
@@ -1154,7 +1264,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 tmpptr[3] = img0[3];
 #endif // __SSE__              
                 tmpptr += 4;
-                img0 += out_size;
+                img0 += row_stride;
             }
         }
 
@@ -1171,7 +1281,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 tmpptr[0] = img0[0];
 
                 tmpptr += 1;
-                img0 += out_size;
+                img0 += row_stride;
             }
         }
     }
@@ -1179,8 +1289,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
     // sgemm(int M, int N, int L, float* A, float* B, float* C)
     {
         //int M = outch;                    // outch
-        int N = outw * outh;                // outsize or out stride
-        int L = kernel_w * kernel_h * inch; // ksize * inch
+        int N = out_size;                   // outsize or out stride
+        int L = kernel_size * inch;         // ksize * inch
 
         int nn_outch = 0;
         int remain_outch_start = 0;
@@ -1369,6 +1479,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     output3[n] = sum3[n] + biasptr[3];
                 }
 #endif // __SSE__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 4, j, 4);
+
                 output0 += 4;
                 output1 += 4;
                 output2 += 4;
@@ -1448,6 +1560,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 output2[0] = sum2;
                 output3[0] = sum3;
 #endif // __SSE__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 4, j, 1);
+
                 output0++;
                 output1++;
                 output2++;
@@ -1542,6 +1656,8 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     output[n] = sum[n] + bias0;
                 }
 #endif // __SSE__
+                conv_sgemm_epilogue(epilogue, top_blob, i, 1, j, 4);
+
                 output += 4;
             }
 
@@ -1576,9 +1692,112 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 }
                 output[0] = sum0;
 
+                conv_sgemm_epilogue(epilogue, top_blob, i, 1, j, 1);
+
                 output++;
             }
         }
     }   
 }
 #endif
+
+static void conv_im2col_sse(const Mat& bottom_blob, Mat& bottom_im2col, const int col_offset, \
+            const int kernel_w, const int kernel_h, const int dilation_w, const int dilation_h, const int stride_w, const int stride_h, const int outw, const int outh, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int inch = bottom_blob.c;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<inch; p++)
+    {
+        const float* input = bottom_blob.channel(p);
+        float* ret = bottom_im2col.row(kernel_h*kernel_w*p) + col_offset;
+
+        for (int u=0; u<kernel_h; u++)
+        {
+            for (int v=0; v<kernel_w; v++)
+            {
+                float* outptr = ret;
+
+                for (int i=0; i<outh; i++)
+                {
+                    const float* sptr = input + (u * dilation_h + i * stride_h) * w + v * dilation_w;
+
+                    if (stride_w == 1)
+                    {
+                        memcpy(outptr, sptr, outw * sizeof(float));
+                    }
+                    else
+                    {
+                        for (int j=0; j<outw; j++)
+                        {
+                            outptr[j] = sptr[j * stride_w];
+                        }
+                    }
+
+                    outptr += outw;
+                }
+
+                ret += bottom_im2col.w;
+            }
+        }
+    }
+}
+
+static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const Mat & kernel_tm, const Mat& _bias, \
+            const int kernel_w, const int kernel_h, const int dilation_w, const int dilation_h, const int stride_w, const int stride_h, const ConvolutionEpilogue* epilogue, const Option& opt)
+{
+    int inch = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+
+    // im2col
+    Mat bottom_im2col(outw*outh, kernel_h*kernel_w*inch, elemsize, opt.workspace_allocator);
+    conv_im2col_sse(bottom_blob, bottom_im2col, 0, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, outw, outh, opt);
+
+    conv_sgemm_sse(bottom_im2col, top_blob, kernel_tm, _bias, kernel_w*kernel_h, epilogue, opt);
+}
+
+static void conv1x1s1_sgemm_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const ConvolutionEpilogue* epilogue, const Option& opt)
+{
+    // no im2col, the channels are the rows already
+    conv_sgemm_sse(bottom_blob, top_blob, kernel_tm, _bias, 1, epilogue, opt);
+}
+
+static void conv_im2col_sgemm_batch_sse(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Mat & kernel_tm, const Mat& _bias, \
+            const int kernel_w, const int kernel_h, const int dilation_w, const int dilation_h, const int stride_w, const int stride_h, const Option& opt)
+{
+    const int batch = bottom_blobs.size();
+
+    int inch = bottom_blobs[0].c;
+    size_t elemsize = bottom_blobs[0].elemsize;
+
+    int outw = top_blobs[0].w;
+    int outh = top_blobs[0].h;
+    int outch = top_blobs[0].c;
+    int out_size = outw * outh;
+
+    // im2col of all samples side by side, the packed kernel is walked once for the whole batch
+    Mat bottom_im2col(out_size*batch, kernel_h*kernel_w*inch, elemsize, opt.workspace_allocator);
+    for (int n=0; n<batch; n++)
+    {
+        conv_im2col_sse(bottom_blobs[n], bottom_im2col, out_size*n, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, outw, outh, opt);
+    }
+
+    Mat top_blob_tm(out_size*batch, 1, outch, elemsize, opt.workspace_allocator);
+    conv_sgemm_sse(bottom_im2col, top_blob_tm, kernel_tm, _bias, kernel_w*kernel_h, 0, opt);
+
+    // scatter to samples
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        const float* ptr = top_blob_tm.channel(p);
+
+        for (int n=0; n<batch; n++)
+        {
+            memcpy(top_blobs[n].channel(p), ptr + out_size*n, out_size*elemsize);
+        }
+    }
+}
@@ -0,0 +1,344 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// int8 im2col sgemm on the x86 dot product instructions
+// the inner loop follows the compile flags of the including file
+//   avx512 vnni  vpdpbusd over 16 pixels, the input is biased to unsigned by +128
+//                and 128 * sum(weight) is taken back per output channel
+//   avx2         vpmaddubsw over 8 pixels as |x| * (w * sign(x)), the pair sums
+//                stay in int16 as the quantized weights are within [-127, 127]
+
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -128) return -128;
+    return (signed char)int32;
+}
+
+// kernel rows padded to 4 along k, kernel_sum holds 128 * sum(weight) per output channel
+static void conv_im2col_sgemm_int8_dot_transform_kernel(const Mat& _kernel, Mat& kernel_tm, Mat& kernel_sum, int inch, int outch, int kernel_size)
+{
+    const int K = inch * kernel_size;
+    const int K4 = (K + 3) / 4 * 4;
+
+    kernel_tm.create(K4, outch, (size_t)1u);
+    kernel_sum.create(outch, (size_t)4u);
+
+    const signed char* kernel = _kernel;
+    int* ksum = kernel_sum;
+
+    for (int p=0; p<outch; p++)
+    {
+        const signed char* k0 = kernel + p * K;
+        signed char* ktmp = kernel_tm.row<signed char>(p);
+
+        int sum = 0;
+        for (int k=0; k<K; k++)
+        {
+            ktmp[k] = k0[k];
+            sum += k0[k];
+        }
+        for (int k=K; k<K4; k++)
+        {
+            ktmp[k] = 0;
+        }
+
+        ksum[p] = sum * 128;
+    }
+}
+
+static inline void conv_im2col_sgemm_int8_dot_store(Mat& top_blob, int p, int j, int nn, const int* sum, int sum_bias, float bias, const std::vector<float>& scales, bool requant)
+{
+    if (requant)
+    {
+        signed char* outptr = (signed char*)top_blob.channel(p) + j;
+
+        const float scale_in = scales[2*p];
+        const float scale_out = scales[2*p+1];
+
+        for (int n=0; n<nn; n++)
+        {
+            outptr[n] = float2int8(((float)(sum[n] - sum_bias) * scale_in + bias) * scale_out);
+        }
+    }
+    else
+    {
+        float* outptr = (float*)top_blob.channel(p) + j;
+
+        const float scale = scales[p];
+
+        for (int n=0; n<nn; n++)
+        {
+            outptr[n] = (float)(sum[n] - sum_bias) * scale + bias;
+        }
+    }
+}
+
+// top_blob is float32 with per output channel dequantize scales,
+// or int8 with per output channel requantize scale in and out pairs
+static void conv_im2col_sgemm_int8_dot(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& _bias, const std::vector<float>& scales, bool requant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+#if __AVX512VNNI__
+    const int tile = 16;
+    const signed char input_xor = (signed char)0x80;
+#else
+    const int tile = 8;
+    const signed char input_xor = 0;
+#endif
+
+    int w = bottom_blob.w;
+    int inch = bottom_blob.c;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+    const int K4 = kernel_tm.w;
+    const int N = outw * outh;
+    const int ntile = (N + tile - 1) / tile;
+
+    // kernel offsets
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        for (int u = 0; u < kernel_h; u++)
+        {
+            for (int v = 0; v < kernel_w; v++)
+            {
+                space_ofs[p1] = u * dilation_h * w + v * dilation_w;
+                p1++;
+            }
+        }
+    }
+
+    // im2col packed to pixel tiles, the 4 k of one pixel are adjacent
+    Mat bottom_tm(tile * K4, ntile, (size_t)1u, opt.workspace_allocator);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t=0; t<ntile; t++)
+    {
+        int ofs[16];
+        for (int n=0; n<tile; n++)
+        {
+            // the tail repeats the last pixel, its columns are never stored
+            int j = std::min(t * tile + n, N - 1);
+            ofs[n] = (j / outw) * stride_h * w + (j % outw) * stride_w;
+        }
+
+        signed char* tmpptr = bottom_tm.row<signed char>(t);
+
+        int k = 0;
+        for (int p=0; p<inch; p++)
+        {
+            const signed char* img = bottom_blob.channel(p);
+
+            for (int q=0; q<maxk; q++)
+            {
+                const signed char* sptr = img + space_ofs[q];
+                signed char* dst = tmpptr + (k / 4) * tile * 4 + k % 4;
+
+                for (int n=0; n<tile; n++)
+                {
+                    dst[n * 4] = sptr[ofs[n]] ^ input_xor;
+                }
+
+                k++;
+            }
+        }
+
+        // the padded weights are zero
+        for (; k<K4; k++)
+        {
+            signed char* dst = tmpptr + (k / 4) * tile * 4 + k % 4;
+
+            for (int n=0; n<tile; n++)
+            {
+                dst[n * 4] = 0;
+            }
+        }
+    }
+
+    const float* bias = _bias;
+#if __AVX512VNNI__
+    const int* ksum = kernel_sum;
+#else
+    (void)kernel_sum;
+#endif
+
+    int nn_outch = outch >> 2;
+    int remain_outch_start = nn_outch << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_outch; pp++)
+    {
+        int p = pp * 4;
+
+        const signed char* k0 = kernel_tm.row<signed char>(p);
+        const signed char* k1 = kernel_tm.row<signed char>(p+1);
+        const signed char* k2 = kernel_tm.row<signed char>(p+2);
+        const signed char* k3 = kernel_tm.row<signed char>(p+3);
+
+#if __AVX512VNNI__
+        const int sum_bias0 = ksum[p];
+        const int sum_bias1 = ksum[p+1];
+        const int sum_bias2 = ksum[p+2];
+        const int sum_bias3 = ksum[p+3];
+#else
+        const int sum_bias0 = 0;
+        const int sum_bias1 = 0;
+        const int sum_bias2 = 0;
+        const int sum_bias3 = 0;
+#endif
+
+        const float bias0 = bias ? bias[p] : 0.f;
+        const float bias1 = bias ? bias[p+1] : 0.f;
+        const float bias2 = bias ? bias[p+2] : 0.f;
+        const float bias3 = bias ? bias[p+3] : 0.f;
+
+        for (int t=0; t<ntile; t++)
+        {
+            const signed char* tmpptr = bottom_tm.row<signed char>(t);
+
+            // avx2 fills only the first 8, zero the rest for the vectorized store
+            int sum0[16] = { 0 };
+            int sum1[16] = { 0 };
+            int sum2[16] = { 0 };
+            int sum3[16] = { 0 };
+
+#if __AVX512VNNI__
+            __m512i _sum0 = _mm512_setzero_si512();
+            __m512i _sum1 = _mm512_setzero_si512();
+            __m512i _sum2 = _mm512_setzero_si512();
+            __m512i _sum3 = _mm512_setzero_si512();
+
+            for (int k=0; k<K4; k+=4)
+            {
+                __m512i _x = _mm512_loadu_si512(tmpptr);
+
+                _sum0 = _mm512_dpbusd_epi32(_sum0, _x, _mm512_set1_epi32(*(const int*)(k0 + k)));
+                _sum1 = _mm512_dpbusd_epi32(_sum1, _x, _mm512_set1_epi32(*(const int*)(k1 + k)));
+                _sum2 = _mm512_dpbusd_epi32(_sum2, _x, _mm512_set1_epi32(*(const int*)(k2 + k)));
+                _sum3 = _mm512_dpbusd_epi32(_sum3, _x, _mm512_set1_epi32(*(const int*)(k3 + k)));
+
+                tmpptr += 64;
+            }
+
+            _mm512_storeu_si512(sum0, _sum0);
+            _mm512_storeu_si512(sum1, _sum1);
+            _mm512_storeu_si512(sum2, _sum2);
+            _mm512_storeu_si512(sum3, _sum3);
+#else
+            __m256i _one = _mm256_set1_epi16(1);
+
+            __m256i _sum0 = _mm256_setzero_si256();
+            __m256i _sum1 = _mm256_setzero_si256();
+            __m256i _sum2 = _mm256_setzero_si256();
+            __m256i _sum3 = _mm256_setzero_si256();
+
+            for (int k=0; k<K4; k+=4)
+            {
+                __m256i _x = _mm256_loadu_si256((const __m256i*)tmpptr);
+                __m256i _ax = _mm256_abs_epi8(_x);
+
+                __m256i _w0 = _mm256_sign_epi8(_mm256_set1_epi32(*(const int*)(k0 + k)), _x);
+                __m256i _w1 = _mm256_sign_epi8(_mm256_set1_epi32(*(const int*)(k1 + k)), _x);
+                __m256i _w2 = _mm256_sign_epi8(_mm256_set1_epi32(*(const int*)(k2 + k)), _x);
+                __m256i _w3 = _mm256_sign_epi8(_mm256_set1_epi32(*(const int*)(k3 + k)), _x);
+
+                _sum0 = _mm256_add_epi32(_sum0, _mm256_madd_epi16(_mm256_maddubs_epi16(_ax, _w0), _one));
+                _sum1 = _mm256_add_epi32(_sum1, _mm256_madd_epi16(_mm256_maddubs_epi16(_ax, _w1), _one));
+                _sum2 = _mm256_add_epi32(_sum2, _mm256_madd_epi16(_mm256_maddubs_epi16(_ax, _w2), _one));
+                _sum3 = _mm256_add_epi32(_sum3, _mm256_madd_epi16(_mm256_maddubs_epi16(_ax, _w3), _one));
+
+                tmpptr += 32;
+            }
+
+            _mm256_storeu_si256((__m256i*)sum0, _sum0);
+            _mm256_storeu_si256((__m256i*)sum1, _sum1);
+            _mm256_storeu_si256((__m256i*)sum2, _sum2);
+            _mm256_storeu_si256((__m256i*)sum3, _sum3);
+#endif
+
+            const int j = t * tile;
+            const int nn = std::min(tile, N - j);
+
+            conv_im2col_sgemm_int8_dot_store(top_blob, p, j, nn, sum0, sum_bias0, bias0, scales, requant);
+            conv_im2col_sgemm_int8_dot_store(top_blob, p+1, j, nn, sum1, sum_bias1, bias1, scales, requant);
+            conv_im2col_sgemm_int8_dot_store(top_blob, p+2, j, nn, sum2, sum_bias2, bias2, scales, requant);
+            conv_im2col_sgemm_int8_dot_store(top_blob, p+3, j, nn, sum3, sum_bias3, bias3, scales, requant);
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_outch_start; p<outch; p++)
+    {
+        const signed char* k0 = kernel_tm.row<signed char>(p);
+
+#if __AVX512VNNI__
+        const int sum_bias0 = ksum[p];
+#else
+        const int sum_bias0 = 0;
+#endif
+
+        const float bias0 = bias ? bias[p] : 0.f;
+
+        for (int t=0; t<ntile; t++)
+        {
+            const signed char* tmpptr = bottom_tm.row<signed char>(t);
+
+            int sum0[16] = { 0 };
+
+#if __AVX512VNNI__
+            __m512i _sum0 = _mm512_setzero_si512();
+
+            for (int k=0; k<K4; k+=4)
+            {
+                __m512i _x = _mm512_loadu_si512(tmpptr);
+
+                _sum0 = _mm512_dpbusd_epi32(_sum0, _x, _mm512_set1_epi32(*(const int*)(k0 + k)));
+
+                tmpptr += 64;
+            }
+
+            _mm512_storeu_si512(sum0, _sum0);
+#else
+            __m256i _one = _mm256_set1_epi16(1);
+
+            __m256i _sum0 = _mm256_setzero_si256();
+
+            for (int k=0; k<K4; k+=4)
+            {
+                __m256i _x = _mm256_loadu_si256((const __m256i*)tmpptr);
+                __m256i _ax = _mm256_abs_epi8(_x);
+
+                __m256i _w0 = _mm256_sign_epi8(_mm256_set1_epi32(*(const int*)(k0 + k)), _x);
+
+                _sum0 = _mm256_add_epi32(_sum0, _mm256_madd_epi16(_mm256_maddubs_epi16(_ax, _w0), _one));
+
+                tmpptr += 32;
+            }
+
+            _mm256_storeu_si256((__m256i*)sum0, _sum0);
+#endif
+
+            const int j = t * tile;
+            const int nn = std::min(tile, N - j);
+
+            conv_im2col_sgemm_int8_dot_store(top_blob, p, j, nn, sum0, sum_bias0, bias0, scales, requant);
+        }
+    }
+}
@@ -0,0 +1,250 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+// weights of every 4 output channels, for each input block of elempack channels and kernel tap
+// laid out [elempack][4] so that one input lane scales one column of output lanes
+static void conv_im2col_sgemm_transform_kernel_pack4_sse(const Mat& _kernel, Mat& kernel_tm, int inch, int outch, int kernel_size, int elempack)
+{
+    const float* kernel = _kernel;
+
+    kernel_tm.create(4 * inch * kernel_size, outch / 4);
+    if (kernel_tm.empty())
+        return;
+
+    for (int p=0; p<outch / 4; p++)
+    {
+        float* ktmp = kernel_tm.row(p);
+
+        for (int q=0; q<inch; q+=elempack)
+        {
+            for (int k=0; k<kernel_size; k++)
+            {
+                for (int l=0; l<elempack; l++)
+                {
+                    for (int i=0; i<4; i++)
+                    {
+                        ktmp[0] = kernel[((p * 4 + i) * inch + q + l) * kernel_size + k];
+                        ktmp++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// gather kernel taps of packed pixels, one row per input block and tap
+static void conv_im2col_pack_sse(const Mat& bottom_blob, Mat& bottom_im2col, int outw, int outh, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    const int w = bottom_blob.w;
+    const int inch = bottom_blob.c;
+    const int elempack = bottom_blob.packing;
+    const int maxk = kernel_w * kernel_h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<inch; q++)
+    {
+        const float* img = bottom_blob.channel(q);
+
+        for (int u=0; u<kernel_h; u++)
+        {
+            for (int v=0; v<kernel_w; v++)
+            {
+                float* ptr = bottom_im2col.row(q * maxk + u * kernel_w + v);
+
+                for (int i=0; i<outh; i++)
+                {
+                    const float* sptr = img + ((i * stride_h + u * dilation_h) * w + v * dilation_w) * elempack;
+
+                    if (elempack == 4)
+                    {
+                        for (int j=0; j<outw; j++)
+                        {
+                            _mm_storeu_ps(ptr, _mm_loadu_ps(sptr));
+
+                            sptr += stride_w * 4;
+                            ptr += 4;
+                        }
+                    }
+                    else
+                    {
+                        for (int j=0; j<outw; j++)
+                        {
+                            *ptr = *sptr;
+
+                            sptr += stride_w;
+                            ptr++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// top = kernel_tm x bottom, rows of bottom are rowstep floats apart
+static void conv_sgemm_pack4to4_sse(const float* bottom_tm, size_t rowstep, int nk, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const Option& opt)
+{
+    const int size = top_blob.w * top_blob.h;
+    const int outch = top_blob.c;
+
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        float* outptr = top_blob.channel(p);
+        const float* kptr0 = kernel_tm.row(p);
+
+        __m128 _bias0 = bias ? _mm_loadu_ps(bias + p * 4) : _mm_setzero_ps();
+
+        int j = 0;
+        for (; j+3<size; j+=4)
+        {
+            __m128 _sum0 = _bias0;
+            __m128 _sum1 = _bias0;
+            __m128 _sum2 = _bias0;
+            __m128 _sum3 = _bias0;
+
+            const float* kptr = kptr0;
+            const float* ptr = bottom_tm + j * 4;
+
+            for (int r=0; r<nk; r++)
+            {
+                __m128 _w0 = _mm_loadu_ps(kptr);
+                __m128 _w1 = _mm_loadu_ps(kptr + 4);
+                __m128 _w2 = _mm_loadu_ps(kptr + 8);
+                __m128 _w3 = _mm_loadu_ps(kptr + 12);
+
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_w0, _mm_load1_ps(ptr)));
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_w1, _mm_load1_ps(ptr + 1)));
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_w2, _mm_load1_ps(ptr + 2)));
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_w3, _mm_load1_ps(ptr + 3)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_w0, _mm_load1_ps(ptr + 4)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_w1, _mm_load1_ps(ptr + 5)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_w2, _mm_load1_ps(ptr + 6)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_w3, _mm_load1_ps(ptr + 7)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_w0, _mm_load1_ps(ptr + 8)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_w1, _mm_load1_ps(ptr + 9)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_w2, _mm_load1_ps(ptr + 10)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_w3, _mm_load1_ps(ptr + 11)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_w0, _mm_load1_ps(ptr + 12)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_w1, _mm_load1_ps(ptr + 13)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_w2, _mm_load1_ps(ptr + 14)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_w3, _mm_load1_ps(ptr + 15)));
+
+                kptr += 16;
+                ptr += rowstep;
+            }
+
+            _mm_storeu_ps(outptr, _sum0);
+            _mm_storeu_ps(outptr + 4, _sum1);
+            _mm_storeu_ps(outptr + 8, _sum2);
+            _mm_storeu_ps(outptr + 12, _sum3);
+
+            outptr += 16;
+        }
+        for (; j<size; j++)
+        {
+            __m128 _sum0 = _bias0;
+
+            const float* kptr = kptr0;
+            const float* ptr = bottom_tm + j * 4;
+
+            for (int r=0; r<nk; r++)
+            {
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_loadu_ps(kptr), _mm_load1_ps(ptr)));
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_loadu_ps(kptr + 4), _mm_load1_ps(ptr + 1)));
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_loadu_ps(kptr + 8), _mm_load1_ps(ptr + 2)));
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_loadu_ps(kptr + 12), _mm_load1_ps(ptr + 3)));
+
+                kptr += 16;
+                ptr += rowstep;
+            }
+
+            _mm_storeu_ps(outptr, _sum0);
+
+            outptr += 4;
+        }
+    }
+}
+
+// top = kernel_tm x bottom, rows of bottom are rowstep floats apart
+static void conv_sgemm_pack1to4_sse(const float* bottom_tm, size_t rowstep, int nk, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const Option& opt)
+{
+    const int size = top_blob.w * top_blob.h;
+    const int outch = top_blob.c;
+
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        float* outptr = top_blob.channel(p);
+        const float* kptr0 = kernel_tm.row(p);
+
+        __m128 _bias0 = bias ? _mm_loadu_ps(bias + p * 4) : _mm_setzero_ps();
+
+        int j = 0;
+        for (; j+3<size; j+=4)
+        {
+            __m128 _sum0 = _bias0;
+            __m128 _sum1 = _bias0;
+            __m128 _sum2 = _bias0;
+            __m128 _sum3 = _bias0;
+
+            const float* kptr = kptr0;
+            const float* ptr = bottom_tm + j;
+
+            for (int r=0; r<nk; r++)
+            {
+                __m128 _w0 = _mm_loadu_ps(kptr);
+
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_w0, _mm_load1_ps(ptr)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_w0, _mm_load1_ps(ptr + 1)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_w0, _mm_load1_ps(ptr + 2)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_w0, _mm_load1_ps(ptr + 3)));
+
+                kptr += 4;
+                ptr += rowstep;
+            }
+
+            _mm_storeu_ps(outptr, _sum0);
+            _mm_storeu_ps(outptr + 4, _sum1);
+            _mm_storeu_ps(outptr + 8, _sum2);
+            _mm_storeu_ps(outptr + 12, _sum3);
+
+            outptr += 16;
+        }
+        for (; j<size; j++)
+        {
+            __m128 _sum0 = _bias0;
+
+            const float* kptr = kptr0;
+            const float* ptr = bottom_tm + j;
+
+            for (int r=0; r<nk; r++)
+            {
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_loadu_ps(kptr), _mm_load1_ps(ptr)));
+
+                kptr += 4;
+                ptr += rowstep;
+            }
+
+            _mm_storeu_ps(outptr, _sum0);
+
+            outptr += 4;
+        }
+    }
+}
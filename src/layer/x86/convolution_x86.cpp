@@ -22,14 +22,28 @@
 #include <immintrin.h>
 #endif
 
+#include <stdio.h>
+#include <algorithm>
+
 #include "layer_type.h"
 #include "benchmark.h"
+#include "cpu.h"
+
+#if NCNN_RUNTIME_CPU
+#include "convolution_x86_avx2.h"
+#include "convolution_x86_avx512.h"
+#include "convolution_x86_avx512vnni.h"
+#endif
 
 namespace ncnn {
 
 #include "convolution_sgemm.h"
+#if __SSE2__
+#include "convolution_sgemm_pack4.h"
+#endif // __SSE2__
 #include "convolution_1x1.h"
 #include "convolution_3x3.h"
+#include "convolution_winograd.h"
 #include "convolution_5x5.h"
 #include "convolution_7x7.h"
 #include "convolution_sgemm_int8.h"
@@ -43,6 +57,10 @@ DEFINE_LAYER_CREATOR(Convolution_x86)
 Convolution_x86::Convolution_x86()
 {
     activation = 0;
+    use_avx2 = false;
+    use_avx512 = false;
+    use_avx512_vnni = false;
+    elempack = 1;
 }
 
 int Convolution_x86::create_pipeline(const Option& opt)
@@ -87,9 +105,32 @@ int Convolution_x86::create_pipeline(const Option& opt)
         activation->create_pipeline(opt_cpu);
     }
 
+    use_avx2 = false;
+    use_avx512 = false;
+    use_avx512_vnni = false;
+#if NCNN_RUNTIME_CPU
+    use_avx2 = cpu_support_x86_avx2();
+    use_avx512 = cpu_support_x86_avx512();
+    use_avx512_vnni = cpu_support_x86_avx512_vnni();
+#endif
+
+    weight_sgemm_int8_data.release();
+    weight_sgemm_int8_sum.release();
+
+#if NCNN_RUNTIME_CPU
+    // the int8 dot product kernels take any kernel size and stride, and outrun the int8 winograd
+    if (use_int8_inference && (use_avx2 || use_avx512_vnni))
+    {
+        int kernel_size = kernel_w * kernel_h;
+        int num_input = weight_data_size / kernel_size / num_output;
+
+        conv_im2col_sgemm_int8_transform_kernel_avx2(weight_data, weight_sgemm_int8_data, weight_sgemm_int8_sum, num_input, num_output, kernel_size);
+    }
+#endif
+
     use_winograd3x3 = false;
 
-    if (opt.use_winograd_convolution && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
+    if (opt.use_winograd_convolution && weight_sgemm_int8_data.empty() && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
     {
         int num_input = weight_data_size / 9 / num_output;
         // winograd is slow on small channel count
@@ -97,6 +138,9 @@ int Convolution_x86::create_pipeline(const Option& opt)
             use_winograd3x3 = true;
     }           
 
+    weight_3x3_winograd63_data.release();
+    weight_3x3_winograd43_data.release();
+
     if (use_winograd3x3)
     {
         int num_input = weight_data_size / 9 / num_output;
@@ -105,8 +149,41 @@ int Convolution_x86::create_pipeline(const Option& opt)
             // conv3x3s1_winograd23_transform_kernel_int8_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
             conv3x3s1_winograd43_transform_kernel_int8_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
         else
-            // conv3x3s1_winograd23_transform_kernel_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
-            conv3x3s1_winograd43_transform_kernel_sse(weight_data, weight_3x3_winograd43_data, num_input, num_output);
+        {
+            // F(6,3) for large feature maps, F(4,3) for small ones
+            int mask = WINOGRAD_F63 | WINOGRAD_F43;
+
+            // the input shape is known from Net::reshape, keep only the kernel it runs
+            if (!bottom_shapes.empty() && bottom_shapes[0].dims == 3)
+            {
+                int w = bottom_shapes[0].w;
+                int h = bottom_shapes[0].h;
+                if (pad_w > 0 || pad_h > 0)
+                {
+                    w += pad_w * 2;
+                    h += pad_h * 2;
+                }
+                else if (pad_w == -233 && pad_h == -233)
+                {
+                    w += 2;
+                    h += 2;
+                }
+
+                // a tuned choice, or the cost model unless autotune wants every candidate
+                // none when sgemm wins, the layer still stays planar as the packed sgemm is no faster there
+                int winograd_m = kernel_choices.find(w - 2, h - 2, num_input);
+                if (winograd_m == -1 && !opt.use_kernel_autotune)
+                    winograd_m = winograd_select(w - 2, h - 2, num_input, mask);
+
+                if (winograd_m != -1)
+                    mask = winograd_m == 6 ? WINOGRAD_F63 : winograd_m == 4 ? WINOGRAD_F43 : 0;
+            }
+
+            if (mask & WINOGRAD_F63)
+                conv3x3s1_winograd_transform_kernel(weight_data, weight_3x3_winograd63_data, num_input, num_output, 6);
+            if (mask & WINOGRAD_F43)
+                conv3x3s1_winograd_transform_kernel(weight_data, weight_3x3_winograd43_data, num_input, num_output, 4);
+        }
     }
 
     if (use_int8_inference == false)
@@ -114,9 +191,35 @@ int Convolution_x86::create_pipeline(const Option& opt)
         int kernel_size = kernel_w * kernel_h;
         int num_input = weight_data_size / kernel_size / num_output;
 
+#if NCNN_RUNTIME_CPU
+        // the avx2 and avx512 kernels pack 8 output channels together
+        if (use_avx2 || use_avx512)
+            conv_im2col_sgemm_transform_kernel_avx2(weight_data, weight_sgemm_data, num_input, num_output, kernel_size);
+        else
+#endif
         conv_im2col_sgemm_transform_kernel_sse(weight_data, weight_sgemm_data, num_input, num_output, kernel_size);
     }       
 
+    support_packing = false;
+    elempack = 1;
+    weight_sgemm_pack4_data.release();
+
+#if __SSE2__
+    // winograd kernels stay planar
+    if (opt.use_packing_layout && !use_int8_inference && !use_winograd3x3 && num_output % 4 == 0)
+    {
+        int kernel_size = kernel_w * kernel_h;
+        int num_input = weight_data_size / kernel_size / num_output;
+
+        support_packing = true;
+        elempack = num_input % 4 == 0 ? 4 : 1;
+
+        conv_im2col_sgemm_transform_kernel_pack4_sse(weight_data, weight_sgemm_pack4_data, num_input, num_output, kernel_size, elempack);
+        if (weight_sgemm_pack4_data.empty())
+            return -100;
+    }
+#endif // __SSE2__
+
     return 0;
 }
 
@@ -135,110 +238,6 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
-int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv_func conv, const Option& opt) const
-{
-    int w = bottom_blob.w;
-    int h = bottom_blob.h;
-    size_t elemsize = bottom_blob.elemsize;
-
-    const int kernel_size = kernel_w;
-    const int stride = stride_w;
-    const int dilation = dilation_w;
-    const int kernel_extent = dilation * (kernel_size - 1) + 1;
-
-    Mat bottom_blob_bordered = bottom_blob;
-    if (pad_w > 0 || pad_h > 0)
-    {
-        copy_make_border(bottom_blob, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-        if (bottom_blob_bordered.empty())
-            return -100;
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-    else if (pad_w == -233 && pad_h == -233)
-    {
-        int wpad = kernel_extent + (w - 1) / stride * stride - w;
-        int hpad = kernel_extent + (h - 1) / stride * stride - h;
-        if (wpad > 0 || hpad > 0)
-        {
-            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-            if (bottom_blob_bordered.empty())
-                return -100;
-        }
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-
-    int outw = (w - kernel_extent) / stride + 1;
-    int outh = (h - kernel_extent) / stride + 1;
-
-    top_blob.create(outw, outh, num_output, elemsize, opt.blob_allocator);
-    if (top_blob.empty())
-        return -100;
-
-    // Make (dilation * dilation) batches
-    Mat inner_bottom_blob;
-    Mat inner_top_blob;
-    for (int x = 0; x < dilation; x ++)
-    {
-        for (int y = 0; y < dilation; y ++)
-        {
-            int inner_w = (w - y + dilation - 1) / dilation;
-            int inner_h = (h - x + dilation - 1) / dilation;
-
-            int inner_outw = (inner_w - kernel_size) / stride + 1;
-            int inner_outh = (inner_h - kernel_size) / stride + 1;
-
-            inner_bottom_blob.create(inner_w, inner_h, bottom_blob.c, elemsize, opt.workspace_allocator);
-            if (inner_bottom_blob.empty())
-                return -100;
-
-            inner_top_blob.create(inner_outw, inner_outh, num_output, elemsize, opt.workspace_allocator);
-            if (inner_top_blob.empty())
-                return -100;
-
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int c = 0; c < bottom_blob.c; c ++)
-            {
-                float *outptr = inner_bottom_blob.channel(c);
-
-                for (int i = 0; i < inner_h; i ++)
-                {
-                    const float* ptr = (const float *)bottom_blob_bordered.channel(c) + dilation * i * w + x * w + y;
-                    for (int j = 0; j < inner_w; j ++)
-                    {
-                        outptr[j] = ptr[j*dilation];
-                    }
-                    outptr += inner_w;
-                }
-            }
-
-            ncnn::Option opt_g = opt;
-            opt_g.blob_allocator = inner_top_blob.allocator;
-            conv(inner_bottom_blob, inner_top_blob, weight_data, bias_data, opt_g);
-
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int c = 0; c < num_output; c ++)
-            {
-                float *outptr = (float *)top_blob.channel(c) + x * outw + y;
-                for (int i = 0; i < inner_outh; i ++)
-                {
-                    const float* ptr = (const float *)inner_top_blob.channel(c) + i * inner_outw;
-                    for (int j = 0; j < inner_outw; j ++)
-                    {
-                        outptr[j*dilation] = ptr[j];
-                    }
-                    outptr += dilation * outw;
-                }
-            }
-        }
-    }
-
-    return 0;
-}
-
 int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // convolv with NxN kernel
@@ -249,195 +248,143 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         return Convolution::forward(bottom_blob, top_blob, opt);
     }
 
-    if (kernel_w != kernel_h || stride_w != stride_h)
+    if (support_packing && opt.use_packing_layout && bottom_blob.packing == elempack && bottom_blob.elemsize == 4u * elempack)
     {
-        return Convolution::forward(bottom_blob, top_blob, opt);
+        return forward_pack4(bottom_blob, top_blob, opt);
     }
 
-    const int kernel_size = kernel_w;
-    const int stride = stride_w;  
-
-    if (kernel_size > 7 || stride > 7 || dilation_w != dilation_h)
+    if (bottom_blob.packing != 1)
     {
-        return Convolution::forward(bottom_blob, top_blob, opt);
-    }
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_unpacked.empty())
+            return -100;
 
-    typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, const Option&);
+        return forward(bottom_blob_unpacked, top_blob, opt);
+    }
 
-    // kernel_size x stride
-    conv_func conv_func_table[7][4] =
-    {
-        {
-            conv1x1s1_sse,
-            conv1x1s2_sse,
-            0,
-            0
-        }, // kernel_size = 1
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 2
-        {
-            conv3x3s1_sse,
-            conv3x3s2_sse,
-            0,
-            0
-        }, // kernel_size = 3
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 4
-        {
-            conv5x5s1_sse,
-            conv5x5s2_sse,
-            0,
-            0
-        }, // kernel_size = 5
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 6
-        {
-            conv7x7s1_sse,          
-            conv7x7s2_sse,          
-            0,
-            0
-        }  // kernel_size = 7        
-    };
+    const bool use_int8_dot = use_int8_inference && !weight_sgemm_int8_data.empty();
 
+    // float32 and the int8 dot product kernels run im2col sgemm for any kernel, stride and dilation
+    // the direct int8 kernels are square and do not dilate
     typedef void (*conv_int8_dequant_func)(const Mat&, Mat&, const Mat&, const Mat&, std::vector<float>, const Option&);
     typedef void (*conv_int8_requant_func)(const Mat&, Mat&, const Mat&, const Mat&, std::vector<float>, const Option&);
 
-    // kernel_size x stride
-    conv_int8_dequant_func conv_int8_dequant_func_table[7][4] =
-    {
-        {
-            conv1x1s1_int8_dequant_sse,
-            conv1x1s2_int8_dequant_sse,
-            0,
-            0
-        }, // kernel_size = 1
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 2
-        {
-            conv3x3s1_int8_dequant_sse,
-            conv3x3s2_int8_dequant_sse,
-            0,
-            0,
-        }, // kernel_size = 3
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 4
-        {        
-            conv5x5s1_int8_dequant_sse,
-            conv5x5s2_int8_dequant_sse,    
-            0,
-            0
-        }, // kernel_size = 5
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 6
-        {
-            conv7x7s1_int8_dequant_sse,          
-            conv7x7s2_int8_dequant_sse, 
-            0,
-            0
-        }  // kernel_size = 7
-    };
+    conv_int8_dequant_func conv_int8_dequant = 0;
+    conv_int8_requant_func conv_int8_requant = 0;
 
-    conv_int8_requant_func conv_int8_requant_func_table[7][4] =
+    if (use_int8_inference && !use_int8_dot)
     {
+        const int kernel_size = kernel_w;
+        const int stride = stride_w;
+
+        if (kernel_w != kernel_h || stride_w != stride_h || dilation_w != 1 || dilation_h != 1 || kernel_size > 7 || stride > 4)
         {
-            conv1x1s1_int8_requant_sse,
-            conv1x1s2_int8_requant_sse,
-            0,
-            0
-        }, // kernel_size = 1
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 2
-        {
-            conv3x3s1_int8_requant_sse,
-            conv3x3s2_int8_requant_sse,
-            0,
-            0,
-        }, // kernel_size = 3
-        {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 4
-        {        
-            conv5x5s1_int8_requant_sse,
-            conv5x5s2_int8_requant_sse,    
-            0,
-            0
-        }, // kernel_size = 5
+            return Convolution::forward(bottom_blob, top_blob, opt);
+        }
+
+        // kernel_size x stride
+        conv_int8_dequant_func conv_int8_dequant_func_table[7][4] =
         {
-            0,
-            0,
-            0,
-            0
-        }, // kernel_size = 6
+            {
+                conv1x1s1_int8_dequant_sse,
+                conv1x1s2_int8_dequant_sse,
+                0,
+                0
+            }, // kernel_size = 1
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 2
+            {
+                conv3x3s1_int8_dequant_sse,
+                conv3x3s2_int8_dequant_sse,
+                0,
+                0,
+            }, // kernel_size = 3
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 4
+            {        
+                conv5x5s1_int8_dequant_sse,
+                conv5x5s2_int8_dequant_sse,    
+                0,
+                0
+            }, // kernel_size = 5
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 6
+            {
+                conv7x7s1_int8_dequant_sse,          
+                conv7x7s2_int8_dequant_sse, 
+                0,
+                0
+            }  // kernel_size = 7
+        };
+
+        conv_int8_requant_func conv_int8_requant_func_table[7][4] =
         {
-            conv7x7s1_int8_requant_sse,          
-            conv7x7s2_int8_requant_sse, 
-            0,
-            0
-        }  // kernel_size = 7
-    };
-
-    conv_func conv = 0;
-    conv_int8_dequant_func conv_int8_dequant = 0;
-    conv_int8_requant_func conv_int8_requant = 0;
+            {
+                conv1x1s1_int8_requant_sse,
+                conv1x1s2_int8_requant_sse,
+                0,
+                0
+            }, // kernel_size = 1
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 2
+            {
+                conv3x3s1_int8_requant_sse,
+                conv3x3s2_int8_requant_sse,
+                0,
+                0,
+            }, // kernel_size = 3
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 4
+            {        
+                conv5x5s1_int8_requant_sse,
+                conv5x5s2_int8_requant_sse,    
+                0,
+                0
+            }, // kernel_size = 5
+            {
+                0,
+                0,
+                0,
+                0
+            }, // kernel_size = 6
+            {
+                conv7x7s1_int8_requant_sse,          
+                conv7x7s2_int8_requant_sse, 
+                0,
+                0
+            }  // kernel_size = 7
+        };
 
-    if (use_int8_inference)
-    {
         if (use_int8_requantize)
             conv_int8_requant = conv_int8_requant_func_table[kernel_size-1][stride-1];
         else
-            conv_int8_dequant = conv_int8_dequant_func_table[kernel_size-1][stride-1];  
+            conv_int8_dequant = conv_int8_dequant_func_table[kernel_size-1][stride-1];
         if ((!conv_int8_requant) && (!conv_int8_dequant))
         {
             return Convolution::forward(bottom_blob, top_blob, opt);
         }
     }
-    else
-    {
-        conv = conv_func_table[kernel_size-1][stride-1];
-        if (!conv)
-        {
-            return Convolution::forward(bottom_blob, top_blob, opt);
-        }
-
-        if (dilation_w != 1)
-        {
-            if (stride != 1)
-                return Convolution::forward(bottom_blob, top_blob, opt);
-
-            return forwardDilation(bottom_blob, top_blob, conv, opt);
-        }
-    }
 
     int w = bottom_blob.w;
     int h = bottom_blob.h;
@@ -463,33 +410,19 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         bottom_blob_unbordered = bottom_blob_int8;
     }
 
-    Mat bottom_blob_bordered = bottom_blob_unbordered;
-    if (pad_w > 0 || pad_h > 0)
-    {
-        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-        if (bottom_blob_bordered.empty())
-            return -100;
+    Mat bottom_blob_bordered;
+    int ret = make_padding(bottom_blob_unbordered, bottom_blob_bordered, opt);
+    if (ret != 0)
+        return ret;
 
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-    else if (pad_w == -233 && pad_h == -233)
-    {
-        int wpad = kernel_size + (w - 1) / stride * stride - w;
-        int hpad = kernel_size + (h - 1) / stride * stride - h;
-        if (wpad > 0 || hpad > 0)
-        {
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-            if (bottom_blob_bordered.empty())
-                return -100;
-        }
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
 
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
 
-    int outw = (w - kernel_size) / stride + 1;
-    int outh = (h - kernel_size) / stride + 1;
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
 
     // int8
     if (use_int8_inference)
@@ -505,6 +438,16 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             if (top_blob.empty())
                 return -100; 
 
+#if NCNN_RUNTIME_CPU
+            if (use_int8_dot)
+            {
+                if (use_avx512_vnni)
+                    conv_im2col_sgemm_int8_requant_avx512vnni(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, weight_sgemm_int8_sum, bias_data, requantize_scales, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+                else
+                    conv_im2col_sgemm_int8_requant_avx2(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, weight_sgemm_int8_sum, bias_data, requantize_scales, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+            }
+            else
+#endif // NCNN_RUNTIME_CPU
             if (use_winograd3x3)
             {
                 // conv3x3s1_winograd23_int8_sse(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_data, opt);
@@ -532,6 +475,16 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             if (top_blob.empty())
                 return -100;
 
+#if NCNN_RUNTIME_CPU
+            if (use_int8_dot)
+            {
+                if (use_avx512_vnni)
+                    conv_im2col_sgemm_int8_dequant_avx512vnni(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, weight_sgemm_int8_sum, bias_data, dequantize_scales, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+                else
+                    conv_im2col_sgemm_int8_dequant_avx2(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, weight_sgemm_int8_sum, bias_data, dequantize_scales, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+            }
+            else
+#endif // NCNN_RUNTIME_CPU
             if (use_winograd3x3)
             {
                 // conv3x3s1_winograd23_int8_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, opt);
@@ -553,6 +506,11 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
                 conv_int8_dequant(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);     
         }
 
+        if (activation)
+        {
+            activation->forward_inplace(top_blob, opt);
+        }
+
         return 0;
     }
 
@@ -561,14 +519,365 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     if (top_blob.empty())
         return -100;    
 
-    if (use_winograd3x3 && outw >= 8 && outh >=8)
+    int winograd_m = winograd_tile_size(bottom_blob_bordered, top_blob, opt);
+
+    forward_float(bottom_blob_bordered, top_blob, winograd_m, 0, opt);
+
+    if (activation)
+    {
+        activation->forward_inplace(top_blob, opt);
+    }
+
+    return 0;
+}
+
+int Convolution_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& residual_blob = bottom_blobs[1];
+
+    // the packed, int8 and activation paths sum the residual in a pass of their own
+    const bool use_pack4 = support_packing && opt.use_packing_layout && bottom_blob.packing == elempack && bottom_blob.elemsize == 4u * elempack;
+    if (!use_fused_eltwise || activation || use_int8_inference || use_pack4 || bottom_blob.dims != 3 || bottom_blob.packing != 1 || bottom_blob.elemsize != 4u || residual_blob.packing != 1)
+    {
+        return Convolution::forward(bottom_blobs, top_blobs, opt);
+    }
+
+    Mat bottom_blob_bordered;
+    int ret = make_padding(bottom_blob, bottom_blob_bordered, opt);
+    if (ret != 0)
+        return ret;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    int outw = (bottom_blob_bordered.w - kernel_extent_w) / stride_w + 1;
+    int outh = (bottom_blob_bordered.h - kernel_extent_h) / stride_h + 1;
+
+    if (residual_blob.w != outw || residual_blob.h != outh || residual_blob.c != num_output || residual_blob.elemsize != 4u)
+    {
+        fprintf(stderr, "fused eltwise residual shape mismatch\n");
+        return -1;
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(outw, outh, num_output, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    int winograd_m = winograd_tile_size(bottom_blob_bordered, top_blob, opt);
+
+    const ConvolutionEpilogue epilogue = fused_epilogue(residual_blob);
+    forward_float(bottom_blob_bordered, top_blob, winograd_m, &epilogue, opt);
+
+    return 0;
+}
+
+int Convolution_x86::forward_float(const Mat& bottom_blob_bordered, Mat& top_blob, int winograd_m, const ConvolutionEpilogue* epilogue, const Option& opt) const
+{
+    const Mat& weight_3x3_winograd_data = winograd_m == 6 ? weight_3x3_winograd63_data : weight_3x3_winograd43_data;
+
+#if NCNN_RUNTIME_CPU
+    if (use_avx512)
+    {
+        if (winograd_m)
+            conv3x3s1_winograd_avx512(bottom_blob_bordered, top_blob, weight_3x3_winograd_data, bias_data, winograd_m, epilogue, opt);
+        else if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+            conv1x1s1_sgemm_avx512(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, epilogue, opt);
+        else
+            conv_im2col_sgemm_avx512(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, epilogue, opt);
+    }
+    else if (use_avx2)
+    {
+        if (winograd_m)
+            conv3x3s1_winograd_avx2(bottom_blob_bordered, top_blob, weight_3x3_winograd_data, bias_data, winograd_m, epilogue, opt);
+        else if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+            conv1x1s1_sgemm_avx2(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, epilogue, opt);
+        else
+            conv_im2col_sgemm_avx2(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, epilogue, opt);
+    }
+    else
+#endif
+    if (winograd_m)
+        conv3x3s1_winograd(bottom_blob_bordered, top_blob, weight_3x3_winograd_data, bias_data, winograd_m, epilogue, opt);
+    else if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+        // 1x1 stride 1 reads the bottom blob as the im2col matrix
+        conv1x1s1_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, epilogue, opt);
+    else
+        conv_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, epilogue, opt);
+
+    return 0;
+}
+
+int Convolution_x86::forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const int batch = bottom_blobs.size();
+
+    // packed layout runs sample by sample
+    if ((support_packing && opt.use_packing_layout) || bottom_blobs[0].packing != 1)
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+    int w = bottom_blobs[0].w;
+    int h = bottom_blobs[0].h;
+    int channels = bottom_blobs[0].c;
+    size_t elemsize = bottom_blobs[0].elemsize;
+
+    bool same_shape = bottom_blobs[0].dims == 3;
+    for (int n=1; n<batch; n++)
     {
-        // conv3x3s1_winograd23_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, bias_data, opt);
-        conv3x3s1_winograd43_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd43_data, bias_data, opt);
+        const Mat& m = bottom_blobs[n];
+        if (m.dims != 3 || m.w != w || m.h != h || m.c != channels || m.elemsize != elemsize)
+            same_shape = false;
+    }
+
+    // batched gemm covers the float32 im2col path only
+    if (use_int8_inference || elemsize != 4u || !same_shape)
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+    std::vector<Mat> bottom_blobs_bordered(batch);
+    for (int n=0; n<batch; n++)
+    {
+        int ret = make_padding(bottom_blobs[n], bottom_blobs_bordered[n], opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    w = bottom_blobs_bordered[0].w;
+    h = bottom_blobs_bordered[0].h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    if (winograd_tile_size(outw, outh, channels))
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+    // large feature maps already fill the 8 column tiles of sgemm
+    // gathering them only spills the wider im2col workspace out of cache
+    if (outw * outh > 256)
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+    top_blobs.resize(batch);
+    for (int n=0; n<batch; n++)
+    {
+        top_blobs[n].create(outw, outh, num_output, elemsize, opt.blob_allocator);
+        if (top_blobs[n].empty())
+            return -100;
+    }
+
+#if NCNN_RUNTIME_CPU
+    if (use_avx512)
+        conv_im2col_sgemm_batch_avx512(bottom_blobs_bordered, top_blobs, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+    else if (use_avx2)
+        conv_im2col_sgemm_batch_avx2(bottom_blobs_bordered, top_blobs, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+    else
+#endif
+    conv_im2col_sgemm_batch_sse(bottom_blobs_bordered, top_blobs, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+
+    if (activation)
+    {
+        for (int n=0; n<batch; n++)
+        {
+            activation->forward_inplace(top_blobs[n], opt);
+        }
+    }
+
+    return 0;
+}
+
+int Convolution_x86::make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    bottom_blob_bordered = bottom_blob;
+    if (pad_w > 0 || pad_h > 0)
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+    }
+    else if (pad_w == -233 && pad_h == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
     }
+
+    return 0;
+}
+
+int Convolution_x86::winograd_tile_size(int outw, int outh, int num_input) const
+{
+    if (!use_winograd3x3 || use_int8_inference)
+        return 0;
+
+    // only the tile sizes whose kernels were transformed
+    int mask = 0;
+    if (!weight_3x3_winograd63_data.empty())
+        mask |= WINOGRAD_F63;
+    if (!weight_3x3_winograd43_data.empty())
+        mask |= WINOGRAD_F43;
+
+    // a tuned choice wins over the cost model
+    int winograd_m = kernel_choices.find(outw, outh, num_input);
+    if (winograd_m == 0 || (winograd_m == 6 && (mask & WINOGRAD_F63)) || (winograd_m == 4 && (mask & WINOGRAD_F43)))
+        return winograd_m;
+
+    return winograd_select(outw, outh, num_input, mask);
+}
+
+int Convolution_x86::winograd_tile_size(const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const
+{
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int channels = bottom_blob_bordered.c;
+
+    if (opt.use_kernel_autotune && use_winograd3x3 && kernel_choices.find(outw, outh, channels) == -1)
+    {
+        return tune_winograd_tile_size(bottom_blob_bordered, top_blob, opt);
+    }
+
+    return winograd_tile_size(outw, outh, channels);
+}
+
+int Convolution_x86::tune_winograd_tile_size(const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const
+{
+    const int candidates[3] = { 0, 4, 6 };
+
+    int best_m = 0;
+    double best_time = -1;
+    for (int i=0; i<3; i++)
+    {
+        const int m = candidates[i];
+        if ((m == 6 && weight_3x3_winograd63_data.empty()) || (m == 4 && weight_3x3_winograd43_data.empty()))
+            continue;
+
+        // the first run warms up caches and allocators, the second one is timed
+        double time = 0;
+        for (int j=0; j<2; j++)
+        {
+            double start = get_current_time();
+
+            forward_float(bottom_blob_bordered, top_blob, m, 0, opt);
+
+            time = get_current_time() - start;
+        }
+
+        if (best_time < 0 || time < best_time)
+        {
+            best_time = time;
+            best_m = m;
+        }
+    }
+
+    kernel_choices.insert(top_blob.w, top_blob.h, bottom_blob_bordered.c, best_m);
+
+    return best_m;
+}
+
+int Convolution_x86::load_kernel_choices(const std::vector<KernelChoice>& choices)
+{
+    kernel_choices.assign(choices);
+
+    return 0;
+}
+
+int Convolution_x86::save_kernel_choices(std::vector<KernelChoice>& choices) const
+{
+    choices = kernel_choices.choices();
+
+    return 0;
+}
+
+int Convolution_x86::winograd_select(int outw, int outh, int num_input, int mask) const
+{
+#if NCNN_RUNTIME_CPU
+    if (use_avx512)
+        return conv3x3s1_winograd_select_avx512(outw, outh, num_input, num_output, mask);
+    if (use_avx2)
+        return conv3x3s1_winograd_select_avx2(outw, outh, num_input, num_output, mask);
+#endif
+
+    return conv3x3s1_winograd_select(outw, outh, num_input, num_output, mask);
+}
+
+int Convolution_x86::forward_pack4(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if __SSE2__
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    Mat bottom_blob_bordered = bottom_blob;
+    if (pad_w > 0 || pad_h > 0)
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_w == -233 && pad_h == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, num_output / 4, (size_t)16u, 4, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int maxk = kernel_w * kernel_h;
+    const int nk = channels * maxk;
+
+    const float* bottom_tm = bottom_blob_bordered;
+    size_t rowstep = bottom_blob_bordered.cstep * elempack;
+
+    // 1x1 stride 1 reads the bottom blob as the im2col matrix
+    Mat bottom_im2col;
+    if (!(kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1))
+    {
+        bottom_im2col.create(outw * outh, nk, bottom_blob.elemsize, elempack, opt.workspace_allocator);
+        if (bottom_im2col.empty())
+            return -100;
+
+        conv_im2col_pack_sse(bottom_blob_bordered, bottom_im2col, outw, outh, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+
+        bottom_tm = bottom_im2col;
+        rowstep = outw * outh * elempack;
+    }
+
+    if (elempack == 4)
+        conv_sgemm_pack4to4_sse(bottom_tm, rowstep, nk, top_blob, weight_sgemm_pack4_data, bias_data, opt);
     else
-        //conv(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
-        conv_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, opt);
+        conv_sgemm_pack1to4_sse(bottom_tm, rowstep, nk, top_blob, weight_sgemm_pack4_data, bias_data, opt);
 
     if (activation)
     {
@@ -576,6 +885,9 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     }
 
     return 0;
+#else
+    return -1;
+#endif // __SSE2__
 }
 
 } // namespace ncnn
@@ -19,8 +19,6 @@
 
 namespace ncnn {
 
-typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, const Option&);
-
 class Convolution_x86 : virtual public Convolution
 {
 public:
@@ -30,14 +28,55 @@ public:
     virtual int destroy_pipeline(const Option& opt);
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
-    virtual int forwardDilation(const Mat& bottom_blob, Mat &top_blob, conv_func conv, const Option& opt) const;
+
+    // the float32 kernels apply the fused residual sum and relu as they store each output tile
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    virtual int forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    virtual int load_kernel_choices(const std::vector<KernelChoice>& choices);
+    virtual int save_kernel_choices(std::vector<KernelChoice>& choices) const;
+
+protected:
+    int make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const;
+
+    int forward_pack4(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    // winograd output tile size for this feature map, 0 for sgemm
+    int winograd_tile_size(int outw, int outh, int num_input) const;
+    // pick among the winograd tile sizes in mask, 0 for sgemm
+    int winograd_select(int outw, int outh, int num_input, int mask) const;
+    // time sgemm and the transformed winograd kernels on this input, record and return the fastest
+    int tune_winograd_tile_size(const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const;
+
+    // winograd tile size for the bordered input, tuned on it the first time when autotune is on
+    int winograd_tile_size(const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const;
+
+    // float32 convolution of the bordered input into top_blob, without activation
+    // epilogue is the fused residual sum, or null
+    int forward_float(const Mat& bottom_blob_bordered, Mat& top_blob, int winograd_m, const ConvolutionEpilogue* epilogue, const Option& opt) const;
 
 public:
     Layer* activation;
+    bool use_avx2;
+    bool use_avx512;
+    bool use_avx512_vnni;
     bool use_winograd3x3;
     Mat weight_3x3_winograd23_data;
     Mat weight_sgemm_data;
-    std::vector<Mat> weight_3x3_winograd43_data;
+    Mat weight_3x3_winograd63_data;
+    Mat weight_3x3_winograd43_data;
+
+    // winograd tile size per output size w h and input channels, 0 for sgemm
+    mutable KernelChoiceCache kernel_choices;
+
+    // int8 weights for the dot product kernels and their 128 * sum per output channel
+    Mat weight_sgemm_int8_data;
+    Mat weight_sgemm_int8_sum;
+
+    // input blob packing the packed weights are arranged for
+    int elempack;
+    Mat weight_sgemm_pack4_data;
 };
 
 } // namespace ncnn
@@ -0,0 +1,41 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_CONVOLUTION_X86_AVX2_H
+#define LAYER_CONVOLUTION_X86_AVX2_H
+
+#include <vector>
+#include "mat.h"
+#include "option.h"
+#include "convolution.h"
+
+namespace ncnn {
+
+// 8-wide fma kernels built with avx2 enabled
+// only call them when cpu_support_x86_avx2() is true
+void conv_im2col_sgemm_transform_kernel_avx2(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int kernel_size);
+void conv_im2col_sgemm_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const ConvolutionEpilogue* epilogue, const Option& opt);
+void conv_im2col_sgemm_batch_avx2(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+void conv1x1s1_sgemm_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, const ConvolutionEpilogue* epilogue, const Option& opt);
+int conv3x3s1_winograd_select_avx2(int outw, int outh, int inch, int outch, int mask);
+void conv3x3s1_winograd_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int m, const ConvolutionEpilogue* epilogue, const Option& opt);
+
+// int8 kernels on vpmaddubsw, the packed kernel is shared with the avx512 vnni ones
+void conv_im2col_sgemm_int8_transform_kernel_avx2(const Mat& kernel, Mat& kernel_tm, Mat& kernel_sum, int inch, int outch, int kernel_size);
+void conv_im2col_sgemm_int8_dequant_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& bias, const std::vector<float>& scales_dequant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+void conv_im2col_sgemm_int8_requant_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& bias, const std::vector<float>& scales_requant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+
+} // namespace ncnn
+
+#endif // LAYER_CONVOLUTION_X86_AVX2_H
@@ -0,0 +1,54 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// this file is compiled with avx512f, avx2 and fma enabled
+// the shared sgemm header takes its __AVX512F__ 16 column tiles here
+
+#include "convolution_x86_avx512.h"
+
+#include <string.h>
+#include <algorithm>
+#include <immintrin.h>
+
+namespace ncnn {
+
+#include "convolution_sgemm.h"
+#include "convolution_winograd.h"
+
+void conv_im2col_sgemm_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const ConvolutionEpilogue* epilogue, const Option& opt)
+{
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, kernel_tm, bias, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, epilogue, opt);
+}
+
+void conv_im2col_sgemm_batch_avx512(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    conv_im2col_sgemm_batch_sse(bottom_blobs, top_blobs, kernel_tm, bias, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+}
+
+void conv1x1s1_sgemm_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, const ConvolutionEpilogue* epilogue, const Option& opt)
+{
+    conv1x1s1_sgemm_sse(bottom_blob, top_blob, kernel_tm, bias, epilogue, opt);
+}
+
+int conv3x3s1_winograd_select_avx512(int outw, int outh, int inch, int outch, int mask)
+{
+    return conv3x3s1_winograd_select(outw, outh, inch, outch, mask);
+}
+
+void conv3x3s1_winograd_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int m, const ConvolutionEpilogue* epilogue, const Option& opt)
+{
+    conv3x3s1_winograd(bottom_blob, top_blob, kernel_tm, bias, m, epilogue, opt);
+}
+
+} // namespace ncnn
@@ -0,0 +1,36 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_CONVOLUTION_X86_AVX512_H
+#define LAYER_CONVOLUTION_X86_AVX512_H
+
+#include <vector>
+#include "mat.h"
+#include "option.h"
+#include "convolution.h"
+
+namespace ncnn {
+
+// 16-wide fma kernels built with avx512f enabled
+// the packed kernel is the avx2 one from conv_im2col_sgemm_transform_kernel_avx2
+// only call them when cpu_support_x86_avx512() is true
+void conv_im2col_sgemm_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const ConvolutionEpilogue* epilogue, const Option& opt);
+void conv_im2col_sgemm_batch_avx512(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+void conv1x1s1_sgemm_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, const ConvolutionEpilogue* epilogue, const Option& opt);
+int conv3x3s1_winograd_select_avx512(int outw, int outh, int inch, int outch, int mask);
+void conv3x3s1_winograd_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int m, const ConvolutionEpilogue* epilogue, const Option& opt);
+
+} // namespace ncnn
+
+#endif // LAYER_CONVOLUTION_X86_AVX512_H
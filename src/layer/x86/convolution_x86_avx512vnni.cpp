@@ -0,0 +1,39 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// this file is compiled with avx512f, avx512 vnni, avx2 and fma enabled
+// the int8 dot header takes its __AVX512VNNI__ vpdpbusd path here
+
+#include "convolution_x86_avx512vnni.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <immintrin.h>
+
+namespace ncnn {
+
+#include "convolution_sgemm_int8_dot.h"
+
+void conv_im2col_sgemm_int8_dequant_avx512vnni(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& bias, const std::vector<float>& scales_dequant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    conv_im2col_sgemm_int8_dot(bottom_blob, top_blob, kernel_tm, kernel_sum, bias, scales_dequant, false, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+}
+
+void conv_im2col_sgemm_int8_requant_avx512vnni(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& bias, const std::vector<float>& scales_requant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    conv_im2col_sgemm_int8_dot(bottom_blob, top_blob, kernel_tm, kernel_sum, bias, scales_requant, true, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+}
+
+} // namespace ncnn
@@ -0,0 +1,32 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_CONVOLUTION_X86_AVX512VNNI_H
+#define LAYER_CONVOLUTION_X86_AVX512VNNI_H
+
+#include <vector>
+#include "mat.h"
+#include "option.h"
+
+namespace ncnn {
+
+// 16-wide int8 kernels built with avx512f and avx512 vnni enabled
+// the packed kernel is the avx2 one from conv_im2col_sgemm_int8_transform_kernel_avx2
+// only call them when cpu_support_x86_avx512_vnni() is true
+void conv_im2col_sgemm_int8_dequant_avx512vnni(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& bias, const std::vector<float>& scales_dequant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+void conv_im2col_sgemm_int8_requant_avx512vnni(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& kernel_sum, const Mat& bias, const std::vector<float>& scales_requant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+
+} // namespace ncnn
+
+#endif // LAYER_CONVOLUTION_X86_AVX512VNNI_H
@@ -47,6 +47,19 @@ static void convdw3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
         const float* k1 = kernel0 + 3;
         const float* k2 = kernel0 + 6;
 
+#if __AVX512F__
+        __m512 _bias0 = _mm512_set1_ps(bias0);
+        __m512 _k00 = _mm512_set1_ps(k0[0]);
+        __m512 _k01 = _mm512_set1_ps(k0[1]);
+        __m512 _k02 = _mm512_set1_ps(k0[2]);
+        __m512 _k10 = _mm512_set1_ps(k1[0]);
+        __m512 _k11 = _mm512_set1_ps(k1[1]);
+        __m512 _k12 = _mm512_set1_ps(k1[2]);
+        __m512 _k20 = _mm512_set1_ps(k2[0]);
+        __m512 _k21 = _mm512_set1_ps(k2[1]);
+        __m512 _k22 = _mm512_set1_ps(k2[2]);
+#endif // __AVX512F__
+
         int i = 0;
 
         for (; i+1 < outh; i+=2)
@@ -54,6 +67,54 @@ static void convdw3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
 
             int remain = outw;
 
+#if __AVX512F__
+            for (; remain>15; remain-=16)
+            {
+                __m512 _r00 = _mm512_loadu_ps(r0);
+                __m512 _r01 = _mm512_loadu_ps(r0+1);
+                __m512 _r02 = _mm512_loadu_ps(r0+2);
+                __m512 _r10 = _mm512_loadu_ps(r1);
+                __m512 _r11 = _mm512_loadu_ps(r1+1);
+                __m512 _r12 = _mm512_loadu_ps(r1+2);
+                __m512 _r20 = _mm512_loadu_ps(r2);
+                __m512 _r21 = _mm512_loadu_ps(r2+1);
+                __m512 _r22 = _mm512_loadu_ps(r2+2);
+                __m512 _r30 = _mm512_loadu_ps(r3);
+                __m512 _r31 = _mm512_loadu_ps(r3+1);
+                __m512 _r32 = _mm512_loadu_ps(r3+2);
+
+                __m512 _sum = _mm512_fmadd_ps(_r00, _k00, _bias0);
+                _sum = _mm512_fmadd_ps(_r01, _k01, _sum);
+                _sum = _mm512_fmadd_ps(_r02, _k02, _sum);
+                _sum = _mm512_fmadd_ps(_r10, _k10, _sum);
+                _sum = _mm512_fmadd_ps(_r11, _k11, _sum);
+                _sum = _mm512_fmadd_ps(_r12, _k12, _sum);
+                _sum = _mm512_fmadd_ps(_r20, _k20, _sum);
+                _sum = _mm512_fmadd_ps(_r21, _k21, _sum);
+                _sum = _mm512_fmadd_ps(_r22, _k22, _sum);
+
+                __m512 _sum2 = _mm512_fmadd_ps(_r10, _k00, _bias0);
+                _sum2 = _mm512_fmadd_ps(_r11, _k01, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r12, _k02, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r20, _k10, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r21, _k11, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r22, _k12, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r30, _k20, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r31, _k21, _sum2);
+                _sum2 = _mm512_fmadd_ps(_r32, _k22, _sum2);
+
+                _mm512_storeu_ps(outptr, _sum);
+                _mm512_storeu_ps(outptr2, _sum2);
+
+                r0 += 16;
+                r1 += 16;
+                r2 += 16;
+                r3 += 16;
+                outptr += 16;
+                outptr2 += 16;
+            }
+#endif // __AVX512F__
+
             for (; remain>0; remain--)
             {
                 float sum = bias0;
@@ -102,6 +163,28 @@ static void convdw3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
         {
             int remain = outw;
 
+#if __AVX512F__
+            for (; remain>15; remain-=16)
+            {
+                __m512 _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r0), _k00, _bias0);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r0+1), _k01, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r0+2), _k02, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r1), _k10, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r1+1), _k11, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r1+2), _k12, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r2), _k20, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r2+1), _k21, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r2+2), _k22, _sum);
+
+                _mm512_storeu_ps(outptr, _sum);
+
+                r0 += 16;
+                r1 += 16;
+                r2 += 16;
+                outptr += 16;
+            }
+#endif // __AVX512F__
+
             for (; remain>0; remain--)
             {
                 float sum = bias0;
@@ -130,6 +213,26 @@ static void convdw3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
     }
 }
 
+#if __AVX512F__
+// deinterleave the three taps of 16 stride 2 outputs
+// r[0] r[2] .. r[30], r[1] r[3] .. r[31] and r[2] r[4] .. r[32]
+static inline void convdw3x3s2_load_avx512(const float* r, __m512& _r0, __m512& _r1, __m512& _r2)
+{
+    const __m512i _even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i _odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    const __m512i _next = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+
+    __m512 _a = _mm512_loadu_ps(r);
+    __m512 _b = _mm512_loadu_ps(r + 16);
+    // r[32] may be the last element of the blob, load nothing past it
+    __m512 _c = _mm512_maskz_loadu_ps(1, r + 32);
+
+    _r0 = _mm512_permutex2var_ps(_a, _even, _b);
+    _r1 = _mm512_permutex2var_ps(_a, _odd, _b);
+    _r2 = _mm512_permutex2var_ps(_r0, _next, _c);
+}
+#endif // __AVX512F__
+
 static void convdw3x3s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, const Option& opt)
 {
     int w = bottom_blob.w;
@@ -165,12 +268,54 @@ static void convdw3x3s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
         const float* k1 = kernel0 + 3;
         const float* k2 = kernel0 + 6;
 
+#if __AVX512F__
+        __m512 _bias0 = _mm512_set1_ps(bias0);
+        __m512 _k00 = _mm512_set1_ps(k0[0]);
+        __m512 _k01 = _mm512_set1_ps(k0[1]);
+        __m512 _k02 = _mm512_set1_ps(k0[2]);
+        __m512 _k10 = _mm512_set1_ps(k1[0]);
+        __m512 _k11 = _mm512_set1_ps(k1[1]);
+        __m512 _k12 = _mm512_set1_ps(k1[2]);
+        __m512 _k20 = _mm512_set1_ps(k2[0]);
+        __m512 _k21 = _mm512_set1_ps(k2[1]);
+        __m512 _k22 = _mm512_set1_ps(k2[2]);
+#endif // __AVX512F__
+
         int i = 0;
 
         for (; i < outh; i++)
         {
             int remain = outw;
 
+#if __AVX512F__
+            for (; remain>15; remain-=16)
+            {
+                __m512 _r00, _r01, _r02;
+                __m512 _r10, _r11, _r12;
+                __m512 _r20, _r21, _r22;
+                convdw3x3s2_load_avx512(r0, _r00, _r01, _r02);
+                convdw3x3s2_load_avx512(r1, _r10, _r11, _r12);
+                convdw3x3s2_load_avx512(r2, _r20, _r21, _r22);
+
+                __m512 _sum = _mm512_fmadd_ps(_r00, _k00, _bias0);
+                _sum = _mm512_fmadd_ps(_r01, _k01, _sum);
+                _sum = _mm512_fmadd_ps(_r02, _k02, _sum);
+                _sum = _mm512_fmadd_ps(_r10, _k10, _sum);
+                _sum = _mm512_fmadd_ps(_r11, _k11, _sum);
+                _sum = _mm512_fmadd_ps(_r12, _k12, _sum);
+                _sum = _mm512_fmadd_ps(_r20, _k20, _sum);
+                _sum = _mm512_fmadd_ps(_r21, _k21, _sum);
+                _sum = _mm512_fmadd_ps(_r22, _k22, _sum);
+
+                _mm512_storeu_ps(outptr, _sum);
+
+                r0 += 32;
+                r1 += 32;
+                r2 += 32;
+                outptr += 16;
+            }
+#endif // __AVX512F__
+
             for (; remain>0; remain--)
             {
                 float sum = bias0;
@@ -0,0 +1,152 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+static void convdw3x3s1_pack4_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& _bias, const Option& opt)
+{
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+
+    const int group = bottom_blob.c;
+
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<group; g++)
+    {
+        Mat out = top_blob.channel(g);
+
+        __m128 _bias0 = bias ? _mm_loadu_ps(bias + g * 4) : _mm_setzero_ps();
+
+        const float* k0 = kernel.row(g);
+
+        float* outptr = out;
+
+        const Mat img0 = bottom_blob.channel(g);
+
+        const float* r0 = img0.row(0);
+        const float* r1 = img0.row(1);
+        const float* r2 = img0.row(2);
+
+        __m128 _k00 = _mm_loadu_ps(k0);
+        __m128 _k01 = _mm_loadu_ps(k0+4);
+        __m128 _k02 = _mm_loadu_ps(k0+8);
+        __m128 _k10 = _mm_loadu_ps(k0+12);
+        __m128 _k11 = _mm_loadu_ps(k0+16);
+        __m128 _k12 = _mm_loadu_ps(k0+20);
+        __m128 _k20 = _mm_loadu_ps(k0+24);
+        __m128 _k21 = _mm_loadu_ps(k0+28);
+        __m128 _k22 = _mm_loadu_ps(k0+32);
+
+        for (int i = 0; i < outh; i++)
+        {
+            for (int j = 0; j < outw; j++)
+            {
+                __m128 _sum = _bias0;
+
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k00, _mm_loadu_ps(r0)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k01, _mm_loadu_ps(r0+4)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k02, _mm_loadu_ps(r0+8)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k10, _mm_loadu_ps(r1)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k11, _mm_loadu_ps(r1+4)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k12, _mm_loadu_ps(r1+8)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k20, _mm_loadu_ps(r2)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k21, _mm_loadu_ps(r2+4)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k22, _mm_loadu_ps(r2+8)));
+
+                _mm_storeu_ps(outptr, _sum);
+
+                r0 += 4;
+                r1 += 4;
+                r2 += 4;
+                outptr += 4;
+            }
+
+            r0 += 2 * 4;
+            r1 += 2 * 4;
+            r2 += 2 * 4;
+        }
+    }
+}
+
+static void convdw3x3s2_pack4_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& _bias, const Option& opt)
+{
+    int w = bottom_blob.w;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+
+    const int group = bottom_blob.c;
+
+    const int tailstep = (w - 2*outw + w) * 4;
+
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<group; g++)
+    {
+        Mat out = top_blob.channel(g);
+
+        __m128 _bias0 = bias ? _mm_loadu_ps(bias + g * 4) : _mm_setzero_ps();
+
+        const float* k0 = kernel.row(g);
+
+        float* outptr = out;
+
+        const Mat img0 = bottom_blob.channel(g);
+
+        const float* r0 = img0.row(0);
+        const float* r1 = img0.row(1);
+        const float* r2 = img0.row(2);
+
+        __m128 _k00 = _mm_loadu_ps(k0);
+        __m128 _k01 = _mm_loadu_ps(k0+4);
+        __m128 _k02 = _mm_loadu_ps(k0+8);
+        __m128 _k10 = _mm_loadu_ps(k0+12);
+        __m128 _k11 = _mm_loadu_ps(k0+16);
+        __m128 _k12 = _mm_loadu_ps(k0+20);
+        __m128 _k20 = _mm_loadu_ps(k0+24);
+        __m128 _k21 = _mm_loadu_ps(k0+28);
+        __m128 _k22 = _mm_loadu_ps(k0+32);
+
+        for (int i = 0; i < outh; i++)
+        {
+            for (int j = 0; j < outw; j++)
+            {
+                __m128 _sum = _bias0;
+
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k00, _mm_loadu_ps(r0)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k01, _mm_loadu_ps(r0+4)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k02, _mm_loadu_ps(r0+8)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k10, _mm_loadu_ps(r1)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k11, _mm_loadu_ps(r1+4)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k12, _mm_loadu_ps(r1+8)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k20, _mm_loadu_ps(r2)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k21, _mm_loadu_ps(r2+4)));
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_k22, _mm_loadu_ps(r2+8)));
+
+                _mm_storeu_ps(outptr, _sum);
+
+                r0 += 2 * 4;
+                r1 += 2 * 4;
+                r2 += 2 * 4;
+                outptr += 4;
+            }
+
+            r0 += tailstep;
+            r1 += tailstep;
+            r2 += tailstep;
+        }
+    }
+}
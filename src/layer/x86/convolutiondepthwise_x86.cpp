@@ -14,15 +14,28 @@
 
 #include "convolutiondepthwise_x86.h"
 
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
 #include "layer_type.h"
+#include "cpu.h"
+
+#if NCNN_RUNTIME_CPU
+#include "convolutiondepthwise_x86_avx512.h"
+#endif
 
 namespace ncnn {
 
 #include "convolutiondepthwise_3x3.h"
+#if __SSE2__
+#include "convolutiondepthwise_3x3_pack4.h"
+#endif // __SSE2__
 
 #include "convolutiondepthwise_3x3_int8.h"
 
@@ -31,6 +44,7 @@ DEFINE_LAYER_CREATOR(ConvolutionDepthWise_x86)
 ConvolutionDepthWise_x86::ConvolutionDepthWise_x86()
 {
     activation = 0;
+    use_avx512 = false;
 }
 
 int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
@@ -38,6 +52,11 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
     Option opt_cpu = opt;
     opt_cpu.use_vulkan_compute = false;
 
+    use_avx512 = false;
+#if NCNN_RUNTIME_CPU
+    use_avx512 = cpu_support_x86_avx512();
+#endif
+
     if (activation_type == 1)
     {
         activation = ncnn::create_layer(ncnn::LayerType::ReLU);
@@ -84,6 +103,34 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
 
     group_ops.clear();      
 
+    support_packing = false;
+    weight_data_pack4.release();
+
+#if __SSE2__
+    if (opt.use_packing_layout && !use_int8_inference && channels == group && group == num_output && num_output % 4 == 0)
+    {
+        support_packing = true;
+
+        // interleave 4 channels per kernel tap
+        weight_data_pack4.create(maxk, group / 4, (size_t)16u, 4);
+        if (weight_data_pack4.empty())
+            return -100;
+
+        for (int g=0; g<group / 4; g++)
+        {
+            float* kptr = weight_data_pack4.row(g);
+
+            for (int k=0; k<maxk; k++)
+            {
+                for (int i=0; i<4; i++)
+                {
+                    kptr[k * 4 + i] = weight_data[(g * 4 + i) * maxk + k];
+                }
+            }
+        }
+    }
+#endif // __SSE2__
+
     if (channels == group && group == num_output)
     {
         // depth-wise specific
@@ -99,6 +146,9 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
     const int channels_g = channels / group;
     const int num_output_g = num_output / group;
 
+    // group ops write into channel range views of a plain blob
+    opt_cpu.use_packing_layout = false;
+
     group_ops.resize(group);     
 
     for (int g=0; g<group; g++)
@@ -136,7 +186,7 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
 
             if (int8_scale_term)
             {
-                weights[2] = weight_data_int8_scales.range(g, 1);
+                weights[2] = weight_data_int8_scales.range(num_output_g * g, num_output_g);
                 weights[3] = bottom_blob_int8_scales.range(g, 1);     
             }
 
@@ -149,7 +199,7 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
 
             if (int8_scale_term)
             {
-                weights[1] = weight_data_int8_scales.range(g, 1);
+                weights[1] = weight_data_int8_scales.range(num_output_g * g, num_output_g);
                 weights[2] = bottom_blob_int8_scales.range(g, 1);
             }
 
@@ -191,6 +241,11 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
     // convolv with NxN kernel
     // value = value + bias
 
+#if __SSE2__
+    if (bottom_blob.packing == 4)
+        return forward_pack4(bottom_blob, top_blob, opt);
+#endif // __SSE2__
+
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int channels = bottom_blob.c;
@@ -202,6 +257,12 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
         return -100;
     }
 
+    if (use_int8_requantize && !(channels == group && group == num_output && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))))
+    {
+        // the group convolutions only dequantize
+        return ConvolutionDepthWise::forward(bottom_blob, top_blob, opt);
+    }
+
     const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
     const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
 
@@ -264,71 +325,18 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
     {
         if (use_int8_requantize)
         {
-            Mat top_blob_tm;
-            top_blob_tm.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
-            if (top_blob_tm.empty())
-                return -100;
-            
             top_blob.create(outw, outh, num_output, (size_t)1u, opt.blob_allocator);
             if (top_blob.empty())
                 return -100;
 
-            // depth-wise
-            if (channels == group && group == num_output)
-            {                
-                if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
-                {
-                    if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
-                    {
-                        if (stride_w == 1 && stride_h == 1)
-                        {
-                            convdw3x3s1_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);                          
-                        }
-                        else if (stride_w == 2 && stride_h == 2)
-                        {
-                            convdw3x3s2_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);                           
-                        }
-
-                        return 0;
-                    }
-                }
-
-                #pragma omp parallel for num_threads(opt.num_threads)
-                for (int g=0; g<group; g++)
-                {
-                    const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(g, 1);
-                    Mat top_blob_tm_g = top_blob_tm.channel_range(g, 1);
-
-                    const ncnn::Layer* op = group_ops[g];
-
-                    ncnn::Option opt_g = opt;
-                    opt_g.num_threads = 1;
-                    opt_g.blob_allocator = top_blob.allocator;
-
-                    // forward
-                    op->forward(bottom_blob_bordered_g, top_blob_tm_g, opt_g);
-                }
-
-                return 0;
+            if (stride_w == 1 && stride_h == 1)
+            {
+                convdw3x3s1_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
             }
-
-            const int channels_g = channels / group;
-            const int num_output_g = num_output / group;
-
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int g=0; g<group; g++)
+            else if (stride_w == 2 && stride_h == 2)
             {
-                const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
-                Mat top_blob_tm_g = top_blob_tm.channel_range(num_output_g * g, num_output_g);
-
-                const ncnn::Layer* op = group_ops[g];
-
-                ncnn::Option opt_g = opt;
-                opt_g.blob_allocator = top_blob.allocator;
-
-                // forward
-                op->forward(bottom_blob_bordered_g, top_blob_tm_g, opt_g);
-            }       
+                convdw3x3s2_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
+            }
         }
         else
         {
@@ -337,25 +345,16 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
                 return -100;
 
             // depth-wise
-            if (channels == group && group == num_output)
-            {                
-                if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
-                {
-                    if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
-                    {
-                        if (stride_w == 1 && stride_h == 1)
-                        {
-                            convdw3x3s1_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);
-                        }
-                        else if (stride_w == 2 && stride_h == 2)
-                        {
-                            convdw3x3s2_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);                          
-                        }
-
-                        return 0;
-                    }
-                }
-
+            if (channels == group && group == num_output && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
+            {
+                convdw3x3s1_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);
+            }
+            else if (channels == group && group == num_output && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+            {
+                convdw3x3s2_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);
+            }
+            else if (channels == group && group == num_output)
+            {
                 #pragma omp parallel for num_threads(opt.num_threads)
                 for (int g=0; g<group; g++)
                 {
@@ -371,27 +370,32 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
                     // forward
                     op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
                 }
-              
-                return 0;
             }
+            else
+            {
+                const int channels_g = channels / group;
+                const int num_output_g = num_output / group;
 
-            const int channels_g = channels / group;
-            const int num_output_g = num_output / group;
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int g=0; g<group; g++)
+                {
+                    const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
+                    Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
 
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int g=0; g<group; g++)
-            {
-                const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
-                Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
+                    const ncnn::Layer* op = group_ops[g];
 
-                const ncnn::Layer* op = group_ops[g];
+                    ncnn::Option opt_g = opt;
+                    opt_g.blob_allocator = top_blob.allocator;
 
-                ncnn::Option opt_g = opt;
-                opt_g.blob_allocator = top_blob.allocator;
+                    // forward
+                    op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
+                }
+            }
+        }
 
-                // forward
-                op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
-            }                      
+        if (activation)
+        {
+            activation->forward_inplace(top_blob, opt);
         }
 
         return 0;
@@ -409,10 +413,20 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
         {
             if (stride_w == 1 && stride_h == 1)
             {
+#if NCNN_RUNTIME_CPU
+                if (use_avx512)
+                    convdw3x3s1_avx512(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
+                else
+#endif
                 convdw3x3s1_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
             }
             else if (stride_w == 2 && stride_h == 2)
             {
+#if NCNN_RUNTIME_CPU
+                if (use_avx512)
+                    convdw3x3s2_avx512(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
+                else
+#endif
                 convdw3x3s2_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
             }
 
@@ -473,4 +487,133 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
     return 0;
 }
 
+int ConvolutionDepthWise_x86::forward_pack4(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // depth-wise only, four channels per lane group
+
+    if (weight_data_pack4.empty() || bottom_blob.c * 4 != group)
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+
+        return forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+#if __SSE2__
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    Mat bottom_blob_bordered = bottom_blob;
+    if (pad_w > 0 || pad_h > 0)
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_w == -233 && pad_h == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, channels, elemsize, 4, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
+    {
+        convdw3x3s1_pack4_sse(bottom_blob_bordered, top_blob, weight_data_pack4, bias_data, opt);
+    }
+    else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+    {
+        convdw3x3s2_pack4_sse(bottom_blob_bordered, top_blob, weight_data_pack4, bias_data, opt);
+    }
+    else
+    {
+        const int maxk = kernel_w * kernel_h;
+
+        // kernel offsets, in pixels
+        std::vector<int> _space_ofs(maxk);
+        int* space_ofs = &_space_ofs[0];
+        {
+            int p1 = 0;
+            int p2 = 0;
+            int gap = w * dilation_h - kernel_w * dilation_w;
+            for (int i = 0; i < kernel_h; i++)
+            {
+                for (int j = 0; j < kernel_w; j++)
+                {
+                    space_ofs[p1] = p2;
+                    p1++;
+                    p2 += dilation_w;
+                }
+                p2 += gap;
+            }
+        }
+
+        const float* bias = bias_data;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int g=0; g<channels; g++)
+        {
+            const Mat m = bottom_blob_bordered.channel(g);
+            float* outptr = top_blob.channel(g);
+            const float* kptr = weight_data_pack4.row(g);
+
+            __m128 _bias0 = bias_term ? _mm_loadu_ps(bias + g * 4) : _mm_setzero_ps();
+
+            for (int i = 0; i < outh; i++)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    const float* sptr = (const float*)m.data + (i*stride_h * w + j*stride_w) * 4;
+
+                    __m128 _sum = _bias0;
+                    for (int k = 0; k < maxk; k++)
+                    {
+                        __m128 _val = _mm_loadu_ps(sptr + space_ofs[k] * 4);
+                        __m128 _w = _mm_loadu_ps(kptr + k * 4);
+                        _sum = _mm_add_ps(_sum, _mm_mul_ps(_val, _w));
+                    }
+
+                    _mm_storeu_ps(outptr, _sum);
+                    outptr += 4;
+                }
+            }
+        }
+    }
+
+    if (activation)
+    {
+        activation->forward_inplace(top_blob, opt);
+    }
+
+    return 0;
+#else
+    return -1;
+#endif // __SSE2__
+}
+
 } // namespace ncnn
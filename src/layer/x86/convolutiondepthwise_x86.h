@@ -29,9 +29,16 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+protected:
+    int forward_pack4(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
 public:
     Layer* activation;
+    bool use_avx512;
     std::vector<ncnn::Layer*> group_ops;
+
+    // packed weight layout [group/4][maxk][4]
+    Mat weight_data_pack4;
 };
 
 } // namespace ncnn
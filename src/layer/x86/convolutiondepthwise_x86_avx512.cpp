@@ -0,0 +1,36 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// this file is compiled with avx512f, avx2 and fma enabled
+// the shared depthwise header takes its __AVX512F__ paths here
+
+#include "convolutiondepthwise_x86_avx512.h"
+
+#include <immintrin.h>
+
+namespace ncnn {
+
+#include "convolutiondepthwise_3x3.h"
+
+void convdw3x3s1_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& bias, const Option& opt)
+{
+    convdw3x3s1_sse(bottom_blob, top_blob, kernel, bias, opt);
+}
+
+void convdw3x3s2_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& bias, const Option& opt)
+{
+    convdw3x3s2_sse(bottom_blob, top_blob, kernel, bias, opt);
+}
+
+} // namespace ncnn
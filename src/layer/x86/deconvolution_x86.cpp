@@ -0,0 +1,194 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "deconvolution_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+#if __AVX__
+#include <immintrin.h>
+#endif
+
+#include <string.h>
+#include <algorithm>
+
+#include "layer_type.h"
+#include "cpu.h"
+#include "convolution.h"
+
+#if NCNN_RUNTIME_CPU
+#include "deconvolution_x86_avx2.h"
+#include "deconvolution_x86_avx512.h"
+#endif
+
+namespace ncnn {
+
+#include "convolution_sgemm.h"
+#include "deconvolution_sgemm.h"
+
+DEFINE_LAYER_CREATOR(Deconvolution_x86)
+
+Deconvolution_x86::Deconvolution_x86()
+{
+    activation = 0;
+    use_avx2 = false;
+    use_avx512 = false;
+}
+
+int Deconvolution_x86::create_pipeline(const Option& opt)
+{
+    Option opt_cpu = opt;
+    opt_cpu.use_vulkan_compute = false;
+
+    if (activation_type == 1)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::ReLU);
+
+        ncnn::ParamDict pd;
+        activation->load_param(pd);
+    }
+    else if (activation_type == 2)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::ReLU);
+
+        ncnn::ParamDict pd;
+        pd.set(0, activation_params[0]);// slope
+        activation->load_param(pd);
+    }
+    else if (activation_type == 3)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::Clip);
+
+        ncnn::ParamDict pd;
+        pd.set(0, activation_params[0]);// min
+        pd.set(1, activation_params[1]);// max
+        activation->load_param(pd);
+    }
+    else if (activation_type == 4)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::Sigmoid);
+
+        ncnn::ParamDict pd;
+        activation->load_param(pd);
+    }
+
+    if (activation)
+    {
+        activation->create_pipeline(opt_cpu);
+    }
+
+    use_avx2 = false;
+    use_avx512 = false;
+#if NCNN_RUNTIME_CPU
+    use_avx2 = cpu_support_x86_avx2();
+    use_avx512 = cpu_support_x86_avx512();
+#endif
+
+    const int maxk = kernel_w * kernel_h;
+    int num_input = weight_data_size / maxk / num_output;
+
+#if NCNN_RUNTIME_CPU
+    // the avx2 and avx512 kernels pack 8 output columns together
+    if (use_avx2 || use_avx512)
+        deconv_sgemm_transform_kernel_avx2(weight_data, weight_sgemm_data, num_input, num_output, maxk);
+    else
+#endif
+    deconv_sgemm_transform_kernel_sse(weight_data, weight_sgemm_data, num_input, num_output, maxk);
+
+    return 0;
+}
+
+int Deconvolution_x86::destroy_pipeline(const Option& opt)
+{
+    if (activation)
+    {
+        Option opt_cpu = opt;
+        opt_cpu.use_vulkan_compute = false;
+        activation->destroy_pipeline(opt_cpu);
+        delete activation;
+        activation = 0;
+    }
+
+    return 0;
+}
+
+int Deconvolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // deconvolv with NxN kernel
+    // value = value + bias
+
+    if (bottom_blob.dims != 3 || bottom_blob.elemsize != 4u)
+    {
+        return Deconvolution::forward(bottom_blob, top_blob, opt);
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    size_t elemsize = bottom_blob.elemsize;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    int outw = (w - 1) * stride_w + kernel_extent_w;
+    int outh = (h - 1) * stride_h + kernel_extent_h;
+
+    Mat top_blob_bordered;
+    if (pad_w > 0 || pad_h > 0)
+    {
+        top_blob_bordered.create(outw, outh, num_output, elemsize, opt.workspace_allocator);
+        if (top_blob_bordered.empty())
+            return -100;
+    }
+    else
+    {
+        top_blob_bordered = top_blob;
+        top_blob_bordered.create(outw, outh, num_output, elemsize, opt.blob_allocator);
+        if (top_blob_bordered.empty())
+            return -100;
+    }
+
+#if NCNN_RUNTIME_CPU
+    if (use_avx512)
+        deconv_sgemm_avx512(bottom_blob, top_blob_bordered, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+    else if (use_avx2)
+        deconv_sgemm_avx2(bottom_blob, top_blob_bordered, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+    else
+#endif
+    deconv_sgemm_sse(bottom_blob, top_blob_bordered, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+
+    if (pad_w > 0 || pad_h > 0)
+    {
+        copy_cut_border(top_blob_bordered, top_blob, pad_h, pad_h, pad_w, pad_w, opt.blob_allocator, opt.num_threads);
+        if (top_blob.empty())
+            return -100;
+
+        outw = top_blob.w;
+        outh = top_blob.h;
+    }
+    else
+    {
+        top_blob = top_blob_bordered;
+    }
+
+    if (activation)
+    {
+        activation->forward_inplace(top_blob, opt);
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
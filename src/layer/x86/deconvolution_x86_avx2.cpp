@@ -0,0 +1,47 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// this file is compiled with avx2 and fma enabled
+// the shared sgemm headers take their __AVX__ 8-wide fma paths here
+
+#include "deconvolution_x86_avx2.h"
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "convolution.h"
+
+namespace ncnn {
+
+#include "convolution_sgemm.h"
+#include "deconvolution_sgemm.h"
+
+void deconv_sgemm_transform_kernel_avx2(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int maxk)
+{
+    deconv_sgemm_transform_kernel_sse(kernel, kernel_tm, inch, outch, maxk);
+}
+
+void deconv_sgemm_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    deconv_sgemm_sse(bottom_blob, top_blob, kernel_tm, bias, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+}
+
+void deconvdw_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    deconvdw_sse(bottom_blob, top_blob, kernel, bias, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+}
+
+} // namespace ncnn
@@ -0,0 +1,31 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_DECONVOLUTION_X86_AVX2_H
+#define LAYER_DECONVOLUTION_X86_AVX2_H
+
+#include "mat.h"
+#include "option.h"
+
+namespace ncnn {
+
+// 8-wide fma kernels built with avx2 enabled
+// only call them when cpu_support_x86_avx2() is true
+void deconv_sgemm_transform_kernel_avx2(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int maxk);
+void deconv_sgemm_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+void deconvdw_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel, const Mat& bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt);
+
+} // namespace ncnn
+
+#endif // LAYER_DECONVOLUTION_X86_AVX2_H
@@ -0,0 +1,380 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "eltwise_x86.h"
+#include <algorithm>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Eltwise_x86)
+
+Eltwise_x86::Eltwise_x86()
+{
+    // elementwise, packed lanes are just more elements
+    support_packing = true;
+}
+
+int Eltwise_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    if (use_int8_inference)
+        return Eltwise::forward_int8(bottom_blobs, top_blobs, opt);
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+    int packing = bottom_blob.packing;
+    int size = w * h * packing;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(w, h, channels, elemsize, packing, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    if (op_type == Operation_PROD)
+    {
+        // first blob
+        const Mat& bottom_blob1 = bottom_blobs[1];
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob.channel(q);
+            const float* ptr1 = bottom_blob1.channel(q);
+            float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                __m128 _p1 = _mm_loadu_ps(ptr1);
+                _p = _mm_mul_ps(_p, _p1);
+                _mm_storeu_ps(outptr, _p);
+
+                ptr += 4;
+                ptr1 += 4;
+                outptr += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                *outptr = *ptr * *ptr1;
+
+                ptr++;
+                ptr1++;
+                outptr++;
+            }
+        }
+
+        for (size_t b=2; b<bottom_blobs.size(); b++)
+        {
+            const Mat& bottom_blob1 = bottom_blobs[b];
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob1.channel(q);
+                float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+                int nn = size >> 2;
+                int remain = size - (nn << 2);
+#else
+                int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                for (; nn>0; nn--)
+                {
+                    __m128 _p = _mm_loadu_ps(ptr);
+                    __m128 _out = _mm_loadu_ps(outptr);
+                    _out = _mm_mul_ps(_out, _p);
+                    _mm_storeu_ps(outptr, _out);
+
+                    ptr += 4;
+                    outptr += 4;
+                }
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    *outptr *= *ptr;
+
+                    ptr++;
+                    outptr++;
+                }
+            }
+        }
+    }
+    else if (op_type == Operation_SUM)
+    {
+        if (coeffs.w == 0)
+        {
+            // first blob
+            const Mat& bottom_blob1 = bottom_blobs[1];
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+                const float* ptr1 = bottom_blob1.channel(q);
+                float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+                int nn = size >> 2;
+                int remain = size - (nn << 2);
+#else
+                int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                for (; nn>0; nn--)
+                {
+                    __m128 _p = _mm_loadu_ps(ptr);
+                    __m128 _p1 = _mm_loadu_ps(ptr1);
+                    _p = _mm_add_ps(_p, _p1);
+                    _mm_storeu_ps(outptr, _p);
+
+                    ptr += 4;
+                    ptr1 += 4;
+                    outptr += 4;
+                }
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    *outptr = *ptr + *ptr1;
+
+                    ptr++;
+                    ptr1++;
+                    outptr++;
+                }
+            }
+
+            for (size_t b=2; b<bottom_blobs.size(); b++)
+            {
+                const Mat& bottom_blob1 = bottom_blobs[b];
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q=0; q<channels; q++)
+                {
+                    const float* ptr = bottom_blob1.channel(q);
+                    float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+                    int nn = size >> 2;
+                    int remain = size - (nn << 2);
+#else
+                    int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                    for (; nn>0; nn--)
+                    {
+                        __m128 _p = _mm_loadu_ps(ptr);
+                        __m128 _out = _mm_loadu_ps(outptr);
+                        _out = _mm_add_ps(_out, _p);
+                        _mm_storeu_ps(outptr, _out);
+
+                        ptr += 4;
+                        outptr += 4;
+                    }
+#endif // __SSE2__
+                    for (; remain>0; remain--)
+                    {
+                        *outptr += *ptr;
+
+                        ptr++;
+                        outptr++;
+                    }
+                }
+            }
+        }
+        else
+        {
+            // first blob
+            const Mat& bottom_blob1 = bottom_blobs[1];
+            float coeff0 = coeffs[0];
+            float coeff1 = coeffs[1];
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+                const float* ptr1 = bottom_blob1.channel(q);
+                float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+                int nn = size >> 2;
+                int remain = size - (nn << 2);
+#else
+                int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                __m128 _coeff0 = _mm_set1_ps(coeff0);
+                __m128 _coeff1 = _mm_set1_ps(coeff1);
+                for (; nn>0; nn--)
+                {
+                    __m128 _p = _mm_loadu_ps(ptr);
+                    __m128 _p1 = _mm_loadu_ps(ptr1);
+                    _p = _mm_add_ps(_mm_mul_ps(_p, _coeff0), _mm_mul_ps(_p1, _coeff1));
+                    _mm_storeu_ps(outptr, _p);
+
+                    ptr += 4;
+                    ptr1 += 4;
+                    outptr += 4;
+                }
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    *outptr = *ptr * coeff0 + *ptr1 * coeff1;
+
+                    ptr++;
+                    ptr1++;
+                    outptr++;
+                }
+            }
+
+            for (size_t b=2; b<bottom_blobs.size(); b++)
+            {
+                const Mat& bottom_blob1 = bottom_blobs[b];
+                float coeff = coeffs[b];
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q=0; q<channels; q++)
+                {
+                    const float* ptr = bottom_blob1.channel(q);
+                    float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+                    int nn = size >> 2;
+                    int remain = size - (nn << 2);
+#else
+                    int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                    __m128 _coeff = _mm_set1_ps(coeff);
+                    for (; nn>0; nn--)
+                    {
+                        __m128 _p = _mm_loadu_ps(ptr);
+                        __m128 _out = _mm_loadu_ps(outptr);
+                        _out = _mm_add_ps(_out, _mm_mul_ps(_p, _coeff));
+                        _mm_storeu_ps(outptr, _out);
+
+                        ptr += 4;
+                        outptr += 4;
+                    }
+#endif // __SSE2__
+                    for (; remain>0; remain--)
+                    {
+                        *outptr += *ptr * coeff;
+
+                        ptr++;
+                        outptr++;
+                    }
+                }
+            }
+        }
+    }
+    else if (op_type == Operation_MAX)
+    {
+        // first blob
+        const Mat& bottom_blob1 = bottom_blobs[1];
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob.channel(q);
+            const float* ptr1 = bottom_blob1.channel(q);
+            float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                __m128 _p1 = _mm_loadu_ps(ptr1);
+                _p = _mm_max_ps(_p1, _p);
+                _mm_storeu_ps(outptr, _p);
+
+                ptr += 4;
+                ptr1 += 4;
+                outptr += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                *outptr = std::max(*ptr, *ptr1);
+
+                ptr++;
+                ptr1++;
+                outptr++;
+            }
+        }
+
+        for (size_t b=2; b<bottom_blobs.size(); b++)
+        {
+            const Mat& bottom_blob1 = bottom_blobs[b];
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob1.channel(q);
+                float* outptr = top_blob.channel(q);
+
+#if __SSE2__
+                int nn = size >> 2;
+                int remain = size - (nn << 2);
+#else
+                int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                for (; nn>0; nn--)
+                {
+                    __m128 _p = _mm_loadu_ps(ptr);
+                    __m128 _out = _mm_loadu_ps(outptr);
+                    _out = _mm_max_ps(_p, _out);
+                    _mm_storeu_ps(outptr, _out);
+
+                    ptr += 4;
+                    outptr += 4;
+                }
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    *outptr = std::max(*outptr, *ptr);
+
+                    ptr++;
+                    outptr++;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,314 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "expression_x86.h"
+
+#include <math.h>
+#include <algorithm>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#define USE_SSE2
+#include "sse_mathfun.h"
+#endif // __SSE2__
+
+#include "binaryop.h"
+#include "unaryop.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Expression_x86)
+
+#if __SSE2__
+// each op takes 4 lanes, or one float for the tail
+struct sse_op_abs {
+    __m128 operator() (__m128 x) const { return _mm_andnot_ps(_mm_set1_ps(-0.f), x); }
+    float operator() (float x) const { return fabs(x); }
+};
+
+struct sse_op_neg {
+    __m128 operator() (__m128 x) const { return _mm_sub_ps(_mm_setzero_ps(), x); }
+    float operator() (float x) const { return -x; }
+};
+
+struct sse_op_square {
+    __m128 operator() (__m128 x) const { return _mm_mul_ps(x, x); }
+    float operator() (float x) const { return x * x; }
+};
+
+struct sse_op_sqrt {
+    __m128 operator() (__m128 x) const { return _mm_sqrt_ps(x); }
+    float operator() (float x) const { return sqrt(x); }
+};
+
+struct sse_op_reciprocal {
+    __m128 operator() (__m128 x) const { return _mm_div_ps(_mm_set1_ps(1.f), x); }
+    float operator() (float x) const { return 1.f / x; }
+};
+
+struct sse_op_exp {
+    __m128 operator() (__m128 x) const { return exp_ps(x); }
+    float operator() (float x) const { return exp(x); }
+};
+
+struct sse_op_sigmoid {
+    __m128 operator() (__m128 x) const
+    {
+        __m128 _one = _mm_set1_ps(1.f);
+        return _mm_div_ps(_one, _mm_add_ps(_one, exp_ps(_mm_sub_ps(_mm_setzero_ps(), x))));
+    }
+    float operator() (float x) const { return 1.f / (1.f + exp(-x)); }
+};
+
+struct sse_op_add {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_add_ps(x, y); }
+    float operator() (float x, float y) const { return x + y; }
+};
+
+struct sse_op_sub {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_sub_ps(x, y); }
+    float operator() (float x, float y) const { return x - y; }
+};
+
+struct sse_op_mul {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_mul_ps(x, y); }
+    float operator() (float x, float y) const { return x * y; }
+};
+
+struct sse_op_div {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_div_ps(x, y); }
+    float operator() (float x, float y) const { return x / y; }
+};
+
+struct sse_op_max {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_max_ps(x, y); }
+    float operator() (float x, float y) const { return std::max(x, y); }
+};
+
+struct sse_op_min {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_min_ps(x, y); }
+    float operator() (float x, float y) const { return std::min(x, y); }
+};
+
+struct sse_op_rsub {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_sub_ps(y, x); }
+    float operator() (float x, float y) const { return y - x; }
+};
+
+struct sse_op_rdiv {
+    __m128 operator() (__m128 x, __m128 y) const { return _mm_div_ps(y, x); }
+    float operator() (float x, float y) const { return y / x; }
+};
+
+template<typename Op>
+static void unary_sse(float* dst, const float* a, int n)
+{
+    Op op;
+    int i = 0;
+    for (; i+3<n; i+=4)
+    {
+        _mm_storeu_ps(dst + i, op(_mm_loadu_ps(a + i)));
+    }
+    for (; i<n; i++)
+    {
+        dst[i] = op(a[i]);
+    }
+}
+
+template<typename Op>
+static void binary_sse(float* dst, const float* a, const float* b, int n)
+{
+    Op op;
+    int i = 0;
+    for (; i+3<n; i+=4)
+    {
+        _mm_storeu_ps(dst + i, op(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    for (; i<n; i++)
+    {
+        dst[i] = op(a[i], b[i]);
+    }
+}
+
+template<typename Op>
+static void binary_scalar_sse(float* dst, const float* a, float b, int n)
+{
+    Op op;
+    __m128 _b = _mm_set1_ps(b);
+    int i = 0;
+    for (; i+3<n; i+=4)
+    {
+        _mm_storeu_ps(dst + i, op(_mm_loadu_ps(a + i), _b));
+    }
+    for (; i<n; i++)
+    {
+        dst[i] = op(a[i], b);
+    }
+}
+
+// the ops without a sse path return false
+static bool unary_op_sse(int op_type, float* dst, const float* a, int n)
+{
+    if (op_type == UnaryOp::Operation_ABS)
+        unary_sse<sse_op_abs>(dst, a, n);
+    else if (op_type == UnaryOp::Operation_NEG)
+        unary_sse<sse_op_neg>(dst, a, n);
+    else if (op_type == UnaryOp::Operation_SQUARE)
+        unary_sse<sse_op_square>(dst, a, n);
+    else if (op_type == UnaryOp::Operation_SQRT)
+        unary_sse<sse_op_sqrt>(dst, a, n);
+    else if (op_type == UnaryOp::Operation_RECIPROCAL)
+        unary_sse<sse_op_reciprocal>(dst, a, n);
+    else if (op_type == UnaryOp::Operation_EXP)
+        unary_sse<sse_op_exp>(dst, a, n);
+    else
+        return false;
+
+    return true;
+}
+
+static bool binary_op_sse(int op_type, float* dst, const float* a, const float* b, int n)
+{
+    if (op_type == BinaryOp::Operation_ADD)
+        binary_sse<sse_op_add>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_SUB)
+        binary_sse<sse_op_sub>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_MUL)
+        binary_sse<sse_op_mul>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_DIV)
+        binary_sse<sse_op_div>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_MAX)
+        binary_sse<sse_op_max>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_MIN)
+        binary_sse<sse_op_min>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_RSUB)
+        binary_sse<sse_op_rsub>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_RDIV)
+        binary_sse<sse_op_rdiv>(dst, a, b, n);
+    else
+        return false;
+
+    return true;
+}
+
+static bool binary_op_scalar_sse(int op_type, float* dst, const float* a, float b, int n)
+{
+    if (op_type == BinaryOp::Operation_ADD)
+        binary_scalar_sse<sse_op_add>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_SUB)
+        binary_scalar_sse<sse_op_sub>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_MUL)
+        binary_scalar_sse<sse_op_mul>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_DIV)
+        binary_scalar_sse<sse_op_div>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_MAX)
+        binary_scalar_sse<sse_op_max>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_MIN)
+        binary_scalar_sse<sse_op_min>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_RSUB)
+        binary_scalar_sse<sse_op_rsub>(dst, a, b, n);
+    else if (op_type == BinaryOp::Operation_RDIV)
+        binary_scalar_sse<sse_op_rdiv>(dst, a, b, n);
+    else
+        return false;
+
+    return true;
+}
+
+static void relu_sse(float* dst, const float* a, float slope, int n)
+{
+    __m128 _zero = _mm_setzero_ps();
+    __m128 _slope = _mm_set1_ps(slope);
+    int i = 0;
+    for (; i+3<n; i+=4)
+    {
+        __m128 _p = _mm_loadu_ps(a + i);
+        if (slope == 0.f)
+        {
+            _p = _mm_max_ps(_zero, _p);
+        }
+        else
+        {
+            __m128 _lemask = _mm_cmplt_ps(_p, _zero);
+            __m128 _ps = _mm_mul_ps(_p, _slope);
+            _p = _mm_or_ps(_mm_and_ps(_lemask, _ps), _mm_andnot_ps(_lemask, _p));
+        }
+        _mm_storeu_ps(dst + i, _p);
+    }
+    for (; i<n; i++)
+    {
+        dst[i] = a[i] < 0.f ? a[i] * slope : a[i];
+    }
+}
+
+static void clip_sse(float* dst, const float* a, float min, float max, int n)
+{
+    __m128 _min = _mm_set1_ps(min);
+    __m128 _max = _mm_set1_ps(max);
+    int i = 0;
+    for (; i+3<n; i+=4)
+    {
+        __m128 _p = _mm_loadu_ps(a + i);
+        _p = _mm_max_ps(_min, _p);
+        _p = _mm_min_ps(_max, _p);
+        _mm_storeu_ps(dst + i, _p);
+    }
+    for (; i<n; i++)
+    {
+        dst[i] = std::min(std::max(a[i], min), max);
+    }
+}
+#endif // __SSE2__
+
+void Expression_x86::run_instruction(const Instruction& ins, float* dst, const float* a, const float* b, int n) const
+{
+#if __SSE2__
+    // per channel values come one at a time, the tile loop broadcasts them
+    if (n >= 4)
+    {
+        if (ins.op == Instruction_UNARY && unary_op_sse(ins.type, dst, a, n))
+            return;
+
+        if (ins.op == Instruction_BINARY && binary_op_sse(ins.type, dst, a, b, n))
+            return;
+
+        if (ins.op == Instruction_SCALAR && binary_op_scalar_sse(ins.type, dst, a, ins.p0, n))
+            return;
+
+        if (ins.op == Instruction_RELU)
+        {
+            relu_sse(dst, a, ins.p0, n);
+            return;
+        }
+
+        if (ins.op == Instruction_CLIP)
+        {
+            clip_sse(dst, a, ins.p0, ins.p1, n);
+            return;
+        }
+
+        if (ins.op == Instruction_SIGMOID)
+        {
+            unary_sse<sse_op_sigmoid>(dst, a, n);
+            return;
+        }
+    }
+#endif // __SSE2__
+
+    Expression::run_instruction(ins, dst, a, b, n);
+}
+
+} // namespace ncnn
@@ -0,0 +1,404 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "innerproduct_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "layer_type.h"
+#include "cpu.h"
+
+#if NCNN_RUNTIME_CPU
+#include "innerproduct_x86_avx2.h"
+#include "innerproduct_x86_avx512.h"
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(InnerProduct_x86)
+
+InnerProduct_x86::InnerProduct_x86()
+{
+    activation = 0;
+    use_avx2 = false;
+    use_avx512 = false;
+}
+
+int InnerProduct_x86::create_pipeline(const Option& opt)
+{
+    Option opt_cpu = opt;
+    opt_cpu.use_vulkan_compute = false;
+
+    use_avx2 = false;
+    use_avx512 = false;
+#if NCNN_RUNTIME_CPU
+    use_avx2 = cpu_support_x86_avx2() && !use_int8_inference && weight_data.elemsize == (size_t)4u;
+    use_avx512 = cpu_support_x86_avx512() && !use_int8_inference && weight_data.elemsize == (size_t)4u;
+#endif
+
+    if (use_int8_inference)
+        return 0;
+
+    if (activation_type == 1)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::ReLU);
+
+        ncnn::ParamDict pd;
+        activation->load_param(pd);
+    }
+    else if (activation_type == 2)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::ReLU);
+
+        ncnn::ParamDict pd;
+        pd.set(0, activation_params[0]);// slope
+        activation->load_param(pd);
+    }
+    else if (activation_type == 3)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::Clip);
+
+        ncnn::ParamDict pd;
+        pd.set(0, activation_params[0]);// min
+        pd.set(1, activation_params[1]);// max
+        activation->load_param(pd);
+    }
+    else if (activation_type == 4)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::Sigmoid);
+
+        ncnn::ParamDict pd;
+        activation->load_param(pd);
+    }
+
+    if (activation)
+    {
+        activation->create_pipeline(opt_cpu);
+    }
+
+    return 0;
+}
+
+int InnerProduct_x86::destroy_pipeline(const Option& opt)
+{
+    Option opt_cpu = opt;
+    opt_cpu.use_vulkan_compute = false;
+
+    if (activation)
+    {
+        activation->destroy_pipeline(opt_cpu);
+        delete activation;
+        activation = 0;
+    }
+
+    return 0;
+}
+
+int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (use_int8_inference || bottom_blob.elemsize != 4u)
+        return InnerProduct::forward(bottom_blob, top_blob, opt);
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+    int size = w * h;
+
+    if (weight_data.elemsize != 4u)
+    {
+        // fp16 or int8 weight storage
+#if NCNN_RUNTIME_CPU
+        // fp16 weights are widened with f16c
+        if (weight_data.elemsize == 2u ? cpu_support_x86_f16c() : cpu_support_x86_avx2())
+        {
+            top_blob.create(num_output, elemsize, opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;
+
+            if (weight_data.elemsize == 2u)
+                innerproduct_fp16s_avx2(bottom_blob, top_blob, weight_data, bias_data, opt);
+            else
+                innerproduct_int8s_avx2(bottom_blob, top_blob, weight_data, weight_data_int8_scales, bias_data, opt);
+
+            if (activation)
+            {
+                activation->forward_inplace(top_blob, opt);
+            }
+
+            return 0;
+        }
+#endif // NCNN_RUNTIME_CPU
+
+        return InnerProduct::forward(bottom_blob, top_blob, opt);
+    }
+
+    top_blob.create(num_output, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+#if NCNN_RUNTIME_CPU
+    if (use_avx512 || use_avx2)
+    {
+        Mat bottom_blob_flattened = bottom_blob;
+        if (bottom_blob.dims != 1)
+        {
+            bottom_blob_flattened = bottom_blob.reshape(size * channels, opt.workspace_allocator);
+            if (bottom_blob_flattened.empty())
+                return -100;
+        }
+
+        int ret = use_avx512
+                  ? innerproduct_avx512(bottom_blob_flattened, top_blob, weight_data, bias_data, opt)
+                  : innerproduct_avx2(bottom_blob_flattened, top_blob, weight_data, bias_data, opt);
+        if (ret != 0)
+            return ret;
+
+        if (activation)
+        {
+            activation->forward_inplace(top_blob, opt);
+        }
+
+        return 0;
+    }
+#endif // NCNN_RUNTIME_CPU
+
+    const float* weight_data_ptr = weight_data;
+    float* outptr = top_blob;
+
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        float sum0 = 0.f;
+        float sum1 = 0.f;
+        float sum2 = 0.f;
+        float sum3 = 0.f;
+
+        const float* w0 = weight_data_ptr + size * channels * p;
+        const float* w1 = weight_data_ptr + size * channels * (p+1);
+        const float* w2 = weight_data_ptr + size * channels * (p+2);
+        const float* w3 = weight_data_ptr + size * channels * (p+3);
+
+#if __SSE2__
+        __m128 _sum0 = _mm_setzero_ps();
+        __m128 _sum1 = _mm_setzero_ps();
+        __m128 _sum2 = _mm_setzero_ps();
+        __m128 _sum3 = _mm_setzero_ps();
+#endif // __SSE2__
+
+        // channels
+        for (int q=0; q<channels; q++)
+        {
+            const float* m = bottom_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size & 3;
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            for (; nn>0; nn--)
+            {
+                __m128 _m = _mm_loadu_ps(m);
+
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_m, _mm_loadu_ps(w0)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_m, _mm_loadu_ps(w1)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_m, _mm_loadu_ps(w2)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_m, _mm_loadu_ps(w3)));
+
+                m += 4;
+                w0 += 4;
+                w1 += 4;
+                w2 += 4;
+                w3 += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                sum0 += *m * *w0;
+                sum1 += *m * *w1;
+                sum2 += *m * *w2;
+                sum3 += *m * *w3;
+
+                m++;
+                w0++;
+                w1++;
+                w2++;
+                w3++;
+            }
+        }
+
+#if __SSE2__
+        // lane i of _sum holds the partial sums of output p+i
+        _MM_TRANSPOSE4_PS(_sum0, _sum1, _sum2, _sum3);
+        __m128 _sum = _mm_add_ps(_mm_add_ps(_sum0, _sum1), _mm_add_ps(_sum2, _sum3));
+        _sum = _mm_add_ps(_sum, _mm_setr_ps(sum0, sum1, sum2, sum3));
+
+        if (bias_term)
+        {
+            _sum = _mm_add_ps(_sum, _mm_loadu_ps((const float*)bias_data + p));
+        }
+
+        _mm_storeu_ps(outptr + p, _sum);
+#else
+        if (bias_term)
+        {
+            sum0 += bias_data[p];
+            sum1 += bias_data[p+1];
+            sum2 += bias_data[p+2];
+            sum3 += bias_data[p+3];
+        }
+
+        outptr[p] = sum0;
+        outptr[p+1] = sum1;
+        outptr[p+2] = sum2;
+        outptr[p+3] = sum3;
+#endif // __SSE2__
+    }
+
+    // num_output
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        float sum = 0.f;
+
+        const float* w = weight_data_ptr + size * channels * p;
+
+#if __SSE2__
+        __m128 _sum = _mm_setzero_ps();
+#endif // __SSE2__
+
+        // channels
+        for (int q=0; q<channels; q++)
+        {
+            const float* m = bottom_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size & 3;
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            for (; nn>0; nn--)
+            {
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_mm_loadu_ps(m), _mm_loadu_ps(w)));
+
+                m += 4;
+                w += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                sum += *m * *w;
+
+                m++;
+                w++;
+            }
+        }
+
+#if __SSE2__
+        _sum = _mm_add_ps(_sum, _mm_movehl_ps(_sum, _sum));
+        _sum = _mm_add_ss(_sum, _mm_shuffle_ps(_sum, _sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        sum += _mm_cvtss_f32(_sum);
+#endif // __SSE2__
+
+        if (bias_term)
+            sum += bias_data[p];
+
+        outptr[p] = sum;
+    }
+
+    if (activation)
+    {
+        activation->forward_inplace(top_blob, opt);
+    }
+
+    return 0;
+}
+
+int InnerProduct_x86::forward_batch(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    if (!use_avx512 && !use_avx2)
+        return InnerProduct::forward_batch(bottom_blobs, top_blobs, opt);
+
+    const int batch = bottom_blobs.size();
+
+    int w = bottom_blobs[0].w;
+    int h = bottom_blobs[0].h;
+    int channels = bottom_blobs[0].c;
+    size_t elemsize = bottom_blobs[0].elemsize;
+
+    bool same_shape = true;
+    for (int n=1; n<batch; n++)
+    {
+        const Mat& m = bottom_blobs[n];
+        if (m.w != w || m.h != h || m.c != channels || m.elemsize != elemsize)
+            same_shape = false;
+    }
+
+    // the single sample path still takes the avx kernel
+    if (elemsize != 4u || !same_shape)
+        return Layer::forward_batch(bottom_blobs, top_blobs, opt);
+
+#if NCNN_RUNTIME_CPU
+    std::vector<Mat> bottom_blobs_flattened(batch);
+    for (int n=0; n<batch; n++)
+    {
+        bottom_blobs_flattened[n] = bottom_blobs[n];
+        if (bottom_blobs[n].dims != 1)
+        {
+            bottom_blobs_flattened[n] = bottom_blobs[n].reshape(w * h * channels, opt.workspace_allocator);
+            if (bottom_blobs_flattened[n].empty())
+                return -100;
+        }
+    }
+
+    top_blobs.resize(batch);
+    for (int n=0; n<batch; n++)
+    {
+        top_blobs[n].create(num_output, elemsize, opt.blob_allocator);
+        if (top_blobs[n].empty())
+            return -100;
+    }
+
+    if (use_avx512)
+        innerproduct_batch_avx512(bottom_blobs_flattened, top_blobs, weight_data, bias_data, opt);
+    else
+        innerproduct_batch_avx2(bottom_blobs_flattened, top_blobs, weight_data, bias_data, opt);
+
+    if (activation)
+    {
+        for (int n=0; n<batch; n++)
+        {
+            activation->forward_inplace(top_blobs[n], opt);
+        }
+    }
+#endif // NCNN_RUNTIME_CPU
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,595 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// this file is compiled with avx2, fma and f16c enabled
+
+#include "innerproduct_x86_avx2.h"
+
+#include <algorithm>
+#include <immintrin.h>
+
+namespace ncnn {
+
+static inline float reduce_add_ps_avx2(__m256 _v)
+{
+    __m128 _s = _mm_add_ps(_mm256_castps256_ps128(_v), _mm256_extractf128_ps(_v, 1));
+    _s = _mm_add_ps(_s, _mm_movehl_ps(_s, _s));
+    _s = _mm_add_ss(_s, _mm_shuffle_ps(_s, _s, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(_s);
+}
+
+static inline __m256 load_fp16_avx2(const unsigned short* ptr)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)ptr));
+}
+
+static inline __m256 load_int8_avx2(const signed char* ptr)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)ptr)));
+}
+
+// 4 weight rows against one input over n elements
+static void dot_4x1_avx2(const float* x, const float* w0, const float* w1, const float* w2, const float* w3, int n, float* sum)
+{
+    const int nn = n >> 3;
+    const int remain = n & 7;
+
+    __m256 _sum0 = _mm256_setzero_ps();
+    __m256 _sum1 = _mm256_setzero_ps();
+    __m256 _sum2 = _mm256_setzero_ps();
+    __m256 _sum3 = _mm256_setzero_ps();
+
+    for (int i=0; i<nn; i++)
+    {
+        __m256 _x = _mm256_loadu_ps(x);
+        _sum0 = _mm256_fmadd_ps(_x, _mm256_loadu_ps(w0), _sum0);
+        _sum1 = _mm256_fmadd_ps(_x, _mm256_loadu_ps(w1), _sum1);
+        _sum2 = _mm256_fmadd_ps(_x, _mm256_loadu_ps(w2), _sum2);
+        _sum3 = _mm256_fmadd_ps(_x, _mm256_loadu_ps(w3), _sum3);
+
+        x += 8;
+        w0 += 8;
+        w1 += 8;
+        w2 += 8;
+        w3 += 8;
+    }
+
+    float sum0 = 0.f;
+    float sum1 = 0.f;
+    float sum2 = 0.f;
+    float sum3 = 0.f;
+    for (int i=0; i<remain; i++)
+    {
+        sum0 += x[i] * w0[i];
+        sum1 += x[i] * w1[i];
+        sum2 += x[i] * w2[i];
+        sum3 += x[i] * w3[i];
+    }
+
+    sum[0] = sum0 + reduce_add_ps_avx2(_sum0);
+    sum[1] = sum1 + reduce_add_ps_avx2(_sum1);
+    sum[2] = sum2 + reduce_add_ps_avx2(_sum2);
+    sum[3] = sum3 + reduce_add_ps_avx2(_sum3);
+}
+
+static float dot_1x1_avx2(const float* x, const float* w, int n)
+{
+    const int nn = n >> 3;
+    const int remain = n & 7;
+
+    __m256 _sum = _mm256_setzero_ps();
+
+    for (int i=0; i<nn; i++)
+    {
+        _sum = _mm256_fmadd_ps(_mm256_loadu_ps(x), _mm256_loadu_ps(w), _sum);
+
+        x += 8;
+        w += 8;
+    }
+
+    float sum = 0.f;
+    for (int i=0; i<remain; i++)
+    {
+        sum += x[i] * w[i];
+    }
+
+    return sum + reduce_add_ps_avx2(_sum);
+}
+
+// 4 weight rows against 2 inputs over n elements, sum[s * 4 + r] for input s and row r
+static void dot_4x2_avx2(const float* x0, const float* x1, const float* w0, const float* w1, const float* w2, const float* w3, int n, float* sum)
+{
+    const int nn = n >> 3;
+    const int remain = n & 7;
+
+    __m256 _sum00 = _mm256_setzero_ps();
+    __m256 _sum01 = _mm256_setzero_ps();
+    __m256 _sum02 = _mm256_setzero_ps();
+    __m256 _sum03 = _mm256_setzero_ps();
+    __m256 _sum10 = _mm256_setzero_ps();
+    __m256 _sum11 = _mm256_setzero_ps();
+    __m256 _sum12 = _mm256_setzero_ps();
+    __m256 _sum13 = _mm256_setzero_ps();
+
+    for (int i=0; i<nn; i++)
+    {
+        __m256 _w0 = _mm256_loadu_ps(w0);
+        __m256 _w1 = _mm256_loadu_ps(w1);
+        __m256 _w2 = _mm256_loadu_ps(w2);
+        __m256 _w3 = _mm256_loadu_ps(w3);
+
+        __m256 _x = _mm256_loadu_ps(x0);
+        _sum00 = _mm256_fmadd_ps(_x, _w0, _sum00);
+        _sum01 = _mm256_fmadd_ps(_x, _w1, _sum01);
+        _sum02 = _mm256_fmadd_ps(_x, _w2, _sum02);
+        _sum03 = _mm256_fmadd_ps(_x, _w3, _sum03);
+
+        _x = _mm256_loadu_ps(x1);
+        _sum10 = _mm256_fmadd_ps(_x, _w0, _sum10);
+        _sum11 = _mm256_fmadd_ps(_x, _w1, _sum11);
+        _sum12 = _mm256_fmadd_ps(_x, _w2, _sum12);
+        _sum13 = _mm256_fmadd_ps(_x, _w3, _sum13);
+
+        x0 += 8;
+        x1 += 8;
+        w0 += 8;
+        w1 += 8;
+        w2 += 8;
+        w3 += 8;
+    }
+
+    float tail[8] = { 0.f };
+    for (int i=0; i<remain; i++)
+    {
+        tail[0] += x0[i] * w0[i];
+        tail[1] += x0[i] * w1[i];
+        tail[2] += x0[i] * w2[i];
+        tail[3] += x0[i] * w3[i];
+        tail[4] += x1[i] * w0[i];
+        tail[5] += x1[i] * w1[i];
+        tail[6] += x1[i] * w2[i];
+        tail[7] += x1[i] * w3[i];
+    }
+
+    sum[0] = tail[0] + reduce_add_ps_avx2(_sum00);
+    sum[1] = tail[1] + reduce_add_ps_avx2(_sum01);
+    sum[2] = tail[2] + reduce_add_ps_avx2(_sum02);
+    sum[3] = tail[3] + reduce_add_ps_avx2(_sum03);
+    sum[4] = tail[4] + reduce_add_ps_avx2(_sum10);
+    sum[5] = tail[5] + reduce_add_ps_avx2(_sum11);
+    sum[6] = tail[6] + reduce_add_ps_avx2(_sum12);
+    sum[7] = tail[7] + reduce_add_ps_avx2(_sum13);
+}
+
+int innerproduct_avx2(const Mat& bottom_blob_flattened, Mat& top_blob, const Mat& weight_data, const Mat& bias_data, const Option& opt)
+{
+    const int K = bottom_blob_flattened.w;
+    const int num_output = top_blob.w;
+
+    const float* x = bottom_blob_flattened;
+    const float* weight_data_ptr = weight_data;
+    const float* bias = bias_data;
+    float* outptr = top_blob;
+
+    // each input vector is loaded once for 4 weight rows
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    const int nsplit = opt.num_threads;
+    if (nsplit > 1 && nn_num_output + (num_output - remain_num_output_start) < nsplit * 2 && K >= nsplit * 256)
+    {
+        // too few outputs to keep every thread busy, split the dot products along K instead
+        const int kstep = ((K + nsplit - 1) / nsplit + 7) / 8 * 8;
+
+        Mat partial(num_output, nsplit, (size_t)4u, opt.workspace_allocator);
+        if (partial.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int s=0; s<nsplit; s++)
+        {
+            const int k0 = std::min(K, kstep * s);
+            const int n = std::min(K - k0, kstep);
+
+            float* ps = partial.row(s);
+
+            for (int pp=0; pp<nn_num_output; pp++)
+            {
+                int p = pp * 4;
+
+                const float* w0 = weight_data_ptr + K * p + k0;
+                dot_4x1_avx2(x + k0, w0, w0 + K, w0 + K * 2, w0 + K * 3, n, ps + p);
+            }
+
+            for (int p=remain_num_output_start; p<num_output; p++)
+            {
+                ps[p] = dot_1x1_avx2(x + k0, weight_data_ptr + K * p + k0, n);
+            }
+        }
+
+        for (int p=0; p<num_output; p++)
+        {
+            float sum = bias ? bias[p] : 0.f;
+
+            for (int s=0; s<nsplit; s++)
+            {
+                sum += partial.row(s)[p];
+            }
+
+            outptr[p] = sum;
+        }
+
+        return 0;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        const float* w0 = weight_data_ptr + K * p;
+
+        float sum[4];
+        dot_4x1_avx2(x, w0, w0 + K, w0 + K * 2, w0 + K * 3, K, sum);
+
+        outptr[p] = sum[0] + (bias ? bias[p] : 0.f);
+        outptr[p+1] = sum[1] + (bias ? bias[p+1] : 0.f);
+        outptr[p+2] = sum[2] + (bias ? bias[p+2] : 0.f);
+        outptr[p+3] = sum[3] + (bias ? bias[p+3] : 0.f);
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        outptr[p] = dot_1x1_avx2(x, weight_data_ptr + K * p, K) + (bias ? bias[p] : 0.f);
+    }
+
+    return 0;
+}
+
+void innerproduct_batch_avx2(const std::vector<Mat>& bottom_blobs_flattened, std::vector<Mat>& top_blobs, const Mat& weight_data, const Mat& bias_data, const Option& opt)
+{
+    const int batch = bottom_blobs_flattened.size();
+
+    const int K = bottom_blobs_flattened[0].w;
+    const int num_output = top_blobs[0].w;
+
+    const float* weight_data_ptr = weight_data;
+    const float* bias = bias_data;
+
+    std::vector<const float*> x(batch);
+    for (int b=0; b<batch; b++)
+    {
+        x[b] = bottom_blobs_flattened[b];
+
+        float* outptr = top_blobs[b];
+        for (int p=0; p<num_output; p++)
+        {
+            outptr[p] = bias ? bias[p] : 0.f;
+        }
+    }
+
+    // the 4 row weight block stays in cache while all samples pass over it
+    // so the weights are read from memory once for the whole batch
+    const int kc = 2048;
+
+    const int nn_batch = batch >> 1;
+    const int remain_batch_start = nn_batch << 1;
+
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        const float* w0 = weight_data_ptr + K * p;
+        const float* w1 = w0 + K;
+        const float* w2 = w1 + K;
+        const float* w3 = w2 + K;
+
+        for (int k0=0; k0<K; k0+=kc)
+        {
+            const int n = std::min(kc, K - k0);
+
+            for (int bb=0; bb<nn_batch; bb++)
+            {
+                int b = bb * 2;
+
+                float sum[8];
+                dot_4x2_avx2(x[b] + k0, x[b+1] + k0, w0 + k0, w1 + k0, w2 + k0, w3 + k0, n, sum);
+
+                for (int s=0; s<2; s++)
+                {
+                    float* outptr = top_blobs[b + s];
+                    outptr[p] += sum[s * 4];
+                    outptr[p+1] += sum[s * 4 + 1];
+                    outptr[p+2] += sum[s * 4 + 2];
+                    outptr[p+3] += sum[s * 4 + 3];
+                }
+            }
+
+            for (int b=remain_batch_start; b<batch; b++)
+            {
+                float sum[4];
+                dot_4x1_avx2(x[b] + k0, w0 + k0, w1 + k0, w2 + k0, w3 + k0, n, sum);
+
+                float* outptr = top_blobs[b];
+                outptr[p] += sum[0];
+                outptr[p+1] += sum[1];
+                outptr[p+2] += sum[2];
+                outptr[p+3] += sum[3];
+            }
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        const float* w = weight_data_ptr + K * p;
+
+        for (int k0=0; k0<K; k0+=kc)
+        {
+            const int n = std::min(kc, K - k0);
+
+            for (int b=0; b<batch; b++)
+            {
+                float* outptr = top_blobs[b];
+                outptr[p] += dot_1x1_avx2(x[b] + k0, w + k0, n);
+            }
+        }
+    }
+}
+
+void innerproduct_fp16s_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_fp16, const Mat& bias_data, const Option& opt)
+{
+    int channels = bottom_blob.c;
+    int size = bottom_blob.w * bottom_blob.h;
+
+    int num_output = top_blob.w;
+
+    const float* bias = bias_data;
+
+    const int nn = size >> 3;
+    const int remain = size & 7;
+
+    // each input vector is loaded once for 4 weight rows
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        __m256 _sum0 = _mm256_setzero_ps();
+        __m256 _sum1 = _mm256_setzero_ps();
+        __m256 _sum2 = _mm256_setzero_ps();
+        __m256 _sum3 = _mm256_setzero_ps();
+
+        float sum0 = 0.f;
+        float sum1 = 0.f;
+        float sum2 = 0.f;
+        float sum3 = 0.f;
+
+        // channels
+        for (int q=0; q<channels; q++)
+        {
+            const unsigned short* w0 = (const unsigned short*)weight_data_fp16 + size * channels * p + size * q;
+            const unsigned short* w1 = w0 + size * channels;
+            const unsigned short* w2 = w1 + size * channels;
+            const unsigned short* w3 = w2 + size * channels;
+            const float* m = bottom_blob.channel(q);
+
+            for (int i=0; i<nn; i++)
+            {
+                __m256 _m = _mm256_loadu_ps(m);
+                _sum0 = _mm256_fmadd_ps(_m, load_fp16_avx2(w0), _sum0);
+                _sum1 = _mm256_fmadd_ps(_m, load_fp16_avx2(w1), _sum1);
+                _sum2 = _mm256_fmadd_ps(_m, load_fp16_avx2(w2), _sum2);
+                _sum3 = _mm256_fmadd_ps(_m, load_fp16_avx2(w3), _sum3);
+
+                m += 8;
+                w0 += 8;
+                w1 += 8;
+                w2 += 8;
+                w3 += 8;
+            }
+            for (int i=0; i<remain; i++)
+            {
+                sum0 += m[i] * _cvtsh_ss(w0[i]);
+                sum1 += m[i] * _cvtsh_ss(w1[i]);
+                sum2 += m[i] * _cvtsh_ss(w2[i]);
+                sum3 += m[i] * _cvtsh_ss(w3[i]);
+            }
+        }
+
+        sum0 += reduce_add_ps_avx2(_sum0);
+        sum1 += reduce_add_ps_avx2(_sum1);
+        sum2 += reduce_add_ps_avx2(_sum2);
+        sum3 += reduce_add_ps_avx2(_sum3);
+
+        if (bias)
+        {
+            sum0 += bias[p];
+            sum1 += bias[p+1];
+            sum2 += bias[p+2];
+            sum3 += bias[p+3];
+        }
+
+        float* outptr = top_blob;
+        outptr[p] = sum0;
+        outptr[p+1] = sum1;
+        outptr[p+2] = sum2;
+        outptr[p+3] = sum3;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        __m256 _sum = _mm256_setzero_ps();
+        float sum = 0.f;
+
+        // channels
+        for (int q=0; q<channels; q++)
+        {
+            const unsigned short* w = (const unsigned short*)weight_data_fp16 + size * channels * p + size * q;
+            const float* m = bottom_blob.channel(q);
+
+            for (int i=0; i<nn; i++)
+            {
+                _sum = _mm256_fmadd_ps(_mm256_loadu_ps(m), load_fp16_avx2(w), _sum);
+
+                m += 8;
+                w += 8;
+            }
+            for (int i=0; i<remain; i++)
+            {
+                sum += m[i] * _cvtsh_ss(w[i]);
+            }
+        }
+
+        sum += reduce_add_ps_avx2(_sum);
+
+        if (bias)
+            sum += bias[p];
+
+        float* outptr = top_blob;
+        outptr[p] = sum;
+    }
+}
+
+void innerproduct_int8s_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_int8, const Mat& weight_data_int8_scales, const Mat& bias_data, const Option& opt)
+{
+    int channels = bottom_blob.c;
+    int size = bottom_blob.w * bottom_blob.h;
+
+    int num_output = top_blob.w;
+
+    const float* bias = bias_data;
+
+    const int nn = size >> 3;
+    const int remain = size & 7;
+
+    // each input vector is loaded once for 4 weight rows
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        __m256 _sum0 = _mm256_setzero_ps();
+        __m256 _sum1 = _mm256_setzero_ps();
+        __m256 _sum2 = _mm256_setzero_ps();
+        __m256 _sum3 = _mm256_setzero_ps();
+
+        float sum0 = 0.f;
+        float sum1 = 0.f;
+        float sum2 = 0.f;
+        float sum3 = 0.f;
+
+        // channels
+        for (int q=0; q<channels; q++)
+        {
+            const signed char* w0 = (const signed char*)weight_data_int8 + size * channels * p + size * q;
+            const signed char* w1 = w0 + size * channels;
+            const signed char* w2 = w1 + size * channels;
+            const signed char* w3 = w2 + size * channels;
+            const float* m = bottom_blob.channel(q);
+
+            for (int i=0; i<nn; i++)
+            {
+                __m256 _m = _mm256_loadu_ps(m);
+                _sum0 = _mm256_fmadd_ps(_m, load_int8_avx2(w0), _sum0);
+                _sum1 = _mm256_fmadd_ps(_m, load_int8_avx2(w1), _sum1);
+                _sum2 = _mm256_fmadd_ps(_m, load_int8_avx2(w2), _sum2);
+                _sum3 = _mm256_fmadd_ps(_m, load_int8_avx2(w3), _sum3);
+
+                m += 8;
+                w0 += 8;
+                w1 += 8;
+                w2 += 8;
+                w3 += 8;
+            }
+            for (int i=0; i<remain; i++)
+            {
+                sum0 += m[i] * w0[i];
+                sum1 += m[i] * w1[i];
+                sum2 += m[i] * w2[i];
+                sum3 += m[i] * w3[i];
+            }
+        }
+
+        float sums[4];
+        sums[0] = sum0 + reduce_add_ps_avx2(_sum0);
+        sums[1] = sum1 + reduce_add_ps_avx2(_sum1);
+        sums[2] = sum2 + reduce_add_ps_avx2(_sum2);
+        sums[3] = sum3 + reduce_add_ps_avx2(_sum3);
+
+        // dequantize the whole dot product at once
+        float* outptr = top_blob;
+        for (int k=0; k<4; k++)
+        {
+            float scale = weight_data_int8_scales[p+k];
+            float sum = scale == 0.f ? 0.f : sums[k] / scale;
+
+            if (bias)
+                sum += bias[p+k];
+
+            outptr[p+k] = sum;
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        __m256 _sum = _mm256_setzero_ps();
+        float sum = 0.f;
+
+        // channels
+        for (int q=0; q<channels; q++)
+        {
+            const signed char* w = (const signed char*)weight_data_int8 + size * channels * p + size * q;
+            const float* m = bottom_blob.channel(q);
+
+            for (int i=0; i<nn; i++)
+            {
+                _sum = _mm256_fmadd_ps(_mm256_loadu_ps(m), load_int8_avx2(w), _sum);
+
+                m += 8;
+                w += 8;
+            }
+            for (int i=0; i<remain; i++)
+            {
+                sum += m[i] * w[i];
+            }
+        }
+
+        sum += reduce_add_ps_avx2(_sum);
+
+        float scale = weight_data_int8_scales[p];
+        sum = scale == 0.f ? 0.f : sum / scale;
+
+        if (bias)
+            sum += bias[p];
+
+        float* outptr = top_blob;
+        outptr[p] = sum;
+    }
+}
+
+} // namespace ncnn
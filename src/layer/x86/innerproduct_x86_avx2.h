@@ -0,0 +1,39 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_INNERPRODUCT_X86_AVX2_H
+#define LAYER_INNERPRODUCT_X86_AVX2_H
+
+#include <vector>
+#include "mat.h"
+#include "option.h"
+
+namespace ncnn {
+
+// 8-wide fma kernels built with avx2 and f16c enabled, no activation
+// only call them when cpu_support_x86_avx2() is true
+// the input is flattened to one contiguous vector of weight_data_size / num_output
+int innerproduct_avx2(const Mat& bottom_blob_flattened, Mat& top_blob, const Mat& weight_data, const Mat& bias_data, const Option& opt);
+// all samples of the same shape, blocked along K so the weights are read once per batch
+void innerproduct_batch_avx2(const std::vector<Mat>& bottom_blobs_flattened, std::vector<Mat>& top_blobs, const Mat& weight_data, const Mat& bias_data, const Option& opt);
+
+// low precision weight storage
+// the fp16 one also needs cpu_support_x86_f16c()
+void innerproduct_fp16s_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_fp16, const Mat& bias_data, const Option& opt);
+// one quantize scale per output channel
+void innerproduct_int8s_avx2(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_int8, const Mat& weight_data_int8_scales, const Mat& bias_data, const Option& opt);
+
+} // namespace ncnn
+
+#endif // LAYER_INNERPRODUCT_X86_AVX2_H
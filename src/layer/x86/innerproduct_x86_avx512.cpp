@@ -0,0 +1,376 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// this file is compiled with avx512f, avx2 and fma enabled
+
+#include "innerproduct_x86_avx512.h"
+
+#include <algorithm>
+#include <immintrin.h>
+
+namespace ncnn {
+
+static inline float reduce_add_ps_avx512(__m512 _v)
+{
+    float tmp[16];
+    _mm512_storeu_ps(tmp, _v);
+
+    float sum = 0.f;
+    for (int i=0; i<16; i++)
+    {
+        sum += tmp[i];
+    }
+
+    return sum;
+}
+
+// 4 weight rows against one input over n elements
+static void dot_4x1_avx512(const float* x, const float* w0, const float* w1, const float* w2, const float* w3, int n, float* sum)
+{
+    const int nn = n >> 4;
+    const __mmask16 tail_mask = (__mmask16)((1u << (n & 15)) - 1);
+
+    __m512 _sum0 = _mm512_setzero_ps();
+    __m512 _sum1 = _mm512_setzero_ps();
+    __m512 _sum2 = _mm512_setzero_ps();
+    __m512 _sum3 = _mm512_setzero_ps();
+
+    for (int i=0; i<nn; i++)
+    {
+        __m512 _x = _mm512_loadu_ps(x);
+        _sum0 = _mm512_fmadd_ps(_x, _mm512_loadu_ps(w0), _sum0);
+        _sum1 = _mm512_fmadd_ps(_x, _mm512_loadu_ps(w1), _sum1);
+        _sum2 = _mm512_fmadd_ps(_x, _mm512_loadu_ps(w2), _sum2);
+        _sum3 = _mm512_fmadd_ps(_x, _mm512_loadu_ps(w3), _sum3);
+
+        x += 16;
+        w0 += 16;
+        w1 += 16;
+        w2 += 16;
+        w3 += 16;
+    }
+
+    if (tail_mask)
+    {
+        __m512 _x = _mm512_maskz_loadu_ps(tail_mask, x);
+        _sum0 = _mm512_fmadd_ps(_x, _mm512_maskz_loadu_ps(tail_mask, w0), _sum0);
+        _sum1 = _mm512_fmadd_ps(_x, _mm512_maskz_loadu_ps(tail_mask, w1), _sum1);
+        _sum2 = _mm512_fmadd_ps(_x, _mm512_maskz_loadu_ps(tail_mask, w2), _sum2);
+        _sum3 = _mm512_fmadd_ps(_x, _mm512_maskz_loadu_ps(tail_mask, w3), _sum3);
+    }
+
+    sum[0] = reduce_add_ps_avx512(_sum0);
+    sum[1] = reduce_add_ps_avx512(_sum1);
+    sum[2] = reduce_add_ps_avx512(_sum2);
+    sum[3] = reduce_add_ps_avx512(_sum3);
+}
+
+static float dot_1x1_avx512(const float* x, const float* w, int n)
+{
+    const int nn = n >> 4;
+    const __mmask16 tail_mask = (__mmask16)((1u << (n & 15)) - 1);
+
+    __m512 _sum = _mm512_setzero_ps();
+
+    for (int i=0; i<nn; i++)
+    {
+        _sum = _mm512_fmadd_ps(_mm512_loadu_ps(x), _mm512_loadu_ps(w), _sum);
+
+        x += 16;
+        w += 16;
+    }
+
+    if (tail_mask)
+    {
+        _sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail_mask, x), _mm512_maskz_loadu_ps(tail_mask, w), _sum);
+    }
+
+    return reduce_add_ps_avx512(_sum);
+}
+
+// 4 weight rows against 4 inputs over n elements, sum[s * 4 + r] for input s and row r
+static void dot_4x4_avx512(const float* const* x, const float* w0, const float* w1, const float* w2, const float* w3, int n, float* sum)
+{
+    const int nn = n >> 4;
+    const __mmask16 tail_mask = (__mmask16)((1u << (n & 15)) - 1);
+
+    const float* x0 = x[0];
+    const float* x1 = x[1];
+    const float* x2 = x[2];
+    const float* x3 = x[3];
+
+    __m512 _sum00 = _mm512_setzero_ps();
+    __m512 _sum01 = _mm512_setzero_ps();
+    __m512 _sum02 = _mm512_setzero_ps();
+    __m512 _sum03 = _mm512_setzero_ps();
+    __m512 _sum10 = _mm512_setzero_ps();
+    __m512 _sum11 = _mm512_setzero_ps();
+    __m512 _sum12 = _mm512_setzero_ps();
+    __m512 _sum13 = _mm512_setzero_ps();
+    __m512 _sum20 = _mm512_setzero_ps();
+    __m512 _sum21 = _mm512_setzero_ps();
+    __m512 _sum22 = _mm512_setzero_ps();
+    __m512 _sum23 = _mm512_setzero_ps();
+    __m512 _sum30 = _mm512_setzero_ps();
+    __m512 _sum31 = _mm512_setzero_ps();
+    __m512 _sum32 = _mm512_setzero_ps();
+    __m512 _sum33 = _mm512_setzero_ps();
+
+    for (int i=0; i<=nn; i++)
+    {
+        const __mmask16 mask = i < nn ? (__mmask16)0xffff : tail_mask;
+        if (!mask)
+            break;
+
+        __m512 _w0 = _mm512_maskz_loadu_ps(mask, w0);
+        __m512 _w1 = _mm512_maskz_loadu_ps(mask, w1);
+        __m512 _w2 = _mm512_maskz_loadu_ps(mask, w2);
+        __m512 _w3 = _mm512_maskz_loadu_ps(mask, w3);
+
+        __m512 _x = _mm512_maskz_loadu_ps(mask, x0);
+        _sum00 = _mm512_fmadd_ps(_x, _w0, _sum00);
+        _sum01 = _mm512_fmadd_ps(_x, _w1, _sum01);
+        _sum02 = _mm512_fmadd_ps(_x, _w2, _sum02);
+        _sum03 = _mm512_fmadd_ps(_x, _w3, _sum03);
+
+        _x = _mm512_maskz_loadu_ps(mask, x1);
+        _sum10 = _mm512_fmadd_ps(_x, _w0, _sum10);
+        _sum11 = _mm512_fmadd_ps(_x, _w1, _sum11);
+        _sum12 = _mm512_fmadd_ps(_x, _w2, _sum12);
+        _sum13 = _mm512_fmadd_ps(_x, _w3, _sum13);
+
+        _x = _mm512_maskz_loadu_ps(mask, x2);
+        _sum20 = _mm512_fmadd_ps(_x, _w0, _sum20);
+        _sum21 = _mm512_fmadd_ps(_x, _w1, _sum21);
+        _sum22 = _mm512_fmadd_ps(_x, _w2, _sum22);
+        _sum23 = _mm512_fmadd_ps(_x, _w3, _sum23);
+
+        _x = _mm512_maskz_loadu_ps(mask, x3);
+        _sum30 = _mm512_fmadd_ps(_x, _w0, _sum30);
+        _sum31 = _mm512_fmadd_ps(_x, _w1, _sum31);
+        _sum32 = _mm512_fmadd_ps(_x, _w2, _sum32);
+        _sum33 = _mm512_fmadd_ps(_x, _w3, _sum33);
+
+        x0 += 16;
+        x1 += 16;
+        x2 += 16;
+        x3 += 16;
+        w0 += 16;
+        w1 += 16;
+        w2 += 16;
+        w3 += 16;
+    }
+
+    sum[0] = reduce_add_ps_avx512(_sum00);
+    sum[1] = reduce_add_ps_avx512(_sum01);
+    sum[2] = reduce_add_ps_avx512(_sum02);
+    sum[3] = reduce_add_ps_avx512(_sum03);
+    sum[4] = reduce_add_ps_avx512(_sum10);
+    sum[5] = reduce_add_ps_avx512(_sum11);
+    sum[6] = reduce_add_ps_avx512(_sum12);
+    sum[7] = reduce_add_ps_avx512(_sum13);
+    sum[8] = reduce_add_ps_avx512(_sum20);
+    sum[9] = reduce_add_ps_avx512(_sum21);
+    sum[10] = reduce_add_ps_avx512(_sum22);
+    sum[11] = reduce_add_ps_avx512(_sum23);
+    sum[12] = reduce_add_ps_avx512(_sum30);
+    sum[13] = reduce_add_ps_avx512(_sum31);
+    sum[14] = reduce_add_ps_avx512(_sum32);
+    sum[15] = reduce_add_ps_avx512(_sum33);
+}
+
+int innerproduct_avx512(const Mat& bottom_blob_flattened, Mat& top_blob, const Mat& weight_data, const Mat& bias_data, const Option& opt)
+{
+    const int K = bottom_blob_flattened.w;
+    const int num_output = top_blob.w;
+
+    const float* x = bottom_blob_flattened;
+    const float* weight_data_ptr = weight_data;
+    const float* bias = bias_data;
+    float* outptr = top_blob;
+
+    // each input vector is loaded once for 4 weight rows
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    const int nsplit = opt.num_threads;
+    if (nsplit > 1 && nn_num_output + (num_output - remain_num_output_start) < nsplit * 2 && K >= nsplit * 256)
+    {
+        // too few outputs to keep every thread busy, split the dot products along K instead
+        const int kstep = ((K + nsplit - 1) / nsplit + 15) / 16 * 16;
+
+        Mat partial(num_output, nsplit, (size_t)4u, opt.workspace_allocator);
+        if (partial.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int s=0; s<nsplit; s++)
+        {
+            const int k0 = std::min(K, kstep * s);
+            const int n = std::min(K - k0, kstep);
+
+            float* ps = partial.row(s);
+
+            for (int pp=0; pp<nn_num_output; pp++)
+            {
+                int p = pp * 4;
+
+                const float* w0 = weight_data_ptr + K * p + k0;
+                dot_4x1_avx512(x + k0, w0, w0 + K, w0 + K * 2, w0 + K * 3, n, ps + p);
+            }
+
+            for (int p=remain_num_output_start; p<num_output; p++)
+            {
+                ps[p] = dot_1x1_avx512(x + k0, weight_data_ptr + K * p + k0, n);
+            }
+        }
+
+        for (int p=0; p<num_output; p++)
+        {
+            float sum = bias ? bias[p] : 0.f;
+
+            for (int s=0; s<nsplit; s++)
+            {
+                sum += partial.row(s)[p];
+            }
+
+            outptr[p] = sum;
+        }
+
+        return 0;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        const float* w0 = weight_data_ptr + K * p;
+
+        float sum[4];
+        dot_4x1_avx512(x, w0, w0 + K, w0 + K * 2, w0 + K * 3, K, sum);
+
+        outptr[p] = sum[0] + (bias ? bias[p] : 0.f);
+        outptr[p+1] = sum[1] + (bias ? bias[p+1] : 0.f);
+        outptr[p+2] = sum[2] + (bias ? bias[p+2] : 0.f);
+        outptr[p+3] = sum[3] + (bias ? bias[p+3] : 0.f);
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        outptr[p] = dot_1x1_avx512(x, weight_data_ptr + K * p, K) + (bias ? bias[p] : 0.f);
+    }
+
+    return 0;
+}
+
+void innerproduct_batch_avx512(const std::vector<Mat>& bottom_blobs_flattened, std::vector<Mat>& top_blobs, const Mat& weight_data, const Mat& bias_data, const Option& opt)
+{
+    const int batch = bottom_blobs_flattened.size();
+
+    const int K = bottom_blobs_flattened[0].w;
+    const int num_output = top_blobs[0].w;
+
+    const float* weight_data_ptr = weight_data;
+    const float* bias = bias_data;
+
+    std::vector<const float*> x(batch);
+    for (int b=0; b<batch; b++)
+    {
+        x[b] = bottom_blobs_flattened[b];
+
+        float* outptr = top_blobs[b];
+        for (int p=0; p<num_output; p++)
+        {
+            outptr[p] = bias ? bias[p] : 0.f;
+        }
+    }
+
+    // the 4 row weight block stays in cache while all samples pass over it
+    // so the weights are read from memory once for the whole batch
+    const int kc = 2048;
+
+    const int nn_batch = batch >> 2;
+    const int remain_batch_start = nn_batch << 2;
+
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        const float* w0 = weight_data_ptr + K * p;
+        const float* w1 = w0 + K;
+        const float* w2 = w1 + K;
+        const float* w3 = w2 + K;
+
+        for (int k0=0; k0<K; k0+=kc)
+        {
+            const int n = std::min(kc, K - k0);
+
+            for (int bb=0; bb<nn_batch; bb++)
+            {
+                int b = bb * 4;
+
+                const float* xb[4] = { x[b] + k0, x[b+1] + k0, x[b+2] + k0, x[b+3] + k0 };
+
+                float sum[16];
+                dot_4x4_avx512(xb, w0 + k0, w1 + k0, w2 + k0, w3 + k0, n, sum);
+
+                for (int s=0; s<4; s++)
+                {
+                    float* outptr = top_blobs[b + s];
+                    outptr[p] += sum[s * 4];
+                    outptr[p+1] += sum[s * 4 + 1];
+                    outptr[p+2] += sum[s * 4 + 2];
+                    outptr[p+3] += sum[s * 4 + 3];
+                }
+            }
+
+            for (int b=remain_batch_start; b<batch; b++)
+            {
+                float sum[4];
+                dot_4x1_avx512(x[b] + k0, w0 + k0, w1 + k0, w2 + k0, w3 + k0, n, sum);
+
+                float* outptr = top_blobs[b];
+                outptr[p] += sum[0];
+                outptr[p+1] += sum[1];
+                outptr[p+2] += sum[2];
+                outptr[p+3] += sum[3];
+            }
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        const float* w = weight_data_ptr + K * p;
+
+        for (int k0=0; k0<K; k0+=kc)
+        {
+            const int n = std::min(kc, K - k0);
+
+            for (int b=0; b<batch; b++)
+            {
+                float* outptr = top_blobs[b];
+                outptr[p] += dot_1x1_avx512(x[b] + k0, w + k0, n);
+            }
+        }
+    }
+}
+
+} // namespace ncnn
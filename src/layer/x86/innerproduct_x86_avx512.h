@@ -0,0 +1,33 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_INNERPRODUCT_X86_AVX512_H
+#define LAYER_INNERPRODUCT_X86_AVX512_H
+
+#include <vector>
+#include "mat.h"
+#include "option.h"
+
+namespace ncnn {
+
+// 16-wide fma kernels built with avx512f enabled, float32 only, no activation
+// the input is flattened to one contiguous vector of weight_data_size / num_output
+// only call them when cpu_support_x86_avx512() is true
+int innerproduct_avx512(const Mat& bottom_blob_flattened, Mat& top_blob, const Mat& weight_data, const Mat& bias_data, const Option& opt);
+// all samples of the same shape, blocked along K so the weights are read once per batch
+void innerproduct_batch_avx512(const std::vector<Mat>& bottom_blobs_flattened, std::vector<Mat>& top_blobs, const Mat& weight_data, const Mat& bias_data, const Option& opt);
+
+} // namespace ncnn
+
+#endif // LAYER_INNERPRODUCT_X86_AVX512_H
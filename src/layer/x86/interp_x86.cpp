@@ -0,0 +1,283 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "interp_x86.h"
+#include <math.h>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Interp_x86)
+
+static void linear_coeffs(int w, int outw, int* xofs, float* alpha)
+{
+    double scale = (double)w / outw;
+
+    for (int dx = 0; dx < outw; dx++)
+    {
+        float fx = (float)((dx + 0.5) * scale - 0.5);
+        int sx = floor(fx);
+        fx -= sx;
+
+        if (sx < 0)
+        {
+            sx = 0;
+            fx = 0.f;
+        }
+        if (sx >= w - 1)
+        {
+            sx = w - 2;
+            fx = 1.f;
+        }
+
+        xofs[dx] = sx;
+
+        alpha[dx*2    ] = 1.f - fx;
+        alpha[dx*2 + 1] = fx;
+    }
+}
+
+#if __SSE2__
+// two adjacent pairs p0[0] p0[1] p1[0] p1[1]
+static inline __m128 load2x2_ps(const float* p0, const float* p1)
+{
+    __m128 _p = _mm_castpd_ps(_mm_load_sd((const double*)p0));
+    return _mm_loadh_pi(_p, (const __m64*)p1);
+}
+#endif // __SSE2__
+
+static void resize_bilinear_image(const Mat& src, Mat& dst, float* alpha, int* xofs, float* beta, int* yofs)
+{
+    int w = dst.w;
+    int h = dst.h;
+
+    // loop body
+    Mat rowsbuf0(w);
+    Mat rowsbuf1(w);
+    float* rows0 = rowsbuf0;
+    float* rows1 = rowsbuf1;
+
+    int prev_sy1 = -2;
+
+    for (int dy = 0; dy < h; dy++ )
+    {
+        int sy = yofs[dy];
+
+        if (sy == prev_sy1)
+        {
+            // reuse all rows
+        }
+        else if (sy == prev_sy1 + 1)
+        {
+            // hresize one row
+            float* rows0_old = rows0;
+            rows0 = rows1;
+            rows1 = rows0_old;
+            const float* S1 = src.row(sy+1);
+
+            const float* alphap = alpha;
+            float* rows1p = rows1;
+            int dx = 0;
+#if __SSE2__
+            for ( ; dx+3 < w; dx += 4 )
+            {
+                const int* sx = xofs + dx;
+
+                __m128 _a0 = _mm_loadu_ps(alphap);
+                __m128 _a1 = _mm_loadu_ps(alphap + 4);
+
+                __m128 _ms10 = _mm_mul_ps(load2x2_ps(S1 + sx[0], S1 + sx[1]), _a0);
+                __m128 _ms11 = _mm_mul_ps(load2x2_ps(S1 + sx[2], S1 + sx[3]), _a1);
+
+                // S[sx] * a0 + S[sx+1] * a1
+                __m128 _rows1 = _mm_add_ps(_mm_shuffle_ps(_ms10, _ms11, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(_ms10, _ms11, _MM_SHUFFLE(3, 1, 3, 1)));
+
+                _mm_storeu_ps(rows1p + dx, _rows1);
+
+                alphap += 8;
+            }
+#endif // __SSE2__
+            for ( ; dx < w; dx++ )
+            {
+                int sx = xofs[dx];
+                const float* S1p = S1 + sx;
+
+                float a0 = alphap[0];
+                float a1 = alphap[1];
+                rows1p[dx] = S1p[0]*a0 + S1p[1]*a1;
+
+                alphap += 2;
+            }
+        }
+        else
+        {
+            // hresize two rows
+            const float* S0 = src.row(sy);
+            const float* S1 = src.row(sy+1);
+
+            const float* alphap = alpha;
+            float* rows0p = rows0;
+            float* rows1p = rows1;
+            int dx = 0;
+#if __SSE2__
+            for ( ; dx+3 < w; dx += 4 )
+            {
+                const int* sx = xofs + dx;
+
+                __m128 _a0 = _mm_loadu_ps(alphap);
+                __m128 _a1 = _mm_loadu_ps(alphap + 4);
+
+                __m128 _ms00 = _mm_mul_ps(load2x2_ps(S0 + sx[0], S0 + sx[1]), _a0);
+                __m128 _ms01 = _mm_mul_ps(load2x2_ps(S0 + sx[2], S0 + sx[3]), _a1);
+                __m128 _ms10 = _mm_mul_ps(load2x2_ps(S1 + sx[0], S1 + sx[1]), _a0);
+                __m128 _ms11 = _mm_mul_ps(load2x2_ps(S1 + sx[2], S1 + sx[3]), _a1);
+
+                // S[sx] * a0 + S[sx+1] * a1
+                __m128 _rows0 = _mm_add_ps(_mm_shuffle_ps(_ms00, _ms01, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(_ms00, _ms01, _MM_SHUFFLE(3, 1, 3, 1)));
+                __m128 _rows1 = _mm_add_ps(_mm_shuffle_ps(_ms10, _ms11, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(_ms10, _ms11, _MM_SHUFFLE(3, 1, 3, 1)));
+
+                _mm_storeu_ps(rows0p + dx, _rows0);
+                _mm_storeu_ps(rows1p + dx, _rows1);
+
+                alphap += 8;
+            }
+#endif // __SSE2__
+            for ( ; dx < w; dx++ )
+            {
+                int sx = xofs[dx];
+                const float* S0p = S0 + sx;
+                const float* S1p = S1 + sx;
+
+                float a0 = alphap[0];
+                float a1 = alphap[1];
+                rows0p[dx] = S0p[0]*a0 + S0p[1]*a1;
+                rows1p[dx] = S1p[0]*a0 + S1p[1]*a1;
+
+                alphap += 2;
+            }
+        }
+
+        prev_sy1 = sy;
+
+        // vresize
+        float b0 = beta[0];
+        float b1 = beta[1];
+
+        float* rows0p = rows0;
+        float* rows1p = rows1;
+        float* Dp = dst.row(dy);
+
+#if __SSE2__
+        int nn = w >> 3;
+#else
+        int nn = 0;
+#endif
+        int remain = w - (nn << 3);
+
+#if __SSE2__
+        __m128 _b0 = _mm_set1_ps(b0);
+        __m128 _b1 = _mm_set1_ps(b1);
+        for (; nn>0; nn--)
+        {
+            __m128 _rows0 = _mm_loadu_ps(rows0p);
+            __m128 _rows1 = _mm_loadu_ps(rows1p);
+
+            __m128 _D = _mm_add_ps(_mm_mul_ps(_rows0, _b0), _mm_mul_ps(_rows1, _b1));
+
+            _mm_storeu_ps(Dp, _D);
+
+            __m128 _rows0n = _mm_loadu_ps(rows0p+4);
+            __m128 _rows1n = _mm_loadu_ps(rows1p+4);
+
+            __m128 _Dn = _mm_add_ps(_mm_mul_ps(_rows0n, _b0), _mm_mul_ps(_rows1n, _b1));
+
+            _mm_storeu_ps(Dp+4, _Dn);
+
+            Dp += 8;
+            rows0p += 8;
+            rows1p += 8;
+        }
+#endif // __SSE2__
+        for ( ; remain; --remain )
+        {
+//             D[x] = rows0[x]*b0 + rows1[x]*b1;
+            *Dp++ = *rows0p++ * b0 + *rows1p++ * b1;
+        }
+
+        beta += 2;
+    }
+}
+
+int Interp_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int h = bottom_blob.h;
+    int w = bottom_blob.w;
+    int channels = bottom_blob.c;
+    int dims = bottom_blob.dims;
+    size_t elemsize = bottom_blob.elemsize;
+
+    if (resize_type != 2 || dims == 1)
+    {
+        return Interp::forward(bottom_blob, top_blob, opt);
+    }
+
+    int outh = output_height;
+    int outw = output_width;
+
+    if (outh == 0 || outw == 0)
+    {
+        outh = h * height_scale;
+        outw = w * width_scale;
+    }
+
+    if (outh == h && outw == w)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    top_blob.create(outw, outh, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    int* buf = new int[outw + outh + outw*2 + outh*2];
+
+    int* xofs = buf;//new int[outw];
+    int* yofs = buf + outw;//new int[outh];
+
+    float* alpha = (float*)(buf + outw + outh);//new float[outw * 2];
+    float* beta = (float*)(buf + outw + outh + outw*2);//new float[outh * 2];
+
+    linear_coeffs(w, outw, xofs, alpha);
+    linear_coeffs(h, outh, yofs, beta);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const Mat src = bottom_blob.channel(q);
+        Mat dst = top_blob.channel(q);
+
+        resize_bilinear_image(src, dst, alpha, xofs, beta, yofs);
+    }
+
+    delete[] buf;
+
+    return 0;
+}
+
+} // namespace ncnn
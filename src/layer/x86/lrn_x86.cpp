@@ -0,0 +1,233 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "lrn_x86.h"
+#include <math.h>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#define USE_SSE2
+#include "sse_mathfun.h"
+#endif // __SSE2__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(LRN_x86)
+
+int LRN_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    size_t elemsize = bottom_top_blob.elemsize;
+    int size = w * h;
+
+    // squared values with local_size padding
+    Mat square_blob;
+    square_blob.create(w, h, channels, elemsize, opt.workspace_allocator);
+    if (square_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = bottom_top_blob.channel(q);
+        float* outptr = square_blob.channel(q);
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            __m128 _outp = _mm_mul_ps(_p, _p);
+            _mm_storeu_ps(outptr, _outp);
+
+            ptr += 4;
+            outptr += 4;
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            *outptr = *ptr * *ptr;
+
+            ptr++;
+            outptr++;
+        }
+    }
+
+    if (region_type == NormRegion_ACROSS_CHANNELS)
+    {
+        Mat square_sum;
+        square_sum.create(w, h, channels, elemsize, opt.workspace_allocator);
+        if (square_sum.empty())
+            return -100;
+        square_sum.fill(0.f);
+
+        const float alpha_div_size = alpha / local_size;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            // square sum
+            for (int p=q - local_size / 2; p<=q + local_size / 2; p++)
+            {
+                if (p < 0 || p >= channels)
+                    continue;
+
+                const float* sptr = square_blob.channel(p);
+                float* ssptr = square_sum.channel(q);
+
+#if __SSE2__
+                int nn = size >> 2;
+                int remain = size - (nn << 2);
+#else
+                int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+                for (; nn>0; nn--)
+                {
+                    __m128 _sp = _mm_loadu_ps(sptr);
+                    __m128 _ssp = _mm_loadu_ps(ssptr);
+                    _ssp = _mm_add_ps(_ssp, _sp);
+                    _mm_storeu_ps(ssptr, _ssp);
+
+                    sptr += 4;
+                    ssptr += 4;
+                }
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    *ssptr += *sptr;
+                    sptr++;
+                    ssptr++;
+                }
+            }
+
+            float* ptr = bottom_top_blob.channel(q);
+            float* ssptr = square_sum.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            __m128 _bias = _mm_set1_ps(bias);
+            __m128 _ads = _mm_set1_ps(alpha_div_size);
+            __m128 _mb = _mm_set1_ps(-beta);
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                __m128 _ssp = _mm_loadu_ps(ssptr);
+                _ssp = _mm_mul_ps(_ssp, _ads);
+                _ssp = _mm_add_ps(_ssp, _bias);
+                _ssp = pow_ps(_ssp, _mb);
+                _p = _mm_mul_ps(_p, _ssp);
+                _mm_storeu_ps(ptr, _p);
+
+                ssptr += 4;
+                ptr += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                *ptr = *ptr * pow(bias + alpha_div_size * *ssptr, -beta);
+
+                ssptr++;
+                ptr++;
+            }
+        }
+    }
+    else if (region_type == NormRegion_WITHIN_CHANNEL)
+    {
+        int outw = w;
+        int outh = h;
+
+        Mat square_blob_bordered = square_blob;
+        int pad = local_size / 2;
+        if (pad > 0)
+        {
+            copy_make_border(square_blob, square_blob_bordered, pad, local_size - pad - 1, pad, local_size - pad - 1, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+            if (square_blob_bordered.empty())
+                return -100;
+
+            w = square_blob_bordered.w;
+            h = square_blob_bordered.h;
+        }
+
+        const int maxk = local_size * local_size;
+
+        const float alpha_div_size = alpha / maxk;
+
+        // norm window offsets
+        std::vector<int> _space_ofs(maxk);
+        int* space_ofs = &_space_ofs[0];
+        {
+            int p1 = 0;
+            int p2 = 0;
+            int gap = w - local_size;
+            for (int i = 0; i < local_size; i++)
+            {
+                for (int j = 0; j < local_size; j++)
+                {
+                    space_ofs[p1] = p2;
+                    p1++;
+                    p2++;
+                }
+                p2 += gap;
+            }
+        }
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+            const Mat m = square_blob_bordered.channel(q);
+
+            for (int i = 0; i < outh; i++)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    const float* sptr = m.row(i) + j;
+
+                    float ss = 0.f;
+
+                    for (int k = 0; k < maxk; k++)
+                    {
+                        float val = sptr[ space_ofs[k] ];
+                        ss += val;
+                    }
+
+                    ptr[j] = ptr[j] * pow(bias + alpha_div_size * ss, -beta);
+                }
+
+                ptr += outw;
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
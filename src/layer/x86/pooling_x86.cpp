@@ -0,0 +1,460 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "pooling_x86.h"
+#include <float.h>
+#include <algorithm>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+#include "pooling_2x2.h"
+#include "pooling_3x3.h"
+
+DEFINE_LAYER_CREATOR(Pooling_x86)
+
+Pooling_x86::Pooling_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int Pooling_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // max value in NxN window
+    // avg value in NxN window
+
+    if (bottom_blob.elemsize == 1u)
+        return Pooling::forward_int8(bottom_blob, top_blob, opt);
+
+#if __SSE2__
+    if (bottom_blob.packing == 4)
+        return forward_pack4(bottom_blob, top_blob, opt);
+#endif // __SSE2__
+
+    if (global_pooling)
+    {
+        int w = bottom_blob.w;
+        int h = bottom_blob.h;
+        int channels = bottom_blob.c;
+        size_t elemsize = bottom_blob.elemsize;
+        int size = w * h;
+
+        top_blob.create(channels, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+            if (pooling_type == PoolMethod_MAX)
+            {
+                float max = ptr[0];
+#if __SSE2__
+                if (nn > 0)
+                {
+                    __m128 _max = _mm_loadu_ps(ptr);
+                    for (; nn>0; nn--)
+                    {
+                        _max = _mm_max_ps(_max, _mm_loadu_ps(ptr));
+                        ptr += 4;
+                    }
+                    _max = _mm_max_ps(_max, _mm_movehl_ps(_max, _max));
+                    _max = _mm_max_ss(_max, _mm_shuffle_ps(_max, _max, _MM_SHUFFLE(1, 1, 1, 1)));
+                    max = _mm_cvtss_f32(_max);
+                }
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    max = std::max(max, *ptr);
+                    ptr++;
+                }
+
+                top_blob[q] = max;
+            }
+            else if (pooling_type == PoolMethod_AVE)
+            {
+                float sum = 0.f;
+#if __SSE2__
+                __m128 _sum = _mm_setzero_ps();
+                for (; nn>0; nn--)
+                {
+                    _sum = _mm_add_ps(_sum, _mm_loadu_ps(ptr));
+                    ptr += 4;
+                }
+                _sum = _mm_add_ps(_sum, _mm_movehl_ps(_sum, _sum));
+                _sum = _mm_add_ss(_sum, _mm_shuffle_ps(_sum, _sum, _MM_SHUFFLE(1, 1, 1, 1)));
+                sum = _mm_cvtss_f32(_sum);
+#endif // __SSE2__
+                for (; remain>0; remain--)
+                {
+                    sum += *ptr;
+                    ptr++;
+                }
+
+                top_blob[q] = sum / size;
+            }
+        }
+
+        return 0;
+    }
+
+    if (kernel_w != kernel_h || stride_w != stride_h)
+    {
+        return Pooling::forward(bottom_blob, top_blob, opt);
+    }
+
+    const int kernel_size = kernel_w;
+    const int stride = stride_w;
+
+    if (pooling_type != PoolMethod_MAX || stride != 2 || global_pooling == 1)
+    {
+        return Pooling::forward(bottom_blob, top_blob, opt);
+    }
+
+    if (kernel_size != 2 && kernel_size != 3)
+    {
+        return Pooling::forward(bottom_blob, top_blob, opt);
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    Mat bottom_blob_bordered = bottom_blob;
+
+    float pad_value = 0.f;
+    if (pooling_type == PoolMethod_MAX)
+    {
+        pad_value = -FLT_MAX;
+    }
+    else if (pooling_type == PoolMethod_AVE)
+    {
+        pad_value = 0.f;
+    }
+
+    int wtailpad = 0;
+    int htailpad = 0;
+
+    if (pad_mode == 0) // full padding
+    {
+        int wtail = (w + pad_left + pad_right - kernel_w) % stride_w;
+        int htail = (h + pad_top + pad_bottom - kernel_h) % stride_h;
+
+        if (wtail != 0)
+            wtailpad = stride_w - wtail;
+        if (htail != 0)
+            htailpad = stride_h - htail;
+
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom + htailpad, pad_left, pad_right + wtailpad, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_mode == 1) // valid padding
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_mode == 2) // tensorflow padding=SAME
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+
+    int outw = (w - kernel_w) / stride_w + 1;
+    int outh = (h - kernel_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    if (kernel_size == 2)
+        pooling2x2s2_max_sse(bottom_blob_bordered, top_blob, opt);
+    if (kernel_size == 3)
+        pooling3x3s2_max_sse(bottom_blob_bordered, top_blob, opt);
+
+    return 0;
+}
+
+int Pooling_x86::forward_pack4(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if __SSE2__
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    if (global_pooling)
+    {
+        // lanes of channel q are output q*4 .. q*4+3, already in plain order
+        top_blob.create(channels * 4, elemsize / 4, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        int size = w * h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob.channel(q);
+            float* outptr = (float*)top_blob + q * 4;
+
+            if (pooling_type == PoolMethod_MAX)
+            {
+                __m128 _max = _mm_loadu_ps(ptr);
+                for (int i=0; i<size; i++)
+                {
+                    _max = _mm_max_ps(_max, _mm_loadu_ps(ptr));
+                    ptr += 4;
+                }
+
+                _mm_storeu_ps(outptr, _max);
+            }
+            else if (pooling_type == PoolMethod_AVE)
+            {
+                __m128 _sum = _mm_setzero_ps();
+                for (int i=0; i<size; i++)
+                {
+                    _sum = _mm_add_ps(_sum, _mm_loadu_ps(ptr));
+                    ptr += 4;
+                }
+
+                _mm_storeu_ps(outptr, _mm_div_ps(_sum, _mm_set1_ps((float)size)));
+            }
+        }
+
+        return 0;
+    }
+
+    Mat bottom_blob_bordered = bottom_blob;
+
+    float pad_value = 0.f;
+    if (pooling_type == PoolMethod_MAX)
+    {
+        pad_value = -FLT_MAX;
+    }
+    else if (pooling_type == PoolMethod_AVE)
+    {
+        pad_value = 0.f;
+    }
+
+    int wtailpad = 0;
+    int htailpad = 0;
+
+    if (pad_mode == 0) // full padding
+    {
+        int wtail = (w + pad_left + pad_right - kernel_w) % stride_w;
+        int htail = (h + pad_top + pad_bottom - kernel_h) % stride_h;
+
+        if (wtail != 0)
+            wtailpad = stride_w - wtail;
+        if (htail != 0)
+            htailpad = stride_h - htail;
+
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom + htailpad, pad_left, pad_right + wtailpad, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_mode == 1) // valid padding
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+    else if (pad_mode == 2) // tensorflow padding=SAME
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt.workspace_allocator, opt.num_threads);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+
+        w = bottom_blob_bordered.w;
+        h = bottom_blob_bordered.h;
+    }
+
+    int outw = (w - kernel_w) / stride_w + 1;
+    int outh = (h - kernel_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, channels, elemsize, 4, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // kernel offsets, in pixels
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w - kernel_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2++;
+            }
+            p2 += gap;
+        }
+    }
+
+    if (pooling_type == PoolMethod_MAX)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = bottom_blob_bordered.channel(q);
+            float* outptr = top_blob.channel(q);
+
+            for (int i = 0; i < outh; i++)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    const float* sptr = (const float*)m.data + (i*stride_h * w + j*stride_w) * 4;
+
+                    __m128 _max = _mm_loadu_ps(sptr);
+                    for (int k = 1; k < maxk; k++)
+                    {
+                        _max = _mm_max_ps(_max, _mm_loadu_ps(sptr + space_ofs[k] * 4));
+                    }
+
+                    _mm_storeu_ps(outptr, _max);
+                    outptr += 4;
+                }
+            }
+        }
+    }
+    else if (pooling_type == PoolMethod_AVE)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = bottom_blob_bordered.channel(q);
+            float* outptr = top_blob.channel(q);
+
+            __m128 _maxk = _mm_set1_ps((float)maxk);
+            for (int i = 0; i < outh; i++)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    const float* sptr = (const float*)m.data + (i*stride_h * w + j*stride_w) * 4;
+
+                    __m128 _sum = _mm_setzero_ps();
+                    for (int k = 0; k < maxk; k++)
+                    {
+                        _sum = _mm_add_ps(_sum, _mm_loadu_ps(sptr + space_ofs[k] * 4));
+                    }
+
+                    _mm_storeu_ps(outptr, _mm_div_ps(_sum, _maxk));
+                    outptr += 4;
+                }
+            }
+
+            // fix pad
+            if (pad_top != 0)
+            {
+                __m128 _scale = _mm_set1_ps((float)kernel_h / (kernel_h - pad_top));
+
+                outptr = top_blob.channel(q).row(0);
+                for (int i = 0; i < outw; i++)
+                {
+                    _mm_storeu_ps(outptr + i * 4, _mm_mul_ps(_mm_loadu_ps(outptr + i * 4), _scale));
+                }
+            }
+            if (pad_bottom + htailpad != 0)
+            {
+                __m128 _scale = _mm_set1_ps((float)kernel_h / (kernel_h - pad_bottom - htailpad));
+
+                outptr = top_blob.channel(q).row(outh - 1);
+                for (int i = 0; i < outw; i++)
+                {
+                    _mm_storeu_ps(outptr + i * 4, _mm_mul_ps(_mm_loadu_ps(outptr + i * 4), _scale));
+                }
+            }
+            if (pad_left != 0)
+            {
+                __m128 _scale = _mm_set1_ps((float)kernel_w / (kernel_w - pad_left));
+
+                outptr = top_blob.channel(q);
+                for (int i = 0; i < outh; i++)
+                {
+                    _mm_storeu_ps(outptr, _mm_mul_ps(_mm_loadu_ps(outptr), _scale));
+                    outptr += outw * 4;
+                }
+            }
+            if (pad_right + wtailpad != 0)
+            {
+                __m128 _scale = _mm_set1_ps((float)kernel_w / (kernel_w - pad_right - wtailpad));
+
+                outptr = top_blob.channel(q);
+                outptr += (outw - 1) * 4;
+                for (int i = 0; i < outh; i++)
+                {
+                    _mm_storeu_ps(outptr, _mm_mul_ps(_mm_loadu_ps(outptr), _scale));
+                    outptr += outw * 4;
+                }
+            }
+        }
+    }
+
+    return 0;
+#else
+    return Pooling::forward(bottom_blob, top_blob, opt);
+#endif // __SSE2__
+}
+
+} // namespace ncnn
@@ -0,0 +1,113 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "prelu_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(PReLU_x86)
+
+PReLU_x86::PReLU_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int PReLU_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int dims = bottom_top_blob.dims;
+    if (dims != 3)
+        return PReLU::forward_inplace(bottom_top_blob, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h;
+
+    const float* slope_data_ptr = slope_data;
+
+#if __SSE2__
+    if (bottom_top_blob.packing == 4)
+    {
+        size = w * h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            __m128 _zero = _mm_setzero_ps();
+            __m128 _slope = num_slope > 1 ? _mm_loadu_ps(slope_data_ptr + q * 4) : _mm_set1_ps(slope_data_ptr[0]);
+            for (int i=0; i<size; i++)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                __m128 _lemask = _mm_cmplt_ps(_p, _zero);
+                __m128 _ps = _mm_mul_ps(_p, _slope);
+                _p = _mm_or_ps(_mm_and_ps(_lemask, _ps), _mm_andnot_ps(_lemask, _p));
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+        }
+
+        return 0;
+    }
+#endif // __SSE2__
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+        float slope = num_slope > 1 ? slope_data_ptr[q] : slope_data_ptr[0];
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        __m128 _zero = _mm_setzero_ps();
+        __m128 _slope = _mm_set1_ps(slope);
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            __m128 _lemask = _mm_cmplt_ps(_p, _zero);
+            __m128 _ps = _mm_mul_ps(_p, _slope);
+            _p = _mm_or_ps(_mm_and_ps(_lemask, _ps), _mm_andnot_ps(_lemask, _p));
+            _mm_storeu_ps(ptr, _p);
+
+            ptr += 4;
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            if (*ptr < 0)
+                *ptr *= slope;
+
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,124 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "relu_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(ReLU_x86)
+
+ReLU_x86::ReLU_x86()
+{
+    // elementwise, packed lanes are just more elements
+    support_packing = true;
+}
+
+int ReLU_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    if (bottom_top_blob.elemsize == 1u)
+        return ReLU::forward_inplace_int8(bottom_top_blob, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h * bottom_top_blob.packing;
+
+    if (slope == 0.f)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            __m128 _zero = _mm_setzero_ps();
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                // max with zero first keeps nan as is
+                _p = _mm_max_ps(_zero, _p);
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                if (*ptr < 0)
+                    *ptr = 0;
+
+                ptr++;
+            }
+        }
+    }
+    else
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            __m128 _zero = _mm_setzero_ps();
+            __m128 _slope = _mm_set1_ps(slope);
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                __m128 _lemask = _mm_cmplt_ps(_p, _zero);
+                __m128 _ps = _mm_mul_ps(_p, _slope);
+                _p = _mm_or_ps(_mm_and_ps(_lemask, _ps), _mm_andnot_ps(_lemask, _p));
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+#endif // __SSE2__
+            for (; remain>0; remain--)
+            {
+                if (*ptr < 0)
+                    *ptr *= slope;
+
+                ptr++;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int ReLU_x86::forward_batch_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    // sse kernel per sample
+    return Layer::forward_batch_inplace(bottom_top_blobs, opt);
+}
+
+} // namespace ncnn
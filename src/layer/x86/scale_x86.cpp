@@ -0,0 +1,154 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "scale_x86.h"
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Scale_x86)
+
+int Scale_x86::create_pipeline(const Option& /*opt*/)
+{
+#if __SSE2__
+    // scale from the second blob keeps the plain layout
+    support_packing = scale_data_size != -233;
+#endif // __SSE2__
+
+    return 0;
+}
+
+int Scale_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int dims = bottom_top_blob.dims;
+    if (dims != 3)
+        return Scale::forward_inplace(bottom_top_blob, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h;
+
+#if __SSE2__
+    if (bottom_top_blob.packing == 4)
+    {
+        const float* scale_ptr = scale_data;
+        const float* bias_ptr = bias_data;
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            __m128 _s = _mm_loadu_ps(scale_ptr + q * 4);
+            __m128 _bias = bias_term ? _mm_loadu_ps(bias_ptr + q * 4) : _mm_setzero_ps();
+            for (int i=0; i<size; i++)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                _p = _mm_add_ps(_mm_mul_ps(_p, _s), _bias);
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+        }
+
+        return 0;
+    }
+#endif // __SSE2__
+
+    if (bias_term)
+    {
+        const float* scale_ptr = scale_data;
+        const float* bias_ptr = bias_data;
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            float s = scale_ptr[q];
+            float bias = bias_ptr[q];
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            __m128 _s = _mm_set1_ps(s);
+            __m128 _bias = _mm_set1_ps(bias);
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                _p = _mm_add_ps(_mm_mul_ps(_p, _s), _bias);
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+#endif // __SSE2__
+
+            for (; remain>0; remain--)
+            {
+                *ptr = *ptr * s + bias;
+
+                ptr++;
+            }
+        }
+    }
+    else
+    {
+        const float* scale_ptr = scale_data;
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            float s = scale_ptr[q];
+
+#if __SSE2__
+            int nn = size >> 2;
+            int remain = size - (nn << 2);
+#else
+            int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+            __m128 _s = _mm_set1_ps(s);
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(ptr);
+                _p = _mm_mul_ps(_p, _s);
+                _mm_storeu_ps(ptr, _p);
+
+                ptr += 4;
+            }
+#endif // __SSE2__
+
+            for (; remain>0; remain--)
+            {
+                *ptr *= s;
+
+                ptr++;
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,80 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "sigmoid_x86.h"
+
+#include <math.h>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#define USE_SSE2
+#include "sse_mathfun.h"
+#endif // __SSE2__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Sigmoid_x86)
+
+Sigmoid_x86::Sigmoid_x86()
+{
+    // elementwise, packed lanes are just more elements
+    support_packing = true;
+}
+
+int Sigmoid_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h * bottom_top_blob.packing;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        __m128 _one = _mm_set1_ps(1.f);
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            _p = _mm_sub_ps(_mm_setzero_ps(), _p);
+            _p = exp_ps(_p);
+            _p = _mm_add_ps(_p, _one);
+            _p = _mm_div_ps(_one, _p);
+            _mm_storeu_ps(ptr, _p);
+
+            ptr += 4;
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            *ptr = 1.f / (1.f + exp(-*ptr));
+
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
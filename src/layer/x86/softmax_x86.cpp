@@ -0,0 +1,330 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "softmax_x86.h"
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+#include "platform.h"
+#if __SSE2__
+#include <emmintrin.h>
+#define USE_SSE2
+#include "sse_mathfun.h"
+#endif // __SSE2__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Softmax_x86)
+
+// softmax of one contiguous row
+static void softmax_row(float* ptr, int size)
+{
+    // value = exp( value - max value )
+    // sum all value
+    // value = value / sum
+
+    float m = -FLT_MAX;
+    {
+        const float* p = ptr;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        if (nn > 0)
+        {
+            __m128 _max = _mm_set1_ps(-FLT_MAX);
+            for (; nn>0; nn--)
+            {
+                _max = _mm_max_ps(_max, _mm_loadu_ps(p));
+                p += 4;
+            }
+            _max = _mm_max_ps(_max, _mm_movehl_ps(_max, _max));
+            _max = _mm_max_ss(_max, _mm_shuffle_ps(_max, _max, _MM_SHUFFLE(1, 1, 1, 1)));
+            m = _mm_cvtss_f32(_max);
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            m = std::max(m, *p);
+            p++;
+        }
+    }
+
+    float s = 0.f;
+    {
+        float* p = ptr;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        if (nn > 0)
+        {
+            __m128 _m = _mm_set1_ps(m);
+            __m128 _sum = _mm_setzero_ps();
+            for (; nn>0; nn--)
+            {
+                __m128 _p = _mm_loadu_ps(p);
+                _p = exp_ps(_mm_sub_ps(_p, _m));
+                _mm_storeu_ps(p, _p);
+                _sum = _mm_add_ps(_sum, _p);
+                p += 4;
+            }
+            _sum = _mm_add_ps(_sum, _mm_movehl_ps(_sum, _sum));
+            _sum = _mm_add_ss(_sum, _mm_shuffle_ps(_sum, _sum, _MM_SHUFFLE(1, 1, 1, 1)));
+            s = _mm_cvtss_f32(_sum);
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            *p = exp(*p - m);
+            s += *p;
+            p++;
+        }
+    }
+
+    {
+        float* p = ptr;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        __m128 _s = _mm_set1_ps(s);
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(p);
+            _p = _mm_div_ps(_p, _s);
+            _mm_storeu_ps(p, _p);
+            p += 4;
+        }
+#endif // __SSE2__
+        for (; remain>0; remain--)
+        {
+            *p /= s;
+            p++;
+        }
+    }
+}
+
+int Softmax_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    int dims = bottom_top_blob.dims;
+
+    if (dims == 1)
+    {
+        int w = bottom_top_blob.w;
+
+        float* ptr = bottom_top_blob;
+        softmax_row(ptr, w);
+
+        return 0;
+    }
+
+    if (dims == 2 && axis == 1)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<h; i++)
+        {
+            float* ptr = bottom_top_blob.row(i);
+            softmax_row(ptr, w);
+        }
+
+        return 0;
+    }
+
+    if (dims != 3 || axis != 0)
+        return Softmax::forward_inplace(bottom_top_blob, opt);
+
+    // value = exp( value - global max value )
+    // sum all value
+    // value = value / sum
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    size_t elemsize = bottom_top_blob.elemsize;
+    int size = w * h;
+
+    Mat max;
+    max.create(w, h, elemsize, opt.workspace_allocator);
+    if (max.empty())
+        return -100;
+    max.fill(-FLT_MAX);
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = bottom_top_blob.channel(q);
+        float* maxptr = max;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            __m128 _max = _mm_loadu_ps(maxptr);
+            _max = _mm_max_ps(_max, _p);
+            _mm_storeu_ps(maxptr, _max);
+
+            ptr += 4;
+            maxptr += 4;
+        }
+#endif // __SSE2__
+
+        for (; remain>0; remain--)
+        {
+            *maxptr = std::max(*maxptr, *ptr);
+
+            ptr++;
+            maxptr++;
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+        const float* maxptr = max;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            __m128 _max = _mm_loadu_ps(maxptr);
+
+            _p = exp_ps(_mm_sub_ps(_p, _max));
+
+            _mm_storeu_ps(ptr, _p);
+
+            ptr += 4;
+            maxptr += 4;
+        }
+#endif // __SSE2__
+
+        for (; remain>0; remain--)
+        {
+            *ptr = exp(*ptr - *maxptr);
+
+            ptr++;
+            maxptr++;
+        }
+    }
+
+    Mat sum;
+    sum.create(w, h, elemsize, opt.workspace_allocator);
+    if (sum.empty())
+        return -100;
+    sum.fill(0.f);
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = bottom_top_blob.channel(q);
+        float* sumptr = sum;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            __m128 _sum = _mm_loadu_ps(sumptr);
+            _sum = _mm_add_ps(_sum, _p);
+            _mm_storeu_ps(sumptr, _sum);
+
+            ptr += 4;
+            sumptr += 4;
+        }
+#endif // __SSE2__
+
+        for (; remain>0; remain--)
+        {
+            *sumptr += *ptr;
+
+            ptr++;
+            sumptr++;
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+        const float* sumptr = sum;
+
+#if __SSE2__
+        int nn = size >> 2;
+        int remain = size - (nn << 2);
+#else
+        int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128 _p = _mm_loadu_ps(ptr);
+            __m128 _sum = _mm_loadu_ps(sumptr);
+            _p = _mm_div_ps(_p, _sum);
+            _mm_storeu_ps(ptr, _p);
+
+            ptr += 4;
+            sumptr += 4;
+        }
+#endif // __SSE2__
+
+        for (; remain>0; remain--)
+        {
+            *ptr /= *sumptr;
+
+            ptr++;
+            sumptr++;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -77,6 +77,8 @@ public:
     template <typename T> void fill(T v);
     // deep copy
     Mat clone(Allocator* allocator = 0) const;
+    // header of the same dims, elemsize and packing without data
+    Mat shape() const;
     // reshape vec
     Mat reshape(int w, Allocator* allocator = 0) const;
     // reshape image
@@ -373,6 +375,10 @@ void convert_packing(const Mat& src, Mat& dst, int packing, Allocator* allocator
 void cast_float32_to_float16(const Mat& src, Mat& dst, Allocator* allocator = 0, int num_threads = 1);
 void cast_float16_to_float32(const Mat& src, Mat& dst, Allocator* allocator = 0, int num_threads = 1);
 
+// scalar half precision conversion
+unsigned short float32_to_float16(float value);
+float float16_to_float32(unsigned short value);
+
 inline Mat::Mat()
     : data(0), refcount(0), elemsize(0), packing(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
@@ -628,6 +634,18 @@ inline Mat Mat::clone(Allocator* allocator) const
     return m;
 }
 
+inline Mat Mat::shape() const
+{
+    if (dims == 1)
+        return Mat(w, (void*)0, elemsize, packing);
+    if (dims == 2)
+        return Mat(w, h, (void*)0, elemsize, packing);
+    if (dims == 3)
+        return Mat(w, h, c, (void*)0, elemsize, packing);
+
+    return Mat();
+}
+
 inline Mat Mat::reshape(int _w, Allocator* _allocator) const
 {
     if (w * h * c != _w)
@@ -197,10 +197,25 @@ Mat ModelBinFromStdio::load(int w, int type) const
 }
 #endif // NCNN_STDIO
 
-ModelBinFromMemory::ModelBinFromMemory(const unsigned char*& _mem) : mem(_mem)
+ModelBinFromMemory::ModelBinFromMemory(const unsigned char*& _mem) : mem(_mem), mem_end(0)
 {
 }
 
+ModelBinFromMemory::ModelBinFromMemory(const unsigned char*& _mem, size_t size) : mem(_mem), mem_end(_mem + size)
+{
+}
+
+bool ModelBinFromMemory::readable(size_t size) const
+{
+    if (mem_end && (size_t)(mem_end - mem) < size)
+    {
+        fprintf(stderr, "ModelBin read past the end of memory\n");
+        return false;
+    }
+
+    return true;
+}
+
 Mat ModelBinFromMemory::load(int w, int type) const
 {
     if (!mem)
@@ -208,6 +223,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
 
     if (type == 0)
     {
+        if (!readable(4))
+            return Mat();
+
         union
         {
             struct
@@ -228,6 +246,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
         if (flag_struct.tag == 0x01306B47)
         {
             // half-precision data
+            if (!readable(alignSize(w * sizeof(unsigned short), 4)))
+                return Mat();
+
             Mat m = Mat::from_float16((unsigned short*)mem, w);
             mem += alignSize(w * sizeof(unsigned short), 4);
             return m;
@@ -235,6 +256,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
         else if (flag_struct.tag == 0x000D4B38)
         {
             // int8 data
+            if (!readable(alignSize(w, 4)))
+                return Mat();
+
             Mat m = Mat(w, (signed char*)mem, 1u);
             mem += alignSize(w, 4);
             return m;
@@ -242,6 +266,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
         else if (flag_struct.tag == 0x0002C056)
         {
             // raw data with extra scaling
+            if (!readable(w * sizeof(float)))
+                return Mat();
+
             Mat m = Mat(w, (float*)mem);
             mem += w * sizeof(float);
             return m;
@@ -250,6 +277,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
         if (flag != 0)
         {
             // quantized data
+            if (!readable(256 * sizeof(float) + alignSize(w * sizeof(unsigned char), 4)))
+                return Mat();
+
             const float* quantization_value = (const float*)mem;
             mem += 256 * sizeof(float);
 
@@ -271,6 +301,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
         else if (flag_struct.f0 == 0)
         {
             // raw data
+            if (!readable(w * sizeof(float)))
+                return Mat();
+
             Mat m = Mat(w, (float*)mem);
             mem += w * sizeof(float);
             return m;
@@ -279,6 +312,9 @@ Mat ModelBinFromMemory::load(int w, int type) const
     else if (type == 1)
     {
         // raw data
+        if (!readable(w * sizeof(float)))
+            return Mat();
+
         Mat m = Mat(w, (float*)mem);
         mem += w * sizeof(float);
         return m;
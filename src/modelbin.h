@@ -57,11 +57,18 @@ class ModelBinFromMemory : public ModelBin
 public:
     // construct from external memory
     ModelBinFromMemory(const unsigned char*& mem);
+    // construct from external memory of size bytes, reads past the end fail
+    ModelBinFromMemory(const unsigned char*& mem, size_t size);
 
     virtual Mat load(int w, int type) const;
 
 protected:
+    // the next size bytes are within the memory
+    bool readable(size_t size) const;
+
     const unsigned char*& mem;
+    // 0 if the size is unknown
+    const unsigned char* mem_end;
 };
 
 class ModelBinFromMatArray : public ModelBin
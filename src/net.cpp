@@ -16,13 +16,28 @@
 #include "layer_type.h"
 #include "modelbin.h"
 #include "paramdict.h"
+#include "binaryop.h"
+#include "clip.h"
+#include "concat.h"
 #include "convolution.h"
 #include "convolutiondepthwise.h"
+#include "eltwise.h"
+#include "expression.h"
+#include "innerproduct.h"
+#include "padding.h"
+#include "permute.h"
+#include "pooling.h"
 #include "relu.h"
+#include "reshape.h"
+#include "scale.h"
+#include "slice.h"
+#include "unaryop.h"
 
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <algorithm>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -36,10 +51,83 @@
 #include "command.h"
 #endif // NCNN_VULKAN
 
+#if NCNN_STDIO && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // NCNN_STDIO && !defined(_WIN32)
+
 namespace ncnn {
 
+#if NCNN_STDIO
+// map the whole file read-only, return 0 on failure
+static void* map_file(const char* path, size_t* size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return 0;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(file);
+    if (!mapping)
+        return 0;
+
+    // the view keeps the mapping alive
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data)
+        return 0;
+
+    *size = (size_t)file_size.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    // the mapping outlives the descriptor
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return 0;
+
+    *size = st.st_size;
+    return data;
+#endif // _WIN32
+}
+
+static void unmap_file(void* data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif // _WIN32
+}
+#endif // NCNN_STDIO
+
 Net::Net()
 {
+#if NCNN_STDIO
+#endif // NCNN_STDIO
+
 #if NCNN_VULKAN
     vkdev = 0;
     weight_vkallocator = 0;
@@ -272,7 +360,7 @@ int Net::load_param(FILE* fp)
         layers[i] = layer;
     }
 
-    return 0;
+    return build_execution_plan();
 }
 
 #if _MSC_VER
@@ -443,7 +531,7 @@ int Net::load_param_mem(const char* _mem)
         layers[i] = layer;
     }
 
-    return 0;
+    return build_execution_plan();
 }
 
 int Net::load_param(const char* protopath)
@@ -596,7 +684,7 @@ int Net::load_param_bin(FILE* fp)
         layers[i] = layer;
     }
 
-    return 0;
+    return build_execution_plan();
 }
 
 int Net::load_param_bin(const char* protopath)
@@ -664,7 +752,11 @@ int Net::load_model(FILE* fp)
     }
 #endif // NCNN_VULKAN
 
-    fuse_network();
+    if (ret == 0 && fuse_network() != 0)
+    {
+        fprintf(stderr, "fuse_network failed\n");
+        ret = -1;
+    }
 
     return ret;
 }
@@ -684,6 +776,111 @@ int Net::load_model(const char* modelpath)
 
     return ret;
 }
+
+int Net::load_model_mmap(const char* modelpath)
+{
+    size_t size = 0;
+    void* data = map_file(modelpath, &size);
+    if (!data)
+    {
+        fprintf(stderr, "mmap %s failed\n", modelpath);
+        return -1;
+    }
+
+    // float32 and int8 weights point into the mapping, others are converted
+    // reads past the end of the mapping fail instead of faulting
+    int ret = load_model_memory((const unsigned char*)data, size);
+
+    // layers loaded before a failure reference the new mapping, the others the old ones
+    mapped_models.push_back(data);
+    mapped_model_sizes.push_back(size);
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "model file %s load failed\n", modelpath);
+        return -1;
+    }
+
+    // every layer references the new mapping now
+    const size_t old_count = mapped_models.size() - 1;
+    for (size_t i=0; i<old_count; i++)
+    {
+        unmap_file(mapped_models[i], mapped_model_sizes[i]);
+    }
+    mapped_models.erase(mapped_models.begin(), mapped_models.begin() + old_count);
+    mapped_model_sizes.erase(mapped_model_sizes.begin(), mapped_model_sizes.begin() + old_count);
+
+    return 0;
+}
+
+int Net::load_kernel_cache(const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    // layer index, layer type, w h c and kernel per line
+    std::vector< std::vector<KernelChoice> > layer_choices(layers.size());
+
+    int layer_index;
+    int typeindex;
+    KernelChoice choice;
+    while (fscanf(fp, "%d %d %d %d %d %d", &layer_index, &typeindex, &choice.w, &choice.h, &choice.c, &choice.kernel) == 6)
+    {
+        if (layer_index < 0 || layer_index >= (int)layers.size() || layers[layer_index]->typeindex != typeindex)
+            continue;
+
+        layer_choices[layer_index].push_back(choice);
+    }
+
+    fclose(fp);
+
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        if (layer_choices[i].empty())
+            continue;
+
+        int ret = layers[i]->load_kernel_choices(layer_choices[i]);
+        if (ret != 0)
+        {
+            fprintf(stderr, "layer load_kernel_choices %d failed\n", (int)i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int Net::save_kernel_cache(const char* path) const
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        const Layer* layer = layers[i];
+
+        std::vector<KernelChoice> choices;
+        layer->save_kernel_choices(choices);
+
+        for (size_t j=0; j<choices.size(); j++)
+        {
+            const KernelChoice& choice = choices[j];
+            fprintf(fp, "%d %d %d %d %d %d\n", (int)i, layer->typeindex, choice.w, choice.h, choice.c, choice.kernel);
+        }
+    }
+
+    fclose(fp);
+
+    return 0;
+}
 #endif // NCNN_STDIO
 
 int Net::load_param(const unsigned char* _mem)
@@ -811,10 +1008,19 @@ int Net::load_param(const unsigned char* _mem)
         layers[i] = layer;
     }
 
+    int pret = build_execution_plan();
+    if (pret != 0)
+        return pret;
+
     return mem - _mem;
 }
 
 int Net::load_model(const unsigned char* _mem)
+{
+    return load_model_memory(_mem, 0);
+}
+
+int Net::load_model_memory(const unsigned char* _mem, size_t size)
 {
     if (layers.empty())
     {
@@ -830,7 +1036,7 @@ int Net::load_model(const unsigned char* _mem)
     }
 
     const unsigned char* mem = _mem;
-    ModelBinFromMemory mb(mem);
+    ModelBinFromMemory mb(mem, size);
     for (size_t i=0; i<layers.size(); i++)
     {
         Layer* layer = layers[i];
@@ -865,232 +1071,1122 @@ int Net::load_model(const unsigned char* _mem)
     }
 #endif // NCNN_VULKAN
 
+    if (fuse_network() != 0)
+    {
+        fprintf(stderr, "fuse_network failed\n");
+        return -1;
+    }
+
     return mem - _mem;
 }
 
-int Net::fuse_network()
+#if NCNN_STRING && NCNN_REQUANT
+// what the consumers of one blob expect from it
+struct Int8BlobDemand
 {
-    // set the int8 op fusion:requantize
-#if NCNN_STRING && NCNN_REQUANT    
-    // fprintf(stderr, "Test op fusion to int8 implement:\n");
-    // parse the network whether is a quantization model
-    bool net_quantized = false;
-    for (size_t i=0; i<layers.size(); i++)
-    {
-        Layer* layer = layers[i];
-        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise")
-        {
-            if (layer->type == "Convolution" && (((Convolution*)layer)->use_int8_inference == false))
-                continue;
-            if (layer->type == "ConvolutionDepthWise" && (((ConvolutionDepthWise*)layer)->use_int8_inference == false))
-                continue;    
-            net_quantized = true;
-        }
-    }
-
-    if (net_quantized == false)
-        return 0;
+    Int8BlobDemand() : float32(false), scale(0.f), suggested_scale(0.f) {}
 
-    for (size_t i=0; i<layers.size(); i++)
+    void merge(const Int8BlobDemand& d)
     {
-        Layer* layer = layers[i];
-
-        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise")
-        {
-            if (layer->type == "Convolution" && (((Convolution*)layer)->use_int8_inference == false))
-                continue;
-            if (layer->type == "ConvolutionDepthWise" && (((ConvolutionDepthWise*)layer)->use_int8_inference == false))
-                continue;
-
-            for (size_t n=0; n<blobs[layer->tops[0]].consumers.size(); n++)
-            {
-                int layer_next_index = blobs[layer->tops[0]].consumers[n];
-                Layer* layer_next = layers[layer_next_index];
-
-                if (layer_next->type == "ReLU")
-                {
-                    int layer_next_2_index = blobs[layer_next->tops[0]].consumers[0];
-                    Layer* layer_next_2 = layers[layer_next_2_index];
+        float32 = float32 || d.float32;
 
-                    if (layer_next_2->type == "Convolution" || layer_next_2->type == "ConvolutionDepthWise")
-                    {
-                        if (layer_next_2->type == "Convolution" && ((Convolution*)layer_next_2)->use_int8_inference == false)
-                            continue;
-                        if (layer_next_2->type == "ConvolutionDepthWise" && ((ConvolutionDepthWise*)layer_next_2)->use_int8_inference == false)
-                            continue;    
+        if (scale != 0.f && d.scale != 0.f && scale != d.scale)
+            float32 = true;
+        else if (d.scale != 0.f)
+            scale = d.scale;
 
-                        // fprintf(stderr, "%s, %s, %s\n", layer->name.c_str(), layer_next->name.c_str(), layer_next_2->name.c_str());
-                        if (layer->type == "Convolution" && layer_next_2->type == "Convolution")
-                        {
-                            ((Convolution*)layer)->use_int8_requantize = true;
-                            ((Convolution*)layer)->top_blob_int8_scale = ((Convolution*)layer_next_2)->bottom_blob_int8_scale;
-                            ((Convolution*)layer)->create_requantize_op();
-                        }
-                        else if (layer->type == "ConvolutionDepthWise" && layer_next_2->type == "Convolution")
-                        {
-                            ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
-                            ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = ((Convolution*)layer_next_2)->bottom_blob_int8_scale;
-                            ((ConvolutionDepthWise*)layer)->create_requantize_op();
-                        }
-                        else if (layer->type == "Convolution" && layer_next_2->type == "ConvolutionDepthWise")
-                        {
-                            ((Convolution*)layer)->use_int8_requantize = true;
-                            ((Convolution*)layer)->top_blob_int8_scale = ((ConvolutionDepthWise*)layer_next_2)->bottom_blob_int8_scales[0];
-                            ((Convolution*)layer)->create_requantize_op();
-                        }
-                        else
-                        {
-                            ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
-                            ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = ((ConvolutionDepthWise*)layer_next_2)->bottom_blob_int8_scales[0];
-                            ((ConvolutionDepthWise*)layer)->create_requantize_op();
-                        }
-                    }
-                    else if (layer_next_2->type == "Split")
-                    {
-                        bool all_conv = true;
-                        for (size_t i=0; i<layer_next_2->tops.size(); i++)
-                        {
-                            int layer_next_3_index = blobs[layer_next_2->tops[i]].consumers[0];
-                            if (layers[layer_next_3_index]->type != "Convolution" && layers[layer_next_3_index]->type != "ConvolutionDepthWise" && layers[layer_next_3_index]->type != "PriorBox" )
-                            {
-                                // fprintf(stderr, "%s, %s, %s, %s\n", layer->name.c_str(), layer_next->name.c_str(), layer_next_2->name.c_str(), layers[layer_next_3_index]->name.c_str());
-                                all_conv = false;
-                            }
-                        }
+        if (suggested_scale == 0.f || (d.suggested_scale != 0.f && d.suggested_scale < suggested_scale))
+            suggested_scale = d.suggested_scale;
+    }
 
-                        if (all_conv == true && layer_next_2->tops.size() >= size_t(2))
-                        {
-                            // fprintf(stderr, "%s, %s, %s, ", layer->name.c_str(), layer_next->name.c_str(), layer_next_2->name.c_str());
-                            for (size_t i=0; i<layer_next_2->tops.size(); i++)
-                            {
-                                int layer_next_3_index = blobs[layer_next_2->tops[i]].consumers[0];
-                                Layer* layer_next_3 = layers[layer_next_3_index];
-
-                                // fprintf(stderr, "%s, ", layer_next_3->name.c_str());
-                                if (layer_next_3->type == "Convolution")
-                                {
-                                    ((Convolution*)layer)->top_blob_int8_scale = ((Convolution*)layer_next_3)->bottom_blob_int8_scale; 
-                                }    
-                            }
+    float resolve() const
+    {
+        if (float32)
+            return 0.f;
 
-                            ((Convolution*)layer)->use_int8_requantize = true;
-                            ((Convolution*)layer)->create_requantize_op();    
-                            // fprintf(stderr, "\n");
-                        }
-                    }
-                    else
-                    {
-                        // fprintf(stderr, "%s, %s\n", layer->name.c_str(), layer_next->name.c_str());
-                    }
-                }
-                else if (layer_next->type == "Pooling")
-                {
-                    // ToDo
-                }
-                else
-                {
-                    // fprintf(stderr, "%s\n", layer->name.c_str());
-                }                  
-            }
-        }
+        return scale != 0.f ? scale : suggested_scale;
     }
-#endif
-    return 0;
-}
 
-void Net::clear()
+    // some consumer only takes float32
+    bool float32;
+    // some consumer quantizes to exactly this scale
+    float scale;
+    // consumers requantize anyway, the smallest scale keeps the widest range
+    float suggested_scale;
+};
+
+// scale the layer quantizes its bottom blob to, 0 if it takes float32
+static float int8_bottom_scale(const Layer* layer)
 {
-#if NCNN_VULKAN
-    destroy_pipeline();
-#endif // NCNN_VULKAN
+    if (layer->type == "Convolution" && ((const Convolution*)layer)->use_int8_inference)
+        return ((const Convolution*)layer)->bottom_blob_int8_scale;
 
-    blobs.clear();
-    for (size_t i=0; i<layers.size(); i++)
-    {
-        int dret = layers[i]->destroy_pipeline(opt);
-        if (dret != 0)
-        {
-            fprintf(stderr, "layer destroy_pipeline failed\n");
-            // ignore anyway
-        }
+    if (layer->type == "ConvolutionDepthWise" && ((const ConvolutionDepthWise*)layer)->use_int8_inference)
+        return ((const ConvolutionDepthWise*)layer)->bottom_blob_int8_scales[0];
 
-        delete layers[i];
-    }
-    layers.clear();
+    if (layer->type == "InnerProduct" && ((const InnerProduct*)layer)->use_int8_inference)
+        return ((const InnerProduct*)layer)->bottom_blob_int8_scale;
 
-#if NCNN_VULKAN
-    if (weight_vkallocator)
-    {
-        delete weight_vkallocator;
-        weight_vkallocator = 0;
-    }
-    if (weight_staging_vkallocator)
-    {
-        delete weight_staging_vkallocator;
-        weight_staging_vkallocator = 0;
-    }
-#endif // NCNN_VULKAN
+    return 0.f;
 }
 
-Extractor Net::create_extractor() const
+// int8 in, the same int8 out
+static bool is_int8_passthrough(const Layer* layer)
 {
-    return Extractor(this, blobs.size());
+    if (layer->type == "ReLU")
+        return ((const ReLU*)layer)->slope == 0.f;
+
+    return layer->type == "Pooling" || layer->type == "Split";
 }
 
-#if NCNN_VULKAN
-void Net::set_vulkan_device(const VulkanDevice* _vkdev)
+// int8 or float32 in, int8 at any scale or float32 out
+static bool is_int8_rescale(const Layer* layer)
 {
-    vkdev = _vkdev;
+    return layer->type == "Eltwise" || layer->type == "Concat";
 }
+#endif // NCNN_STRING && NCNN_REQUANT
 
-int Net::upload_model()
+int Net::fuse_network()
 {
-    ncnn::VkTransfer cmd(vkdev);
+    fuse_requantize();
 
-    // create gpu device allocator if null
-    if (!weight_vkallocator)
+    if (opt.use_layer_fusion && !opt.use_vulkan_compute)
     {
-        weight_vkallocator = new VkWeightBufferAllocator(vkdev);
+        if (fuse_layers() > 0)
+            return build_execution_plan();
     }
-    if (!weight_staging_vkallocator)
+
+    return 0;
+}
+
+int Net::fuse_requantize()
+{
+    // keep blobs int8 between quantized layers
+    // a quantized convolution requantizes its top instead of dequantize and quantize again
+    // pooling, relu and split pass int8 through, eltwise and concat rescale
+#if NCNN_STRING && NCNN_REQUANT
+    bool net_quantized = false;
+    for (size_t i=0; i<layers.size(); i++)
     {
-        weight_staging_vkallocator = new VkWeightStagingBufferAllocator(vkdev);
+        if (int8_bottom_scale(layers[i]) != 0.f)
+            net_quantized = true;
     }
 
-    cmd.weight_vkallocator = weight_vkallocator;
-    cmd.staging_vkallocator = weight_staging_vkallocator;
+    if (net_quantized == false)
+        return 0;
 
+    // which blobs could be produced in int8
+    std::vector<bool> blob_int8_capable(blobs.size(), false);
     for (size_t i=0; i<layers.size(); i++)
     {
-        if (layers[i]->support_vulkan)
+        const Layer* layer = layers[i];
+
+        bool int8_capable = false;
+        if (layer->type == "Convolution" && ((const Convolution*)layer)->use_int8_inference)
         {
-            int uret = layers[i]->upload_model(cmd, opt);
-            if (uret != 0)
+            // requantize keeps relu only
+            int activation_type = ((const Convolution*)layer)->activation_type;
+            int8_capable = activation_type == 0 || activation_type == 1;
+        }
+        else if (layer->type == "ConvolutionDepthWise" && ((const ConvolutionDepthWise*)layer)->use_int8_inference)
+        {
+            int activation_type = ((const ConvolutionDepthWise*)layer)->activation_type;
+            int8_capable = activation_type == 0 || activation_type == 1;
+        }
+        else if (is_int8_passthrough(layer))
+        {
+            int8_capable = blob_int8_capable[layer->bottoms[0]];
+        }
+        else if (is_int8_rescale(layer))
+        {
+            for (size_t j=0; j<layer->bottoms.size(); j++)
             {
-                fprintf(stderr, "layer upload_model %d failed\n", (int)i);
-                return -1;
+                if (blob_int8_capable[layer->bottoms[j]])
+                    int8_capable = true;
             }
         }
-    }
-
-    cmd.submit_and_wait();
 
-    return 0;
-}
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            blob_int8_capable[layer->tops[j]] = int8_capable;
+        }
+    }
 
-int Net::create_pipeline()
-{
-    if (opt.use_fp16_storage && vkdev->info.type != 0)
+    // what every blob is expected to be, from the last layer up
+    std::vector<Int8BlobDemand> blob_demands(blobs.size());
+    for (int i=(int)blobs.size()-1; i>=0; i--)
     {
+        if (blobs[i].consumers.empty())
         {
-        cast_float32_to_float16 = ncnn::create_layer(ncnn::LayerType::Cast);
-        cast_float32_to_float16->vkdev = vkdev;
-
-        ncnn::ParamDict pd;
-        pd.set(0, 1);
-        pd.set(1, 2);
-
-        cast_float32_to_float16->load_param(pd);
+            // network output
+            blob_demands[i].float32 = true;
+        }
+    }
+    for (int i=(int)layers.size()-1; i>=0; i--)
+    {
+        const Layer* layer = layers[i];
+
+        Int8BlobDemand demand;
+        if (int8_bottom_scale(layer) != 0.f)
+        {
+            demand.scale = int8_bottom_scale(layer);
+        }
+        else if (is_int8_passthrough(layer))
+        {
+            for (size_t j=0; j<layer->tops.size(); j++)
+            {
+                demand.merge(blob_demands[layer->tops[j]]);
+            }
+        }
+        else if (is_int8_rescale(layer))
+        {
+            if (blob_int8_capable[layer->tops[0]])
+                demand.suggested_scale = blob_demands[layer->tops[0]].resolve();
+        }
+        else if (layer->type == "PriorBox")
+        {
+            // reads the shape only
+        }
+        else
+        {
+            demand.float32 = true;
+        }
+
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            blob_demands[layer->bottoms[j]].merge(demand);
+        }
+    }
+
+    // settle the scales top down
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        Layer* layer = layers[i];
+
+        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise")
+        {
+            int top_blob_index = layer->tops[0];
+            if (!blob_int8_capable[top_blob_index])
+                continue;
+
+            float scale = blob_demands[top_blob_index].resolve();
+            if (scale == 0.f)
+                continue;
+
+            if (layer->type == "Convolution")
+            {
+                Convolution* convolution = (Convolution*)layer;
+                convolution->use_int8_requantize = true;
+                convolution->top_blob_int8_scale = scale;
+                convolution->create_requantize_op();
+            }
+            else
+            {
+                ConvolutionDepthWise* convolutiondepthwise = (ConvolutionDepthWise*)layer;
+                convolutiondepthwise->use_int8_requantize = true;
+                convolutiondepthwise->top_blob_int8_scale = scale;
+                convolutiondepthwise->create_requantize_op();
+            }
+
+            blobs[top_blob_index].int8_scale = scale;
+        }
+        else if (is_int8_passthrough(layer))
+        {
+            for (size_t j=0; j<layer->tops.size(); j++)
+            {
+                blobs[layer->tops[j]].int8_scale = blobs[layer->bottoms[0]].int8_scale;
+            }
+        }
+        else if (is_int8_rescale(layer))
+        {
+            Mat bottom_blob_int8_scales(layer->bottoms.size());
+            bool use_int8_inference = false;
+            for (size_t j=0; j<layer->bottoms.size(); j++)
+            {
+                bottom_blob_int8_scales[j] = blobs[layer->bottoms[j]].int8_scale;
+                if (bottom_blob_int8_scales[j] != 0.f)
+                    use_int8_inference = true;
+            }
+
+            int top_blob_index = layer->tops[0];
+
+            float top_blob_int8_scale = 0.f;
+            if (blob_int8_capable[top_blob_index])
+                top_blob_int8_scale = blob_demands[top_blob_index].resolve();
+
+            if (!use_int8_inference && top_blob_int8_scale == 0.f)
+                continue;
+
+            if (layer->type == "Eltwise")
+            {
+                Eltwise* eltwise = (Eltwise*)layer;
+                eltwise->use_int8_inference = true;
+                eltwise->bottom_blob_int8_scales = bottom_blob_int8_scales;
+                eltwise->top_blob_int8_scale = top_blob_int8_scale;
+            }
+            else
+            {
+                Concat* concat = (Concat*)layer;
+                concat->use_int8_inference = true;
+                concat->bottom_blob_int8_scales = bottom_blob_int8_scales;
+                concat->top_blob_int8_scale = top_blob_int8_scale;
+            }
+
+            blobs[top_blob_index].int8_scale = top_blob_int8_scale;
+        }
+    }
+#endif // NCNN_STRING && NCNN_REQUANT
+
+    return 0;
+}
+
+// the only consumer of a blob, -1 if there are more or none
+static int single_consumer(const std::vector<Blob>& blobs, int blob_index)
+{
+    const std::vector<int>& consumers = blobs[blob_index].consumers;
+    return consumers.size() == 1 ? consumers[0] : -1;
+}
+
+static void replace_consumer(Blob& blob, int layer_index, int new_layer_index)
+{
+    for (size_t i=0; i<blob.consumers.size(); i++)
+    {
+        if (blob.consumers[i] == layer_index)
+            blob.consumers[i] = new_layer_index;
+    }
+}
+
+// the blob between two fused layers is produced and consumed by nobody
+static void drop_blob(Blob& blob)
+{
+    blob.producer = -1;
+    blob.consumers.clear();
+}
+
+// a fused layer stays alive for its host, but leaves the graph
+static void detach_layer(Layer* layer)
+{
+    layer->bottoms.clear();
+    layer->tops.clear();
+}
+
+static bool is_float_convolution(const Layer* layer)
+{
+    return layer->typeindex == LayerType::Convolution && !((const Convolution*)layer)->use_int8_inference
+           && layer->bottoms.size() == 1 && layer->tops.size() == 1;
+}
+
+// elementwise float layers an expression program can take
+static bool is_expression_layer(const Layer* layer, const std::vector<Blob>& blobs)
+{
+    if (!layer || layer->tops.size() != 1 || blobs[layer->tops[0]].int8_scale != 0.f)
+        return false;
+
+    for (size_t j=0; j<layer->bottoms.size(); j++)
+    {
+        if (blobs[layer->bottoms[j]].int8_scale != 0.f)
+            return false;
+    }
+
+    const int bottom_count = layer->bottoms.size();
+
+    switch (layer->typeindex)
+    {
+    case LayerType::UnaryOp:
+    case LayerType::ReLU:
+    case LayerType::Clip:
+    case LayerType::Sigmoid:
+    case LayerType::TanH:
+        return bottom_count == 1;
+    case LayerType::BinaryOp:
+        return bottom_count == (((const BinaryOp*)layer)->with_scalar ? 1 : 2);
+    case LayerType::Scale:
+        return bottom_count == 1 && ((const Scale*)layer)->scale_data_size != -233;
+    case LayerType::Eltwise:
+        return bottom_count == 2 && ((const Eltwise*)layer)->coeffs.w == 0 && !((const Eltwise*)layer)->use_int8_inference;
+    default:
+        return false;
+    }
+}
+
+static Expression::Instruction expression_instruction(int op, int type, int dst, int a, int b = 0, float p0 = 0.f, float p1 = 0.f)
+{
+    Expression::Instruction ins = { op, type, dst, a, b, p0, p1 };
+    return ins;
+}
+
+// the chain value lives in register 0, the other operand of a binary layer in register 1
+static void compile_expression_layer(Expression* expression, const Layer* layer, const std::vector<int>& layer_bottoms, int chain_bottom)
+{
+    std::vector<Expression::Instruction>& program = expression->program;
+
+    if (chain_bottom == -1)
+    {
+        // the first layer loads its bottoms
+        for (size_t j=0; j<layer_bottoms.size(); j++)
+        {
+            program.push_back(expression_instruction(Expression::Instruction_LOAD, 0, (int)j, layer_bottoms[j]));
+        }
+    }
+    else if (layer_bottoms.size() == 2)
+    {
+        program.push_back(expression_instruction(Expression::Instruction_LOAD, 0, 1, layer_bottoms[1 - chain_bottom]));
+    }
+
+    // register of bottom 0 and bottom 1
+    const int a = chain_bottom == 1 ? 1 : 0;
+    const int b = 1 - a;
+
+    switch (layer->typeindex)
+    {
+    case LayerType::UnaryOp:
+        program.push_back(expression_instruction(Expression::Instruction_UNARY, ((const UnaryOp*)layer)->op_type, 0, 0));
+        break;
+    case LayerType::ReLU:
+        program.push_back(expression_instruction(Expression::Instruction_RELU, 0, 0, 0, 0, ((const ReLU*)layer)->slope));
+        break;
+    case LayerType::Clip:
+        program.push_back(expression_instruction(Expression::Instruction_CLIP, 0, 0, 0, 0, ((const Clip*)layer)->min, ((const Clip*)layer)->max));
+        break;
+    case LayerType::Sigmoid:
+        program.push_back(expression_instruction(Expression::Instruction_SIGMOID, 0, 0, 0));
+        break;
+    case LayerType::TanH:
+        program.push_back(expression_instruction(Expression::Instruction_TANH, 0, 0, 0));
+        break;
+    case LayerType::BinaryOp:
+    {
+        const BinaryOp* binaryop = (const BinaryOp*)layer;
+        if (binaryop->with_scalar)
+            program.push_back(expression_instruction(Expression::Instruction_SCALAR, binaryop->op_type, 0, 0, 0, binaryop->b));
+        else
+            program.push_back(expression_instruction(Expression::Instruction_BINARY, binaryop->op_type, 0, a, b));
+        break;
+    }
+    case LayerType::Eltwise:
+    {
+        int op_type = ((const Eltwise*)layer)->op_type;
+        int binary_type = op_type == Eltwise::Operation_PROD ? BinaryOp::Operation_MUL : op_type == Eltwise::Operation_SUM ? BinaryOp::Operation_ADD : BinaryOp::Operation_MAX;
+        program.push_back(expression_instruction(Expression::Instruction_BINARY, binary_type, 0, a, b));
+        break;
+    }
+    case LayerType::Scale:
+    {
+        const Scale* scale = (const Scale*)layer;
+        program.push_back(expression_instruction(Expression::Instruction_CONSTANT, 0, 1, (int)expression->constants.size()));
+        program.push_back(expression_instruction(Expression::Instruction_BINARY, BinaryOp::Operation_MUL, 0, 0, 1));
+        expression->constants.push_back(scale->scale_data);
+        if (scale->bias_term)
+        {
+            program.push_back(expression_instruction(Expression::Instruction_CONSTANT, 0, 1, (int)expression->constants.size()));
+            program.push_back(expression_instruction(Expression::Instruction_BINARY, BinaryOp::Operation_ADD, 0, 0, 1));
+            expression->constants.push_back(scale->bias_data);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int Net::fuse_layers()
+{
+    int fused_count = 0;
+    const int layer_count = layers.size();
+
+    // constant zero padding becomes the padding of the convolution after it
+    for (int i=0; i<layer_count; i++)
+    {
+        Layer* layer = layers[i];
+        if (!layer || layer->typeindex != LayerType::Padding || layer->bottoms.size() != 1 || layer->tops.size() != 1)
+            continue;
+
+        const Padding* padding = (const Padding*)layer;
+        if (padding->type != 0 || padding->value != 0.f || padding->top != padding->bottom || padding->left != padding->right || padding->top < 0 || padding->left < 0)
+            continue;
+
+        int top_blob_index = layer->tops[0];
+        int consumer = single_consumer(blobs, top_blob_index);
+        if (consumer == -1 || !layers[consumer] || layers[consumer]->bottoms.size() != 1)
+            continue;
+
+        int* pad_w = 0;
+        int* pad_h = 0;
+        if (layers[consumer]->typeindex == LayerType::Convolution)
+        {
+            pad_w = &((Convolution*)layers[consumer])->pad_w;
+            pad_h = &((Convolution*)layers[consumer])->pad_h;
+        }
+        else if (layers[consumer]->typeindex == LayerType::ConvolutionDepthWise)
+        {
+            pad_w = &((ConvolutionDepthWise*)layers[consumer])->pad_w;
+            pad_h = &((ConvolutionDepthWise*)layers[consumer])->pad_h;
+        }
+
+        // same padding is resolved from the input size
+        if (!pad_w || *pad_w < 0 || *pad_h < 0)
+            continue;
+
+        *pad_w += padding->left;
+        *pad_h += padding->top;
+
+        int bottom_blob_index = layer->bottoms[0];
+        layers[consumer]->bottoms[0] = bottom_blob_index;
+        replace_consumer(blobs[bottom_blob_index], i, consumer);
+        drop_blob(blobs[top_blob_index]);
+        detach_layer(layer);
+        fused_count++;
+    }
+
+    // residual eltwise sum and the relu after it run in the epilogue of a convolution
+    // pooling is not fused, its windows straddle the output tiles the kernels store one at a time
+    for (int i=0; i<layer_count; i++)
+    {
+        Layer* layer = layers[i];
+        if (!layer || layer->typeindex != LayerType::Eltwise || layer->bottoms.size() != 2 || layer->tops.size() != 1)
+            continue;
+
+        const Eltwise* eltwise = (const Eltwise*)layer;
+        if (eltwise->op_type != Eltwise::Operation_SUM || eltwise->use_int8_inference || (eltwise->coeffs.w != 0 && eltwise->coeffs.w != 2))
+            continue;
+
+        // the later convolution takes the other bottom as residual
+        int host = -1;
+        int host_bottom = -1;
+        for (int j=0; j<2; j++)
+        {
+            int bottom_blob_index = layer->bottoms[j];
+            int producer = blobs[bottom_blob_index].producer;
+            if (producer < 0 || !layers[producer] || single_consumer(blobs, bottom_blob_index) != i)
+                continue;
+
+            const Layer* producer_layer = layers[producer];
+            if (!is_float_convolution(producer_layer) || !producer_layer->one_blob_only)
+                continue;
+
+            if (host == -1 || plan.layer_steps[producer] > plan.layer_steps[host])
+            {
+                host = producer;
+                host_bottom = j;
+            }
+        }
+
+        if (host == -1)
+            continue;
+
+        Convolution* convolution = (Convolution*)layers[host];
+        int residual_blob_index = layer->bottoms[1 - host_bottom];
+
+        convolution->use_fused_eltwise = true;
+        convolution->fused_eltwise_coeffs[0] = eltwise->coeffs.w == 0 ? 1.f : eltwise->coeffs[host_bottom];
+        convolution->fused_eltwise_coeffs[1] = eltwise->coeffs.w == 0 ? 1.f : eltwise->coeffs[1 - host_bottom];
+        convolution->one_blob_only = false;
+
+        drop_blob(blobs[convolution->tops[0]]);
+        convolution->bottoms.push_back(residual_blob_index);
+        replace_consumer(blobs[residual_blob_index], i, host);
+
+        int top_blob_index = layer->tops[0];
+        detach_layer(layer);
+        fused_count++;
+
+        int consumer = single_consumer(blobs, top_blob_index);
+        if (consumer != -1 && layers[consumer] && layers[consumer]->typeindex == LayerType::ReLU && layers[consumer]->bottoms.size() == 1 && layers[consumer]->tops.size() == 1)
+        {
+            convolution->fused_activation_type = 1;
+            convolution->fused_relu_slope = ((const ReLU*)layers[consumer])->slope;
+
+            drop_blob(blobs[top_blob_index]);
+            top_blob_index = layers[consumer]->tops[0];
+            detach_layer(layers[consumer]);
+            fused_count++;
+        }
+
+        convolution->tops[0] = top_blob_index;
+        blobs[top_blob_index].producer = host;
+    }
+
+    // flatten and reshape after permute view its densely written top
+    for (int i=0; i<layer_count; i++)
+    {
+        Layer* layer = layers[i];
+        if (!layer || layer->typeindex != LayerType::Permute || layer->bottoms.size() != 1 || layer->tops.size() != 1)
+            continue;
+
+        Permute* permute = (Permute*)layer;
+        for (;;)
+        {
+            int top_blob_index = layer->tops[0];
+            int consumer = single_consumer(blobs, top_blob_index);
+            if (consumer == -1 || !layers[consumer] || layers[consumer]->bottoms.size() != 1 || layers[consumer]->tops.size() != 1)
+                break;
+
+            Layer* reshape_layer = layers[consumer];
+            if (reshape_layer->typeindex == LayerType::Reshape)
+            {
+                const Reshape* reshape = (const Reshape*)reshape_layer;
+                if (reshape->permute != 0 || reshape->ndim == 0)
+                    break;
+            }
+            else if (reshape_layer->typeindex != LayerType::Flatten)
+            {
+                break;
+            }
+
+            permute->fused_reshapes.push_back(reshape_layer);
+
+            drop_blob(blobs[top_blob_index]);
+            layer->tops[0] = reshape_layer->tops[0];
+            blobs[layer->tops[0]].producer = i;
+            detach_layer(reshape_layer);
+            fused_count++;
+        }
+    }
+
+    // chains of elementwise layers run as one expression program, one pass over the blob
+    for (int i=0; i<layer_count; i++)
+    {
+        if (!is_expression_layer(layers[i], blobs))
+            continue;
+
+        std::vector<int> chain(1, i);
+        for (;;)
+        {
+            int consumer = single_consumer(blobs, layers[chain.back()]->tops[0]);
+            if (consumer == -1 || !is_expression_layer(layers[consumer], blobs))
+                break;
+
+            chain.push_back(consumer);
+        }
+
+        if (chain.size() < 2)
+            continue;
+
+        Layer* layer = create_layer(LayerType::Expression);
+        if (!layer)
+            break;
+
+        Expression* expression = (Expression*)layer;
+        const int expression_index = layers.size();
+#if NCNN_STRING
+        expression->type = "Expression";
+        expression->name = layers[chain.back()]->name;
+#endif // NCNN_STRING
+
+        // bottoms from outside the chain are numbered first, chain values as -k until the count is known
+        std::vector< std::vector<int> > chain_bottoms(chain.size());
+        for (size_t k=0; k<chain.size(); k++)
+        {
+            const Layer* chain_layer = layers[chain[k]];
+
+            int chain_bottom = -1;
+            for (size_t j=0; j<chain_layer->bottoms.size(); j++)
+            {
+                int bottom_blob_index = chain_layer->bottoms[j];
+                if (k > 0 && bottom_blob_index == layers[chain[k - 1]]->tops[0])
+                {
+                    chain_bottom = j;
+                    chain_bottoms[k].push_back(-(int)k);
+                    continue;
+                }
+
+                std::vector<int>::iterator it = std::find(expression->bottoms.begin(), expression->bottoms.end(), bottom_blob_index);
+                if (it == expression->bottoms.end())
+                {
+                    chain_bottoms[k].push_back(expression->bottoms.size());
+                    expression->bottoms.push_back(bottom_blob_index);
+                }
+                else
+                {
+                    chain_bottoms[k].push_back(it - expression->bottoms.begin());
+                }
+            }
+
+            compile_expression_layer(expression, chain_layer, chain_bottoms[k], chain_bottom);
+        }
+
+        // every bottom is consumed once by the expression
+        const int bottom_count = expression->bottoms.size();
+        for (int j=0; j<bottom_count; j++)
+        {
+            std::vector<int>& consumers = blobs[expression->bottoms[j]].consumers;
+            for (size_t k=0; k<chain.size(); k++)
+            {
+                consumers.erase(std::remove(consumers.begin(), consumers.end(), chain[k]), consumers.end());
+            }
+            consumers.push_back(expression_index);
+        }
+
+        for (size_t k=0; k<chain.size(); k++)
+        {
+            for (size_t j=0; j<chain_bottoms[k].size(); j++)
+            {
+                if (chain_bottoms[k][j] < 0)
+                    chain_bottoms[k][j] = bottom_count - 1 - chain_bottoms[k][j];
+            }
+        }
+
+        expression->register_count = 2;
+        expression->fused_layer_bottoms = chain_bottoms;
+
+        int top_blob_index = layers[chain.back()]->tops[0];
+        expression->tops.push_back(top_blob_index);
+        blobs[top_blob_index].producer = expression_index;
+
+        for (size_t k=0; k<chain.size(); k++)
+        {
+            if (k + 1 < chain.size())
+                drop_blob(blobs[layers[chain[k]]->tops[0]]);
+
+            expression->fused_layers.push_back(layers[chain[k]]);
+            detach_layer(layers[chain[k]]);
+            fused_count++;
+        }
+
+        layers.push_back(expression);
+    }
+
+    return fused_count;
+}
+
+void ExecutionPlan::clear()
+{
+    layers.clear();
+    bottom_offsets.clear();
+    bottoms.clear();
+    top_offsets.clear();
+    tops.clear();
+    layer_steps.clear();
+    blob_birth_steps.clear();
+    blob_death_steps.clear();
+    blob_steps.clear();
+    alias_steps.clear();
+    step_alias_groups.clear();
+    blob_alias_groups.clear();
+    blob_alias_parts.clear();
+}
+
+int Net::build_execution_plan()
+{
+    plan.clear();
+
+    const int layer_count = layers.size();
+    const int blob_count = blobs.size();
+
+    // depth-first post order over producers, iterative to keep stack shallow on deep graphs
+    // 0 = unvisited  1 = visiting  2 = done
+    std::vector<int> layer_states(layer_count, 0);
+    std::vector<int> layer_steps(layer_count, -1);
+    std::vector<std::pair<int, int> > stack;
+    for (int i=0; i<layer_count; i++)
+    {
+        // fused layers have left the graph
+        if (!layers[i] || layers[i]->tops.empty() || layer_states[i] != 0)
+            continue;
+
+        layer_states[i] = 1;
+        stack.push_back(std::make_pair(i, 0));
+        while (!stack.empty())
+        {
+            int layer_index = stack.back().first;
+            int& next_bottom = stack.back().second;
+
+            const Layer* layer = layers[layer_index];
+            if (next_bottom < (int)layer->bottoms.size())
+            {
+                int producer = blobs[layer->bottoms[next_bottom]].producer;
+                next_bottom++;
+
+                if (producer < 0 || !layers[producer] || layer_states[producer] == 2)
+                    continue;
+
+                if (layer_states[producer] == 1)
+                {
+                    fprintf(stderr, "network graph has cycle at layer %d\n", producer);
+                    plan.clear();
+                    return -1;
+                }
+
+                layer_states[producer] = 1;
+                stack.push_back(std::make_pair(producer, 0));
+                continue;
+            }
+
+            layer_states[layer_index] = 2;
+            layer_steps[layer_index] = plan.layers.size();
+            plan.layers.push_back(layer_index);
+            stack.pop_back();
+        }
+    }
+
+    const int step_count = plan.layers.size();
+
+    plan.layer_steps = layer_steps;
+    plan.blob_birth_steps.resize(blob_count, -1);
+    plan.blob_death_steps.resize(blob_count, -1);
+    plan.bottom_offsets.resize(step_count + 1);
+    plan.top_offsets.resize(step_count + 1);
+    for (int i=0; i<step_count; i++)
+    {
+        const Layer* layer = layers[plan.layers[i]];
+
+        plan.bottom_offsets[i] = plan.bottoms.size();
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            int bottom_blob_index = layer->bottoms[j];
+            plan.bottoms.push_back(bottom_blob_index);
+            plan.blob_death_steps[bottom_blob_index] = i;
+        }
+
+        plan.top_offsets[i] = plan.tops.size();
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            int top_blob_index = layer->tops[j];
+            plan.tops.push_back(top_blob_index);
+            plan.blob_birth_steps[top_blob_index] = i;
+        }
+    }
+    plan.bottom_offsets[step_count] = plan.bottoms.size();
+    plan.top_offsets[step_count] = plan.tops.size();
+
+    // collect the ancestor steps of every blob
+    std::vector<unsigned char> step_marks(step_count, 0);
+    std::vector<int> step_stack;
+    plan.blob_steps.resize(blob_count);
+    for (int i=0; i<blob_count; i++)
+    {
+        int birth_step = plan.blob_birth_steps[i];
+        if (birth_step == -1)
+            continue;
+
+        std::vector<int>& steps = plan.blob_steps[i];
+
+        step_marks[birth_step] = 1;
+        step_stack.push_back(birth_step);
+        while (!step_stack.empty())
+        {
+            int step = step_stack.back();
+            step_stack.pop_back();
+
+            steps.push_back(step);
+
+            for (int j=plan.bottom_offsets[step]; j<plan.bottom_offsets[step + 1]; j++)
+            {
+                int producer_step = plan.blob_birth_steps[plan.bottoms[j]];
+                if (producer_step == -1 || step_marks[producer_step])
+                    continue;
+
+                step_marks[producer_step] = 1;
+                step_stack.push_back(producer_step);
+            }
+        }
+
+        std::sort(steps.begin(), steps.end());
+
+        for (size_t j=0; j<steps.size(); j++)
+        {
+            step_marks[steps[j]] = 0;
+        }
+    }
+
+    // concat and slice along the outermost axis keep their parts contiguous in the parent
+    plan.step_alias_groups.resize(step_count, -1);
+    plan.blob_alias_groups.resize(blob_count, -1);
+    plan.blob_alias_parts.resize(blob_count, -1);
+    std::vector<int> chain;
+    for (int i=0; i<step_count; i++)
+    {
+        const Layer* layer = layers[plan.layers[i]];
+        const int group = plan.alias_steps.size();
+
+        if (layer->typeindex == LayerType::Concat && ((const Concat*)layer)->axis == 0)
+        {
+            bool has_part = false;
+            for (int j=plan.bottom_offsets[i]; j<plan.bottom_offsets[i + 1]; j++)
+            {
+                // walk back through in-place layers to the producer allocating the part
+                chain.clear();
+                int blob_index = plan.bottoms[j];
+                bool writer_found = false;
+                while (blobs[blob_index].consumers.size() == 1 && plan.blob_alias_groups[blob_index] == -1)
+                {
+                    int producer = blobs[blob_index].producer;
+                    if (producer < 0 || plan.layer_steps[producer] == -1)
+                        break;
+
+                    const Layer* producer_layer = layers[producer];
+                    if (!producer_layer->one_blob_only || producer_layer->bottoms.empty())
+                        break;
+
+                    chain.push_back(blob_index);
+
+                    if (!producer_layer->support_inplace)
+                    {
+                        writer_found = true;
+                        break;
+                    }
+
+                    blob_index = producer_layer->bottoms[0];
+                }
+
+                if (!writer_found)
+                    continue;
+
+                for (size_t k=0; k<chain.size(); k++)
+                {
+                    plan.blob_alias_groups[chain[k]] = group;
+                    plan.blob_alias_parts[chain[k]] = j - plan.bottom_offsets[i];
+                }
+                has_part = true;
+            }
+
+            if (!has_part)
+                continue;
+        }
+        else if (layer->typeindex == LayerType::Slice && ((const Slice*)layer)->axis == 0)
+        {
+            // the slice bottom must not be read by anyone else once the tops are written in place
+            if (plan.bottom_offsets[i + 1] - plan.bottom_offsets[i] != 1 || blobs[plan.bottoms[plan.bottom_offsets[i]]].consumers.size() != 1)
+                continue;
+
+            for (int j=plan.top_offsets[i]; j<plan.top_offsets[i + 1]; j++)
+            {
+                plan.blob_alias_groups[plan.tops[j]] = group;
+                plan.blob_alias_parts[plan.tops[j]] = j - plan.top_offsets[i];
+            }
+        }
+        else
+        {
+            continue;
+        }
+
+        plan.step_alias_groups[i] = group;
+        plan.alias_steps.push_back(i);
+    }
+
+    // concat parents are preallocated from the inferred shapes
+    // the layers changed, infer again from the input shapes given to reshape or the Input params
+    std::vector<Mat> given_shapes(layer_count);
+    for (int i=0; i<layer_count; i++)
+    {
+        if (layers[i]->typeindex == LayerType::Input && !layers[i]->tops.empty())
+            given_shapes[i] = blobs[layers[i]->tops[0]].shape;
+    }
+    infer_blob_shapes(given_shapes);
+
+    return 0;
+}
+
+void Net::clear()
+{
+#if NCNN_VULKAN
+    destroy_pipeline();
+#endif // NCNN_VULKAN
+
+    plan.clear();
+
+    blobs.clear();
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        int dret = layers[i]->destroy_pipeline(opt);
+        if (dret != 0)
+        {
+            fprintf(stderr, "layer destroy_pipeline failed\n");
+            // ignore anyway
+        }
+
+        delete layers[i];
+    }
+    layers.clear();
+
+#if NCNN_STDIO
+    // weights referencing the mappings are gone with the layers
+    for (size_t i=0; i<mapped_models.size(); i++)
+    {
+        unmap_file(mapped_models[i], mapped_model_sizes[i]);
+    }
+    mapped_models.clear();
+    mapped_model_sizes.clear();
+#endif // NCNN_STDIO
+
+#if NCNN_VULKAN
+    if (weight_vkallocator)
+    {
+        delete weight_vkallocator;
+        weight_vkallocator = 0;
+    }
+    if (weight_staging_vkallocator)
+    {
+        delete weight_staging_vkallocator;
+        weight_staging_vkallocator = 0;
+    }
+#endif // NCNN_VULKAN
+}
+
+Extractor Net::create_extractor() const
+{
+    // one more slot per alias group holds its parent
+    return Extractor(this, blobs.size() + plan.alias_steps.size());
+}
+
+int Net::reshape(const std::vector<Mat>& input_shapes)
+{
+    if (plan.layers.empty())
+    {
+        fprintf(stderr, "reshape before load_param\n");
+        return -1;
+    }
+
+    // the given shapes go to the Input layers in layer order
+    std::vector<Mat> given_shapes(layers.size());
+    size_t input_index = 0;
+    for (size_t i=0; i<layers.size() && input_index < input_shapes.size(); i++)
+    {
+        if (layers[i]->typeindex == LayerType::Input && !layers[i]->tops.empty())
+            given_shapes[i] = input_shapes[input_index++].shape();
+    }
+
+    infer_blob_shapes(given_shapes);
+
+    // layers pick kernels for these shapes in create_pipeline
+    for (size_t i=0; i<plan.layers.size(); i++)
+    {
+        Layer* layer = layers[plan.layers[i]];
+
+        layer->bottom_shapes.resize(layer->bottoms.size());
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            layer->bottom_shapes[j] = blobs[layer->bottoms[j]].shape;
+        }
+
+        layer->top_shapes.resize(layer->tops.size());
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            layer->top_shapes[j] = blobs[layer->tops[j]].shape;
+        }
+    }
+
+    return 0;
+}
+
+void Net::infer_blob_shapes(const std::vector<Mat>& given_shapes)
+{
+    for (size_t i=0; i<blobs.size(); i++)
+    {
+        blobs[i].shape = Mat();
+    }
+
+    for (size_t i=0; i<plan.layers.size(); i++)
+    {
+        const int layer_index = plan.layers[i];
+        const Layer* layer = layers[layer_index];
+
+        std::vector<Mat> bottom_shapes(layer->bottoms.size());
+        std::vector<Mat> top_shapes(layer->tops.size());
+
+        // unknown bottoms leave the tops unknown
+        bool bottoms_known = true;
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            bottom_shapes[j] = blobs[layer->bottoms[j]].shape;
+            if (bottom_shapes[j].dims == 0)
+                bottoms_known = false;
+        }
+
+        int ret = -1;
+        if (given_shapes[layer_index].dims != 0)
+        {
+            top_shapes[0] = given_shapes[layer_index];
+            ret = 0;
+        }
+        else if (bottoms_known)
+        {
+            ret = layer->infer_shape(bottom_shapes, top_shapes);
+        }
+
+        if (ret != 0 || top_shapes.size() != layer->tops.size())
+            top_shapes = std::vector<Mat>(layer->tops.size());
+
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            blobs[layer->tops[j]].shape = top_shapes[j];
+        }
+    }
+}
+
+Mat Net::blob_shape(int blob_index) const
+{
+    if (blob_index < 0 || blob_index >= (int)blobs.size())
+        return Mat();
+
+    return blobs[blob_index].shape;
+}
+
+#if NCNN_STRING
+Mat Net::blob_shape(const char* blob_name) const
+{
+    int blob_index = find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+        return Mat();
+
+    return blobs[blob_index].shape;
+}
+#endif // NCNN_STRING
+
+#if NCNN_VULKAN
+void Net::set_vulkan_device(const VulkanDevice* _vkdev)
+{
+    vkdev = _vkdev;
+}
+
+int Net::upload_model()
+{
+    ncnn::VkTransfer cmd(vkdev);
+
+    // create gpu device allocator if null
+    if (!weight_vkallocator)
+    {
+        weight_vkallocator = new VkWeightBufferAllocator(vkdev);
+    }
+    if (!weight_staging_vkallocator)
+    {
+        weight_staging_vkallocator = new VkWeightStagingBufferAllocator(vkdev);
+    }
+
+    cmd.weight_vkallocator = weight_vkallocator;
+    cmd.staging_vkallocator = weight_staging_vkallocator;
+
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        if (layers[i]->support_vulkan)
+        {
+            int uret = layers[i]->upload_model(cmd, opt);
+            if (uret != 0)
+            {
+                fprintf(stderr, "layer upload_model %d failed\n", (int)i);
+                return -1;
+            }
+        }
+    }
+
+    cmd.submit_and_wait();
+
+    return 0;
+}
+
+int Net::create_pipeline()
+{
+    if (opt.use_fp16_storage && vkdev->info.type != 0)
+    {
+        {
+        cast_float32_to_float16 = ncnn::create_layer(ncnn::LayerType::Cast);
+        cast_float32_to_float16->vkdev = vkdev;
+
+        ncnn::ParamDict pd;
+        pd.set(0, 1);
+        pd.set(1, 2);
+
+        cast_float32_to_float16->load_param(pd);
         }
 
         {
@@ -1220,154 +2316,840 @@ Layer* Net::create_custom_layer(int index)
     return layer_creator();
 }
 
-int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt) const
-{
-    const Layer* layer = layers[layer_index];
+// shared state of one branch parallel forward
+class PlanSchedule
+{
+public:
+    std::vector<Mat>* batch_blob_mats;
+    int batch;
+    int* blob_consumer_counts;
+    // unfinished producer steps of each step
+    int* step_pending_counts;
+    const unsigned char* step_wanted;
+    const Mat* part_shapes;
+    Option opt;
+    int ret;
+};
+
+static bool mat_shape_equal(const Mat& a, const Mat& b)
+{
+    return a.dims == b.dims && a.w == b.w && a.h == b.h && a.c == b.c && a.elemsize == b.elemsize && a.packing == b.packing;
+}
+
+// m points into the data of parent without holding a reference
+static bool is_view_of(const Mat& m, const Mat& parent)
+{
+    if (m.refcount || parent.empty())
+        return false;
+
+    const unsigned char* ptr = (const unsigned char*)m.data;
+    const unsigned char* parent_ptr = (const unsigned char*)parent.data;
+    return ptr >= parent_ptr && ptr < parent_ptr + parent.total() * parent.elemsize;
+}
+
+// shape of the outermost axis concat of the part shapes, empty if they do not concat
+static Mat concat_parent_shape(const Mat* shapes, const int* parts, int part_count)
+{
+    const Mat& shape0 = shapes[parts[0]];
+    const int dims = shape0.dims;
+    if (dims == 0)
+        return Mat();
+
+    int size = 0;
+    for (int i=0; i<part_count; i++)
+    {
+        const Mat& shape = shapes[parts[i]];
+        if (shape.dims != dims || shape.elemsize != shape0.elemsize || shape.packing != shape0.packing)
+            return Mat();
+
+        if (dims == 1)
+        {
+            size += shape.w;
+        }
+        else if (dims == 2)
+        {
+            if (shape.w != shape0.w)
+                return Mat();
+
+            size += shape.h;
+        }
+        else
+        {
+            if (shape.w != shape0.w || shape.h != shape0.h)
+                return Mat();
+
+            size += shape.c;
+        }
+    }
+
+    if (dims == 1)
+        return Mat(size, (void*)0, shape0.elemsize, shape0.packing);
+    if (dims == 2)
+        return Mat(shape0.w, size, (void*)0, shape0.elemsize, shape0.packing);
+
+    return Mat(shape0.w, shape0.h, size, (void*)0, shape0.elemsize, shape0.packing);
+}
+
+// view of concat part in the parent
+static Mat concat_part_view(Mat& parent, const Mat* shapes, const int* parts, int part)
+{
+    int offset = 0;
+    for (int i=0; i<part; i++)
+    {
+        const Mat& shape = shapes[parts[i]];
+        offset += parent.dims == 1 ? shape.w : parent.dims == 2 ? shape.h : shape.c;
+    }
+
+    const Mat& shape = shapes[parts[part]];
+    if (parent.dims == 1)
+        return parent.range(offset, shape.w);
+    if (parent.dims == 2)
+        return parent.row_range(offset, shape.h);
+
+    return parent.channel_range(offset, shape.c);
+}
+
+int Net::forward_plan(int blob_index, std::vector<Mat>* batch_blob_mats, int batch, PlanScratch& scratch, Option& opt) const
+{
+    if (plan.blob_steps.empty())
+    {
+        fprintf(stderr, "network graph not ready\n");
+        return -1;
+    }
+
+    const std::vector<int>& steps = plan.blob_steps[blob_index];
+    const int step_count = steps.size();
+
+    // all samples run the same steps, decide them by the first one
+    const std::vector<Mat>& blob_mats = batch_blob_mats[0];
+
+    // the blob between two fused layers is never written
+    if (blobs[blob_index].producer == -1 && blobs[blob_index].consumers.empty())
+    {
+#if NCNN_STRING
+        fprintf(stderr, "blob %s is fused away, disable use_layer_fusion to extract it\n", blobs[blob_index].name.c_str());
+#else
+        fprintf(stderr, "blob %d is fused away, disable use_layer_fusion to extract it\n", blob_index);
+#endif // NCNN_STRING
+        return -1;
+    }
+
+    // the scratch keeps its storage across extracts
+    std::vector<unsigned char>& blob_wanted = scratch.blob_wanted;
+    std::vector<unsigned char>& step_wanted = scratch.step_wanted;
+    std::vector<int>& blob_consumer_counts = scratch.blob_consumer_counts;
+    blob_wanted.assign(blob_mats.size(), 0);
+    step_wanted.assign(plan.layers.size(), 0);
+    blob_consumer_counts.assign(blob_mats.size(), 0);
+
+    // walk backward and pick the steps whose output is still missing
+    blob_wanted[blob_index] = 1;
+    for (int i=step_count-1; i>=0; i--)
+    {
+        int step = steps[i];
+
+        bool wanted = false;
+        for (int j=plan.top_offsets[step]; j<plan.top_offsets[step + 1]; j++)
+        {
+            int top_blob_index = plan.tops[j];
+            if (blob_wanted[top_blob_index] && blob_mats[top_blob_index].dims == 0)
+            {
+                wanted = true;
+                break;
+            }
+        }
+
+        if (!wanted)
+            continue;
+
+        step_wanted[step] = 1;
+        for (int j=plan.bottom_offsets[step]; j<plan.bottom_offsets[step + 1]; j++)
+        {
+            blob_wanted[plan.bottoms[j]] = 1;
+            blob_consumer_counts[plan.bottoms[j]]++;
+        }
+    }
+
+    // blob lifetime ends with its last consumer only if that consumer runs this time
+    for (int i=0; i<step_count; i++)
+    {
+        int step = steps[i];
+        if (!step_wanted[step])
+            continue;
+
+        for (int j=plan.bottom_offsets[step]; j<plan.bottom_offsets[step + 1]; j++)
+        {
+            int bottom_blob_index = plan.bottoms[j];
+            if (!step_wanted[plan.blob_death_steps[bottom_blob_index]])
+                blob_consumer_counts[bottom_blob_index] = INT_MAX / 2;
+        }
+    }
+
+    // concat parts are preallocated from the inferred shapes
+    std::vector<Mat>& part_shapes = scratch.part_shapes;
+    part_shapes.clear();
+    if (!plan.alias_steps.empty())
+    {
+        const int blob_count = blobs.size();
+
+        part_shapes.resize(blob_mats.size());
+        for (size_t g=0; g<plan.alias_steps.size(); g++)
+        {
+            int step = plan.alias_steps[g];
+            if (!step_wanted[step] || layers[plan.layers[step]]->typeindex != LayerType::Concat)
+                continue;
+
+            for (int j=plan.bottom_offsets[step]; j<plan.bottom_offsets[step + 1]; j++)
+            {
+                part_shapes[plan.bottoms[j]] = blobs[plan.bottoms[j]].shape;
+            }
+        }
+
+        for (size_t g=0; g<plan.alias_steps.size(); g++)
+        {
+            int step = plan.alias_steps[g];
+            if (!step_wanted[step] || layers[plan.layers[step]]->typeindex != LayerType::Concat)
+                continue;
+
+            part_shapes[blob_count + g] = concat_parent_shape(&part_shapes[0], &plan.bottoms[plan.bottom_offsets[step]], plan.bottom_offsets[step + 1] - plan.bottom_offsets[step]);
+        }
+
+        if (opt.lightmode && batch == 1)
+        {
+            // slice parents stay alive while views of them are left from earlier runs
+            for (int i=0; i<blob_count; i++)
+            {
+                const Mat& m = blob_mats[i];
+                if (m.refcount || !m.data)
+                    continue;
+
+                int holder_index = find_slice_holder(blob_mats, m);
+                if (holder_index != -1)
+                    blob_consumer_counts[holder_index]++;
+            }
+        }
+    }
+    const Mat* part_shapes_ptr = part_shapes.empty() ? 0 : &part_shapes[0];
+
+#ifdef _OPENMP
+    const int num_inter_op_threads = std::min(opt.num_inter_op_threads, opt.num_threads);
+    if (num_inter_op_threads > 1)
+    {
+        // unfinished producers of each step
+        std::vector<int>& step_pending_counts = scratch.step_pending_counts;
+        step_pending_counts.assign(plan.layers.size(), 0);
+        for (int i=0; i<step_count; i++)
+        {
+            int step = steps[i];
+            if (!step_wanted[step])
+                continue;
+
+            for (int j=plan.bottom_offsets[step]; j<plan.bottom_offsets[step + 1]; j++)
+            {
+                int producer_step = plan.blob_birth_steps[plan.bottoms[j]];
+                if (producer_step != -1 && step_wanted[producer_step])
+                    step_pending_counts[step]++;
+            }
+        }
+
+        PlanSchedule schedule;
+        schedule.batch_blob_mats = batch_blob_mats;
+        schedule.batch = batch;
+        schedule.blob_consumer_counts = &blob_consumer_counts[0];
+        schedule.step_pending_counts = &step_pending_counts[0];
+        schedule.step_wanted = &step_wanted[0];
+        schedule.part_shapes = part_shapes_ptr;
+        schedule.opt = opt;
+        schedule.opt.num_threads = std::max(opt.num_threads / num_inter_op_threads, 1);
+        schedule.ret = 0;
+
+        #pragma omp parallel num_threads(num_inter_op_threads)
+        {
+            #pragma omp single
+            {
+                for (int i=0; i<step_count; i++)
+                {
+                    int step = steps[i];
+                    if (!step_wanted[step] || step_pending_counts[step] != 0)
+                        continue;
+
+                    #pragma omp task firstprivate(step)
+                    forward_plan_task(step, schedule);
+                }
+            }
+        }
+
+        return schedule.ret;
+    }
+#endif // _OPENMP
+
+    // reused across steps and extracts for layers with multiple blobs
+    std::vector<Mat>& bottom_blobs = scratch.bottom_blobs;
+    std::vector<Mat>& top_blobs = scratch.top_blobs;
+
+    for (int i=0; i<step_count; i++)
+    {
+        int step = steps[i];
+        if (!step_wanted[step])
+            continue;
+
+        int ret = forward_layer(step, batch_blob_mats, batch, &blob_consumer_counts[0], part_shapes_ptr, bottom_blobs, top_blobs, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+void Net::forward_plan_task(int step, PlanSchedule& schedule) const
+{
+    int schedule_ret;
+    #pragma omp atomic read
+    schedule_ret = schedule.ret;
+
+    if (schedule_ret != 0)
+        return;
+
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+    int ret = forward_layer(step, schedule.batch_blob_mats, schedule.batch, schedule.blob_consumer_counts, schedule.part_shapes, bottom_blobs, top_blobs, schedule.opt);
+    if (ret != 0)
+    {
+        #pragma omp atomic write
+        schedule.ret = ret;
+        return;
+    }
+
+    // release consumers whose last producer is this step
+    for (int i=plan.top_offsets[step]; i<plan.top_offsets[step + 1]; i++)
+    {
+        const std::vector<int>& consumers = blobs[plan.tops[i]].consumers;
+        for (size_t j=0; j<consumers.size(); j++)
+        {
+            int consumer_step = plan.layer_steps[consumers[j]];
+            if (consumer_step == -1 || !schedule.step_wanted[consumer_step])
+                continue;
+
+            if (NCNN_XADD(&schedule.step_pending_counts[consumer_step], -1) == 1)
+            {
+                #pragma omp task firstprivate(consumer_step)
+                forward_plan_task(consumer_step, schedule);
+            }
+        }
+    }
+}
+
+int Net::find_slice_holder(const std::vector<Mat>& blob_mats, const Mat& m) const
+{
+    const int blob_count = blobs.size();
+    for (size_t g=0; g<plan.alias_steps.size(); g++)
+    {
+        if (layers[plan.layers[plan.alias_steps[g]]]->typeindex != LayerType::Slice)
+            continue;
+
+        if (is_view_of(m, blob_mats[blob_count + g]))
+            return blob_count + g;
+    }
+
+    return -1;
+}
+
+Mat Net::alias_part_view(int blob_index, std::vector<Mat>& blob_mats, const Mat* part_shapes, const Option& opt) const
+{
+    if (!part_shapes)
+        return Mat();
+
+    const int group = plan.blob_alias_groups[blob_index];
+    const int holder_index = blobs.size() + group;
+
+    // empty for slice, or concat not run this time, or no shape known yet
+    const Mat& parent_shape = part_shapes[holder_index];
+    if (parent_shape.dims == 0)
+        return Mat();
+
+    // without light mode every blob is kept, only the last of an in-place chain may live in the parent
+    const int step = plan.alias_steps[group];
+    if (!opt.lightmode && plan.layer_steps[blobs[blob_index].consumers[0]] != step)
+        return Mat();
+
+    Mat& parent = blob_mats[holder_index];
+
+    // the first part written allocates the parent
+    bool parent_ready;
+    #pragma omp critical(ncnn_alias_parent)
+    {
+        if (parent.dims == 0)
+            parent.create_like(parent_shape, opt.blob_allocator);
+
+        parent_ready = !parent.empty() && mat_shape_equal(parent, parent_shape);
+    }
+
+    if (!parent_ready)
+        return Mat();
+
+    Mat part = concat_part_view(parent, part_shapes, &plan.bottoms[plan.bottom_offsets[step]], plan.blob_alias_parts[blob_index]);
+
+    // producers may assume 16 byte aligned blobs, unaligned parts are copied by concat instead
+    if ((size_t)part.data % 16 != 0)
+        return Mat();
+
+    return part;
+}
+
+bool Net::forward_alias(int step, std::vector<Mat>* batch_blob_mats, int batch, int* blob_consumer_counts, const Mat* part_shapes, const std::vector<Mat>& bottom_blobs, const Option& opt) const
+{
+    const Layer* layer = layers[plan.layers[step]];
+
+    const int* bottom_blob_indexes = &plan.bottoms[0] + plan.bottom_offsets[step];
+    const int* top_blob_indexes = &plan.tops[0] + plan.top_offsets[step];
+    const int bottom_count = plan.bottom_offsets[step + 1] - plan.bottom_offsets[step];
+    const int top_count = plan.top_offsets[step + 1] - plan.top_offsets[step];
+
+    const int holder_index = blobs.size() + plan.step_alias_groups[step];
+
+    if (layer->typeindex == LayerType::Concat)
+    {
+        // int8 concat rescales its parts
+        if (((const Concat*)layer)->use_int8_inference)
+            return false;
+
+        if (!part_shapes || part_shapes[holder_index].dims == 0)
+            return false;
+
+        bool parts_match = true;
+        for (int n=0; n<batch && parts_match; n++)
+        {
+            Mat& parent = batch_blob_mats[n][holder_index];
+            if (parent.empty() || !mat_shape_equal(parent, part_shapes[holder_index]))
+            {
+                parts_match = false;
+                break;
+            }
+
+            for (int i=0; i<bottom_count; i++)
+            {
+                Mat part = concat_part_view(parent, part_shapes, bottom_blob_indexes, i);
+                if (!mat_shape_equal(bottom_blobs[n * bottom_count + i], part))
+                {
+                    parts_match = false;
+                    break;
+                }
+            }
+        }
+
+        if (!parts_match)
+            return false;
+
+        for (int n=0; n<batch; n++)
+        {
+            Mat& parent = batch_blob_mats[n][holder_index];
+
+            for (int i=0; i<bottom_count; i++)
+            {
+                const Mat& bottom_blob = bottom_blobs[n * bottom_count + i];
+
+                // copy the parts not written in place
+                Mat part = concat_part_view(parent, part_shapes, bottom_blob_indexes, i);
+                if (part.data != bottom_blob.data)
+                {
+                    memcpy(part.data, bottom_blob.data, bottom_blob.total() * bottom_blob.elemsize);
+                }
+            }
+
+            batch_blob_mats[n][top_blob_indexes[0]] = parent;
+            parent.release();
+        }
+
+        return true;
+    }
+
+    // slice
+    if (batch != 1)
+        return false;
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    const int dims = bottom_blob.dims;
+    const int size = dims == 1 ? bottom_blob.w : dims == 2 ? bottom_blob.h : bottom_blob.c;
+    const size_t stride = dims == 2 ? bottom_blob.w * bottom_blob.elemsize : bottom_blob.elemsize;
+    const int* slices_ptr = ((const Slice*)layer)->slices;
+
+    // same split as Slice::forward, views of 1d and 2d blobs must stay 16 byte aligned
+    std::vector<int> offsets(top_count + 1, 0);
+    for (int i=0; i<top_count; i++)
+    {
+        int slice = slices_ptr[i];
+        if (slice == -233)
+        {
+            slice = (size - offsets[i]) / (top_count - i);
+        }
+
+        if (slice <= 0 || (dims != 3 && offsets[i] * stride % 16 != 0))
+            return false;
+
+        offsets[i + 1] = offsets[i] + slice;
+    }
+    if (offsets[top_count] > size)
+        return false;
+
+    std::vector<Mat>& blob_mats = batch_blob_mats[0];
+
+    if (opt.lightmode)
+    {
+        // the tops may be written in place, take the bottom over only if nothing else holds it
+        if (!bottom_blob.refcount || *bottom_blob.refcount != 1)
+            return false;
+
+        bool holder_free;
+        #pragma omp critical(ncnn_alias_holder)
+        {
+            holder_free = blob_mats[holder_index].dims == 0;
+            if (holder_free)
+            {
+                // kept alive by the views counted after this step
+                blob_mats[holder_index] = bottom_blob;
+                blob_consumer_counts[holder_index] = 0;
+            }
+        }
+
+        if (!holder_free)
+            return false;
+    }
+    else if (bottom_blob.data != blob_mats[bottom_blob_indexes[0]].data)
+    {
+        // the views must live on the bottom blob kept in the extractor
+        return false;
+    }
+
+    for (int i=0; i<top_count; i++)
+    {
+        const int slice = offsets[i + 1] - offsets[i];
+
+        Mat& top_blob = blob_mats[top_blob_indexes[i]];
+        if (dims == 1)
+            top_blob = bottom_blob.range(offsets[i], slice);
+        else if (dims == 2)
+            top_blob = bottom_blob.row_range(offsets[i], slice);
+        else
+            top_blob = bottom_blob.channel_range(offsets[i], slice);
+    }
+
+    return true;
+}
+
+// float blobs with a multiple of 4 channels are packed for layers supporting it
+static int blob_packing_for_layer(const Layer* layer, const Mat& m)
+{
+    if (!layer->support_packing || m.dims != 3 || m.elemsize != 4u * m.packing)
+        return 1;
+
+    return (m.c * m.packing) % 4 == 0 ? 4 : 1;
+}
+
+int Net::forward_layer(int step, std::vector<Mat>* batch_blob_mats, int batch, int* blob_consumer_counts, const Mat* part_shapes, std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, Option& opt) const
+{
+    const int layer_index = plan.layers[step];
+    const Layer* layer = layers[layer_index];
+
+    const int* bottom_blob_indexes = &plan.bottoms[0] + plan.bottom_offsets[step];
+    const int* top_blob_indexes = &plan.tops[0] + plan.top_offsets[step];
+    const int bottom_count = plan.bottom_offsets[step + 1] - plan.bottom_offsets[step];
+    const int top_count = plan.top_offsets[step + 1] - plan.top_offsets[step];
+
+//     fprintf(stderr, "forward_layer %d %s\n", layer_index, layer->name.c_str());
+
+    for (int n=0; n<batch; n++)
+    {
+        for (int i=0; i<bottom_count; i++)
+        {
+            if (batch_blob_mats[n][bottom_blob_indexes[i]].dims == 0)
+            {
+                fprintf(stderr, "forward_layer %d bottom blob %d not ready\n", layer_index, bottom_blob_indexes[i]);
+                return -1;
+            }
+        }
+    }
+
+    if (layer->one_blob_only && bottom_count == 0)
+    {
+        fprintf(stderr, "forward_layer %d input blob %d not set\n", layer_index, top_blob_indexes[0]);
+        return -1;
+    }
 
-//     fprintf(stderr, "forward_layer %d %s\n", layer_index, layer->name.c_str());
+    // views of slice parents handed over by this step
+    std::vector<Mat> released_views;
 
-    if (layer->one_blob_only)
+    // load bottom blobs, sample major
+    bottom_blobs.resize(batch * bottom_count);
+    for (int i=0; i<bottom_count; i++)
     {
-        // load bottom blob
-        int bottom_blob_index = layer->bottoms[0];
-        int top_blob_index = layer->tops[0];
+        int bottom_blob_index = bottom_blob_indexes[i];
 
-        if (blob_mats[bottom_blob_index].dims == 0)
+        // the last consumer takes the blob of every sample
+        bool last_consumer = NCNN_XADD(&blob_consumer_counts[bottom_blob_index], -1) == 1;
+
+        for (int n=0; n<batch; n++)
         {
-            int ret = forward_layer(blobs[bottom_blob_index].producer, blob_mats, opt);
-            if (ret != 0)
-                return ret;
-        }
+            Mat& bottom_blob = bottom_blobs[n * bottom_count + i];
 
-        Mat bottom_blob = blob_mats[bottom_blob_index];
+            bottom_blob = batch_blob_mats[n][bottom_blob_index];
 
-        if (opt.lightmode)
-        {
-            // delete after taken in light mode
-            blob_mats[bottom_blob_index].release();
-            // deep copy for inplace forward if data is shared
-            if (layer->support_inplace && *bottom_blob.refcount != 1)
+            // switch layout where packed and unpacked layers meet
+            bool converted = false;
+            if (opt.use_packing_layout)
+            {
+                int packing = blob_packing_for_layer(layer, bottom_blob);
+                if (bottom_blob.packing != packing)
+                {
+                    Mat bottom_blob_converted;
+                    convert_packing(bottom_blob, bottom_blob_converted, packing, opt.blob_allocator, opt.num_threads);
+                    if (bottom_blob_converted.empty())
+                        return -100;
+
+                    bottom_blob = bottom_blob_converted;
+                    converted = true;
+                }
+            }
+
+            if (last_consumer && opt.lightmode)
+            {
+                if (!batch_blob_mats[n][bottom_blob_index].refcount && batch == 1 && !plan.alias_steps.empty())
+                    released_views.push_back(batch_blob_mats[n][bottom_blob_index]);
+
+                // delete after the last consumer taken in light mode
+                batch_blob_mats[n][bottom_blob_index].release();
+
+                // deep copy for inplace forward if data is shared
+                // a view is shared unless it is an alias part of this run
+                bool shared = !bottom_blob.refcount || *bottom_blob.refcount != 1;
+                if (!bottom_blob.refcount && plan.blob_alias_groups[bottom_blob_index] != -1)
+                    shared = !is_view_of(bottom_blob, batch_blob_mats[n][blobs.size() + plan.blob_alias_groups[bottom_blob_index]]);
+                if (layer->support_inplace && shared)
+                {
+                    bottom_blob = bottom_blob.clone();
+                }
+            }
+            else if (opt.lightmode && layer->support_inplace && !converted)
             {
+                // still referenced by a later step
                 bottom_blob = bottom_blob.clone();
             }
         }
+    }
+
+    int ret = 0;
+
+    if (plan.step_alias_groups[step] != -1 && forward_alias(step, batch_blob_mats, batch, blob_consumer_counts, part_shapes, bottom_blobs, opt))
+    {
+        // concat or slice done as views of the parent
+    }
+    else if (layer->one_blob_only)
+    {
+        int top_blob_index = top_blob_indexes[0];
 
         // forward
         if (opt.lightmode && layer->support_inplace)
         {
-            Mat& bottom_top_blob = bottom_blob;
 #if NCNN_BENCHMARK
             double start = get_current_time();
-            int ret = layer->forward_inplace(bottom_top_blob, opt);
+            ret = batch == 1 ? layer->forward_inplace(bottom_blobs[0], opt) : layer->forward_batch_inplace(bottom_blobs, opt);
             double end = get_current_time();
-            benchmark(layer, bottom_top_blob, bottom_top_blob, start, end);
+            benchmark(layer, bottom_blobs[0], bottom_blobs[0], start, end);
 #else
-            int ret = layer->forward_inplace(bottom_top_blob, opt);
+            ret = batch == 1 ? layer->forward_inplace(bottom_blobs[0], opt) : layer->forward_batch_inplace(bottom_blobs, opt);
 #endif // NCNN_BENCHMARK
-            if (ret != 0)
-                return ret;
 
-            // store top blob
-            blob_mats[top_blob_index] = bottom_top_blob;
+            if (ret == 0)
+            {
+                // store top blob
+                for (int n=0; n<batch; n++)
+                {
+                    batch_blob_mats[n][top_blob_index] = bottom_blobs[n];
+                }
+            }
         }
         else
         {
-            Mat top_blob;
+            top_blobs.resize(batch);
+            if (plan.blob_alias_groups[top_blob_index] != -1)
+            {
+                // write the concat part straight into the parent
+                for (int n=0; n<batch; n++)
+                {
+                    top_blobs[n] = alias_part_view(top_blob_index, batch_blob_mats[n], part_shapes, opt);
+                }
+            }
 #if NCNN_BENCHMARK
             double start = get_current_time();
-            int ret = layer->forward(bottom_blob, top_blob, opt);
+            ret = batch == 1 ? layer->forward(bottom_blobs[0], top_blobs[0], opt) : layer->forward_batch(bottom_blobs, top_blobs, opt);
             double end = get_current_time();
-            benchmark(layer, bottom_blob, top_blob, start, end);
+            benchmark(layer, bottom_blobs[0], top_blobs[0], start, end);
 #else
-            int ret = layer->forward(bottom_blob, top_blob, opt);
+            ret = batch == 1 ? layer->forward(bottom_blobs[0], top_blobs[0], opt) : layer->forward_batch(bottom_blobs, top_blobs, opt);
 #endif // NCNN_BENCHMARK
-            if (ret != 0)
-                return ret;
-
-            // store top blob
-            blob_mats[top_blob_index] = top_blob;
-        }
-
-    }
-    else
-    {
-        // load bottom blobs
-        std::vector<Mat> bottom_blobs(layer->bottoms.size());
-        for (size_t i=0; i<layer->bottoms.size(); i++)
-        {
-            int bottom_blob_index = layer->bottoms[i];
-
-            if (blob_mats[bottom_blob_index].dims == 0)
-            {
-                int ret = forward_layer(blobs[bottom_blob_index].producer, blob_mats, opt);
-                if (ret != 0)
-                    return ret;
-            }
 
-            bottom_blobs[i] = blob_mats[bottom_blob_index];
-
-            if (opt.lightmode)
+            if (ret == 0)
             {
-                // delete after taken in light mode
-                blob_mats[bottom_blob_index].release();
-                // deep copy for inplace forward if data is shared
-                if (layer->support_inplace && *bottom_blobs[i].refcount != 1)
+                // store top blob
+                for (int n=0; n<batch; n++)
                 {
-                    bottom_blobs[i] = bottom_blobs[i].clone();
+                    batch_blob_mats[n][top_blob_index] = top_blobs[n];
                 }
             }
         }
-
+    }
+    else if (batch == 1)
+    {
         // forward
         if (opt.lightmode && layer->support_inplace)
         {
             std::vector<Mat>& bottom_top_blobs = bottom_blobs;
 #if NCNN_BENCHMARK
             double start = get_current_time();
-            int ret = layer->forward_inplace(bottom_top_blobs, opt);
+            ret = layer->forward_inplace(bottom_top_blobs, opt);
             double end = get_current_time();
             benchmark(layer, start, end);
 #else
-            int ret = layer->forward_inplace(bottom_top_blobs, opt);
+            ret = layer->forward_inplace(bottom_top_blobs, opt);
 #endif // NCNN_BENCHMARK
-            if (ret != 0)
-                return ret;
 
-            // store top blobs
-            for (size_t i=0; i<layer->tops.size(); i++)
+            if (ret == 0)
             {
-                int top_blob_index = layer->tops[i];
-
-                blob_mats[top_blob_index] = bottom_top_blobs[i];
+                // store top blobs
+                for (int i=0; i<top_count; i++)
+                {
+                    batch_blob_mats[0][top_blob_indexes[i]] = bottom_top_blobs[i];
+                }
             }
         }
         else
         {
-            std::vector<Mat> top_blobs(layer->tops.size());
+            top_blobs.resize(top_count);
 #if NCNN_BENCHMARK
             double start = get_current_time();
-            int ret = layer->forward(bottom_blobs, top_blobs, opt);
+            ret = layer->forward(bottom_blobs, top_blobs, opt);
             double end = get_current_time();
             benchmark(layer, start, end);
 #else
-            int ret = layer->forward(bottom_blobs, top_blobs, opt);
+            ret = layer->forward(bottom_blobs, top_blobs, opt);
+#endif // NCNN_BENCHMARK
+
+            if (ret == 0)
+            {
+                // store top blobs
+                for (int i=0; i<top_count; i++)
+                {
+                    batch_blob_mats[0][top_blob_indexes[i]] = top_blobs[i];
+                }
+            }
+        }
+    }
+    else
+    {
+        // layers with multiple blobs run sample by sample
+#if NCNN_BENCHMARK
+        double start = get_current_time();
+#endif // NCNN_BENCHMARK
+        for (int n=0; n<batch && ret == 0; n++)
+        {
+            std::vector<Mat> sample_bottom_blobs(bottom_blobs.begin() + n * bottom_count, bottom_blobs.begin() + (n + 1) * bottom_count);
+
+            if (opt.lightmode && layer->support_inplace)
+            {
+                ret = layer->forward_inplace(sample_bottom_blobs, opt);
+
+                if (ret == 0)
+                {
+                    // store top blobs
+                    for (int i=0; i<top_count; i++)
+                    {
+                        batch_blob_mats[n][top_blob_indexes[i]] = sample_bottom_blobs[i];
+                    }
+                }
+            }
+            else
+            {
+                std::vector<Mat> sample_top_blobs(top_count);
+                ret = layer->forward(sample_bottom_blobs, sample_top_blobs, opt);
+
+                if (ret == 0)
+                {
+                    // store top blobs
+                    for (int i=0; i<top_count; i++)
+                    {
+                        batch_blob_mats[n][top_blob_indexes[i]] = sample_top_blobs[i];
+                    }
+                }
+            }
+        }
+#if NCNN_BENCHMARK
+        double end = get_current_time();
+        benchmark(layer, start, end);
 #endif // NCNN_BENCHMARK
-            if (ret != 0)
-                return ret;
+    }
+
+    // drop references held by the reused vectors, keep their storage
+    for (size_t i=0; i<bottom_blobs.size(); i++)
+    {
+        bottom_blobs[i].release();
+    }
+    for (size_t i=0; i<top_blobs.size(); i++)
+    {
+        top_blobs[i].release();
+    }
+
+    if (plan.step_alias_groups[step] != -1 && opt.lightmode && layer->typeindex == LayerType::Concat)
+    {
+        // parent left over when the parts did not match, nothing views it once concat is done
+        for (int n=0; n<batch; n++)
+        {
+            batch_blob_mats[n][blobs.size() + plan.step_alias_groups[step]].release();
+        }
+    }
+
+    bool has_top_views = false;
+    if (ret == 0 && batch == 1 && opt.lightmode && !plan.alias_steps.empty())
+    {
+        for (int i=0; i<top_count; i++)
+        {
+            const Mat& top_blob = batch_blob_mats[0][top_blob_indexes[i]];
+            if (!top_blob.refcount && top_blob.data)
+                has_top_views = true;
+        }
+    }
 
-            // store top blobs
-            for (size_t i=0; i<layer->tops.size(); i++)
+    if (has_top_views || !released_views.empty())
+    {
+        std::vector<Mat>& blob_mats = batch_blob_mats[0];
+
+        // a slice parent lives as long as blobs view it
+        #pragma omp critical(ncnn_alias_holder)
+        {
+            for (int i=0; i<top_count && has_top_views; i++)
             {
-                int top_blob_index = layer->tops[i];
+                const Mat& top_blob = blob_mats[top_blob_indexes[i]];
+                if (top_blob.refcount || !top_blob.data)
+                    continue;
+
+                int holder_index = find_slice_holder(blob_mats, top_blob);
+                if (holder_index != -1)
+                    blob_consumer_counts[holder_index]++;
+            }
 
-                blob_mats[top_blob_index] = top_blobs[i];
+            for (size_t i=0; i<released_views.size(); i++)
+            {
+                int holder_index = find_slice_holder(blob_mats, released_views[i]);
+                if (holder_index != -1 && --blob_consumer_counts[holder_index] == 0)
+                    blob_mats[holder_index].release();
             }
         }
     }
 
+    if (ret != 0)
+        return ret;
+
 //     fprintf(stderr, "forward_layer %d %s done\n", layer_index, layer->name.c_str());
-//     const Mat& blob = blob_mats[layer->tops[0]];
-//     fprintf(stderr, "[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d\n", layer_index, layer->type.c_str(), layer->name.c_str(), layer->tops[0], blob.c, blob.h, blob.w);
+//     const Mat& blob = batch_blob_mats[0][top_blob_indexes[0]];
+//     fprintf(stderr, "[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d\n", layer_index, layer->type.c_str(), layer->name.c_str(), top_blob_indexes[0], blob.c, blob.h, blob.w);
 
     return 0;
 }
@@ -1946,11 +3728,29 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector
 }
 #endif // NCNN_VULKAN
 
+#ifdef _OPENMP
+// layers open their own parallel region inside the branch workers
+// raised once and never restored, a save and restore per extract would race between extractors
+static void enable_nested_parallel(const Option& opt)
+{
+    if (std::min(opt.num_inter_op_threads, opt.num_threads) < 2 || opt.num_threads / opt.num_inter_op_threads < 2)
+        return;
+
+    if (omp_get_max_active_levels() < 2)
+        omp_set_max_active_levels(2);
+}
+#endif // _OPENMP
+
 Extractor::Extractor(const Net* _net, int blob_count) : net(_net)
 {
-    blob_mats.resize(blob_count);
+    batch_blob_mats.resize(1);
+    batch_blob_mats[0].resize(blob_count);
     opt = net->opt;
 
+#ifdef _OPENMP
+    enable_nested_parallel(opt);
+#endif // _OPENMP
+
 #if NCNN_VULKAN
     if (net->opt.use_vulkan_compute)
     {
@@ -1963,6 +3763,9 @@ Extractor::Extractor(const Net* _net, int blob_count) : net(_net)
             opt.staging_vkallocator = net->vkdev->staging_allocator();
 
         blob_mats_gpu.resize(blob_count);
+
+        // the gpu path exchanges unpacked blobs with cpu layers
+        opt.use_packing_layout = false;
     }
 #endif // NCNN_VULKAN
 }
@@ -1975,6 +3778,29 @@ void Extractor::set_light_mode(bool enable)
 void Extractor::set_num_threads(int num_threads)
 {
     opt.num_threads = num_threads;
+
+#ifdef _OPENMP
+    enable_nested_parallel(opt);
+#endif // _OPENMP
+}
+
+void Extractor::set_num_inter_op_threads(int num_inter_op_threads)
+{
+    opt.num_inter_op_threads = num_inter_op_threads;
+
+#ifdef _OPENMP
+    enable_nested_parallel(opt);
+#endif // _OPENMP
+}
+
+void Extractor::set_blob_allocator(Allocator* allocator)
+{
+    opt.blob_allocator = allocator;
+}
+
+void Extractor::set_workspace_allocator(Allocator* allocator)
+{
+    opt.workspace_allocator = allocator;
 }
 
 #if NCNN_VULKAN
@@ -1991,6 +3817,25 @@ void Extractor::set_vulkan_compute(bool enable)
 }
 #endif // NCNN_VULKAN
 
+void Extractor::clear()
+{
+    // blob vectors and plan scratch keep their storage
+    batch_blob_mats.resize(1);
+
+    std::vector<Mat>& blob_mats = batch_blob_mats[0];
+    for (size_t i=0; i<blob_mats.size(); i++)
+    {
+        blob_mats[i].release();
+    }
+
+#if NCNN_VULKAN
+    for (size_t i=0; i<blob_mats_gpu.size(); i++)
+    {
+        blob_mats_gpu[i].release();
+    }
+#endif // NCNN_VULKAN
+}
+
 #if NCNN_STRING
 int Extractor::input(const char* blob_name, const Mat& in)
 {
@@ -2009,29 +3854,173 @@ int Extractor::extract(const char* blob_name, Mat& feat)
 
     return extract(blob_index, feat);
 }
+
+int Extractor::input(const char* blob_name, const std::vector<Mat>& in)
+{
+    int blob_index = net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+        return -1;
+
+    return input(blob_index, in);
+}
+
+int Extractor::extract(const char* blob_name, std::vector<Mat>& feats)
+{
+    int blob_index = net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+        return -1;
+
+    return extract(blob_index, feats);
+}
 #endif // NCNN_STRING
 
 int Extractor::input(int blob_index, const Mat& in)
 {
-    if (blob_index < 0 || blob_index >= (int)blob_mats.size())
+    if (blob_index < 0 || blob_index >= (int)net->blobs.size())
+        return -1;
+
+    for (size_t n=0; n<batch_blob_mats.size(); n++)
+    {
+        batch_blob_mats[n][blob_index] = in;
+    }
+
+    return 0;
+}
+
+int Extractor::input(int blob_index, const std::vector<Mat>& in)
+{
+    if (blob_index < 0 || blob_index >= (int)net->blobs.size())
+        return -1;
+
+    const int batch = batch_blob_mats.size();
+    if (in.empty() || (batch != 1 && batch != (int)in.size()))
+    {
+        fprintf(stderr, "batch size mismatch %d vs %d\n", (int)in.size(), batch);
         return -1;
+    }
+
+    // new samples start with the inputs set so far
+    batch_blob_mats.resize(in.size(), batch_blob_mats[0]);
 
-    blob_mats[blob_index] = in;
+    for (size_t n=0; n<in.size(); n++)
+    {
+        batch_blob_mats[n][blob_index] = in[n];
+    }
+
+    return 0;
+}
+
+// int8 blob kept by fuse_network, float value = int8 value / scale
+static int dequantize_int8_blob(const Mat& src, Mat& dst, float scale, const Option& opt)
+{
+    Mat m;
+    if (src.dims == 1)
+        m.create(src.w, (size_t)4u, opt.blob_allocator);
+    else if (src.dims == 2)
+        m.create(src.w, src.h, (size_t)4u, opt.blob_allocator);
+    else
+        m.create(src.w, src.h, src.c, (size_t)4u, opt.blob_allocator);
+    if (m.empty())
+        return -100;
+
+    const int size = src.w * src.h;
+    const float descale = 1.f / scale;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<src.c; q++)
+    {
+        const signed char* ptr = src.channel(q);
+        float* outptr = m.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = ptr[i] * descale;
+        }
+    }
+
+    dst = m;
 
     return 0;
 }
 
+int Extractor::extract(int blob_index, std::vector<Mat>& feats)
+{
+    if (blob_index < 0 || blob_index >= (int)net->blobs.size())
+        return -1;
+
+    const int batch = batch_blob_mats.size();
+
+    int ret = 0;
+
+    if (batch == 1)
+    {
+        Mat feat;
+        ret = extract(blob_index, feat);
+
+        feats.resize(1);
+        feats[0] = feat;
+
+        return ret;
+    }
+
+    if (batch_blob_mats[0][blob_index].dims == 0)
+    {
+        // batched inference always runs on cpu
+        ret = net->forward_plan(blob_index, &batch_blob_mats[0], batch, scratch, opt);
+    }
+
+    feats.resize(batch);
+    for (int n=0; n<batch; n++)
+    {
+        feats[n] = batch_blob_mats[n][blob_index];
+
+        if (!feats[n].refcount && !net->plan.alias_steps.empty())
+        {
+            // views of an alias parent must not outlive the extractor
+            feats[n] = feats[n].clone(opt.blob_allocator);
+        }
+
+        if (feats[n].packing != 1)
+        {
+            // callers always see the plain layout
+            convert_packing(batch_blob_mats[n][blob_index], feats[n], 1, opt.blob_allocator, opt.num_threads);
+        }
+
+        if (feats[n].elemsize == 1u && net->blobs[blob_index].int8_scale != 0.f)
+        {
+            // callers always see float32
+            int dret = dequantize_int8_blob(batch_blob_mats[n][blob_index], feats[n], net->blobs[blob_index].int8_scale, opt);
+            if (dret != 0)
+                return dret;
+        }
+    }
+
+    return ret;
+}
+
 int Extractor::extract(int blob_index, Mat& feat)
 {
-    if (blob_index < 0 || blob_index >= (int)blob_mats.size())
+    if (blob_index < 0 || blob_index >= (int)net->blobs.size())
         return -1;
 
+    const int batch = batch_blob_mats.size();
+    if (batch != 1)
+    {
+        // first sample of the batch
+        std::vector<Mat> feats;
+        int ret = extract(blob_index, feats);
+
+        feat = feats[0];
+
+        return ret;
+    }
+
+    std::vector<Mat>& blob_mats = batch_blob_mats[0];
+
     int ret = 0;
 
     if (blob_mats[blob_index].dims == 0)
     {
-        int layer_index = net->blobs[blob_index].producer;
-
 #if NCNN_VULKAN
         if (opt.use_vulkan_compute)
         {
@@ -2101,16 +4090,36 @@ int Extractor::extract(int blob_index, Mat& feat)
         }
         else
         {
-            ret = net->forward_layer(layer_index, blob_mats, opt);
+            ret = net->forward_plan(blob_index, &blob_mats, 1, scratch, opt);
         }
 #else
-        ret = net->forward_layer(layer_index, blob_mats, opt);
+        ret = net->forward_plan(blob_index, &blob_mats, 1, scratch, opt);
 #endif // NCNN_VULKAN
 
     }
 
     feat = blob_mats[blob_index];
 
+    if (!feat.refcount && !net->plan.alias_steps.empty())
+    {
+        // views of an alias parent must not outlive the extractor
+        feat = feat.clone(opt.blob_allocator);
+    }
+
+    if (feat.packing != 1)
+    {
+        // callers always see the plain layout
+        convert_packing(blob_mats[blob_index], feat, 1, opt.blob_allocator, opt.num_threads);
+    }
+
+    if (feat.elemsize == 1u && net->blobs[blob_index].int8_scale != 0.f)
+    {
+        // callers always see float32
+        int dret = dequantize_int8_blob(blob_mats[blob_index], feat, net->blobs[blob_index].int8_scale, opt);
+        if (dret != 0)
+            return dret;
+    }
+
     return ret;
 }
 
@@ -2137,7 +4146,7 @@ int Extractor::extract(const char* blob_name, VkMat& feat, VkCompute& cmd)
 
 int Extractor::input(int blob_index, const VkMat& in)
 {
-    if (blob_index < 0 || blob_index >= (int)blob_mats.size())
+    if (blob_index < 0 || blob_index >= (int)net->blobs.size())
         return -1;
 
     blob_mats_gpu[blob_index] = in;
@@ -2147,9 +4156,11 @@ int Extractor::input(int blob_index, const VkMat& in)
 
 int Extractor::extract(int blob_index, VkMat& feat, VkCompute& cmd)
 {
-    if (blob_index < 0 || blob_index >= (int)blob_mats.size())
+    if (blob_index < 0 || blob_index >= (int)net->blobs.size())
         return -1;
 
+    std::vector<Mat>& blob_mats = batch_blob_mats[0];
+
     int ret = 0;
 
     if (blob_mats_gpu[blob_index].dims == 0)
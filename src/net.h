@@ -28,7 +28,72 @@ namespace ncnn {
 #if NCNN_VULKAN
 class VkCompute;
 #endif // NCNN_VULKAN
+
+// compiled execution order of the network graph
+// built once after loading network structure
+class ExecutionPlan
+{
+public:
+    // reset to empty plan
+    void clear();
+
+public:
+    // layer index of each step, in topological order
+    std::vector<int> layers;
+
+    // bottom and top blob indexes of each step, packed
+    // step i reads bottoms[bottom_offsets[i]] .. bottoms[bottom_offsets[i+1]-1]
+    std::vector<int> bottom_offsets;
+    std::vector<int> bottoms;
+    std::vector<int> top_offsets;
+    std::vector<int> tops;
+
+    // step of each layer, -1 if the layer is not loaded
+    std::vector<int> layer_steps;
+
+    // blob lifetime, step which produces each blob, -1 if not produced
+    std::vector<int> blob_birth_steps;
+    // blob lifetime, last step which consumes each blob, -1 if never consumed
+    std::vector<int> blob_death_steps;
+
+    // ascending steps needed to produce each blob
+    std::vector< std::vector<int> > blob_steps;
+
+    // zero-copy concat and slice along the outermost axis
+    // the parts of an alias group are views of one parent blob held in extractor slot blob_count + group
+    // concat parts are written in place by their producers, slice tops view the slice bottom
+    // step of each alias group, a concat or a slice
+    std::vector<int> alias_steps;
+    // alias group of each step, -1 if none
+    std::vector<int> step_alias_groups;
+    // alias group of each blob viewing a parent, -1 if none
+    // for concat this is every blob on the in-place chain from the writing producer to the concat
+    std::vector<int> blob_alias_groups;
+    // concat bottom or slice top index of each blob viewing a parent
+    std::vector<int> blob_alias_parts;
+};
+
+// working memory of one forward through the plan
+// kept by the extractor so that repeated extracts do not allocate
+class PlanScratch
+{
+public:
+    // steps to run this time and the blobs they read
+    std::vector<unsigned char> blob_wanted;
+    std::vector<unsigned char> step_wanted;
+    // consumers left of each blob, the last one releases it in light mode
+    std::vector<int> blob_consumer_counts;
+    // unfinished producer steps of each step
+    std::vector<int> step_pending_counts;
+    // inferred concat part shapes of this run, parents in the extra slots
+    std::vector<Mat> part_shapes;
+    // bottom and top blobs of the running layer
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+};
+
 class Extractor;
+class PlanSchedule;
 class Net
 {
 public:
@@ -73,6 +138,22 @@ public:
     // return 0 if success
     int load_model(FILE* fp);
     int load_model(const char* modelpath);
+
+    // map network weight data from model file read-only
+    // weight data is referenced in the mapping instead of copied where possible
+    // the mapping is kept until the network is cleared
+    // return 0 if success
+    int load_model_mmap(const char* modelpath);
+
+    // load the kernels chosen per feature map size by save_kernel_cache
+    // call between load_param and load_model so that only the chosen kernels are prepared
+    // choices of layers that changed since are dropped
+    // return 0 if success
+    int load_kernel_cache(const char* path);
+
+    // save the kernels every layer has chosen so far, see Option::use_kernel_autotune
+    // return 0 if success
+    int save_kernel_cache(const char* path) const;
 #endif // NCNN_STDIO
 
     // load network structure from external memory
@@ -90,14 +171,37 @@ public:
     // unload network structure and weight data
     void clear();
 
+    // infer the shape of every blob from the input shapes without running the network
+    // input_shapes go to the Input layers in layer order, the others keep their param shape
+    // call between load_param and load_model to let layers pick kernels for these shapes
+    // blobs whose shape depends on blob data are left unknown
+    // concat parts are written in place when their shapes are known
+    // return 0 if success
+    int reshape(const std::vector<Mat>& input_shapes);
+
+    // shape inferred by reshape or from the Input params, dims 0 if unknown
+    Mat blob_shape(int blob_index) const;
+#if NCNN_STRING
+    Mat blob_shape(const char* blob_name) const;
+#endif // NCNN_STRING
+
     // construct an Extractor from network
+    // a loaded network is read only, extractors may run on many threads at once
+    // as long as each thread uses its own unlocked allocators
     Extractor create_extractor() const;
 
 protected:
     // parse the structure of network
     // fuse int8 op dequantize and quantize by requantize
+    // and neighbouring layers into one, see Option::use_layer_fusion
     int fuse_network();
 
+    // keep blobs int8 between quantized layers
+    int fuse_requantize();
+
+    // let a layer absorb the layers after it, return the number of layers absorbed
+    int fuse_layers();
+
 #if NCNN_VULKAN
 
     int upload_model();
@@ -109,6 +213,7 @@ protected:
 #endif // NCNN_VULKAN
 
     friend class Extractor;
+    friend class Runner;
 #if NCNN_STRING
     int find_blob_index_by_name(const char* name) const;
     int find_layer_index_by_name(const char* name) const;
@@ -116,7 +221,32 @@ protected:
     Layer* create_custom_layer(const char* type);
 #endif // NCNN_STRING
     Layer* create_custom_layer(int index);
-    int forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt) const;
+
+    // load weights referenced from memory of size bytes, 0 if the size is unknown
+    // return bytes consumed
+    int load_model_memory(const unsigned char* mem, size_t size);
+
+    // topologically sort layers and record blob lifetimes
+    // return 0 if success
+    int build_execution_plan();
+    // infer blob shapes along the plan, Input layers without a given shape take their param shape
+    // layer bottom_shapes and top_shapes are left to reshape
+    void infer_blob_shapes(const std::vector<Mat>& given_shapes);
+
+    // run the steps needed to produce blob_index
+    // batch_blob_mats holds the blobs of each sample
+    int forward_plan(int blob_index, std::vector<Mat>* batch_blob_mats, int batch, PlanScratch& scratch, Option& opt) const;
+    int forward_layer(int step, std::vector<Mat>* batch_blob_mats, int batch, int* blob_consumer_counts, const Mat* part_shapes, std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, Option& opt) const;
+
+    // view of the parent a concat part is written into, empty if the concat part is not preallocated this time
+    Mat alias_part_view(int blob_index, std::vector<Mat>& blob_mats, const Mat* part_shapes, const Option& opt) const;
+    // finish concat or slice as views of the parent, return false to run the layer instead
+    bool forward_alias(int step, std::vector<Mat>* batch_blob_mats, int batch, int* blob_consumer_counts, const Mat* part_shapes, const std::vector<Mat>& bottom_blobs, const Option& opt) const;
+    // extractor slot of the slice parent viewed by m, -1 if none
+    int find_slice_holder(const std::vector<Mat>& blob_mats, const Mat& m) const;
+
+    // run one step and spawn the consumers it makes ready
+    void forward_plan_task(int step, PlanSchedule& schedule) const;
 
 #if NCNN_VULKAN
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, Option& opt) const;
@@ -126,8 +256,17 @@ protected:
     std::vector<Blob> blobs;
     std::vector<Layer*> layers;
 
+    ExecutionPlan plan;
+
     std::vector<layer_registry_entry> custom_layer_registry;
 
+#if NCNN_STDIO
+    // model files mapped by load_model_mmap, the last one is current
+    // earlier ones stay mapped while layers may still reference them
+    std::vector<void*> mapped_models;
+    std::vector<size_t> mapped_model_sizes;
+#endif // NCNN_STDIO
+
 #if NCNN_VULKAN
     const VulkanDevice* vkdev;
 
@@ -154,10 +293,29 @@ public:
     // default count is system depended
     void set_num_threads(int num_threads);
 
+    // set inter-layer thread count for this extractor
+    // this will overwrite the global setting
+    // default count is 1
+    // more than one enables nested openmp parallelism process wide
+    // so that each branch worker keeps num_threads / num_inter_op_threads threads
+    void set_num_inter_op_threads(int num_inter_op_threads);
+
+    // set blob memory allocator for this extractor
+    // this will overwrite the global setting
+    void set_blob_allocator(Allocator* allocator);
+
+    // set workspace memory allocator for this extractor
+    // this will overwrite the global setting
+    void set_workspace_allocator(Allocator* allocator);
+
 #if NCNN_VULKAN
     void set_vulkan_compute(bool enable);
 #endif // NCNN_VULKAN
 
+    // drop the inputs and blobs of the last run, back to a single sample
+    // the extractor may then take new inputs without being created again
+    void clear();
+
 #if NCNN_STRING
     // set input by blob name
     // return 0 if success
@@ -176,6 +334,26 @@ public:
     // return 0 if success
     int extract(int blob_index, Mat& feat);
 
+#if NCNN_STRING
+    // set batched input by blob name, one mat per sample
+    // return 0 if success
+    int input(const char* blob_name, const std::vector<Mat>& in);
+
+    // get batched result by blob name, one mat per sample
+    // return 0 if success
+    int extract(const char* blob_name, std::vector<Mat>& feats);
+#endif // NCNN_STRING
+
+    // set batched input by blob index
+    // all batched inputs must have the same sample count
+    // single mat input is shared by all samples
+    // return 0 if success
+    int input(int blob_index, const std::vector<Mat>& in);
+
+    // get batched result by blob index
+    // return 0 if success
+    int extract(int blob_index, std::vector<Mat>& feats);
+
 #if NCNN_VULKAN
 #if NCNN_STRING
     // set input by blob name
@@ -202,7 +380,9 @@ protected:
 
 private:
     const Net* net;
-    std::vector<Mat> blob_mats;
+    // blob mats of each sample in batch
+    std::vector< std::vector<Mat> > batch_blob_mats;
+    PlanScratch scratch;
     Option opt;
 
 #if NCNN_VULKAN
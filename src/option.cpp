@@ -21,6 +21,7 @@ Option::Option()
 {
     lightmode = true;
     num_threads = get_cpu_count();
+    num_inter_op_threads = 1;
     blob_allocator = 0;
     workspace_allocator = 0;
 
@@ -33,6 +34,11 @@ Option::Option()
     use_winograd_convolution = true;
     use_sgemm_convolution = true;
     use_int8_inference = true;
+    use_packing_layout = false;
+    use_weight_fp16_storage = false;
+    use_weight_int8_storage = false;
+    use_layer_fusion = false;
+    use_kernel_autotune = false;
     use_vulkan_compute = false;// TODO enable me
 
     use_fp16_packed = false;// TODO enable me
@@ -40,6 +40,13 @@ public:
     // default value is the one returned by get_cpu_count()
     int num_threads;
 
+    // inter-layer thread count
+    // independent branches of the graph run concurrently on this many workers
+    // and every layer runs with num_threads / num_inter_op_threads threads
+    // blob and workspace allocator must be thread safe when greater than 1
+    // default value is 1
+    int num_inter_op_threads;
+
     // blob memory allocator
     Allocator* blob_allocator;
 
@@ -75,6 +82,40 @@ public:
     // enabled by default
     bool use_int8_inference;
 
+    // enable packed channel layout on cpu
+    // blobs with a multiple of 4 channels are kept interleaved in pack4 between layers supporting it
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_packing_layout;
+
+    // store innerproduct weight in fp16
+    // weight is converted back to fp32 on the fly, blobs stay in fp32
+    // reduce model memory for fully connected heavy network, may lose some precision
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_weight_fp16_storage;
+
+    // store innerproduct weight in int8 with one scale per output channel
+    // unlike use_int8_inference, blobs stay in fp32 and no calibration table is needed
+    // takes precedence over use_weight_fp16_storage
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_weight_int8_storage;
+
+    // fuse neighbouring layers into one when loading the model on cpu
+    // residual eltwise sum and relu into convolution, zero padding into convolution,
+    // flatten or reshape into permute and chains of elementwise layers into one expression
+    // blobs between fused layers can not be extracted
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_layer_fusion;
+
+    // time the candidate convolution kernels the first time a layer sees a feature map size
+    // and keep the fastest one for that size, see Net::save_kernel_cache
+    // the first run at each size is slower
+    // disabled by default
+    bool use_kernel_autotune;
+
     // enable vulkan compute
     bool use_vulkan_compute;
 
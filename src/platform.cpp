@@ -0,0 +1,77 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "platform.h"
+
+namespace ncnn {
+
+#ifdef _WIN32
+Thread::Thread(void* (*start)(void* args), void* args)
+{
+    _start = start;
+    _args = args;
+    handle = (HANDLE)_beginthreadex(0, 0, start_wrapper, this, 0, 0);
+}
+
+Thread::~Thread()
+{
+}
+
+bool Thread::joinable() const
+{
+    return handle != 0;
+}
+
+void Thread::join()
+{
+    if (!handle)
+        return;
+
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+    handle = 0;
+}
+
+unsigned __stdcall Thread::start_wrapper(void* args)
+{
+    Thread* t = (Thread*)args;
+    t->_start(t->_args);
+    return 0;
+}
+#else // _WIN32
+Thread::Thread(void* (*start)(void* args), void* args)
+{
+    created = pthread_create(&t, 0, start, args) == 0;
+}
+
+Thread::~Thread()
+{
+}
+
+bool Thread::joinable() const
+{
+    return created;
+}
+
+void Thread::join()
+{
+    if (!created)
+        return;
+
+    pthread_join(t, 0);
+    created = false;
+}
+#endif // _WIN32
+
+} // namespace ncnn
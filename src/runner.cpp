@@ -0,0 +1,358 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "runner.h"
+
+#include <stdio.h>
+#include "allocator.h"
+#include "benchmark.h"
+
+namespace ncnn {
+
+// shared state of one request, owned by the runner queue and the futures
+class RunnerRequest
+{
+public:
+    RunnerRequest() : ret(0), done(false), submit_time(0), refcount(1) {}
+
+    void addref() { NCNN_XADD(&refcount, 1); }
+    void release() { if (NCNN_XADD(&refcount, -1) == 1) delete this; }
+
+    void finish(int _ret)
+    {
+        MutexLockGuard g(lock);
+        ret = _ret;
+        done = true;
+        condition.broadcast();
+    }
+
+public:
+    Mat in;
+    Mat out;
+    int ret;
+    bool done;
+    double submit_time;
+
+    Mutex lock;
+    ConditionVariable condition;
+
+private:
+    int refcount;
+};
+
+// one worker thread, its extractor and allocators
+class RunnerWorker
+{
+public:
+    Runner* runner;
+    Thread* thread;
+
+    // cleared and reused for every batch
+    Extractor* extractor;
+
+    // blobs never leave the worker thread
+    UnlockedPoolAllocator blob_allocator;
+    // layers may take workspace inside their own parallel region
+    PoolAllocator workspace_allocator;
+};
+
+RunnerFuture::RunnerFuture() : request(0)
+{
+}
+
+RunnerFuture::RunnerFuture(RunnerRequest* _request) : request(_request)
+{
+}
+
+RunnerFuture::RunnerFuture(const RunnerFuture& f) : request(f.request)
+{
+    if (request)
+        request->addref();
+}
+
+RunnerFuture::~RunnerFuture()
+{
+    if (request)
+        request->release();
+}
+
+RunnerFuture& RunnerFuture::operator=(const RunnerFuture& f)
+{
+    if (this == &f)
+        return *this;
+
+    if (f.request)
+        f.request->addref();
+
+    if (request)
+        request->release();
+
+    request = f.request;
+
+    return *this;
+}
+
+bool RunnerFuture::ready() const
+{
+    if (!request)
+        return false;
+
+    MutexLockGuard g(request->lock);
+    return request->done;
+}
+
+int RunnerFuture::get(Mat& out) const
+{
+    if (!request)
+        return -1;
+
+    MutexLockGuard g(request->lock);
+    while (!request->done)
+    {
+        request->condition.wait(request->lock);
+    }
+
+    out = request->out;
+
+    return request->ret;
+}
+
+Runner::Runner()
+{
+    num_workers = 1;
+    num_threads = 1;
+    max_batch_size = 8;
+    max_latency_ms = 2.0;
+
+    net = 0;
+    input_blob_index = -1;
+    output_blob_index = -1;
+    stopping = false;
+}
+
+Runner::~Runner()
+{
+    stop();
+}
+
+#if NCNN_STRING
+int Runner::start(const Net* _net, const char* input_blob_name, const char* output_blob_name)
+{
+    int _input_blob_index = _net->find_blob_index_by_name(input_blob_name);
+    if (_input_blob_index == -1)
+        return -1;
+
+    int _output_blob_index = _net->find_blob_index_by_name(output_blob_name);
+    if (_output_blob_index == -1)
+        return -1;
+
+    return start(_net, _input_blob_index, _output_blob_index);
+}
+#endif // NCNN_STRING
+
+int Runner::start(const Net* _net, int _input_blob_index, int _output_blob_index)
+{
+    if (!workers.empty())
+    {
+        fprintf(stderr, "runner already started\n");
+        return -1;
+    }
+
+    if (num_workers < 1 || max_batch_size < 1)
+    {
+        fprintf(stderr, "invalid runner worker count %d or batch size %d\n", num_workers, max_batch_size);
+        return -1;
+    }
+
+    const int blob_count = _net->blobs.size();
+    if (_input_blob_index < 0 || _input_blob_index >= blob_count || _output_blob_index < 0 || _output_blob_index >= blob_count)
+        return -1;
+
+    net = _net;
+    input_blob_index = _input_blob_index;
+    output_blob_index = _output_blob_index;
+    stopping = false;
+
+    workers.reserve(num_workers);
+    for (int i=0; i<num_workers; i++)
+    {
+        RunnerWorker* worker = new RunnerWorker;
+        worker->runner = this;
+
+        worker->extractor = new Extractor(net->create_extractor());
+        worker->extractor->set_num_threads(num_threads);
+        // worker allocators are not shared between layers run concurrently
+        worker->extractor->set_num_inter_op_threads(1);
+        worker->extractor->set_blob_allocator(&worker->blob_allocator);
+        worker->extractor->set_workspace_allocator(&worker->workspace_allocator);
+
+        worker->thread = new Thread(worker_main, worker);
+        if (!worker->thread->joinable())
+        {
+            fprintf(stderr, "runner worker %d thread create failed\n", i);
+            delete worker->thread;
+            delete worker->extractor;
+            delete worker;
+
+            // join the workers started so far
+            stop();
+            return -1;
+        }
+
+        workers.push_back(worker);
+    }
+
+    return 0;
+}
+
+void Runner::stop()
+{
+    {
+        MutexLockGuard g(lock);
+        stopping = true;
+        condition.broadcast();
+    }
+
+    // workers drain the queue before they exit
+    for (size_t i=0; i<workers.size(); i++)
+    {
+        workers[i]->thread->join();
+        delete workers[i]->thread;
+        delete workers[i]->extractor;
+        delete workers[i];
+    }
+
+    workers.clear();
+}
+
+RunnerFuture Runner::submit(const Mat& in)
+{
+    RunnerRequest* request = new RunnerRequest;
+    request->in = in;
+
+    // one reference for the queue, one for the future
+    request->addref();
+    RunnerFuture future(request);
+
+    {
+        MutexLockGuard g(lock);
+
+        if (workers.empty() || stopping)
+        {
+            fprintf(stderr, "runner not started\n");
+            request->finish(-1);
+            request->release();
+            return future;
+        }
+
+        request->submit_time = get_current_time();
+        queue.push_back(request);
+
+        // wake an idle worker, or the one waiting for its batch to fill
+        condition.broadcast();
+    }
+
+    return future;
+}
+
+void* Runner::worker_main(void* args)
+{
+    RunnerWorker* worker = (RunnerWorker*)args;
+    worker->runner->run_worker(worker);
+    return 0;
+}
+
+void Runner::run_worker(RunnerWorker* worker)
+{
+    std::vector<RunnerRequest*> batch;
+    std::vector<Mat> inputs;
+    std::vector<Mat> outputs;
+
+    for (;;)
+    {
+        batch.clear();
+
+        {
+            MutexLockGuard g(lock);
+
+            while (queue.empty() && !stopping)
+            {
+                condition.wait(lock);
+            }
+
+            // stopped and drained
+            if (queue.empty())
+                break;
+
+            // wait for the batch to fill until the oldest request runs out of latency budget
+            while ((int)queue.size() < max_batch_size && !queue.empty() && !stopping)
+            {
+                double timeout_ms = queue.front()->submit_time + max_latency_ms - get_current_time();
+                if (timeout_ms <= 0)
+                    break;
+
+                condition.timed_wait(lock, timeout_ms);
+            }
+
+            // another worker may have taken them meanwhile
+            while (!queue.empty() && (int)batch.size() < max_batch_size)
+            {
+                batch.push_back(queue.front());
+                queue.pop_front();
+            }
+
+            // leftovers are for another worker
+            if (!queue.empty())
+                condition.signal();
+        }
+
+        if (batch.empty())
+            continue;
+
+        const int batch_size = batch.size();
+
+        inputs.resize(batch_size);
+        for (int i=0; i<batch_size; i++)
+        {
+            inputs[i] = batch[i]->in;
+        }
+
+        Extractor& ex = *worker->extractor;
+
+        int ret = ex.input(input_blob_index, inputs);
+        if (ret == 0)
+            ret = ex.extract(output_blob_index, outputs);
+
+        // the blobs go back to the worker allocator, the extractor is ready for the next batch
+        ex.clear();
+
+        for (int i=0; i<batch_size; i++)
+        {
+            RunnerRequest* request = batch[i];
+
+            // the worker allocator is not thread safe, hand out a heap copy
+            if (ret == 0)
+                request->out = outputs[i].clone();
+
+            request->in.release();
+            request->finish(ret);
+            request->release();
+        }
+
+        inputs.clear();
+        outputs.clear();
+    }
+}
+
+} // namespace ncnn
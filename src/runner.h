@@ -0,0 +1,119 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef NCNN_RUNNER_H
+#define NCNN_RUNNER_H
+
+#include <deque>
+#include <vector>
+#include "platform.h"
+#include "mat.h"
+#include "net.h"
+
+namespace ncnn {
+
+class RunnerRequest;
+class RunnerWorker;
+
+// result of a request submitted to Runner
+class RunnerFuture
+{
+public:
+    // empty future
+    RunnerFuture();
+    // refcount++
+    RunnerFuture(const RunnerFuture& f);
+    // refcount--
+    ~RunnerFuture();
+    // assign
+    RunnerFuture& operator=(const RunnerFuture& f);
+
+    // the request has finished
+    bool ready() const;
+
+    // wait for the request to finish and get its output
+    // return 0 if success
+    int get(Mat& out) const;
+
+protected:
+    friend class Runner;
+    RunnerFuture(RunnerRequest* request);
+
+    RunnerRequest* request;
+};
+
+// serve requests from many threads with one network
+// queued requests are coalesced into batches and run by a pool of workers
+// each worker owns an extractor and its allocators, reused across batches
+class Runner
+{
+public:
+    Runner();
+    // stop and wait for queued requests
+    ~Runner();
+
+public:
+    // worker count
+    int num_workers;
+
+    // thread count of each worker
+    int num_threads;
+
+    // most requests coalesced into one batch
+    int max_batch_size;
+
+    // how long the oldest queued request may wait for the batch to fill
+    // in milliseconds
+    double max_latency_ms;
+
+public:
+    // start workers on a loaded network
+    // the network must outlive the runner
+    // return 0 if success
+#if NCNN_STRING
+    int start(const Net* net, const char* input_blob_name, const char* output_blob_name);
+#endif // NCNN_STRING
+    int start(const Net* net, int input_blob_index, int output_blob_index);
+
+    // run the queued requests and join workers
+    void stop();
+
+    // queue one sample, thread safe
+    // the input mat is referenced, not copied
+    RunnerFuture submit(const Mat& in);
+
+protected:
+    static void* worker_main(void* args);
+    void run_worker(RunnerWorker* worker);
+
+private:
+    // not copyable
+    Runner(const Runner&);
+    Runner& operator=(const Runner&);
+
+    const Net* net;
+    int input_blob_index;
+    int output_blob_index;
+
+    Mutex lock;
+    ConditionVariable condition;
+    std::deque<RunnerRequest*> queue;
+    bool stopping;
+
+    std::vector<RunnerWorker*> workers;
+};
+
+} // namespace ncnn
+
+#endif // NCNN_RUNNER_H
@@ -689,6 +689,11 @@ int main(int argc, char** argv)
                     {
                         fprintf(pp, " 8=1");
                     }
+                    else if ((int)weight_int8scale.size() == (int)convolution_param.num_output())
+                    {
+                        // per output channel
+                        fprintf(pp, " 8=3");
+                    }
                     else
                     {
                         fprintf(pp, " 8=2");
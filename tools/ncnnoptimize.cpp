@@ -12,7 +12,13 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 // ncnn public header
@@ -96,6 +102,8 @@ public:
     int replace_convolution_with_innerproduct_after_global_pooling();
     int replace_convolution_with_innerproduct_after_innerproduct();
 
+    int apply_int8scale_table(const char* tablepath);
+
 public:
     int fprintf_param_int_array(int id, const ncnn::Mat& m, FILE* pp);
     int fprintf_param_float_array(int id, const ncnn::Mat& m, FILE* pp);
@@ -1265,6 +1273,158 @@ int NetOptimize::replace_convolution_with_innerproduct_after_innerproduct()
     return 0;
 }
 
+static bool read_int8scale_table(const char* filepath, std::map<std::string, std::vector<float> >& blob_int8scale_table, std::map<std::string, std::vector<float> >& weight_int8scale_table)
+{
+    blob_int8scale_table.clear();
+    weight_int8scale_table.clear();
+
+    FILE* fp = fopen(filepath, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", filepath);
+        return false;
+    }
+
+    bool in_scale_vector = false;
+
+    std::string keystr;
+    std::vector<float> scales;
+
+    while (!feof(fp))
+    {
+        char key[256];
+        int nscan = fscanf(fp, "%255s", key);
+        if (nscan != 1)
+        {
+            break;
+        }
+
+        if (in_scale_vector)
+        {
+            float scale = 1.f;
+            int nscan = sscanf(key, "%f", &scale);
+            if (nscan == 1)
+            {
+                scales.push_back(scale);
+                continue;
+            }
+            else
+            {
+                // XYZ_param_N pattern
+                if (strstr(keystr.c_str(), "_param_"))
+                {
+                    weight_int8scale_table[ keystr ] = scales;
+                }
+                else
+                {
+                    blob_int8scale_table[ keystr ] = scales;
+                }
+
+                keystr.clear();
+                scales.clear();
+
+                in_scale_vector = false;
+            }
+        }
+
+        if (!in_scale_vector)
+        {
+            keystr = key;
+
+            in_scale_vector = true;
+        }
+    }
+
+    if (in_scale_vector)
+    {
+        // XYZ_param_N pattern
+        if (strstr(keystr.c_str(), "_param_"))
+        {
+            weight_int8scale_table[ keystr ] = scales;
+        }
+        else
+        {
+            blob_int8scale_table[ keystr ] = scales;
+        }
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+// per output channel, the same as ncnn2table takes them
+static ncnn::Mat weight_int8_scales(const ncnn::Mat& weight_data, int num_output)
+{
+    const int size = weight_data.w * weight_data.h * weight_data.c / num_output;
+    const float* ptr = weight_data;
+
+    ncnn::Mat scales(num_output);
+    for (int n=0; n<num_output; n++)
+    {
+        float absmax = 0.f;
+        for (int k=0; k<size; k++)
+        {
+            absmax = std::max(absmax, fabsf(ptr[n * size + k]));
+        }
+
+        scales[n] = absmax == 0.f ? 1.f : 127.f / absmax;
+    }
+
+    return scales;
+}
+
+int NetOptimize::apply_int8scale_table(const char* tablepath)
+{
+    std::map<std::string, std::vector<float> > blob_int8scale_table;
+    std::map<std::string, std::vector<float> > weight_int8scale_table;
+    if (!read_int8scale_table(tablepath, blob_int8scale_table, weight_int8scale_table))
+        return -1;
+
+    // batchnorm and scale fusion rewrote the weights the table was calibrated on
+    // only the blob scales are kept, the weight scales are taken again from the fused weights
+    const int layer_count = layers.size();
+    for (int i=0; i<layer_count; i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        if (layer->type != "Convolution" && layer->type != "ConvolutionDepthWise" && layer->type != "InnerProduct")
+            continue;
+
+        if (blob_int8scale_table.find(layer->name) == blob_int8scale_table.end())
+            continue;
+
+        const std::vector<float>& blob_scales = blob_int8scale_table[layer->name];
+        if (blob_scales.empty())
+            continue;
+
+        if (layer->type == "Convolution")
+        {
+            ncnn::Convolution* op = (ncnn::Convolution*)layer;
+            op->int8_scale_term = 1;
+            op->weight_data_int8_scales = weight_int8_scales(op->weight_data, op->num_output);
+            op->bottom_blob_int8_scale = blob_scales[0];
+        }
+        else if (layer->type == "ConvolutionDepthWise")
+        {
+            ncnn::ConvolutionDepthWise* op = (ncnn::ConvolutionDepthWise*)layer;
+            op->int8_scale_term = 1;
+            op->weight_data_int8_scales = weight_int8_scales(op->weight_data, op->num_output);
+            op->bottom_blob_int8_scales = ncnn::Mat(op->group);
+            op->bottom_blob_int8_scales.fill(blob_scales[0]);
+        }
+        else if (layer->type == "InnerProduct")
+        {
+            ncnn::InnerProduct* op = (ncnn::InnerProduct*)layer;
+            op->int8_scale_term = 1;
+            op->weight_data_int8_scales = weight_int8_scales(op->weight_data, op->num_output);
+            op->bottom_blob_int8_scale = blob_scales[0];
+        }
+    }
+
+    return 0;
+}
+
 int NetOptimize::fprintf_param_int_array(int id, const ncnn::Mat& m, FILE* pp)
 {
     const int count = m.w;
@@ -1478,6 +1638,12 @@ int NetOptimize::save(const char* parampath, const char* binpath)
 
             fwrite_weight_tag_data(0, op->weight_data, bp);
             fwrite_weight_data(op->bias_data, bp);
+
+            if (op->int8_scale_term)
+            {
+                fwrite_weight_data(op->weight_data_int8_scales, bp);
+                fwrite_weight_data(ncnn::Mat(1, (void*)&op->bottom_blob_int8_scale), bp);
+            }
         }
         else if (layer->type == "ConvolutionDepthWise")
         {
@@ -1496,12 +1662,19 @@ int NetOptimize::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 5=%d", bias_term)
             fprintf_param_value(" 6=%d", weight_data_size)
             fprintf_param_value(" 7=%d", group)
-            fprintf_param_value(" 8=%d", int8_scale_term)
+            // scales were expanded to per output channel on load, which is per group for depthwise
+            { if (op->int8_scale_term) fprintf(pp, " 8=%d", op->num_output == op->group ? 1 : 3); }
             fprintf_param_value(" 9=%d", activation_type)
             { if (!op->activation_params.empty()) fprintf_param_float_array(10, op->activation_params, pp); }
 
             fwrite_weight_tag_data(0, op->weight_data, bp);
             fwrite_weight_data(op->bias_data, bp);
+
+            if (op->int8_scale_term)
+            {
+                fwrite_weight_data(op->weight_data_int8_scales, bp);
+                fwrite_weight_data(op->bottom_blob_int8_scales.range(0, 1), bp);
+            }
         }
         else if (layer->type == "Crop")
         {
@@ -1620,6 +1793,12 @@ int NetOptimize::save(const char* parampath, const char* binpath)
 
             fwrite_weight_tag_data(0, op->weight_data, bp);
             fwrite_weight_data(op->bias_data, bp);
+
+            if (op->int8_scale_term)
+            {
+                fwrite_weight_data(op->weight_data_int8_scales, bp);
+                fwrite_weight_data(ncnn::Mat(1, (void*)&op->bottom_blob_int8_scale), bp);
+            }
         }
         else if (layer->type == "Input")
         {
@@ -1950,9 +2129,9 @@ int NetOptimize::save(const char* parampath, const char* binpath)
 
 int main(int argc, char** argv)
 {
-    if (argc != 6)
+    if (argc != 6 && argc != 7)
     {
-        fprintf(stderr, "usage: %s [inparam] [inbin] [outparam] [outbin] [flag]\n", argv[0]);
+        fprintf(stderr, "usage: %s [inparam] [inbin] [outparam] [outbin] [flag] [int8scaletable]\n", argv[0]);
         return -1;
     }
 
@@ -1961,6 +2140,7 @@ int main(int argc, char** argv)
     const char* outparam = argv[3];
     const char* outbin = argv[4];
     int flag = atoi(argv[5]);
+    const char* int8scale_table_path = argc == 7 ? argv[6] : NULL;
 
     NetOptimize optimizer;
 
@@ -1973,6 +2153,9 @@ int main(int argc, char** argv)
         optimizer.storage_type = 0;
     }
 
+    // the graph is written back as it was loaded
+    optimizer.opt.use_layer_fusion = false;
+
     optimizer.load_param(inparam);
     optimizer.load_model(inbin);
 
@@ -1997,6 +2180,17 @@ int main(int argc, char** argv)
 
     optimizer.eliminate_flatten_after_innerproduct();
 
+    // the table is keyed by layer name, fusion keeps the name of the surviving layer
+    // weight scales are taken from the fused weights, the table gives the blob scales
+    if (int8scale_table_path)
+    {
+        if (optimizer.apply_int8scale_table(int8scale_table_path) != 0)
+        {
+            fprintf(stderr, "apply_int8scale_table failed\n");
+            return -1;
+        }
+    }
+
     optimizer.save(outparam, outbin);
 
     return 0;
@@ -0,0 +1,890 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// ncnn public header
+#include "net.h"
+#include "layer.h"
+
+// ncnn private header
+#include "layer/convolution.h"
+#include "layer/convolutiondepthwise.h"
+#include "layer/innerproduct.h"
+
+// binary pgm and ppm, 8bit per channel
+static int read_pnm(const char* path, std::vector<unsigned char>& pixels, int& w, int& h, int& channels)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return -1;
+
+    char magic[3] = {0};
+    if (fread(magic, 1, 2, fp) != 2 || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6'))
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    channels = magic[1] == '5' ? 1 : 3;
+
+    // width height maxval, may be interleaved with comment lines
+    int header[3];
+    for (int i=0; i<3; i++)
+    {
+        int c = fgetc(fp);
+        while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            if (c == '#')
+            {
+                while (c != '\n' && c != EOF)
+                    c = fgetc(fp);
+            }
+            c = fgetc(fp);
+        }
+        ungetc(c, fp);
+
+        if (fscanf(fp, "%d", &header[i]) != 1)
+        {
+            fclose(fp);
+            return -1;
+        }
+    }
+
+    // single whitespace before the pixel data
+    fgetc(fp);
+
+    w = header[0];
+    h = header[1];
+    if (w <= 0 || h <= 0 || header[2] != 255)
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    pixels.resize((size_t)w * h * channels);
+    size_t nread = fread(&pixels[0], 1, pixels.size(), fp);
+
+    fclose(fp);
+
+    return nread == pixels.size() ? 0 : -1;
+}
+
+static int list_images(const char* dirpath, std::vector<std::string>& paths)
+{
+    paths.clear();
+
+#ifdef _WIN32
+    std::string pattern = std::string(dirpath) + "\\*";
+
+    WIN32_FIND_DATAA data;
+    HANDLE handle = FindFirstFileA(pattern.c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "open image dir %s failed\n", dirpath);
+        return -1;
+    }
+
+    do
+    {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        paths.push_back(std::string(dirpath) + "\\" + data.cFileName);
+    }
+    while (FindNextFileA(handle, &data));
+
+    FindClose(handle);
+#else
+    DIR* dir = opendir(dirpath);
+    if (!dir)
+    {
+        fprintf(stderr, "open image dir %s failed\n", dirpath);
+        return -1;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != 0)
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        paths.push_back(std::string(dirpath) + "/" + entry->d_name);
+    }
+
+    closedir(dir);
+#endif
+
+    std::sort(paths.begin(), paths.end());
+
+    return 0;
+}
+
+// reference distribution and its expansion from target_bin quantized bins
+static float compute_kl_divergence(const std::vector<float>& p, const std::vector<float>& q)
+{
+    float p_sum = 0.f;
+    float q_sum = 0.f;
+    for (size_t i=0; i<p.size(); i++)
+    {
+        p_sum += p[i];
+        q_sum += q[i];
+    }
+
+    if (p_sum == 0.f || q_sum == 0.f)
+        return FLT_MAX;
+
+    float kl = 0.f;
+    for (size_t i=0; i<p.size(); i++)
+    {
+        if (p[i] == 0.f)
+            continue;
+
+        float pi = p[i] / p_sum;
+        float qi = q[i] / q_sum;
+
+        // bins the quantized distribution lost entirely
+        if (qi == 0.f)
+            qi = 1e-10f;
+
+        kl += pi * logf(pi / qi);
+    }
+
+    return kl;
+}
+
+// find the histogram bin minimizing the kl divergence between the clipped
+// distribution and its int8 quantization
+static int threshold_distribution(const std::vector<float>& distribution, int target_bin)
+{
+    const int length = distribution.size();
+
+    float outliers_sum = 0.f;
+    for (int i=target_bin; i<length; i++)
+    {
+        outliers_sum += distribution[i];
+    }
+
+    int target_threshold = length;
+    float min_kl = FLT_MAX;
+
+    std::vector<float> clipped_distribution;
+    std::vector<float> quantized_distribution(target_bin);
+    std::vector<float> expanded_distribution;
+
+    for (int threshold=target_bin; threshold<=length; threshold++)
+    {
+        // fold the outliers into the last bin
+        clipped_distribution.assign(distribution.begin(), distribution.begin() + threshold);
+        clipped_distribution[threshold - 1] += outliers_sum;
+        if (threshold < length)
+            outliers_sum -= distribution[threshold];
+
+        // merge the bins under threshold into target_bin bins, outliers excluded
+        const float num_per_bin = (float)threshold / target_bin;
+        for (int i=0; i<target_bin; i++)
+        {
+            const float start = i * num_per_bin;
+            const float end = start + num_per_bin;
+
+            float sum = 0.f;
+
+            const int left_upper = (int)ceilf(start);
+            if (left_upper > start)
+            {
+                sum += (left_upper - start) * distribution[left_upper - 1];
+            }
+
+            const int right_lower = (int)floorf(end);
+            if (right_lower < end && right_lower < threshold)
+            {
+                sum += (end - right_lower) * distribution[right_lower];
+            }
+
+            for (int j=left_upper; j<right_lower; j++)
+            {
+                sum += distribution[j];
+            }
+
+            quantized_distribution[i] = sum;
+        }
+
+        // expand back over the nonzero source bins
+        expanded_distribution.assign(threshold, 0.f);
+        for (int i=0; i<target_bin; i++)
+        {
+            const float start = i * num_per_bin;
+            const float end = start + num_per_bin;
+
+            float count = 0.f;
+
+            const int left_upper = (int)ceilf(start);
+            float left_scale = 0.f;
+            if (left_upper > start)
+            {
+                left_scale = left_upper - start;
+                if (distribution[left_upper - 1] != 0.f)
+                    count += left_scale;
+            }
+
+            const int right_lower = (int)floorf(end);
+            float right_scale = 0.f;
+            if (right_lower < end && right_lower < threshold)
+            {
+                right_scale = end - right_lower;
+                if (distribution[right_lower] != 0.f)
+                    count += right_scale;
+            }
+
+            for (int j=left_upper; j<right_lower; j++)
+            {
+                if (distribution[j] != 0.f)
+                    count += 1.f;
+            }
+
+            if (count == 0.f)
+                continue;
+
+            const float expand_value = quantized_distribution[i] / count;
+
+            if (left_upper > start && distribution[left_upper - 1] != 0.f)
+            {
+                expanded_distribution[left_upper - 1] += expand_value * left_scale;
+            }
+
+            if (right_lower < end && right_lower < threshold && distribution[right_lower] != 0.f)
+            {
+                expanded_distribution[right_lower] += expand_value * right_scale;
+            }
+
+            for (int j=left_upper; j<right_lower; j++)
+            {
+                if (distribution[j] != 0.f)
+                    expanded_distribution[j] += expand_value;
+            }
+        }
+
+        float kl = compute_kl_divergence(clipped_distribution, expanded_distribution);
+        if (kl < min_kl)
+        {
+            min_kl = kl;
+            target_threshold = threshold;
+        }
+    }
+
+    return target_threshold;
+}
+
+// activation statistics of the bottom blob of one quantizable layer
+class QuantizeBlobStat
+{
+public:
+    int layer_index;
+    int blob_index;
+
+    float absmax;
+    std::vector<float> histogram;
+
+    float scale;
+
+    // fp32 vs int8 top blob
+    double cosine_sum;
+    int cosine_count;
+};
+
+class NetQuantize : public ncnn::Net
+{
+public:
+    NetQuantize();
+
+    // input preprocessing
+    int target_w;
+    int target_h;
+    float mean_vals[3];
+    float norm_vals[3];
+    // 0=bgr 1=rgb 2=gray
+    int pixel_order;
+
+    // 0=kl 1=minmax
+    int method;
+
+    std::vector<std::string> image_paths;
+    std::vector<QuantizeBlobStat> stats;
+
+public:
+    int find_quantizable_layers();
+
+    int load_image(const std::string& path, ncnn::Mat& in) const;
+
+    int collect_absmax();
+    int collect_histogram();
+    int compute_blob_scales();
+
+    int weight_scales(const ncnn::Layer* layer, std::vector<float>& scales) const;
+
+    // quantize the layers of this net with the scale table of another
+    int apply_scales(const NetQuantize& calibrated);
+
+    // cosine similarity of the quantized layer outputs against fp32
+    int compare(const NetQuantize& quantized);
+
+    int save_table(const char* tablepath) const;
+
+protected:
+    int input_blob_index;
+    static const int num_histogram_bins = 2048;
+};
+
+NetQuantize::NetQuantize()
+{
+    target_w = 224;
+    target_h = 224;
+    mean_vals[0] = mean_vals[1] = mean_vals[2] = 0.f;
+    norm_vals[0] = norm_vals[1] = norm_vals[2] = 1.f;
+    pixel_order = 0;
+    method = 0;
+    input_blob_index = -1;
+}
+
+int NetQuantize::find_quantizable_layers()
+{
+    stats.clear();
+
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        const ncnn::Layer* layer = layers[i];
+
+        if (layer->type == "Input" && input_blob_index == -1)
+        {
+            input_blob_index = layer->tops[0];
+            continue;
+        }
+
+        if (layer->type != "Convolution" && layer->type != "ConvolutionDepthWise" && layer->type != "InnerProduct")
+            continue;
+
+        if (layer->type == "Convolution" && ((const ncnn::Convolution*)layer)->weight_data.elemsize != 4)
+            continue;
+        if (layer->type == "ConvolutionDepthWise" && ((const ncnn::ConvolutionDepthWise*)layer)->weight_data.elemsize != 4)
+            continue;
+        if (layer->type == "InnerProduct" && ((const ncnn::InnerProduct*)layer)->weight_data.elemsize != 4)
+            continue;
+
+        QuantizeBlobStat stat;
+        stat.layer_index = i;
+        stat.blob_index = layer->bottoms[0];
+        stat.absmax = 0.f;
+        stat.histogram.resize(num_histogram_bins, 0.f);
+        stat.scale = 1.f;
+        stat.cosine_sum = 0.0;
+        stat.cosine_count = 0;
+
+        stats.push_back(stat);
+    }
+
+    if (input_blob_index == -1)
+    {
+        fprintf(stderr, "no Input layer found\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int NetQuantize::load_image(const std::string& path, ncnn::Mat& in) const
+{
+    std::vector<unsigned char> pixels;
+    int w;
+    int h;
+    int channels;
+    if (read_pnm(path.c_str(), pixels, w, h, channels) != 0)
+    {
+        fprintf(stderr, "read %s failed\n", path.c_str());
+        return -1;
+    }
+
+    int type = ncnn::Mat::PIXEL_RGB;
+    if (channels == 1)
+    {
+        type = pixel_order == 0 ? ncnn::Mat::PIXEL_GRAY2BGR : pixel_order == 1 ? ncnn::Mat::PIXEL_GRAY2RGB : ncnn::Mat::PIXEL_GRAY;
+    }
+    else
+    {
+        type = pixel_order == 0 ? ncnn::Mat::PIXEL_RGB2BGR : pixel_order == 1 ? ncnn::Mat::PIXEL_RGB : ncnn::Mat::PIXEL_RGB2GRAY;
+    }
+
+    in = ncnn::Mat::from_pixels_resize(&pixels[0], type, w, h, target_w, target_h);
+    in.substract_mean_normalize(mean_vals, norm_vals);
+
+    return 0;
+}
+
+int NetQuantize::collect_absmax()
+{
+    for (size_t i=0; i<image_paths.size(); i++)
+    {
+        ncnn::Mat in;
+        if (load_image(image_paths[i], in) != 0)
+            continue;
+
+        ncnn::Extractor ex = create_extractor();
+        ex.set_light_mode(false);
+        ex.input(input_blob_index, in);
+
+        for (size_t j=0; j<stats.size(); j++)
+        {
+            QuantizeBlobStat& stat = stats[j];
+
+            ncnn::Mat m;
+            ex.extract(stat.blob_index, m);
+
+            for (int q=0; q<m.c; q++)
+            {
+                const float* ptr = m.channel(q);
+                for (int k=0; k<m.w * m.h; k++)
+                {
+                    stat.absmax = std::max(stat.absmax, fabsf(ptr[k]));
+                }
+            }
+        }
+
+        fprintf(stderr, "\rabsmax %d / %d", (int)i + 1, (int)image_paths.size());
+    }
+    fprintf(stderr, "\n");
+
+    return 0;
+}
+
+int NetQuantize::collect_histogram()
+{
+    for (size_t i=0; i<image_paths.size(); i++)
+    {
+        ncnn::Mat in;
+        if (load_image(image_paths[i], in) != 0)
+            continue;
+
+        ncnn::Extractor ex = create_extractor();
+        ex.set_light_mode(false);
+        ex.input(input_blob_index, in);
+
+        for (size_t j=0; j<stats.size(); j++)
+        {
+            QuantizeBlobStat& stat = stats[j];
+            if (stat.absmax == 0.f)
+                continue;
+
+            ncnn::Mat m;
+            ex.extract(stat.blob_index, m);
+
+            const float bin_scale = num_histogram_bins / stat.absmax;
+
+            for (int q=0; q<m.c; q++)
+            {
+                const float* ptr = m.channel(q);
+                for (int k=0; k<m.w * m.h; k++)
+                {
+                    // the zeros of relu would dominate the distribution
+                    if (ptr[k] == 0.f)
+                        continue;
+
+                    int index = std::min((int)(fabsf(ptr[k]) * bin_scale), num_histogram_bins - 1);
+                    stat.histogram[index] += 1.f;
+                }
+            }
+        }
+
+        fprintf(stderr, "\rhistogram %d / %d", (int)i + 1, (int)image_paths.size());
+    }
+    fprintf(stderr, "\n");
+
+    return 0;
+}
+
+int NetQuantize::compute_blob_scales()
+{
+    for (size_t j=0; j<stats.size(); j++)
+    {
+        QuantizeBlobStat& stat = stats[j];
+
+        if (stat.absmax == 0.f)
+        {
+            stat.scale = 1.f;
+            continue;
+        }
+
+        if (method == 1)
+        {
+            stat.scale = 127.f / stat.absmax;
+            continue;
+        }
+
+        int threshold_bin = threshold_distribution(stat.histogram, 128);
+
+        const float bin_width = stat.absmax / num_histogram_bins;
+        float threshold = (threshold_bin + 0.5f) * bin_width;
+
+        stat.scale = 127.f / std::min(threshold, stat.absmax);
+    }
+
+    return 0;
+}
+
+// per output channel
+int NetQuantize::weight_scales(const ncnn::Layer* layer, std::vector<float>& scales) const
+{
+    ncnn::Mat weight_data;
+    int num_scales = 0;
+
+    if (layer->type == "Convolution")
+    {
+        const ncnn::Convolution* op = (const ncnn::Convolution*)layer;
+        weight_data = op->weight_data;
+        num_scales = op->num_output;
+    }
+    else if (layer->type == "ConvolutionDepthWise")
+    {
+        const ncnn::ConvolutionDepthWise* op = (const ncnn::ConvolutionDepthWise*)layer;
+        weight_data = op->weight_data;
+        num_scales = op->num_output;
+    }
+    else if (layer->type == "InnerProduct")
+    {
+        const ncnn::InnerProduct* op = (const ncnn::InnerProduct*)layer;
+        weight_data = op->weight_data;
+        num_scales = op->num_output;
+    }
+
+    if (num_scales == 0)
+        return -1;
+
+    const int size = weight_data.w * weight_data.h * weight_data.c / num_scales;
+    const float* ptr = weight_data;
+
+    scales.resize(num_scales);
+    for (int n=0; n<num_scales; n++)
+    {
+        float absmax = 0.f;
+        for (int k=0; k<size; k++)
+        {
+            absmax = std::max(absmax, fabsf(ptr[n * size + k]));
+        }
+
+        scales[n] = absmax == 0.f ? 1.f : 127.f / absmax;
+    }
+
+    return 0;
+}
+
+int NetQuantize::apply_scales(const NetQuantize& calibrated)
+{
+    opt.use_int8_inference = true;
+
+    for (size_t j=0; j<calibrated.stats.size(); j++)
+    {
+        const QuantizeBlobStat& stat = calibrated.stats[j];
+        ncnn::Layer* layer = layers[stat.layer_index];
+
+        std::vector<float> scales;
+        if (calibrated.weight_scales(calibrated.layers[stat.layer_index], scales) != 0)
+            continue;
+
+        ncnn::Mat weight_scales_mat((int)scales.size());
+        for (size_t k=0; k<scales.size(); k++)
+        {
+            weight_scales_mat[k] = scales[k];
+        }
+
+        layer->destroy_pipeline(opt);
+
+        if (layer->type == "Convolution")
+        {
+            ncnn::Convolution* op = (ncnn::Convolution*)layer;
+            op->int8_scale_term = 1;
+            op->weight_data_int8_scales = weight_scales_mat;
+            op->bottom_blob_int8_scale = stat.scale;
+        }
+        else if (layer->type == "ConvolutionDepthWise")
+        {
+            ncnn::ConvolutionDepthWise* op = (ncnn::ConvolutionDepthWise*)layer;
+            op->int8_scale_term = 1;
+            op->weight_data_int8_scales = weight_scales_mat;
+            op->bottom_blob_int8_scales = ncnn::Mat(op->group);
+            op->bottom_blob_int8_scales.fill(stat.scale);
+        }
+        else if (layer->type == "InnerProduct")
+        {
+            ncnn::InnerProduct* op = (ncnn::InnerProduct*)layer;
+            op->int8_scale_term = 1;
+            op->weight_data_int8_scales = weight_scales_mat;
+            op->bottom_blob_int8_scale = stat.scale;
+        }
+
+        int ret = layer->create_pipeline(opt);
+        if (ret != 0)
+        {
+            fprintf(stderr, "layer %s create_pipeline failed\n", layer->name.c_str());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int NetQuantize::compare(const NetQuantize& quantized)
+{
+    for (size_t i=0; i<image_paths.size(); i++)
+    {
+        ncnn::Mat in;
+        if (load_image(image_paths[i], in) != 0)
+            continue;
+
+        ncnn::Extractor ex = create_extractor();
+        ex.set_light_mode(false);
+        ex.input(input_blob_index, in);
+
+        ncnn::Extractor ex_int8 = quantized.create_extractor();
+        ex_int8.set_light_mode(false);
+        ex_int8.input(input_blob_index, in);
+
+        for (size_t j=0; j<stats.size(); j++)
+        {
+            QuantizeBlobStat& stat = stats[j];
+            const int top_blob_index = layers[stat.layer_index]->tops[0];
+
+            ncnn::Mat a;
+            ncnn::Mat b;
+            ex.extract(top_blob_index, a);
+            ex_int8.extract(top_blob_index, b);
+
+            if (a.total() != b.total() || a.elemsize != 4 || b.elemsize != 4)
+                continue;
+
+            double dot = 0.0;
+            double a_norm = 0.0;
+            double b_norm = 0.0;
+            for (int q=0; q<a.c; q++)
+            {
+                const float* pa = a.channel(q);
+                const float* pb = b.channel(q);
+                for (int k=0; k<a.w * a.h; k++)
+                {
+                    dot += (double)pa[k] * pb[k];
+                    a_norm += (double)pa[k] * pa[k];
+                    b_norm += (double)pb[k] * pb[k];
+                }
+            }
+
+            double cosine = (a_norm == 0.0 && b_norm == 0.0) ? 1.0 : dot / sqrt(a_norm * b_norm + 1e-20);
+
+            stat.cosine_sum += cosine;
+            stat.cosine_count++;
+        }
+
+        fprintf(stderr, "\rcompare %d / %d", (int)i + 1, (int)image_paths.size());
+    }
+    fprintf(stderr, "\n");
+
+    for (size_t j=0; j<stats.size(); j++)
+    {
+        const QuantizeBlobStat& stat = stats[j];
+        const ncnn::Layer* layer = layers[stat.layer_index];
+
+        double cosine = stat.cosine_count ? stat.cosine_sum / stat.cosine_count : 0.0;
+
+        fprintf(stderr, "%-24s %-20s  scale = %12.6f  cosine = %.6f\n", layer->type.c_str(), layer->name.c_str(), stat.scale, cosine);
+    }
+
+    return 0;
+}
+
+int NetQuantize::save_table(const char* tablepath) const
+{
+    FILE* fp = fopen(tablepath, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", tablepath);
+        return -1;
+    }
+
+    // weight scales first, keyed as the caffe blobs XYZ_param_0
+    for (size_t j=0; j<stats.size(); j++)
+    {
+        const ncnn::Layer* layer = layers[stats[j].layer_index];
+
+        std::vector<float> scales;
+        if (weight_scales(layer, scales) != 0)
+            continue;
+
+        fprintf(fp, "%s_param_0", layer->name.c_str());
+        for (size_t k=0; k<scales.size(); k++)
+        {
+            fprintf(fp, " %f", scales[k]);
+        }
+        fprintf(fp, "\n");
+    }
+
+    // bottom blob scales, keyed by the consumer layer
+    for (size_t j=0; j<stats.size(); j++)
+    {
+        const ncnn::Layer* layer = layers[stats[j].layer_index];
+
+        fprintf(fp, "%s %f\n", layer->name.c_str(), stats[j].scale);
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
+static int parse_floats(const char* s, float* vals, int n)
+{
+    int count = sscanf(s, "%f,%f,%f", &vals[0], &vals[1], &vals[2]);
+    if (count == 1)
+    {
+        for (int i=1; i<n; i++)
+            vals[i] = vals[0];
+        count = n;
+    }
+
+    return count == n ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        fprintf(stderr, "usage: %s [param] [bin] [imagedir] [table] [width,height] [mean] [norm] [bgr|rgb|gray] [kl|minmax] [threads]\n", argv[0]);
+        fprintf(stderr, "images are binary ppm or pgm files, mean and norm are one or three comma separated values\n");
+        fprintf(stderr, "apply the table with ncnnoptimize [inparam] [inbin] [outparam] [outbin] [flag] [table]\n");
+        return -1;
+    }
+
+    const char* parampath = argv[1];
+    const char* binpath = argv[2];
+    const char* imagedir = argv[3];
+    const char* tablepath = argv[4];
+
+    NetQuantize net;
+    NetQuantize net_int8;
+
+    int num_threads = 1;
+
+    if (argc >= 6 && sscanf(argv[5], "%d,%d", &net.target_w, &net.target_h) != 2)
+    {
+        fprintf(stderr, "invalid size %s\n", argv[5]);
+        return -1;
+    }
+    if (argc >= 7 && parse_floats(argv[6], net.mean_vals, 3) != 0)
+    {
+        fprintf(stderr, "invalid mean %s\n", argv[6]);
+        return -1;
+    }
+    if (argc >= 8 && parse_floats(argv[7], net.norm_vals, 3) != 0)
+    {
+        fprintf(stderr, "invalid norm %s\n", argv[7]);
+        return -1;
+    }
+    if (argc >= 9)
+    {
+        net.pixel_order = strcmp(argv[8], "rgb") == 0 ? 1 : strcmp(argv[8], "gray") == 0 ? 2 : 0;
+    }
+    if (argc >= 10)
+    {
+        net.method = strcmp(argv[9], "minmax") == 0 ? 1 : 0;
+    }
+    if (argc >= 11)
+    {
+        num_threads = atoi(argv[10]);
+    }
+
+    net.opt.num_threads = num_threads;
+    net.opt.use_int8_inference = false;
+    // statistics are taken at the original layer boundaries
+    net.opt.use_layer_fusion = false;
+
+    if (net.load_param(parampath) != 0 || net.load_model(binpath) != 0)
+    {
+        fprintf(stderr, "load %s %s failed\n", parampath, binpath);
+        return -1;
+    }
+
+    if (net.find_quantizable_layers() != 0)
+        return -1;
+
+    std::vector<std::string> paths;
+    if (list_images(imagedir, paths) != 0)
+        return -1;
+
+    for (size_t i=0; i<paths.size(); i++)
+    {
+        std::vector<unsigned char> pixels;
+        int w;
+        int h;
+        int channels;
+        if (read_pnm(paths[i].c_str(), pixels, w, h, channels) != 0)
+        {
+            fprintf(stderr, "skip %s, not a binary pgm or ppm\n", paths[i].c_str());
+            continue;
+        }
+
+        net.image_paths.push_back(paths[i]);
+    }
+
+    if (net.image_paths.empty())
+    {
+        fprintf(stderr, "no image in %s\n", imagedir);
+        return -1;
+    }
+
+    fprintf(stderr, "images = %d\n", (int)net.image_paths.size());
+    fprintf(stderr, "quantizable layers = %d\n", (int)net.stats.size());
+    fprintf(stderr, "method = %s\n", net.method == 1 ? "minmax" : "kl");
+
+    net.collect_absmax();
+
+    if (net.method == 0)
+        net.collect_histogram();
+
+    net.compute_blob_scales();
+
+    if (net.save_table(tablepath) != 0)
+        return -1;
+
+    // run the model again with the table for the per layer accuracy report
+    net_int8.opt.num_threads = num_threads;
+    net_int8.opt.use_layer_fusion = false;
+    if (net_int8.load_param(parampath) != 0 || net_int8.load_model(binpath) != 0)
+        return -1;
+
+    if (net_int8.apply_scales(net) != 0)
+        return -1;
+
+    net.compare(net_int8);
+
+    return 0;
+}